@@ -0,0 +1,578 @@
+#include "desiredstatereconciler.h"
+#include "sharemanager.h"
+#include "mountmanager.h"
+#include "../core/configurationmanager.h"
+#include "../core/remotenfsshare.h"
+#include "../core/shareconfiguration.h"
+#include "../system/fstabfile.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QHostAddress>
+#include <QSet>
+#include <algorithm>
+
+namespace NFSShareManager {
+
+namespace {
+
+QString translate(const char *text)
+{
+    return QCoreApplication::translate("DesiredStateReconciler", text);
+}
+
+QByteArray readTable(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+QString sourceOf(const NFSMount &mount)
+{
+    const RemoteNFSShare remoteShare = mount.remoteShare();
+    const QString server = remoteShare.hostName().isEmpty() ? remoteShare.hostAddress().toString()
+                                                            : remoteShare.hostName();
+    return QString("%1:%2").arg(server, QDir::cleanPath(remoteShare.exportPath()));
+}
+
+QString normalizeSource(const QString &source)
+{
+    const int separator = source.indexOf(":/");
+    if (separator < 0) {
+        return source;
+    }
+    return source.left(separator + 1) + QDir::cleanPath(source.mid(separator + 1));
+}
+
+/**
+ * @brief Rebuild a mount from a table entry so it can be unmounted or removed
+ */
+NFSMount mountOf(const MountTableEntry &entry, bool persistent)
+{
+    const int separator = entry.source.indexOf(":/");
+    const QString host = separator > 0 ? entry.source.left(separator) : entry.source;
+    const QString exportPath = separator > 0 ? entry.source.mid(separator + 1) : QString();
+    RemoteNFSShare remoteShare(host, QHostAddress(host), exportPath);
+    return NFSMount(remoteShare, entry.mountPoint, MountOptions(), persistent);
+}
+
+/**
+ * @brief Check that an fstab entry carries every option the mount asks for
+ */
+bool fstabEntryMatches(const MountTableEntry &entry, const NFSMount &mount)
+{
+    if (normalizeSource(entry.source) != sourceOf(mount)) {
+        return false;
+    }
+    const QSet<QString> present(entry.options.cbegin(), entry.options.cend());
+    const QStringList expected = DesiredStateReconciler::fstabOptions(mount);
+    return std::all_of(expected.cbegin(), expected.cend(), [&present](const QString &option) {
+        return present.contains(option);
+    });
+}
+
+PlanStep makeStep(PlanStep::Action action, const QString &target, const QString &reason)
+{
+    PlanStep step;
+    step.action = action;
+    step.target = target;
+    step.reason = reason;
+    return step;
+}
+
+} // namespace
+
+QString PlanStep::description() const
+{
+    QString text;
+    switch (action) {
+    case Action::Unmount:
+        text = translate("Unmount %1");
+        break;
+    case Action::RemoveFstabEntry:
+        text = translate("Remove fstab entry for %1");
+        break;
+    case Action::Unexport:
+        text = translate("Stop exporting %1");
+        break;
+    case Action::UpdateExport:
+        text = translate("Re-export %1");
+        break;
+    case Action::Export:
+        text = translate("Export %1");
+        break;
+    case Action::AddFstabEntry:
+        text = translate("Add fstab entry for %1");
+        break;
+    case Action::Mount:
+        text = translate("Mount %1");
+        break;
+    }
+    text = text.arg(target);
+    return reason.isEmpty() ? text : QString("%1 (%2)").arg(text, reason);
+}
+
+int ReconcilePlan::count(PlanStep::Action action) const
+{
+    return std::count_if(steps.cbegin(), steps.cend(), [action](const PlanStep &step) {
+        return step.action == action;
+    });
+}
+
+QStringList ReconcilePlan::describe() const
+{
+    QStringList lines;
+    for (const PlanStep &step : steps) {
+        lines << step.description();
+    }
+    return lines;
+}
+
+DesiredStateReconciler::DesiredStateReconciler(ShareManager *shareManager, MountManager *mountManager, QObject *parent)
+    : QObject(parent)
+    , m_shareManager(shareManager)
+    , m_mountManager(mountManager)
+    , m_fstabPath("/etc/fstab")
+    , m_mountTablePath("/proc/self/mounts")
+    , m_phase(Phase::Idle)
+    , m_finishedSteps(0)
+    , m_mountBatch(0)
+{
+    if (m_mountManager) {
+        // Results of batches started by someone else are ignored by the phase checks
+        connect(m_mountManager, &MountManager::unmountCompleted, this, [this](const QString &mountPoint) {
+            if (m_phase == Phase::Unmounting) {
+                finishMountStep(mountPoint, QString());
+            }
+        });
+        connect(m_mountManager, &MountManager::unmountFailed, this,
+                [this](const QString &mountPoint, const QString &error) {
+            if (m_phase == Phase::Unmounting) {
+                finishMountStep(mountPoint, error.isEmpty() ? tr("Unmount failed") : error);
+            }
+        });
+        connect(m_mountManager, &MountManager::mountCompleted, this, [this](const NFSMount &mount) {
+            if (m_phase == Phase::Mounting) {
+                finishMountStep(mount.localMountPoint(), QString());
+            }
+        });
+        connect(m_mountManager, &MountManager::mountFailed, this,
+                [this](const RemoteNFSShare &, const QString &mountPoint, MountManager::MountResult,
+                       const QString &error) {
+            if (m_phase == Phase::Mounting) {
+                finishMountStep(mountPoint, error.isEmpty() ? tr("Mount failed") : error);
+            }
+        });
+        // Other batches (the UI, a login restore) may finish in between
+        connect(m_mountManager, &MountManager::mountBatchFinished, this, [this](int batch) {
+            if (batch == m_mountBatch) {
+                m_mountBatch = 0;
+                onMountBatchFinished();
+            }
+        });
+    }
+    if (m_shareManager) {
+        connect(m_shareManager, &ShareManager::bulkOperationFinished, this, [this](const ExportBatchResult &batch) {
+            if (m_phase == Phase::Exporting) {
+                onExportBatchFinished(batch);
+            }
+        });
+    }
+}
+
+DesiredStateReconciler::~DesiredStateReconciler()
+{
+}
+
+DesiredState DesiredStateReconciler::desiredStateOf(ConfigurationManager *configuration)
+{
+    DesiredState desired;
+    if (configuration) {
+        desired.shares = configuration->getLocalShares();
+        desired.mounts = configuration->getPersistentMounts();
+    }
+    return desired;
+}
+
+ObservedState DesiredStateReconciler::observe() const
+{
+    ObservedState observed;
+
+    if (m_shareManager) {
+        const QList<NFSShare> managed = m_shareManager->getActiveShares();
+        for (const NFSShare &share : managed) {
+            observed.managedExports << QDir::cleanPath(share.path());
+        }
+
+        const QString etabPath = m_shareManager->exportReconciler()->etabPath();
+        if (QFile::exists(etabPath)) {
+            observed.exports = ExportReconciler::parseExportTable(QString::fromUtf8(readTable(etabPath)));
+        } else {
+            // No etab (nfs-server never ran here): trust the managed set
+            for (const NFSShare &share : managed) {
+                observed.exports << ExportReconciler::parseExportTable(
+                    share.config().toExportLine(QDir::cleanPath(share.path())));
+            }
+        }
+    }
+
+    if (m_mountManager) {
+        const QList<NFSMount> managed = m_mountManager->getManagedMounts();
+        for (const NFSMount &mount : managed) {
+            observed.managedMountPoints << QDir::cleanPath(mount.localMountPoint());
+        }
+    }
+
+    observed.mounts = parseMountTable(QString::fromUtf8(readTable(m_mountTablePath)));
+    observed.fstab = parseMountTable(QString::fromUtf8(readTable(m_fstabPath)));
+    return observed;
+}
+
+ReconcilePlan DesiredStateReconciler::plan(const DesiredState &desired) const
+{
+    const ReconcilePlan result = computePlan(desired, observe());
+    qDebug() << "DesiredStateReconciler: plan has" << result.steps.size() << "steps,"
+             << result.unchanged << "entries unchanged," << result.conflicts.size() << "conflicts";
+    return result;
+}
+
+bool DesiredStateReconciler::execute(const ReconcilePlan &plan)
+{
+    if (m_phase != Phase::Idle) {
+        return false;
+    }
+    m_plan = plan;
+    m_result = ReconcileResult();
+    m_finishedSteps = 0;
+    emit progress(0, tr("Applying %n change(s)", "", plan.steps.size()));
+
+    startMountBatch(PlanStep::Action::Unmount);
+    return true;
+}
+
+bool DesiredStateReconciler::isRunning() const
+{
+    return m_phase != Phase::Idle;
+}
+
+void DesiredStateReconciler::startMountBatch(PlanStep::Action action)
+{
+    m_phase = action == PlanStep::Action::Unmount ? Phase::Unmounting : Phase::Mounting;
+    m_pendingMounts.clear();
+
+    QStringList mountPoints;
+    QList<NFSMount> mounts;
+    for (const PlanStep &step : m_plan.steps) {
+        if (step.action == action) {
+            mountPoints << step.target;
+            // Persistence is handled by the fstab steps of the plan
+            mounts << NFSMount(step.mount.remoteShare(), step.target, step.mount.options(), false);
+        }
+    }
+    if (mountPoints.isEmpty()) {
+        onMountBatchFinished();
+        return;
+    }
+
+    // Set before starting: invalid entries are reported from within the call
+    m_pendingMounts = QSet<QString>(mountPoints.cbegin(), mountPoints.cend());
+    m_mountBatch = action == PlanStep::Action::Unmount ? m_mountManager->unmountShares(mountPoints)
+                                                       : m_mountManager->mountShares(mounts);
+}
+
+void DesiredStateReconciler::onMountBatchFinished()
+{
+    if (m_phase == Phase::Idle) {
+        return;
+    }
+    // Entries the batch never reported did not happen
+    const QStringList unreported = m_pendingMounts.values();
+    for (const QString &mountPoint : unreported) {
+        finishMountStep(mountPoint, tr("no result"));
+    }
+
+    if (m_phase == Phase::Unmounting) {
+        if (!applyFileSteps()) {
+            startMountBatch(PlanStep::Action::Mount);
+        }
+        return;
+    }
+
+    m_phase = Phase::Idle;
+    m_result.success = m_result.errors.isEmpty();
+    emit progress(100, tr("Applied %1 of %2 change(s)").arg(m_result.applied).arg(m_plan.steps.size()));
+    emit finished(m_result);
+}
+
+void DesiredStateReconciler::finishMountStep(const QString &mountPoint, const QString &error)
+{
+    const QString target = QDir::cleanPath(mountPoint);
+    if (!m_pendingMounts.remove(target)) {
+        return;
+    }
+    const bool unmounting = m_phase == Phase::Unmounting;
+    if (error.isEmpty()) {
+        m_result.applied++;
+    } else if (unmounting) {
+        m_result.errors << tr("Failed to unmount %1: %2").arg(target, error);
+    } else {
+        m_result.errors << tr("Failed to mount %1: %2").arg(target, error);
+    }
+    reportStep(unmounting ? tr("Unmounted %1").arg(target) : tr("Mounted %1").arg(target));
+}
+
+bool DesiredStateReconciler::applyFileSteps()
+{
+    // All fstab steps go into one rewrite of the file
+    QStringList fstabRemovals;
+    QList<NFSMount> fstabAdditions;
+    // Export changes go out as one transaction
+    QStringList removals;
+    QList<ShareRequest> updates;
+    QList<ShareRequest> creations;
+    for (const PlanStep &step : m_plan.steps) {
+        switch (step.action) {
+        case PlanStep::Action::RemoveFstabEntry:
+            fstabRemovals << step.target;
+            break;
+        case PlanStep::Action::AddFstabEntry:
+            fstabAdditions << step.mount;
+            break;
+        case PlanStep::Action::Unexport:
+            removals << step.target;
+            break;
+        case PlanStep::Action::UpdateExport:
+            updates << ShareRequest(step.target, step.share.config());
+            break;
+        case PlanStep::Action::Export:
+            creations << ShareRequest(step.target, step.share.config());
+            break;
+        case PlanStep::Action::Unmount:
+        case PlanStep::Action::Mount:
+            break;
+        }
+    }
+
+    const int fstabSteps = fstabRemovals.size() + fstabAdditions.size();
+    if (fstabSteps > 0) {
+        QString error;
+        if (m_mountManager->applyFstabChanges(fstabAdditions, fstabRemovals, &error)) {
+            m_result.applied += fstabSteps;
+        } else {
+            m_result.errors << tr("Failed to update fstab: %1").arg(error);
+        }
+        reportStep(tr("Updated fstab"), fstabSteps);
+    }
+
+    if (removals.isEmpty() && updates.isEmpty() && creations.isEmpty()) {
+        return false;
+    }
+
+    // Set before starting: a batch without creations finishes from within the call
+    m_phase = Phase::Exporting;
+    if (!m_shareManager->applyShareChanges(removals, updates, creations)) {
+        m_phase = Phase::Unmounting;
+        m_result.errors << tr("Export changes not applied: another share operation is still running");
+        reportStep(tr("Skipped exports"), removals.size() + updates.size() + creations.size());
+        return false;
+    }
+    return true;
+}
+
+void DesiredStateReconciler::onExportBatchFinished(const ExportBatchResult &batch)
+{
+    for (const ExportEntryResult &entry : batch.entries) {
+        if (entry.success) {
+            m_result.applied++;
+        } else {
+            m_result.errors << QString("%1: %2").arg(entry.path, entry.error);
+        }
+    }
+    reportStep(tr("Updated exports"), batch.entries.size());
+    startMountBatch(PlanStep::Action::Mount);
+}
+
+void DesiredStateReconciler::reportStep(const QString &statusMessage, int steps)
+{
+    m_finishedSteps += steps;
+    const int total = qMax(1, m_plan.steps.size());
+    emit progress(qMin(99, m_finishedSteps * 100 / total), statusMessage);
+}
+
+void DesiredStateReconciler::setFstabPath(const QString &filePath)
+{
+    m_fstabPath = filePath;
+}
+
+void DesiredStateReconciler::setMountTablePath(const QString &filePath)
+{
+    m_mountTablePath = filePath;
+}
+
+ReconcilePlan DesiredStateReconciler::computePlan(const DesiredState &desired, const ObservedState &observed)
+{
+    ReconcilePlan plan;
+
+    // Exports: the drift between desired shares and the kernel table is the plan
+    const QSet<QString> ownedExports(observed.managedExports.cbegin(), observed.managedExports.cend());
+    QHash<QString, NFSShare> desiredShares;
+    for (const NFSShare &share : desired.shares) {
+        desiredShares.insert(QDir::cleanPath(share.path()), share);
+    }
+
+    int changedShares = 0;
+    for (const ExportDrift &drift : ExportReconciler::diff(desired.shares, observed.exports)) {
+        const bool owned = ownedExports.contains(drift.path);
+        switch (drift.kind) {
+        case ExportDrift::Kind::Missing: {
+            PlanStep step = makeStep(owned ? PlanStep::Action::UpdateExport : PlanStep::Action::Export,
+                                     drift.path, owned ? translate("not exported by the kernel") : QString());
+            step.share = desiredShares.value(drift.path);
+            plan.steps << step;
+            changedShares++;
+            break;
+        }
+        case ExportDrift::Kind::Extra:
+            // Exports configured outside this application are not ours to remove
+            if (owned) {
+                plan.steps << makeStep(PlanStep::Action::Unexport, drift.path, translate("no longer wanted"));
+            }
+            break;
+        case ExportDrift::Kind::OptionsDrifted:
+            changedShares++;
+            if (owned) {
+                PlanStep step = makeStep(PlanStep::Action::UpdateExport, drift.path,
+                                         translate("exported as %1").arg(drift.actual));
+                step.share = desiredShares.value(drift.path);
+                plan.steps << step;
+            } else {
+                plan.conflicts << translate("%1 is exported outside this application as %2")
+                                      .arg(drift.path, drift.actual);
+            }
+            break;
+        }
+    }
+    plan.unchanged += desiredShares.size() - changedShares;
+
+    // Mounts and fstab, keyed by mount point; later table lines win
+    const QSet<QString> ownedMounts(observed.managedMountPoints.cbegin(), observed.managedMountPoints.cend());
+    QHash<QString, MountTableEntry> mounted;
+    for (const MountTableEntry &entry : observed.mounts) {
+        mounted.insert(QDir::cleanPath(entry.mountPoint), entry);
+    }
+    QHash<QString, MountTableEntry> fstab;
+    for (const MountTableEntry &entry : observed.fstab) {
+        fstab.insert(QDir::cleanPath(entry.mountPoint), entry);
+    }
+
+    QHash<QString, NFSMount> desiredMounts;
+    for (const NFSMount &mount : desired.mounts) {
+        desiredMounts.insert(QDir::cleanPath(mount.localMountPoint()), mount);
+    }
+
+    for (auto it = desiredMounts.constBegin(); it != desiredMounts.constEnd(); ++it) {
+        const QString &mountPoint = it.key();
+        const NFSMount &mount = it.value();
+        const QString source = sourceOf(mount);
+        const int stepsBefore = plan.steps.size();
+
+        auto current = mounted.constFind(mountPoint);
+        if (current == mounted.constEnd()) {
+            PlanStep step = makeStep(PlanStep::Action::Mount, mountPoint, source);
+            step.mount = mount;
+            plan.steps << step;
+        } else if (normalizeSource(current->source) != source) {
+            if (ownedMounts.contains(mountPoint)) {
+                PlanStep unmount = makeStep(PlanStep::Action::Unmount, mountPoint,
+                                            translate("%1 is mounted there").arg(current->source));
+                unmount.mount = mountOf(current.value(), false);
+                PlanStep step = makeStep(PlanStep::Action::Mount, mountPoint, source);
+                step.mount = mount;
+                plan.steps << unmount << step;
+            } else {
+                plan.conflicts << translate("%1 is in use by %2").arg(mountPoint, current->source);
+            }
+        }
+
+        auto entry = fstab.constFind(mountPoint);
+        const bool hasEntry = entry != fstab.constEnd();
+        if (mount.isPersistent() && (!hasEntry || !fstabEntryMatches(entry.value(), mount))) {
+            if (hasEntry && !ownedMounts.contains(mountPoint)) {
+                plan.conflicts << translate("fstab already has an entry for %1").arg(mountPoint);
+            } else {
+                if (hasEntry) {
+                    PlanStep remove = makeStep(PlanStep::Action::RemoveFstabEntry, mountPoint,
+                                               translate("outdated"));
+                    remove.mount = mountOf(entry.value(), true);
+                    plan.steps << remove;
+                }
+                PlanStep add = makeStep(PlanStep::Action::AddFstabEntry, mountPoint, source);
+                add.mount = mount;
+                plan.steps << add;
+            }
+        } else if (!mount.isPersistent() && hasEntry && ownedMounts.contains(mountPoint)) {
+            PlanStep remove = makeStep(PlanStep::Action::RemoveFstabEntry, mountPoint,
+                                       translate("mount is no longer persistent"));
+            remove.mount = mountOf(entry.value(), true);
+            plan.steps << remove;
+        }
+
+        if (plan.steps.size() == stepsBefore) {
+            plan.unchanged++;
+        }
+    }
+
+    // Owned mounts and fstab entries the desired state no longer lists
+    for (auto it = mounted.constBegin(); it != mounted.constEnd(); ++it) {
+        if (ownedMounts.contains(it.key()) && !desiredMounts.contains(it.key())) {
+            PlanStep step = makeStep(PlanStep::Action::Unmount, it.key(), translate("no longer wanted"));
+            step.mount = mountOf(it.value(), false);
+            plan.steps << step;
+        }
+    }
+    for (auto it = fstab.constBegin(); it != fstab.constEnd(); ++it) {
+        if (ownedMounts.contains(it.key()) && !desiredMounts.contains(it.key())) {
+            PlanStep step = makeStep(PlanStep::Action::RemoveFstabEntry, it.key(), translate("no longer wanted"));
+            step.mount = mountOf(it.value(), true);
+            plan.steps << step;
+        }
+    }
+
+    // Execution order: by action, unmounts deepest first, everything else shallowest first
+    std::stable_sort(plan.steps.begin(), plan.steps.end(), [](const PlanStep &a, const PlanStep &b) {
+        if (a.action != b.action) {
+            return a.action < b.action;
+        }
+        return a.action == PlanStep::Action::Unmount ? a.target > b.target : a.target < b.target;
+    });
+    plan.conflicts.sort();
+
+    return plan;
+}
+
+QList<MountTableEntry> DesiredStateReconciler::parseMountTable(const QString &content)
+{
+    // /proc/self/mounts has the fstab(5) layout
+    QList<MountTableEntry> entries;
+    const QStringList lines = content.split('\n', Qt::SkipEmptyParts);
+    for (const QString &line : lines) {
+        // "nfsd" is the server's control filesystem, not a mount
+        FstabEntry entry;
+        if (FstabFile::parseLine(line, &entry) && entry.isNFS()) {
+            entries << MountTableEntry(entry.source, entry.mountPoint, entry.type, entry.options);
+        }
+    }
+    return entries;
+}
+
+QStringList DesiredStateReconciler::fstabOptions(const NFSMount &mount)
+{
+    return MountManager::toFstabOptions(mount);
+}
+
+} // namespace NFSShareManager
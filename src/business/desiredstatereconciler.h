@@ -0,0 +1,275 @@
+#pragma once
+
+#include <QObject>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include "../core/nfsshare.h"
+#include "../core/nfsmount.h"
+#include "exportreconciler.h"
+
+namespace NFSShareManager {
+
+class ConfigurationManager;
+class ShareManager;
+class MountManager;
+
+/**
+ * @brief Exports and mounts the system should end up with
+ */
+struct DesiredState {
+    QList<NFSShare> shares;     ///< Local shares to export
+    QList<NFSMount> mounts;     ///< Remote shares to mount; persistent ones belong in fstab
+};
+
+/**
+ * @brief One NFS line of fstab or of the kernel mount table
+ */
+struct MountTableEntry {
+    QString source;         ///< "server:/export"
+    QString mountPoint;     ///< Local mount point
+    QString type;           ///< "nfs" or "nfs4"
+    QStringList options;    ///< Mount options
+
+    MountTableEntry() = default;
+    MountTableEntry(const QString &s, const QString &m, const QString &t, const QStringList &o)
+        : source(s), mountPoint(m), type(t), options(o) {}
+};
+
+/**
+ * @brief What the system currently has, as far as a plan is concerned
+ */
+struct ObservedState {
+    QList<KernelExport> exports;        ///< Live kernel export table
+    QStringList managedExports;         ///< Exported paths this application owns
+    QList<MountTableEntry> mounts;      ///< Mounted NFS filesystems
+    QList<MountTableEntry> fstab;       ///< NFS entries of fstab
+    QStringList managedMountPoints;     ///< Mount points this application owns
+};
+
+/**
+ * @brief One step of a reconcile plan
+ */
+struct PlanStep {
+    /**
+     * @brief Kind of change, in execution order
+     */
+    enum class Action {
+        Unmount,            ///< Unmount a mount that is not wanted or has the wrong source
+        RemoveFstabEntry,   ///< Remove a stale or outdated fstab entry
+        Unexport,           ///< Stop exporting a share that is no longer wanted
+        UpdateExport,       ///< Re-export a managed share with the desired configuration
+        Export,             ///< Export a new share
+        AddFstabEntry,      ///< Add the fstab entry of a persistent mount
+        Mount               ///< Mount a remote share
+    };
+
+    Action action;          ///< Kind of change
+    QString target;         ///< Share path or mount point
+    QString reason;         ///< Why the step is needed
+    NFSShare share;         ///< Desired share (UpdateExport, Export)
+    NFSMount mount;         ///< Mount to act on (mount and fstab steps)
+
+    PlanStep() : action(Action::Export) {}
+
+    /**
+     * @brief Get a one-line description for dry runs
+     */
+    QString description() const;
+};
+
+/**
+ * @brief Ordered list of changes that turns the observed state into the desired one
+ */
+struct ReconcilePlan {
+    QList<PlanStep> steps;      ///< Changes in execution order
+    QStringList conflicts;      ///< Differences the plan leaves alone, with the reason
+    int unchanged = 0;          ///< Desired entries that already match
+
+    bool isEmpty() const { return steps.isEmpty(); }
+
+    /**
+     * @brief Count the steps of one kind
+     */
+    int count(PlanStep::Action action) const;
+
+    /**
+     * @brief Describe every step, one line each
+     */
+    QStringList describe() const;
+};
+
+/**
+ * @brief Outcome of executing a plan
+ */
+struct ReconcileResult {
+    bool success = false;       ///< Whether every step was applied
+    int applied = 0;            ///< Steps that took effect
+    QStringList errors;         ///< One message per failed step
+};
+
+/**
+ * @brief Computes and applies the minimal change plan for exports and mounts
+ *
+ * A plan compares the full desired state (usually the shares and mounts of
+ * the ConfigurationManager) with the kernel export table, the mount table
+ * and fstab, and lists only what differs. Entries that already match cost
+ * nothing, so applying a large profile touches only the changed lines.
+ *
+ * Steps are ordered so that nothing is removed from under something else:
+ * unmounts (deepest mount point first) and fstab removals come before export
+ * changes, and fstab additions and mounts (shallowest first) come last.
+ * Export changes go out as one ShareManager::applyShareChanges() transaction,
+ * whose paths are validated off the GUI thread; unmounts and mounts each go
+ * to MountManager as one batch, which runs off the GUI thread too, so
+ * execute() only starts the plan and finished() reports.
+ *
+ * Only entries this application owns are ever removed or re-exported;
+ * differences in foreign exports are reported as conflicts instead.
+ */
+class DesiredStateReconciler : public QObject
+{
+    Q_OBJECT
+
+public:
+    DesiredStateReconciler(ShareManager *shareManager, MountManager *mountManager, QObject *parent = nullptr);
+    ~DesiredStateReconciler();
+
+    /**
+     * @brief Collect the desired state from the stored configuration
+     * @param configuration The configuration manager
+     */
+    static DesiredState desiredStateOf(ConfigurationManager *configuration);
+
+    /**
+     * @brief Read the current exports, mounts and fstab
+     */
+    ObservedState observe() const;
+
+    /**
+     * @brief Compute the plan for a desired state against the live system (dry run)
+     * @param desired The desired state
+     */
+    ReconcilePlan plan(const DesiredState &desired) const;
+
+    /**
+     * @brief Start applying a plan; finished() reports the outcome
+     *
+     * Export changes succeed or fail together; a failed mount or fstab step
+     * does not stop the remaining ones.
+     *
+     * @param plan Plan from plan()
+     * @return False if another plan is still being applied
+     */
+    bool execute(const ReconcilePlan &plan);
+
+    /**
+     * @brief Check if a plan is being applied
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Set the fstab file (for testing)
+     * @param filePath Replacement for "/etc/fstab"
+     */
+    void setFstabPath(const QString &filePath);
+
+    /**
+     * @brief Set the kernel mount table (for testing)
+     * @param filePath Replacement for "/proc/self/mounts"
+     */
+    void setMountTablePath(const QString &filePath);
+
+    /**
+     * @brief Compute the plan that turns one state into the other
+     * @param desired The desired state
+     * @param observed The observed state
+     */
+    static ReconcilePlan computePlan(const DesiredState &desired, const ObservedState &observed);
+
+    /**
+     * @brief Parse the NFS entries of fstab or /proc/self/mounts
+     * @param content Table content
+     * @return NFS entries in file order
+     */
+    static QList<MountTableEntry> parseMountTable(const QString &content);
+
+    /**
+     * @brief Get the fstab options that describe a mount
+     * @param mount The mount
+     */
+    static QStringList fstabOptions(const NFSMount &mount);
+
+signals:
+    /**
+     * @brief Emitted while execute() runs
+     * @param progress Progress value (0-100)
+     * @param statusMessage Current step
+     */
+    void progress(int progress, const QString &statusMessage);
+
+    /**
+     * @brief Emitted when execute() has applied every step it could
+     * @param result What was applied
+     */
+    void finished(const ReconcileResult &result);
+
+private:
+    /**
+     * @brief Where execute() is in the plan
+     */
+    enum class Phase {
+        Idle,           ///< No plan running
+        Unmounting,     ///< Waiting for the unmount batch
+        Exporting,      ///< Waiting for the export transaction
+        Mounting        ///< Waiting for the mount batch
+    };
+
+    /**
+     * @brief Hand the Unmount or Mount steps of the plan to MountManager as one batch
+     */
+    void startMountBatch(PlanStep::Action action);
+
+    /**
+     * @brief Apply the fstab steps of the plan and start its export transaction
+     * @return True if the export transaction was started; its result comes later
+     */
+    bool applyFileSteps();
+
+    /**
+     * @brief Record the export transaction and move on to the mounts
+     */
+    void onExportBatchFinished(const ExportBatchResult &batch);
+
+    /**
+     * @brief Move on once the current mount batch has reported every entry
+     */
+    void onMountBatchFinished();
+
+    /**
+     * @brief Record the result of one entry of the current mount batch
+     */
+    void finishMountStep(const QString &mountPoint, const QString &error);
+
+    /**
+     * @brief Emit progress for one more finished step
+     */
+    void reportStep(const QString &statusMessage, int steps = 1);
+
+    ShareManager *m_shareManager;   ///< Applies export changes
+    MountManager *m_mountManager;   ///< Applies mount and fstab changes
+    QString m_fstabPath;            ///< Persistent mount table
+    QString m_mountTablePath;       ///< Kernel mount table
+
+    Phase m_phase;                  ///< Progress of the running plan
+    ReconcilePlan m_plan;           ///< Plan being applied
+    ReconcileResult m_result;       ///< Outcome so far
+    int m_finishedSteps;            ///< Steps done, for progress
+    QSet<QString> m_pendingMounts;  ///< Mount points of the current batch without a result
+    int m_mountBatch;               ///< Id of the current mount batch, 0 if none
+};
+
+} // namespace NFSShareManager
+
+Q_DECLARE_METATYPE(NFSShareManager::ReconcileResult)
@@ -0,0 +1,297 @@
+#include "exportreconciler.h"
+#include "../core/shareconfiguration.h"
+#include "../system/octalescape.h"
+#include <QDir>
+#include <QFile>
+#include <QMap>
+#include <QRegularExpression>
+#include <QDebug>
+#include <algorithm>
+#include <sys/stat.h>
+
+namespace NFSShareManager {
+
+namespace {
+
+/**
+ * @brief Client specifications of one path, options sorted for comparison
+ */
+using ClientMap = QMap<QString, QStringList>;
+
+/**
+ * @brief Split a "client(options)" specification
+ */
+KernelExport parseClientSpec(const QString &path, const QString &spec)
+{
+    const int open = spec.indexOf('(');
+    if (open < 0) {
+        return KernelExport(path, spec, QStringList());
+    }
+
+    const int close = spec.lastIndexOf(')');
+    const QString options = spec.mid(open + 1, close > open ? close - open - 1 : -1);
+    QString client = spec.left(open);
+    if (client.isEmpty()) {
+        client = "*";
+    }
+    return KernelExport(path, client, options.split(',', Qt::SkipEmptyParts));
+}
+
+QString formatClients(const ClientMap &clients)
+{
+    QStringList specs;
+    for (auto it = clients.constBegin(); it != clients.constEnd(); ++it) {
+        specs << QString("%1(%2)").arg(it.key(), it.value().join(','));
+    }
+    return specs.join(' ');
+}
+
+/**
+ * @brief Check that the kernel applies everything the share asks for
+ *
+ * etab lists the effective options, kernel defaults included, so the
+ * share's options only need to be a subset for each client.
+ */
+bool clientsMatch(const ClientMap &expected, const ClientMap &actual)
+{
+    if (expected.size() != actual.size()) {
+        return false;
+    }
+
+    for (auto it = expected.constBegin(); it != expected.constEnd(); ++it) {
+        auto actualIt = actual.constFind(it.key());
+        if (actualIt == actual.constEnd()) {
+            return false;
+        }
+        const QStringList &actualOptions = actualIt.value();
+        for (const QString &option : it.value()) {
+            if (!std::binary_search(actualOptions.cbegin(), actualOptions.cend(), option)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+ExportReconciler::ExportReconciler()
+    : m_etabPath("/var/lib/nfs/etab")
+    , m_dirty(true)
+{
+}
+
+void ExportReconciler::setEtabPath(const QString &filePath)
+{
+    m_etabPath = filePath;
+    m_lastStamp = FileStamp();
+    m_dirty = true;
+}
+
+QString ExportReconciler::etabPath() const
+{
+    return m_etabPath;
+}
+
+bool ExportReconciler::isEtabAvailable() const
+{
+    FileStamp stamp;
+    return stampOf(m_etabPath, &stamp);
+}
+
+void ExportReconciler::invalidate()
+{
+    m_dirty = true;
+}
+
+bool ExportReconciler::needsReconcile() const
+{
+    if (m_dirty) {
+        return true;
+    }
+
+    // A missing etab is an empty table (nfs-server never started)
+    FileStamp stamp;
+    stampOf(m_etabPath, &stamp);
+    return !(stamp == m_lastStamp);
+}
+
+ExportDriftDelta ExportReconciler::reconcile(const QList<NFSShare> &managed)
+{
+    FileStamp stamp;
+    QString content;
+
+    if (stampOf(m_etabPath, &stamp)) {
+        QFile file(m_etabPath);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qWarning() << "Failed to read kernel export table" << m_etabPath << ":" << file.errorString();
+            return ExportDriftDelta();
+        }
+        content = QString::fromUtf8(file.readAll());
+    }
+
+    m_lastStamp = stamp;
+    return reconcile(managed, parseExportTable(content));
+}
+
+ExportDriftDelta ExportReconciler::reconcile(const QList<NFSShare> &managed, const QList<KernelExport> &kernelExports)
+{
+    m_dirty = false;
+
+    ExportDriftDelta delta;
+    QHash<QString, ExportDrift> drift;
+
+    for (const ExportDrift &entry : diff(managed, kernelExports)) {
+        drift.insert(entry.path, entry);
+        auto previous = m_drift.constFind(entry.path);
+        if (previous == m_drift.constEnd() || previous.value() != entry) {
+            delta.detected << entry;
+        }
+    }
+
+    for (auto it = m_drift.constBegin(); it != m_drift.constEnd(); ++it) {
+        if (!drift.contains(it.key())) {
+            delta.resolved << it.key();
+        }
+    }
+    delta.resolved.sort();
+
+    m_drift = drift;
+    return delta;
+}
+
+QList<ExportDrift> ExportReconciler::currentDrift() const
+{
+    QList<ExportDrift> drift = m_drift.values();
+    std::sort(drift.begin(), drift.end(), [](const ExportDrift &a, const ExportDrift &b) {
+        return a.path < b.path;
+    });
+    return drift;
+}
+
+QList<ExportDrift> ExportReconciler::diff(const QList<NFSShare> &managed, const QList<KernelExport> &kernelExports)
+{
+    // Expected side: one entry per managed path, sorted
+    QList<QPair<QString, ClientMap>> expected;
+    expected.reserve(managed.size());
+    for (const NFSShare &share : managed) {
+        const QString path = QDir::cleanPath(share.path());
+        ClientMap clients;
+        const QList<KernelExport> specs = parseExportTable(share.config().toExportLine(path));
+        for (const KernelExport &spec : specs) {
+            QStringList options = spec.options;
+            options.sort();
+            clients.insert(spec.client, options);
+        }
+        expected.append(qMakePair(path, clients));
+    }
+    std::sort(expected.begin(), expected.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    // Actual side: kernel entries sorted by path, one entry per client
+    QList<KernelExport> actual = kernelExports;
+    std::stable_sort(actual.begin(), actual.end(), [](const KernelExport &a, const KernelExport &b) {
+        return a.path < b.path;
+    });
+
+    QList<ExportDrift> result;
+    int i = 0;
+    int j = 0;
+    while (i < expected.size() || j < actual.size()) {
+        // Group the kernel entries of the current path
+        QString actualPath;
+        ClientMap actualClients;
+        int next = j;
+        if (j < actual.size()) {
+            actualPath = actual[j].path;
+            while (next < actual.size() && actual[next].path == actualPath) {
+                QStringList options = actual[next].options;
+                options.sort();
+                actualClients.insert(actual[next].client, options);
+                ++next;
+            }
+        }
+
+        if (j >= actual.size() || (i < expected.size() && expected[i].first < actualPath)) {
+            result << ExportDrift(ExportDrift::Kind::Missing, expected[i].first,
+                                  formatClients(expected[i].second), QString());
+            ++i;
+        } else if (i >= expected.size() || actualPath < expected[i].first) {
+            result << ExportDrift(ExportDrift::Kind::Extra, actualPath,
+                                  QString(), formatClients(actualClients));
+            j = next;
+        } else {
+            if (!clientsMatch(expected[i].second, actualClients)) {
+                result << ExportDrift(ExportDrift::Kind::OptionsDrifted, actualPath,
+                                      formatClients(expected[i].second), formatClients(actualClients));
+            }
+            ++i;
+            j = next;
+        }
+    }
+
+    return result;
+}
+
+QList<KernelExport> ExportReconciler::parseExportTable(const QString &content)
+{
+    static const QRegularExpression whitespace("\\s+");
+
+    QList<KernelExport> exports;
+    QString pendingPath;
+
+    const QStringList lines = content.split('\n', Qt::SkipEmptyParts);
+    for (const QString &line : lines) {
+        const QString trimmed = line.trimmed();
+        if (trimmed.isEmpty() || trimmed.startsWith('#')) {
+            continue;
+        }
+
+        QString path;
+        QString rest;
+        if (trimmed.startsWith('"')) {
+            const int end = trimmed.indexOf('"', 1);
+            path = end > 0 ? trimmed.mid(1, end - 1) : trimmed.mid(1);
+            rest = end > 0 ? trimmed.mid(end + 1) : QString();
+        } else if (trimmed.startsWith('/')) {
+            const int end = trimmed.indexOf(whitespace);
+            path = OctalEscape::unescape(end > 0 ? trimmed.left(end) : trimmed);
+            rest = end > 0 ? trimmed.mid(end) : QString();
+        } else if (!pendingPath.isEmpty()) {
+            path = pendingPath;
+            rest = trimmed;
+        } else {
+            continue;
+        }
+
+        const QStringList fields = rest.split(whitespace, Qt::SkipEmptyParts);
+
+        if (fields.isEmpty()) {
+            // exportfs -v puts long paths on a line of their own
+            pendingPath = path;
+            continue;
+        }
+        pendingPath.clear();
+
+        for (const QString &spec : fields) {
+            exports << parseClientSpec(path, spec);
+        }
+    }
+
+    return exports;
+}
+
+bool ExportReconciler::stampOf(const QString &filePath, FileStamp *stamp)
+{
+    struct stat st;
+    if (::stat(QFile::encodeName(filePath).constData(), &st) != 0) {
+        return false;
+    }
+    stamp->inode = static_cast<quint64>(st.st_ino);
+    stamp->size = static_cast<qint64>(st.st_size);
+    stamp->mtimeNs = static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+} // namespace NFSShareManager
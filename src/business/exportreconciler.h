@@ -0,0 +1,175 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include "../core/nfsshare.h"
+
+namespace NFSShareManager {
+
+/**
+ * @brief One client entry of the kernel export table
+ */
+struct KernelExport {
+    QString path;       ///< Exported directory
+    QString client;     ///< Client specification (host, network or wildcard)
+    QStringList options; ///< Effective export options, including kernel defaults
+
+    KernelExport() = default;
+    KernelExport(const QString &p, const QString &c, const QStringList &o)
+        : path(p), client(c), options(o) {}
+};
+
+/**
+ * @brief Difference between a managed share and the kernel export table
+ */
+struct ExportDrift {
+    /**
+     * @brief Kind of difference
+     */
+    enum class Kind {
+        Missing,        ///< Managed share is not exported by the kernel
+        Extra,          ///< Kernel exports a path no share manages
+        OptionsDrifted  ///< Exported, but clients or options differ
+    };
+
+    Kind kind;              ///< Kind of difference
+    QString path;           ///< Exported directory
+    QString expected;       ///< Client specification the share asks for
+    QString actual;         ///< Client specification the kernel uses
+
+    ExportDrift() : kind(Kind::Missing) {}
+    ExportDrift(Kind k, const QString &p, const QString &e, const QString &a)
+        : kind(k), path(p), expected(e), actual(a) {}
+
+    bool operator==(const ExportDrift &other) const
+    {
+        return kind == other.kind && path == other.path &&
+               expected == other.expected && actual == other.actual;
+    }
+    bool operator!=(const ExportDrift &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Change in drift since the previous reconcile pass
+ */
+struct ExportDriftDelta {
+    QList<ExportDrift> detected;    ///< New or changed drift entries
+    QStringList resolved;           ///< Paths that are back in sync
+
+    bool isEmpty() const { return detected.isEmpty() && resolved.isEmpty(); }
+};
+
+/**
+ * @brief Compares the managed shares with the live kernel export table
+ *
+ * The kernel table is read from the etab file maintained by exportfs
+ * (/var/lib/nfs/etab), which is world-readable and lists every client of
+ * every export with its effective options. A pass sorts both sides by path
+ * and merges them, classifying each path as missing, extra or drifted, and
+ * reports only what changed since the previous pass.
+ *
+ * needsReconcile() makes polling cheap: when neither the etab file
+ * (inode, size, mtime) nor the managed set has changed since the last
+ * pass, it answers from a single stat() without reading anything.
+ */
+class ExportReconciler
+{
+public:
+    ExportReconciler();
+
+    /**
+     * @brief Set the kernel export table file
+     * @param filePath Path to etab (default: /var/lib/nfs/etab)
+     */
+    void setEtabPath(const QString &filePath);
+
+    /**
+     * @brief Get the kernel export table file
+     */
+    QString etabPath() const;
+
+    /**
+     * @brief Check if the kernel export table file can be read
+     */
+    bool isEtabAvailable() const;
+
+    /**
+     * @brief Mark the managed set as changed so the next pass runs
+     */
+    void invalidate();
+
+    /**
+     * @brief Check if a pass would see anything new
+     *
+     * Only stats etab; false means reconcile() would report no changes.
+     */
+    bool needsReconcile() const;
+
+    /**
+     * @brief Reconcile the managed shares against etab
+     * @param managed The managed shares
+     * @return Drift changes since the previous pass
+     */
+    ExportDriftDelta reconcile(const QList<NFSShare> &managed);
+
+    /**
+     * @brief Reconcile the managed shares against an already parsed table
+     *
+     * Used when etab is not available and the table came from "exportfs -v".
+     *
+     * @param managed The managed shares
+     * @param kernelExports The live export table
+     * @return Drift changes since the previous pass
+     */
+    ExportDriftDelta reconcile(const QList<NFSShare> &managed, const QList<KernelExport> &kernelExports);
+
+    /**
+     * @brief Get the drift found by the last pass
+     */
+    QList<ExportDrift> currentDrift() const;
+
+    /**
+     * @brief Compute the drift between managed shares and an export table
+     * @param managed The managed shares
+     * @param kernelExports The live export table
+     * @return Drift entries sorted by path
+     */
+    static QList<ExportDrift> diff(const QList<NFSShare> &managed, const QList<KernelExport> &kernelExports);
+
+    /**
+     * @brief Parse etab or "exportfs -v" output
+     *
+     * Accepts one "path client(options)" entry per line. A path on a line
+     * of its own (exportfs -v wraps long paths) applies to the next line.
+     *
+     * @param content Table content
+     * @return Parsed entries in file order
+     */
+    static QList<KernelExport> parseExportTable(const QString &content);
+
+private:
+    struct FileStamp {
+        quint64 inode = 0;
+        qint64 size = -1;
+        qint64 mtimeNs = 0;
+
+        bool operator==(const FileStamp &other) const
+        {
+            return inode == other.inode && size == other.size && mtimeNs == other.mtimeNs;
+        }
+    };
+
+    static bool stampOf(const QString &filePath, FileStamp *stamp);
+
+    QString m_etabPath;                       ///< Kernel export table file
+    FileStamp m_lastStamp;                    ///< etab state at the last pass
+    bool m_dirty;                             ///< Managed set changed since the last pass
+    QHash<QString, ExportDrift> m_drift;      ///< Drift found by the last pass, by path
+};
+
+} // namespace NFSShareManager
+
+Q_DECLARE_METATYPE(NFSShareManager::ExportDriftDelta)
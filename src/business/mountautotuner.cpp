@@ -0,0 +1,447 @@
+#include "mountautotuner.h"
+#include "../system/nfsserviceinterface.h"
+#include "../system/toolregistry.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace NFSShareManager {
+
+namespace {
+
+constexpr qint64 BenchmarkBlockSize = 1024 * 1024;
+
+/**
+ * @brief Open a file for the sequential test, preferring O_DIRECT
+ *
+ * O_DIRECT keeps the client page cache out of the measurement; if the
+ * mount refuses it the test falls back to buffered I/O plus fsync.
+ */
+int openForBenchmark(const QByteArray &path, int flags, bool *direct)
+{
+    int fd = ::open(path.constData(), flags | O_DIRECT | O_CLOEXEC, 0600);
+    *direct = fd >= 0;
+    if (fd < 0 && errno == EINVAL) {
+        fd = ::open(path.constData(), flags | O_CLOEXEC, 0600);
+    }
+    return fd;
+}
+
+double megabytesPerSecond(qint64 bytes, qint64 elapsedMs)
+{
+    return elapsedMs > 0 ? (bytes / (1024.0 * 1024.0)) / (elapsedMs / 1000.0) : 0.0;
+}
+
+} // namespace
+
+QStringList TuningCandidate::mountOptions() const
+{
+    QStringList options;
+    options << QString("rsize=%1").arg(rsize) << QString("wsize=%1").arg(wsize);
+    if (nconnect > 1) {
+        options << QString("nconnect=%1").arg(nconnect);
+    }
+    return options;
+}
+
+QString TuningCandidate::label() const
+{
+    return QString("NFS %1, rsize/wsize %2 KiB, nconnect %3")
+        .arg(nfsVersionToString(nfsVersion))
+        .arg(rsize / 1024)
+        .arg(nconnect);
+}
+
+MountAutotuner::MountAutotuner(NFSServiceInterface *nfsService, QObject *parent)
+    : QObject(parent)
+    , m_nfsService(nfsService)
+    , m_sequentialTestSize(64 * 1024 * 1024)
+    , m_metadataTestFiles(200)
+    , m_cancelled(false)
+    , m_running(false)
+{
+    qRegisterMetaType<TuningResult>("TuningResult");
+    m_pool.setMaxThreadCount(1);
+
+    QString configDir = QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
+    if (!configDir.isEmpty()) {
+        m_settingsFilePath = configDir + "/mounttuning.ini";
+    }
+}
+
+MountAutotuner::~MountAutotuner()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+bool MountAutotuner::start(const RemoteNFSShare &remoteShare)
+{
+    if (m_running.exchange(true)) {
+        return false;
+    }
+    m_cancelled = false;
+
+    m_pool.start([this, remoteShare]() {
+        const TuningResult result = search(remoteShare);
+        QMetaObject::invokeMethod(this, [this, remoteShare, result]() {
+            m_running = false;
+            emit finished(remoteShare, result);
+        }, Qt::QueuedConnection);
+    });
+    return true;
+}
+
+bool MountAutotuner::isRunning() const
+{
+    return m_running;
+}
+
+TuningResult MountAutotuner::tune(const RemoteNFSShare &remoteShare)
+{
+    m_cancelled = false;
+    return search(remoteShare);
+}
+
+TuningResult MountAutotuner::search(const RemoteNFSShare &remoteShare)
+{
+    // Stage 1: protocol version at the largest transfer size
+    QList<NFSVersion> versions;
+    if (remoteShare.supportedVersion() == NFSVersion::Version3) {
+        versions << NFSVersion::Version3;
+    } else {
+        versions << NFSVersion::Version4_2 << NFSVersion::Version4_1 << NFSVersion::Version4;
+    }
+    const QList<int> transferSizes = {1048576, 262144, 65536};
+    QList<int> connectionCounts = {1};
+    if (ToolRegistry::instance().hasFeature("mount.nfs", ToolRegistry::FeatureNconnect)
+        || ToolRegistry::instance().hasFeature("mount", ToolRegistry::FeatureNconnect)) {
+        connectionCounts << 4 << 8;
+    }
+
+    const int total = versions.size() + transferSizes.size() - 1 + connectionCounts.size() - 1;
+    int current = 0;
+
+    auto runStage = [&](const QList<TuningCandidate> &candidates) -> QList<TuningResult> {
+        QList<TuningResult> results;
+        for (const TuningCandidate &candidate : candidates) {
+            if (m_cancelled) {
+                break;
+            }
+            emit progress(++current, total, candidate.label());
+            TuningResult result = benchmark(remoteShare, candidate);
+            emit candidateMeasured(result);
+            results << result;
+        }
+        return results;
+    };
+
+    QList<TuningCandidate> stage;
+    for (NFSVersion version : versions) {
+        TuningCandidate candidate;
+        candidate.nfsVersion = version;
+        stage << candidate;
+    }
+    QList<TuningResult> stageResults = runStage(stage);
+    const TuningResult *best = bestOf(stageResults);
+    if (!best) {
+        TuningResult failed;
+        failed.errorMessage = m_cancelled ? tr("Tuning was cancelled")
+                                          : tr("No candidate could be mounted and measured");
+        return failed;
+    }
+    TuningResult winner = *best;
+
+    // Stage 2: transfer size with the chosen version (the largest was already measured)
+    stage.clear();
+    for (int size : transferSizes.mid(1)) {
+        TuningCandidate candidate = winner.candidate;
+        candidate.rsize = size;
+        candidate.wsize = size;
+        stage << candidate;
+    }
+    stageResults = runStage(stage);
+    stageResults.prepend(winner);
+    winner = *bestOf(stageResults);
+
+    // Stage 3: number of TCP connections
+    stage.clear();
+    for (int connections : connectionCounts.mid(1)) {
+        TuningCandidate candidate = winner.candidate;
+        candidate.nconnect = connections;
+        stage << candidate;
+    }
+    stageResults = runStage(stage);
+    stageResults.prepend(winner);
+    winner = *bestOf(stageResults);
+
+    qDebug() << "Mount autotuning for" << serverKey(remoteShare) << "selected" << winner.candidate.label()
+             << "read" << winner.readMBps << "MB/s write" << winner.writeMBps << "MB/s metadata"
+             << winner.metadataOpsPerSecond << "ops/s";
+
+    if (m_cancelled) {
+        // The stages were not all measured; nothing is stored
+        winner.success = false;
+        winner.errorMessage = tr("Tuning was cancelled");
+        return winner;
+    }
+    saveTunedOptions(serverKey(remoteShare), winner);
+    return winner;
+}
+
+TuningResult MountAutotuner::benchmark(const RemoteNFSShare &remoteShare, const TuningCandidate &candidate)
+{
+    TuningResult result;
+    result.candidate = candidate;
+
+    if (!m_nfsService) {
+        result.errorMessage = tr("NFS service interface not available");
+        return result;
+    }
+
+    QTemporaryDir mountDir(QDir::tempPath() + "/nfs-autotune-XXXXXX");
+    if (!mountDir.isValid()) {
+        result.errorMessage = tr("Failed to create temporary mount point");
+        return result;
+    }
+
+    NFSCommandResult mountResult = m_nfsService->mountNFSShare(remoteShare.serverAddress(), remoteShare.exportPath(),
+                                                               mountDir.path(), candidate.mountOptions(),
+                                                               candidate.nfsVersion);
+    if (!mountResult.success) {
+        result.errorMessage = tr("Mount failed: %1").arg(mountResult.error.trimmed());
+        return result;
+    }
+
+    runBenchmark(mountDir.path(), result);
+
+    NFSCommandResult unmountResult = m_nfsService->unmountNFSShare(mountDir.path());
+    if (!unmountResult.success) {
+        // Never let QTemporaryDir recurse into a still mounted export
+        qWarning() << "Failed to unmount autotune mount" << mountDir.path() << ":" << unmountResult.error;
+        mountDir.setAutoRemove(false);
+    }
+
+    result.score = computeScore(result);
+    return result;
+}
+
+void MountAutotuner::runBenchmark(const QString &directory, TuningResult &result) const
+{
+    const QString workDir = QString("%1/.nfs-share-manager-autotune-%2").arg(directory).arg(QCoreApplication::applicationPid());
+    const QByteArray workDirPath = QFile::encodeName(workDir);
+    QElapsedTimer timer;
+
+    if (::mkdir(workDirPath.constData(), 0700) != 0) {
+        // Read-only export: rank on directory listing and attribute lookups only
+        DIR *dir = ::opendir(QFile::encodeName(directory).constData());
+        if (!dir) {
+            result.errorMessage = tr("Export is not readable");
+            return;
+        }
+        int operations = 0;
+        timer.start();
+        struct dirent *entry;
+        while ((entry = ::readdir(dir)) != nullptr && operations < m_metadataTestFiles) {
+            struct stat st;
+            QByteArray entryPath = QFile::encodeName(directory) + '/' + entry->d_name;
+            ::lstat(entryPath.constData(), &st);
+            ++operations;
+        }
+        ::closedir(dir);
+        result.metadataOpsPerSecond = operations * 1000.0 / qMax<qint64>(1, timer.elapsed());
+        result.success = operations > 0;
+        return;
+    }
+
+    void *buffer = nullptr;
+    if (::posix_memalign(&buffer, 4096, BenchmarkBlockSize) != 0) {
+        result.errorMessage = tr("Out of memory");
+        ::rmdir(workDirPath.constData());
+        return;
+    }
+    std::memset(buffer, 0x5a, BenchmarkBlockSize);
+
+    const QByteArray dataFile = workDirPath + "/sequential";
+    bool direct = false;
+
+    // Sequential write
+    int fd = openForBenchmark(dataFile, O_WRONLY | O_CREAT | O_TRUNC, &direct);
+    if (fd >= 0) {
+        qint64 written = 0;
+        timer.start();
+        while (written < m_sequentialTestSize) {
+            ssize_t n = ::write(fd, buffer, BenchmarkBlockSize);
+            if (n <= 0) {
+                break;
+            }
+            written += n;
+        }
+        ::fsync(fd);
+        result.writeMBps = megabytesPerSecond(written, timer.elapsed());
+        ::close(fd);
+    }
+
+    // Sequential read
+    fd = openForBenchmark(dataFile, O_RDONLY, &direct);
+    if (fd >= 0) {
+        if (!direct) {
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        }
+        qint64 totalRead = 0;
+        timer.start();
+        for (;;) {
+            ssize_t n = ::read(fd, buffer, BenchmarkBlockSize);
+            if (n <= 0) {
+                break;
+            }
+            totalRead += n;
+        }
+        result.readMBps = megabytesPerSecond(totalRead, timer.elapsed());
+        ::close(fd);
+    }
+    ::unlink(dataFile.constData());
+    std::free(buffer);
+
+    // Metadata: create, stat and unlink small files
+    int operations = 0;
+    timer.start();
+    for (int i = 0; i < m_metadataTestFiles; ++i) {
+        QByteArray path = workDirPath + "/m" + QByteArray::number(i);
+        int metaFd = ::open(path.constData(), O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+        if (metaFd < 0) {
+            break;
+        }
+        ::close(metaFd);
+        struct stat st;
+        ::stat(path.constData(), &st);
+        ::unlink(path.constData());
+        operations += 3;
+    }
+    result.metadataOpsPerSecond = operations * 1000.0 / qMax<qint64>(1, timer.elapsed());
+
+    ::rmdir(workDirPath.constData());
+    result.success = result.writeMBps > 0.0 || result.readMBps > 0.0 || operations > 0;
+    if (!result.success) {
+        result.errorMessage = tr("Benchmark could not write to the export");
+    }
+}
+
+double MountAutotuner::computeScore(const TuningResult &result)
+{
+    double logSum = 0.0;
+    int figures = 0;
+    for (double figure : {result.readMBps, result.writeMBps, result.metadataOpsPerSecond}) {
+        if (figure > 0.0) {
+            logSum += std::log(figure);
+            ++figures;
+        }
+    }
+    return figures > 0 ? std::exp(logSum / figures) : 0.0;
+}
+
+const TuningResult *MountAutotuner::bestOf(const QList<TuningResult> &results)
+{
+    const TuningResult *best = nullptr;
+    for (const TuningResult &result : results) {
+        if (result.success && (!best || result.score > best->score)) {
+            best = &result;
+        }
+    }
+    return best;
+}
+
+void MountAutotuner::cancel()
+{
+    m_cancelled = true;
+}
+
+void MountAutotuner::setSequentialTestSize(qint64 bytes)
+{
+    m_sequentialTestSize = qMax<qint64>(BenchmarkBlockSize, bytes);
+}
+
+void MountAutotuner::setMetadataTestFiles(int files)
+{
+    m_metadataTestFiles = qMax(1, files);
+}
+
+bool MountAutotuner::loadTunedOptions(const QString &serverKey, TuningCandidate *candidate) const
+{
+    if (m_settingsFilePath.isEmpty() || serverKey.isEmpty()) {
+        return false;
+    }
+
+    QSettings settings(m_settingsFilePath, QSettings::IniFormat);
+    settings.beginGroup(QString("servers/%1").arg(QString(serverKey).replace('/', '_')));
+    if (!settings.contains("rsize")) {
+        return false;
+    }
+    if (candidate) {
+        candidate->nfsVersion = stringToNFSVersion(settings.value("nfsVersion").toString());
+        candidate->rsize = settings.value("rsize").toInt();
+        candidate->wsize = settings.value("wsize").toInt();
+        candidate->nconnect = settings.value("nconnect", 1).toInt();
+    }
+    return true;
+}
+
+void MountAutotuner::saveTunedOptions(const QString &serverKey, const TuningResult &result)
+{
+    if (m_settingsFilePath.isEmpty() || serverKey.isEmpty()) {
+        return;
+    }
+
+    QDir().mkpath(QFileInfo(m_settingsFilePath).absolutePath());
+    QSettings settings(m_settingsFilePath, QSettings::IniFormat);
+    settings.beginGroup(QString("servers/%1").arg(QString(serverKey).replace('/', '_')));
+    settings.setValue("nfsVersion", nfsVersionToString(result.candidate.nfsVersion));
+    settings.setValue("rsize", result.candidate.rsize);
+    settings.setValue("wsize", result.candidate.wsize);
+    settings.setValue("nconnect", result.candidate.nconnect);
+    settings.setValue("readMBps", result.readMBps);
+    settings.setValue("writeMBps", result.writeMBps);
+    settings.setValue("metadataOpsPerSecond", result.metadataOpsPerSecond);
+    settings.setValue("tunedAt", QDateTime::currentDateTime());
+    settings.endGroup();
+    settings.sync();
+}
+
+void MountAutotuner::clearTunedOptions(const QString &serverKey)
+{
+    if (m_settingsFilePath.isEmpty()) {
+        return;
+    }
+    QSettings settings(m_settingsFilePath, QSettings::IniFormat);
+    settings.remove(QString("servers/%1").arg(QString(serverKey).replace('/', '_')));
+}
+
+void MountAutotuner::setSettingsFilePath(const QString &filePath)
+{
+    m_settingsFilePath = filePath;
+}
+
+QString MountAutotuner::serverKey(const RemoteNFSShare &remoteShare)
+{
+    if (!remoteShare.hostAddress().isNull()) {
+        return remoteShare.hostAddress().toString();
+    }
+    return remoteShare.hostName();
+}
+
+} // namespace NFSShareManager
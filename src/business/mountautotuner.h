@@ -0,0 +1,220 @@
+#pragma once
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QThreadPool>
+#include <atomic>
+#include "../core/types.h"
+#include "../core/nfsmount.h"
+#include "../core/remotenfsshare.h"
+
+namespace NFSShareManager {
+
+class NFSServiceInterface;
+
+/**
+ * @brief One set of mount options tried by the autotuner
+ */
+struct TuningCandidate {
+    NFSVersion nfsVersion;   ///< NFS protocol version
+    int rsize;               ///< Read transfer size in bytes
+    int wsize;               ///< Write transfer size in bytes
+    int nconnect;            ///< Number of TCP connections (1 = option not used)
+
+    TuningCandidate() : nfsVersion(NFSVersion::Version4), rsize(1048576), wsize(1048576), nconnect(1) {}
+
+    /**
+     * @brief Get the extra mount options for this candidate
+     * @return rsize/wsize/nconnect options; the version is passed separately
+     */
+    QStringList mountOptions() const;
+
+    /**
+     * @brief Get a short human-readable description
+     */
+    QString label() const;
+};
+
+/**
+ * @brief Benchmark outcome for one candidate
+ */
+struct TuningResult {
+    TuningCandidate candidate;      ///< Options that were measured
+    bool success;                   ///< Whether the candidate could be mounted and measured
+    QString errorMessage;           ///< Reason for failure
+    double readMBps;                ///< Sequential O_DIRECT read throughput
+    double writeMBps;               ///< Sequential O_DIRECT write throughput
+    double metadataOpsPerSecond;    ///< create/stat/unlink operations per second
+    double score;                   ///< Combined score used to rank candidates
+
+    TuningResult() : success(false), readMBps(0.0), writeMBps(0.0), metadataOpsPerSecond(0.0), score(0.0) {}
+};
+
+/**
+ * @brief Measured mount-option autotuner
+ *
+ * Mounts the remote share on a temporary directory with a series of
+ * candidate option sets, runs a short sequential read/write and metadata
+ * micro-benchmark on each and keeps the best set per server. The search is
+ * staged (NFS version, then transfer size, then nconnect) so only a
+ * handful of mounts are needed. Results are persisted and picked up by
+ * MountManager::getDefaultMountOptions() for later mounts of the server.
+ *
+ * Tuning needs permission to mount and, for the write and metadata tests,
+ * a writable export. Read-only exports are ranked on metadata reads only.
+ *
+ * start() runs the search on a worker thread and reports through
+ * progress(), candidateMeasured() and finished(); tune() is the same
+ * search on the calling thread.
+ */
+class MountAutotuner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MountAutotuner(NFSServiceInterface *nfsService, QObject *parent = nullptr);
+    ~MountAutotuner();
+
+    /**
+     * @brief Start tuning mount options for a remote share; returns immediately
+     * @param remoteShare The share to benchmark
+     * @return False if a run is already in progress
+     */
+    bool start(const RemoteNFSShare &remoteShare);
+
+    /**
+     * @brief Check if a run started with start() is in progress
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Tune mount options for a remote share on the calling thread
+     *
+     * Blocks until all candidates were measured or cancel() was called.
+     *
+     * @param remoteShare The share to benchmark
+     * @return Best result; success is false if no candidate could be measured
+     *         or the run was cancelled
+     */
+    TuningResult tune(const RemoteNFSShare &remoteShare);
+
+    /**
+     * @brief Mount one candidate temporarily and benchmark it
+     * @param remoteShare The share to benchmark
+     * @param candidate The options to measure
+     * @return Benchmark result
+     */
+    TuningResult benchmark(const RemoteNFSShare &remoteShare, const TuningCandidate &candidate);
+
+    /**
+     * @brief Request cancellation of a running tune() or start() run
+     *
+     * The candidate being measured is finished first.
+     */
+    void cancel();
+
+    /**
+     * @brief Set the size of the sequential read/write test file
+     * @param bytes File size in bytes (default 64 MiB)
+     */
+    void setSequentialTestSize(qint64 bytes);
+
+    /**
+     * @brief Set the number of files used in the metadata test
+     * @param files Number of files (default 200)
+     */
+    void setMetadataTestFiles(int files);
+
+    /**
+     * @brief Get the persisted tuned options for a server
+     * @param serverKey Server address or hostname (see serverKey())
+     * @param candidate Output for the tuned options
+     * @return True if tuned options exist for the server
+     */
+    bool loadTunedOptions(const QString &serverKey, TuningCandidate *candidate) const;
+
+    /**
+     * @brief Persist tuned options for a server
+     * @param serverKey Server address or hostname (see serverKey())
+     * @param result Result to store
+     */
+    void saveTunedOptions(const QString &serverKey, const TuningResult &result);
+
+    /**
+     * @brief Forget the tuned options for a server
+     * @param serverKey Server address or hostname (see serverKey())
+     */
+    void clearTunedOptions(const QString &serverKey);
+
+    /**
+     * @brief Set the file tuned options are persisted to
+     * @param filePath Settings file (default: mounttuning.ini in the config directory)
+     */
+    void setSettingsFilePath(const QString &filePath);
+
+    /**
+     * @brief Get the key tuned options of a share's server are stored under
+     */
+    static QString serverKey(const RemoteNFSShare &remoteShare);
+
+    /**
+     * @brief Combine benchmark figures into a score
+     *
+     * Geometric mean of the measured figures, so no single figure dominates
+     * and figures that could not be measured are ignored.
+     */
+    static double computeScore(const TuningResult &result);
+
+signals:
+    /**
+     * @brief Emitted before each candidate is measured
+     * @param current Index of the candidate (1-based)
+     * @param total Upper bound of candidates in this run
+     * @param description Candidate description
+     */
+    void progress(int current, int total, const QString &description);
+
+    /**
+     * @brief Emitted after each candidate was measured
+     * @param result The benchmark result
+     */
+    void candidateMeasured(const TuningResult &result);
+
+    /**
+     * @brief Emitted when a run started with start() has ended
+     * @param remoteShare The share that was benchmarked
+     * @param result Best result; success is false if nothing could be measured
+     */
+    void finished(const RemoteNFSShare &remoteShare, const TuningResult &result);
+
+private:
+    /**
+     * @brief Run the staged search of tune() without resetting cancellation
+     */
+    TuningResult search(const RemoteNFSShare &remoteShare);
+
+    /**
+     * @brief Run the I/O benchmark in a mounted directory
+     */
+    void runBenchmark(const QString &directory, TuningResult &result) const;
+
+    /**
+     * @brief Pick the best successful result of a stage
+     */
+    static const TuningResult *bestOf(const QList<TuningResult> &results);
+
+    NFSServiceInterface *m_nfsService;   ///< Used to mount and unmount candidates
+    QString m_settingsFilePath;          ///< Persisted tuning results
+    qint64 m_sequentialTestSize;         ///< Sequential test file size in bytes
+    int m_metadataTestFiles;             ///< Files created in the metadata test
+    QThreadPool m_pool;                  ///< Runs start() off the calling thread
+    std::atomic<bool> m_cancelled;       ///< Cancellation requested
+    std::atomic<bool> m_running;         ///< A start() run is in progress
+};
+
+} // namespace NFSShareManager
+
+Q_DECLARE_METATYPE(NFSShareManager::TuningResult)
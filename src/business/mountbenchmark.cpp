@@ -0,0 +1,633 @@
+#include "mountbenchmark.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace NFSShareManager {
+
+namespace {
+
+constexpr int DirectIOAlignment = 4096;
+
+/// Request size of the readahead comparison, a typical application read
+constexpr int ReadAheadRequestSize = 64 * 1024;
+
+/**
+ * @brief Open a test file, preferring O_DIRECT so the page cache stays out of the measurement
+ */
+int openForBenchmark(const QByteArray &path, int flags, bool *direct)
+{
+    int fd = ::open(path.constData(), flags | O_DIRECT | O_CLOEXEC, 0600);
+    *direct = fd >= 0;
+    if (fd < 0 && errno == EINVAL) {
+        fd = ::open(path.constData(), flags | O_CLOEXEC, 0600);
+    }
+    if (fd >= 0 && !*direct) {
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    return fd;
+}
+
+/**
+ * @brief Allocate a buffer aligned for O_DIRECT and fill it with a pattern
+ */
+void *allocateBuffer(int size)
+{
+    void *buffer = nullptr;
+    if (::posix_memalign(&buffer, DirectIOAlignment, size) != 0) {
+        return nullptr;
+    }
+    std::memset(buffer, 0x5a, size);
+    return buffer;
+}
+
+int alignedSize(int bytes)
+{
+    return qMax(DirectIOAlignment, bytes / DirectIOAlignment * DirectIOAlignment);
+}
+
+qint64 nowNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double megabytesPerSecond(qint64 bytes, qint64 elapsedNs)
+{
+    return elapsedNs > 0 ? (bytes / (1024.0 * 1024.0)) / (elapsedNs / 1e9) : 0.0;
+}
+
+void writeLatency(QSettings &settings, const QString &prefix, const LatencyStats &stats)
+{
+    settings.setValue(prefix + "P50Us", stats.p50Us);
+    settings.setValue(prefix + "P95Us", stats.p95Us);
+    settings.setValue(prefix + "P99Us", stats.p99Us);
+    settings.setValue(prefix + "MaxUs", stats.maxUs);
+    settings.setValue(prefix + "Samples", stats.samples);
+}
+
+LatencyStats readLatency(const QSettings &settings, const QString &prefix)
+{
+    LatencyStats stats;
+    stats.p50Us = settings.value(prefix + "P50Us").toDouble();
+    stats.p95Us = settings.value(prefix + "P95Us").toDouble();
+    stats.p99Us = settings.value(prefix + "P99Us").toDouble();
+    stats.maxUs = settings.value(prefix + "MaxUs").toDouble();
+    stats.samples = settings.value(prefix + "Samples").toLongLong();
+    return stats;
+}
+
+QString historyKey(const QString &key)
+{
+    return QString(key).replace('/', '_');
+}
+
+} // namespace
+
+LatencyStats LatencyStats::fromSamples(std::vector<qint64> &nanoseconds)
+{
+    LatencyStats stats;
+    if (nanoseconds.empty()) {
+        return stats;
+    }
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    const auto percentile = [&nanoseconds](double p) {
+        const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * nanoseconds.size()));
+        return nanoseconds[std::min(nanoseconds.size(), std::max<size_t>(1, rank)) - 1] / 1000.0;
+    };
+    stats.p50Us = percentile(50.0);
+    stats.p95Us = percentile(95.0);
+    stats.p99Us = percentile(99.0);
+    stats.maxUs = nanoseconds.back() / 1000.0;
+    stats.samples = static_cast<qint64>(nanoseconds.size());
+    return stats;
+}
+
+int BenchmarkResult::bestReadAheadKb() const
+{
+    const auto best = std::max_element(readAheadSamples.cbegin(), readAheadSamples.cend(),
+                                       [](const ReadAheadSample &first, const ReadAheadSample &second) {
+        return first.readMBps < second.readMBps;
+    });
+    return best == readAheadSamples.cend() ? -1 : best->readAheadKb;
+}
+
+QString BenchmarkResult::summary() const
+{
+    if (!success) {
+        return errorMessage;
+    }
+    QStringList lines;
+    if (sequentialWriteMBps > 0.0 || sequentialReadMBps > 0.0) {
+        lines << QString("Sequential: write %1 MB/s, read %2 MB/s%3")
+                     .arg(sequentialWriteMBps, 0, 'f', 1)
+                     .arg(sequentialReadMBps, 0, 'f', 1)
+                     .arg(directIO ? QString(" (O_DIRECT)") : QString());
+    }
+    if (randomReadIops > 0.0 || randomWriteIops > 0.0) {
+        lines << QString("Random: read %1 IOPS (p50 %2 us, p99 %3 us), write %4 IOPS (p50 %5 us, p99 %6 us)")
+                     .arg(randomReadIops, 0, 'f', 0)
+                     .arg(randomReadLatency.p50Us, 0, 'f', 0)
+                     .arg(randomReadLatency.p99Us, 0, 'f', 0)
+                     .arg(randomWriteIops, 0, 'f', 0)
+                     .arg(randomWriteLatency.p50Us, 0, 'f', 0)
+                     .arg(randomWriteLatency.p99Us, 0, 'f', 0);
+    }
+    if (metadataOpsPerSecond > 0.0) {
+        lines << QString("Metadata: %1 ops/s (p50 %2 us, p99 %3 us)")
+                     .arg(metadataOpsPerSecond, 0, 'f', 0)
+                     .arg(metadataLatency.p50Us, 0, 'f', 0)
+                     .arg(metadataLatency.p99Us, 0, 'f', 0);
+    }
+    if (!readAheadSamples.isEmpty()) {
+        QStringList samples;
+        for (const ReadAheadSample &sample : readAheadSamples) {
+            samples << QString("%1 KiB %2 MB/s").arg(sample.readAheadKb).arg(sample.readMBps, 0, 'f', 1);
+        }
+        lines << QString("Readahead: %1 (best %2 KiB)").arg(samples.join(", ")).arg(bestReadAheadKb());
+    }
+    return lines.join('\n');
+}
+
+MountBenchmark::MountBenchmark(QObject *parent)
+    : QObject(parent)
+    , m_cancelled(false)
+    , m_running(false)
+    , m_stage(0)
+    , m_stages(0)
+{
+    qRegisterMetaType<BenchmarkResult>("BenchmarkResult");
+    m_pool.setMaxThreadCount(1);
+
+    QString configDir = QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
+    if (!configDir.isEmpty()) {
+        m_historyFilePath = configDir + "/mountbenchmarks.ini";
+    }
+}
+
+MountBenchmark::~MountBenchmark()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+bool MountBenchmark::start(const QString &mountPoint, const QString &serverKey, const BenchmarkConfig &config)
+{
+    if (m_running.exchange(true)) {
+        return false;
+    }
+    m_cancelled = false;
+
+    m_pool.start([this, mountPoint, serverKey, config]() {
+        BenchmarkResult result = execute(mountPoint, config);
+        result.serverKey = serverKey;
+        // History and the finished() signal belong to the object's thread
+        QMetaObject::invokeMethod(this, [this, result]() {
+            if (result.success && !result.cancelled) {
+                recordResult(result);
+            }
+            m_running = false;
+            emit finished(result);
+        }, Qt::QueuedConnection);
+    });
+    return true;
+}
+
+BenchmarkResult MountBenchmark::run(const QString &mountPoint, const BenchmarkConfig &config)
+{
+    m_cancelled = false;
+    return execute(mountPoint, config);
+}
+
+void MountBenchmark::cancel()
+{
+    m_cancelled = true;
+}
+
+bool MountBenchmark::isRunning() const
+{
+    return m_running;
+}
+
+BenchmarkResult MountBenchmark::execute(const QString &mountPoint, const BenchmarkConfig &config)
+{
+    BenchmarkResult result;
+    result.mountPoint = mountPoint;
+    result.startedAt = QDateTime::currentDateTime();
+
+    // Scratch directory on the mount; removed below however the run ends
+    const QString workDir = QString("%1/.nfs-share-manager-benchmark-%2")
+                                .arg(mountPoint).arg(QCoreApplication::applicationPid());
+    const QByteArray workDirPath = QFile::encodeName(workDir);
+    if (::mkdir(workDirPath.constData(), 0700) != 0) {
+        result.errorMessage = tr("Cannot create test files on %1: %2")
+                                  .arg(mountPoint, QString::fromLocal8Bit(std::strerror(errno)));
+        return result;
+    }
+
+    m_stage = 0;
+    const bool readAhead = !config.readAheadKb.isEmpty() && config.applyReadAhead;
+    m_stages = (config.sequential ? 2 : 0) + (config.randomIO ? 2 : 0) + (config.metadata ? 1 : 0) +
+               (readAhead ? static_cast<int>(config.readAheadKb.size()) : 0);
+    if (config.sequential && !m_cancelled) {
+        runSequential(workDirPath, config, result);
+    }
+    if (config.randomIO && !m_cancelled) {
+        runRandom(workDirPath, config, result);
+    }
+    if (config.metadata && !m_cancelled) {
+        runMetadata(workDirPath, config, result);
+    }
+    if (readAhead && !m_cancelled) {
+        runReadAhead(workDirPath, config, result);
+    }
+
+    if (!QDir(workDir).removeRecursively()) {
+        qWarning() << "MountBenchmark: could not remove" << workDir;
+    }
+    emit progress(100, tr("Finished"));
+
+    result.cancelled = m_cancelled;
+    // A failed stage (e.g. a readahead that could not be set) fails the run
+    result.success = !result.cancelled && result.errorMessage.isEmpty() &&
+                     (result.sequentialWriteMBps > 0.0 || result.sequentialReadMBps > 0.0 ||
+                      result.randomReadIops > 0.0 || result.randomWriteIops > 0.0 ||
+                      result.metadataOpsPerSecond > 0.0 || !result.readAheadSamples.isEmpty());
+    if (result.cancelled) {
+        result.errorMessage = tr("Benchmark cancelled");
+    } else if (!result.success && result.errorMessage.isEmpty()) {
+        result.errorMessage = tr("Benchmark could not write to %1").arg(mountPoint);
+    }
+    return result;
+}
+
+void MountBenchmark::runSequential(const QByteArray &workDir, const BenchmarkConfig &config, BenchmarkResult &result)
+{
+    const int blockSize = alignedSize(config.sequentialBlockSize);
+    void *buffer = allocateBuffer(blockSize);
+    if (!buffer) {
+        result.errorMessage = tr("Out of memory");
+        return;
+    }
+    const QByteArray dataFile = workDir + "/sequential";
+    bool direct = false;
+
+    beginStage(tr("Sequential write"));
+    int fd = openForBenchmark(dataFile, O_WRONLY | O_CREAT | O_TRUNC, &direct);
+    if (fd >= 0) {
+        qint64 written = 0;
+        const qint64 started = nowNanoseconds();
+        while (written < config.sequentialSize && !m_cancelled) {
+            const ssize_t n = ::write(fd, buffer, blockSize);
+            if (n <= 0) {
+                break;
+            }
+            written += n;
+        }
+        ::fsync(fd);
+        result.sequentialWriteMBps = megabytesPerSecond(written, nowNanoseconds() - started);
+        result.directIO = direct;
+        ::close(fd);
+    }
+
+    beginStage(tr("Sequential read"));
+    fd = m_cancelled ? -1 : openForBenchmark(dataFile, O_RDONLY, &direct);
+    if (fd >= 0) {
+        qint64 totalRead = 0;
+        const qint64 started = nowNanoseconds();
+        while (!m_cancelled) {
+            const ssize_t n = ::read(fd, buffer, blockSize);
+            if (n <= 0) {
+                break;
+            }
+            totalRead += n;
+        }
+        result.sequentialReadMBps = megabytesPerSecond(totalRead, nowNanoseconds() - started);
+        ::close(fd);
+    }
+    ::unlink(dataFile.constData());
+    std::free(buffer);
+}
+
+void MountBenchmark::runRandom(const QByteArray &workDir, const BenchmarkConfig &config, BenchmarkResult &result)
+{
+    const int blockSize = alignedSize(config.randomBlockSize);
+    const qint64 blocks = qMax<qint64>(1, config.randomFileSize / blockSize);
+    const int depth = qMax(1, config.queueDepth);
+    const QByteArray dataFile = workDir + "/random";
+
+    // Lay the file out first so reads hit allocated blocks; not measured
+    bool direct = false;
+    int fd = openForBenchmark(dataFile, O_WRONLY | O_CREAT | O_TRUNC, &direct);
+    void *layout = allocateBuffer(blockSize);
+    if (fd < 0 || !layout) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        std::free(layout);
+        return;
+    }
+    for (qint64 i = 0; i < blocks && !m_cancelled; ++i) {
+        if (::write(fd, layout, blockSize) != blockSize) {
+            break;
+        }
+    }
+    ::fsync(fd);
+    ::close(fd);
+    std::free(layout);
+
+    // One worker per request in flight, each with its own descriptor
+    const auto phase = [&](bool write, LatencyStats *latency) -> double {
+        std::vector<std::vector<qint64>> samples(depth);
+        std::vector<std::thread> workers;
+        const qint64 started = nowNanoseconds();
+        const qint64 deadline = started + qint64(config.randomDurationMs) * 1000000;
+        for (int t = 0; t < depth; ++t) {
+            workers.emplace_back([&, t]() {
+                bool workerDirect = false;
+                const int workerFd = openForBenchmark(dataFile, write ? O_WRONLY : O_RDONLY, &workerDirect);
+                void *buffer = allocateBuffer(blockSize);
+                if (workerFd >= 0 && buffer) {
+                    std::mt19937_64 rng(std::random_device{}() + t);
+                    std::uniform_int_distribution<qint64> pick(0, blocks - 1);
+                    while (!m_cancelled) {
+                        const off_t offset = pick(rng) * blockSize;
+                        const qint64 before = nowNanoseconds();
+                        const ssize_t n = write ? ::pwrite(workerFd, buffer, blockSize, offset)
+                                                : ::pread(workerFd, buffer, blockSize, offset);
+                        const qint64 after = nowNanoseconds();
+                        if (n != blockSize) {
+                            break;
+                        }
+                        samples[t].push_back(after - before);
+                        if (after >= deadline) {
+                            break;
+                        }
+                    }
+                }
+                if (workerFd >= 0) {
+                    ::close(workerFd);
+                }
+                std::free(buffer);
+            });
+        }
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+        const qint64 elapsed = nowNanoseconds() - started;
+
+        std::vector<qint64> all;
+        for (const std::vector<qint64> &workerSamples : samples) {
+            all.insert(all.end(), workerSamples.begin(), workerSamples.end());
+        }
+        *latency = LatencyStats::fromSamples(all);
+        return elapsed > 0 ? latency->samples / (elapsed / 1e9) : 0.0;
+    };
+
+    beginStage(tr("Random %1 KiB reads, queue depth %2").arg(blockSize / 1024).arg(depth));
+    result.randomReadIops = phase(false, &result.randomReadLatency);
+    if (!m_cancelled) {
+        beginStage(tr("Random %1 KiB writes, queue depth %2").arg(blockSize / 1024).arg(depth));
+        result.randomWriteIops = phase(true, &result.randomWriteLatency);
+    }
+    ::unlink(dataFile.constData());
+}
+
+void MountBenchmark::runMetadata(const QByteArray &workDir, const BenchmarkConfig &config, BenchmarkResult &result)
+{
+    beginStage(tr("Metadata create/stat/unlink"));
+    const int depth = qMax(1, config.queueDepth);
+    const int files = qMax(1, config.metadataFiles);
+
+    std::vector<std::vector<qint64>> samples(depth);
+    std::vector<std::thread> workers;
+    const qint64 started = nowNanoseconds();
+    for (int t = 0; t < depth; ++t) {
+        workers.emplace_back([&, t]() {
+            const QByteArray prefix = workDir + "/m" + QByteArray::number(t) + '_';
+            for (int i = 0; i < files && !m_cancelled; ++i) {
+                const QByteArray path = prefix + QByteArray::number(i);
+                qint64 before = nowNanoseconds();
+                const int fd = ::open(path.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+                if (fd < 0) {
+                    break;
+                }
+                ::close(fd);
+                qint64 after = nowNanoseconds();
+                samples[t].push_back(after - before);
+
+                struct stat st;
+                before = after;
+                ::stat(path.constData(), &st);
+                after = nowNanoseconds();
+                samples[t].push_back(after - before);
+
+                before = after;
+                ::unlink(path.constData());
+                samples[t].push_back(nowNanoseconds() - before);
+            }
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    const qint64 elapsed = nowNanoseconds() - started;
+
+    std::vector<qint64> all;
+    for (const std::vector<qint64> &workerSamples : samples) {
+        all.insert(all.end(), workerSamples.begin(), workerSamples.end());
+    }
+    result.metadataLatency = LatencyStats::fromSamples(all);
+    result.metadataOpsPerSecond = elapsed > 0 ? result.metadataLatency.samples / (elapsed / 1e9) : 0.0;
+}
+
+void MountBenchmark::runReadAhead(const QByteArray &workDir, const BenchmarkConfig &config, BenchmarkResult &result)
+{
+    const int blockSize = alignedSize(config.sequentialBlockSize);
+    void *buffer = allocateBuffer(qMax(blockSize, ReadAheadRequestSize));
+    if (!buffer) {
+        result.errorMessage = tr("Out of memory");
+        return;
+    }
+    const QByteArray dataFile = workDir + "/readahead";
+
+    // Lay the file out once; not measured
+    bool direct = false;
+    int fd = openForBenchmark(dataFile, O_WRONLY | O_CREAT | O_TRUNC, &direct);
+    if (fd < 0) {
+        std::free(buffer);
+        return;
+    }
+    for (qint64 written = 0; written < config.sequentialSize && !m_cancelled; written += blockSize) {
+        if (::write(fd, buffer, blockSize) != blockSize) {
+            break;
+        }
+    }
+    ::fsync(fd);
+    ::close(fd);
+
+    for (int readAheadKb : config.readAheadKb) {
+        if (m_cancelled) {
+            break;
+        }
+        beginStage(tr("Buffered read with %1 KiB readahead").arg(readAheadKb));
+        const QString error = config.applyReadAhead(readAheadKb);
+        if (!error.isEmpty()) {
+            result.errorMessage = tr("Cannot set readahead to %1 KiB: %2").arg(readAheadKb).arg(error);
+            break;
+        }
+
+        // Opened after the change: a file takes its readahead window from the device at open()
+        fd = ::open(dataFile.constData(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            break;
+        }
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        qint64 totalRead = 0;
+        const qint64 started = nowNanoseconds();
+        while (!m_cancelled) {
+            const ssize_t n = ::read(fd, buffer, ReadAheadRequestSize);
+            if (n <= 0) {
+                break;
+            }
+            totalRead += n;
+        }
+        const qint64 elapsed = nowNanoseconds() - started;
+        ::close(fd);
+        if (!m_cancelled) {
+            result.readAheadSamples << ReadAheadSample(readAheadKb, megabytesPerSecond(totalRead, elapsed));
+        }
+    }
+    ::unlink(dataFile.constData());
+    std::free(buffer);
+}
+
+void MountBenchmark::beginStage(const QString &description)
+{
+    const int percent = m_stages > 0 ? m_stage * 100 / m_stages : 0;
+    ++m_stage;
+    qDebug() << "MountBenchmark:" << description;
+    emit progress(percent, description);
+}
+
+QList<BenchmarkResult> MountBenchmark::mountHistory(const QString &mountPoint) const
+{
+    return loadHistory(QString("mounts/%1").arg(historyKey(QDir::cleanPath(mountPoint))));
+}
+
+QList<BenchmarkResult> MountBenchmark::serverHistory(const QString &serverKey) const
+{
+    return loadHistory(QString("servers/%1").arg(historyKey(serverKey)));
+}
+
+void MountBenchmark::recordResult(const BenchmarkResult &result)
+{
+    appendHistory(QString("mounts/%1").arg(historyKey(QDir::cleanPath(result.mountPoint))), result);
+    if (!result.serverKey.isEmpty()) {
+        appendHistory(QString("servers/%1").arg(historyKey(result.serverKey)), result);
+    }
+}
+
+void MountBenchmark::setHistoryFilePath(const QString &filePath)
+{
+    m_historyFilePath = filePath;
+}
+
+QList<BenchmarkResult> MountBenchmark::loadHistory(const QString &group) const
+{
+    QList<BenchmarkResult> history;
+    if (m_historyFilePath.isEmpty()) {
+        return history;
+    }
+
+    QSettings settings(m_historyFilePath, QSettings::IniFormat);
+    settings.beginGroup(group);
+    const int size = settings.beginReadArray("results");
+    for (int i = 0; i < size; ++i) {
+        settings.setArrayIndex(i);
+        BenchmarkResult result;
+        result.mountPoint = settings.value("mountPoint").toString();
+        result.serverKey = settings.value("serverKey").toString();
+        result.startedAt = settings.value("startedAt").toDateTime();
+        result.success = settings.value("success").toBool();
+        result.directIO = settings.value("directIO").toBool();
+        result.sequentialWriteMBps = settings.value("sequentialWriteMBps").toDouble();
+        result.sequentialReadMBps = settings.value("sequentialReadMBps").toDouble();
+        result.randomReadIops = settings.value("randomReadIops").toDouble();
+        result.randomWriteIops = settings.value("randomWriteIops").toDouble();
+        result.randomReadLatency = readLatency(settings, "randomRead");
+        result.randomWriteLatency = readLatency(settings, "randomWrite");
+        result.metadataOpsPerSecond = settings.value("metadataOpsPerSecond").toDouble();
+        result.metadataLatency = readLatency(settings, "metadata");
+        for (const QString &sample : settings.value("readAhead").toStringList()) {
+            result.readAheadSamples << ReadAheadSample(sample.section(':', 0, 0).toInt(),
+                                                       sample.section(':', 1, 1).toDouble());
+        }
+        history << result;
+    }
+    settings.endArray();
+    settings.endGroup();
+    return history;
+}
+
+void MountBenchmark::appendHistory(const QString &group, const BenchmarkResult &result)
+{
+    if (m_historyFilePath.isEmpty()) {
+        return;
+    }
+
+    QList<BenchmarkResult> history = loadHistory(group);
+    history << result;
+    while (history.size() > HistorySize) {
+        history.removeFirst();
+    }
+
+    QDir().mkpath(QFileInfo(m_historyFilePath).absolutePath());
+    QSettings settings(m_historyFilePath, QSettings::IniFormat);
+    settings.remove(group);
+    settings.beginGroup(group);
+    settings.beginWriteArray("results", history.size());
+    for (int i = 0; i < history.size(); ++i) {
+        const BenchmarkResult &entry = history[i];
+        settings.setArrayIndex(i);
+        settings.setValue("mountPoint", entry.mountPoint);
+        settings.setValue("serverKey", entry.serverKey);
+        settings.setValue("startedAt", entry.startedAt);
+        settings.setValue("success", entry.success);
+        settings.setValue("directIO", entry.directIO);
+        settings.setValue("sequentialWriteMBps", entry.sequentialWriteMBps);
+        settings.setValue("sequentialReadMBps", entry.sequentialReadMBps);
+        settings.setValue("randomReadIops", entry.randomReadIops);
+        settings.setValue("randomWriteIops", entry.randomWriteIops);
+        writeLatency(settings, "randomRead", entry.randomReadLatency);
+        writeLatency(settings, "randomWrite", entry.randomWriteLatency);
+        settings.setValue("metadataOpsPerSecond", entry.metadataOpsPerSecond);
+        writeLatency(settings, "metadata", entry.metadataLatency);
+        QStringList readAhead;
+        for (const ReadAheadSample &sample : entry.readAheadSamples) {
+            readAhead << QString("%1:%2").arg(sample.readAheadKb).arg(sample.readMBps);
+        }
+        settings.setValue("readAhead", readAhead);
+    }
+    settings.endArray();
+    settings.endGroup();
+    settings.sync();
+}
+
+} // namespace NFSShareManager
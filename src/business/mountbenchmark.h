@@ -0,0 +1,222 @@
+#pragma once
+
+#include <QObject>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace NFSShareManager {
+
+/**
+ * @brief Latency distribution of one kind of operation
+ */
+struct LatencyStats {
+    double p50Us;       ///< Median latency in microseconds
+    double p95Us;       ///< 95th percentile in microseconds
+    double p99Us;       ///< 99th percentile in microseconds
+    double maxUs;       ///< Slowest operation in microseconds
+    qint64 samples;     ///< Number of operations measured
+
+    LatencyStats() : p50Us(0.0), p95Us(0.0), p99Us(0.0), maxUs(0.0), samples(0) {}
+
+    /**
+     * @brief Compute nearest-rank percentiles
+     * @param nanoseconds Operation latencies; sorted in place
+     */
+    static LatencyStats fromSamples(std::vector<qint64> &nanoseconds);
+};
+
+/**
+ * @brief Buffered sequential read throughput at one readahead size
+ */
+struct ReadAheadSample {
+    int readAheadKb;    ///< Readahead of the mount's backing device
+    double readMBps;    ///< Buffered sequential read throughput
+
+    ReadAheadSample(int kb = 0, double mbps = 0.0) : readAheadKb(kb), readMBps(mbps) {}
+};
+
+/**
+ * @brief Workloads and sizes of a benchmark run
+ */
+struct BenchmarkConfig {
+    bool sequential;            ///< Run the sequential write and read test
+    qint64 sequentialSize;      ///< Sequential test file size in bytes
+    int sequentialBlockSize;    ///< Sequential request size in bytes
+    bool randomIO;              ///< Run the random read and write test
+    int randomBlockSize;        ///< Random request size in bytes
+    int queueDepth;             ///< Requests in flight, one worker thread each
+    qint64 randomFileSize;      ///< Random test file size in bytes
+    int randomDurationMs;       ///< Duration of each random phase
+    bool metadata;              ///< Run the create/stat/unlink storm
+    int metadataFiles;          ///< Files created per metadata worker
+    QList<int> readAheadKb;     ///< Readahead sizes to compare with buffered reads; empty to skip
+    std::function<QString(int readAheadKb)> applyReadAhead;    ///< Sets the readahead; runs on the worker thread
+
+    BenchmarkConfig()
+        : sequential(true), sequentialSize(256 * 1024 * 1024), sequentialBlockSize(1024 * 1024)
+        , randomIO(true), randomBlockSize(4096), queueDepth(16), randomFileSize(64 * 1024 * 1024)
+        , randomDurationMs(5000), metadata(true), metadataFiles(250) {}
+};
+
+/**
+ * @brief Figures measured by one benchmark run
+ */
+struct BenchmarkResult {
+    QString mountPoint;             ///< Mount that was measured
+    QString serverKey;              ///< Server of the mount (MountAutotuner::serverKey())
+    QDateTime startedAt;            ///< Start of the run
+    bool success;                   ///< Whether at least one workload could be measured
+    bool cancelled;                 ///< Whether the run was cancelled
+    QString errorMessage;           ///< Reason for failure
+    bool directIO;                  ///< Whether the mount accepted O_DIRECT
+    double sequentialWriteMBps;     ///< Sequential write throughput
+    double sequentialReadMBps;      ///< Sequential read throughput
+    double randomReadIops;          ///< Random read operations per second
+    double randomWriteIops;         ///< Random write operations per second
+    LatencyStats randomReadLatency;     ///< Random read latency
+    LatencyStats randomWriteLatency;    ///< Random write latency
+    double metadataOpsPerSecond;    ///< create/stat/unlink operations per second
+    LatencyStats metadataLatency;   ///< Latency of single metadata operations
+    QList<ReadAheadSample> readAheadSamples;    ///< Buffered read throughput per readahead size
+
+    BenchmarkResult()
+        : success(false), cancelled(false), directIO(false), sequentialWriteMBps(0.0), sequentialReadMBps(0.0)
+        , randomReadIops(0.0), randomWriteIops(0.0), metadataOpsPerSecond(0.0) {}
+
+    /**
+     * @brief Get the readahead size with the highest read throughput
+     * @return Size in KiB, or -1 if no readahead was measured
+     */
+    int bestReadAheadKb() const;
+
+    /**
+     * @brief Get a short human-readable report
+     */
+    QString summary() const;
+};
+
+/**
+ * @brief I/O benchmark of a mounted share
+ *
+ * Runs in a scratch directory on the mount, on worker threads:
+ * - sequential write then read, with O_DIRECT where the mount allows it,
+ * - random reads and writes of small blocks, with one thread per request
+ *   in flight (queue depth), for a fixed time each,
+ * - a metadata storm of create/stat/unlink spread over the same threads,
+ * - optionally, buffered sequential reads at several readahead sizes, with
+ *   the file's cached pages dropped before each pass.
+ *
+ * Latency percentiles are computed from every single request. The scratch
+ * directory is removed when the run ends, also when it fails or is
+ * cancelled. Each result is appended to a history kept per mount point
+ * and per server.
+ */
+class MountBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Results kept per mount point and per server
+     */
+    static constexpr int HistorySize = 20;
+
+    explicit MountBenchmark(QObject *parent = nullptr);
+    ~MountBenchmark();
+
+    /**
+     * @brief Start a benchmark run; returns immediately
+     * @param mountPoint Mounted directory to measure
+     * @param serverKey Server the history is also kept under
+     * @param config Workloads to run
+     * @return False if a run is already in progress
+     */
+    bool start(const QString &mountPoint, const QString &serverKey,
+               const BenchmarkConfig &config = BenchmarkConfig());
+
+    /**
+     * @brief Run a benchmark on the calling thread
+     *
+     * Does not record the result in the history.
+     *
+     * @param mountPoint Mounted directory to measure
+     * @param config Workloads to run
+     * @return The measured figures
+     */
+    BenchmarkResult run(const QString &mountPoint, const BenchmarkConfig &config = BenchmarkConfig());
+
+    /**
+     * @brief Request cancellation of the running benchmark
+     */
+    void cancel();
+
+    /**
+     * @brief Check if a run started with start() is in progress
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Get past results of a mount point, oldest first
+     * @param mountPoint The mount point
+     */
+    QList<BenchmarkResult> mountHistory(const QString &mountPoint) const;
+
+    /**
+     * @brief Get past results of all mounts of a server, oldest first
+     * @param serverKey Server address or hostname
+     */
+    QList<BenchmarkResult> serverHistory(const QString &serverKey) const;
+
+    /**
+     * @brief Append a result to the mount and server history
+     * @param result The result to store
+     */
+    void recordResult(const BenchmarkResult &result);
+
+    /**
+     * @brief Set the file the history is persisted to
+     * @param filePath Settings file (default: mountbenchmarks.ini in the config directory)
+     */
+    void setHistoryFilePath(const QString &filePath);
+
+signals:
+    /**
+     * @brief Emitted as the run advances
+     * @param percent Overall progress (0-100)
+     * @param stage Description of the running workload
+     */
+    void progress(int percent, const QString &stage);
+
+    /**
+     * @brief Emitted when a run started with start() has ended
+     * @param result The measured figures
+     */
+    void finished(const BenchmarkResult &result);
+
+private:
+    BenchmarkResult execute(const QString &mountPoint, const BenchmarkConfig &config);
+    void runSequential(const QByteArray &workDir, const BenchmarkConfig &config, BenchmarkResult &result);
+    void runRandom(const QByteArray &workDir, const BenchmarkConfig &config, BenchmarkResult &result);
+    void runMetadata(const QByteArray &workDir, const BenchmarkConfig &config, BenchmarkResult &result);
+    void runReadAhead(const QByteArray &workDir, const BenchmarkConfig &config, BenchmarkResult &result);
+    void beginStage(const QString &description);
+
+    QList<BenchmarkResult> loadHistory(const QString &group) const;
+    void appendHistory(const QString &group, const BenchmarkResult &result);
+
+    QThreadPool m_pool;                 ///< Runs start() off the calling thread
+    std::atomic<bool> m_cancelled;      ///< Cancellation requested
+    std::atomic<bool> m_running;        ///< A start() run is in progress
+    int m_stage;                        ///< Workloads started in the current run
+    int m_stages;                       ///< Workloads of the current run
+    QString m_historyFilePath;          ///< Persisted results
+};
+
+} // namespace NFSShareManager
+
+Q_DECLARE_METATYPE(NFSShareManager::BenchmarkResult)
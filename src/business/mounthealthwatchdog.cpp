@@ -0,0 +1,294 @@
+#include "mounthealthwatchdog.h"
+#include "../core/remotenfsshare.h"
+#include "../system/detachedcall.h"
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QFile>
+#include <QPair>
+#include <QTcpSocket>
+#include <QtEndian>
+#include <sys/statfs.h>
+#include <cerrno>
+#include <cstring>
+
+namespace NFSShareManager {
+
+namespace {
+
+constexpr quint16 NFSPort = 2049;
+constexpr quint32 RpcCall = 0;
+constexpr quint32 RpcReply = 1;
+constexpr quint32 RpcVersion = 2;
+constexpr quint32 MsgAccepted = 0;
+constexpr quint32 LastFragment = 0x80000000u;
+
+void appendWord(QByteArray &data, quint32 value)
+{
+    const quint32 word = qToBigEndian(value);
+    data.append(reinterpret_cast<const char *>(&word), sizeof(word));
+}
+
+quint32 wordAt(const QByteArray &data, int offset)
+{
+    return qFromBigEndian<quint32>(data.constData() + offset);
+}
+
+} // namespace
+
+MountHealthWatchdog::MountHealthWatchdog(QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+    , m_pingOperation(&MountHealthWatchdog::defaultPing)
+    , m_probeOperation(&MountHealthWatchdog::statfsProbe)
+    , m_pingTimeout(3000)
+    , m_probeTimeout(5000)
+    , m_nextGeneration(1)
+{
+    qRegisterMetaType<MountHealthWatchdog::Health>("MountHealthWatchdog::Health");
+    connect(m_timer, &QTimer::timeout, this, &MountHealthWatchdog::checkNow);
+}
+
+MountHealthWatchdog::~MountHealthWatchdog()
+{
+    // Outstanding checks find the watchdog gone and drop their result
+}
+
+void MountHealthWatchdog::setMounts(const QList<NFSMount> &mounts)
+{
+    QHash<QString, Entry> entries;
+    for (const NFSMount &mount : mounts) {
+        Entry entry = m_entries.value(mount.localMountPoint());
+        entry.mount = mount;
+        entries.insert(mount.localMountPoint(), entry);
+    }
+    m_entries = entries;
+}
+
+void MountHealthWatchdog::start(int intervalMs)
+{
+    m_timer->start(intervalMs);
+    checkNow();
+}
+
+void MountHealthWatchdog::stop()
+{
+    m_timer->stop();
+}
+
+bool MountHealthWatchdog::isRunning() const
+{
+    return m_timer->isActive();
+}
+
+void MountHealthWatchdog::checkNow()
+{
+    const QStringList mountPoints = m_entries.keys();
+    for (const QString &mountPoint : mountPoints) {
+        startCheck(mountPoint);
+    }
+}
+
+void MountHealthWatchdog::setPingTimeout(int msecs)
+{
+    m_pingTimeout = qMax(1, msecs);
+}
+
+int MountHealthWatchdog::pingTimeout() const
+{
+    return m_pingTimeout;
+}
+
+void MountHealthWatchdog::setProbeTimeout(int msecs)
+{
+    m_probeTimeout = qMax(1, msecs);
+}
+
+int MountHealthWatchdog::probeTimeout() const
+{
+    return m_probeTimeout;
+}
+
+void MountHealthWatchdog::setPingOperation(const PingOperation &operation)
+{
+    m_pingOperation = operation;
+}
+
+void MountHealthWatchdog::setProbeOperation(const ProbeOperation &operation)
+{
+    m_probeOperation = operation;
+}
+
+MountHealthWatchdog::Health MountHealthWatchdog::health(const QString &mountPoint) const
+{
+    return m_entries.value(mountPoint).health;
+}
+
+QString MountHealthWatchdog::healthMessage(const QString &mountPoint) const
+{
+    return m_entries.value(mountPoint).message;
+}
+
+bool MountHealthWatchdog::isChecking(const QString &mountPoint) const
+{
+    return m_entries.value(mountPoint).generation != 0;
+}
+
+QString MountHealthWatchdog::rpcNullPing(const QString &host, quint16 port, quint32 program, quint32 version,
+                                         int timeoutMs)
+{
+    QDeadlineTimer deadline(timeoutMs);
+    QTcpSocket socket;
+    socket.connectToHost(host, port);
+    if (!socket.waitForConnected(static_cast<int>(deadline.remainingTime()))) {
+        return QString("Cannot connect to %1:%2: %3").arg(host).arg(port).arg(socket.errorString());
+    }
+
+    const quint32 xid = static_cast<quint32>(QDateTime::currentMSecsSinceEpoch()) ^ (program << 8) ^ version;
+    socket.write(buildRpcNullCall(xid, program, version));
+
+    // A NULL reply is small; read until the record mark's length is in
+    QByteArray reply;
+    int expected = -1;
+    while (expected < 0 || reply.size() < expected) {
+        if (deadline.hasExpired() || !socket.waitForReadyRead(static_cast<int>(deadline.remainingTime()))) {
+            return QString("No RPC reply from %1:%2").arg(host).arg(port);
+        }
+        reply += socket.readAll();
+        if (expected < 0 && reply.size() >= 4) {
+            expected = 4 + static_cast<int>(wordAt(reply, 0) & ~LastFragment);
+            if (expected > 4096) {
+                return QString("Oversized RPC reply from %1:%2").arg(host).arg(port);
+            }
+        }
+    }
+    return checkRpcReply(reply.left(expected), xid);
+}
+
+QByteArray MountHealthWatchdog::buildRpcNullCall(quint32 xid, quint32 program, quint32 version)
+{
+    QByteArray body;
+    appendWord(body, xid);
+    appendWord(body, RpcCall);
+    appendWord(body, RpcVersion);
+    appendWord(body, program);
+    appendWord(body, version);
+    appendWord(body, 0);    // procedure 0 (NULL)
+    appendWord(body, 0);    // credential AUTH_NONE
+    appendWord(body, 0);
+    appendWord(body, 0);    // verifier AUTH_NONE
+    appendWord(body, 0);
+
+    QByteArray record;
+    appendWord(record, LastFragment | static_cast<quint32>(body.size()));
+    return record + body;
+}
+
+QString MountHealthWatchdog::checkRpcReply(const QByteArray &reply, quint32 xid)
+{
+    // Record mark, xid, message type, reply status
+    if (reply.size() < 16) {
+        return QString("Truncated RPC reply");
+    }
+    if (wordAt(reply, 4) != xid) {
+        return QString("RPC reply for another call");
+    }
+    if (wordAt(reply, 8) != RpcReply) {
+        return QString("Not an RPC reply");
+    }
+    if (wordAt(reply, 12) != MsgAccepted) {
+        // Denied (RPC version or auth) still proves the server is serving RPC
+        qDebug() << "MountHealthWatchdog: RPC call denied, server is alive";
+    }
+    return QString();
+}
+
+QString MountHealthWatchdog::statfsProbe(const QString &mountPoint)
+{
+    struct statfs info;
+    if (::statfs(QFile::encodeName(mountPoint).constData(), &info) != 0) {
+        return QString::fromLocal8Bit(std::strerror(errno));
+    }
+    return QString();
+}
+
+void MountHealthWatchdog::startCheck(const QString &mountPoint)
+{
+    auto it = m_entries.find(mountPoint);
+    if (it == m_entries.end() || it->generation != 0) {
+        // A previous check is still outstanding, possibly stuck in the kernel
+        return;
+    }
+
+    const quint64 generation = m_nextGeneration++;
+    it->generation = generation;
+
+    const NFSMount mount = it->mount;
+    const PingOperation ping = m_pingOperation;
+    const ProbeOperation probe = m_probeOperation;
+    const int pingTimeout = m_pingTimeout;
+
+    // Detached: a thread stuck in statfs() must never be joined
+    DetachedCall::run(this, [mount, mountPoint, ping, probe, pingTimeout]() {
+        QString message = ping(mount, pingTimeout);
+        if (!message.isEmpty()) {
+            return qMakePair(Health::ServerUnreachable, message);
+        }
+        message = probe(mountPoint);
+        return qMakePair(message.isEmpty() ? Health::Healthy : Health::Error, message);
+    }, [mountPoint, generation](MountHealthWatchdog *watchdog, const QPair<Health, QString> &result) {
+        watchdog->finishCheck(mountPoint, generation, result.first, result.second);
+    });
+
+    QTimer::singleShot(m_pingTimeout + m_probeTimeout, this, [this, mountPoint, generation]() {
+        onDeadline(mountPoint, generation);
+    });
+}
+
+void MountHealthWatchdog::finishCheck(const QString &mountPoint, quint64 generation, Health health,
+                                      const QString &message)
+{
+    auto it = m_entries.find(mountPoint);
+    if (it == m_entries.end() || it->generation != generation) {
+        return;
+    }
+    it->generation = 0;
+    report(it.value(), health, health == Health::ServerUnreachable
+                                   ? tr("NFS server is not reachable: %1").arg(message)
+                                   : message);
+}
+
+void MountHealthWatchdog::onDeadline(const QString &mountPoint, quint64 generation)
+{
+    auto it = m_entries.find(mountPoint);
+    if (it == m_entries.end() || it->generation != generation) {
+        return;
+    }
+
+    // Keep the check outstanding: its late result clears the state again
+    qWarning() << "MountHealthWatchdog:" << mountPoint << "did not answer within"
+               << m_pingTimeout + m_probeTimeout << "ms";
+    report(it.value(), Health::Unresponsive,
+           tr("Mount is not responding (no answer within %1 s)").arg((m_pingTimeout + m_probeTimeout) / 1000.0));
+}
+
+void MountHealthWatchdog::report(Entry &entry, Health health, const QString &message)
+{
+    if (entry.health == health && entry.message == message) {
+        return;
+    }
+    entry.health = health;
+    entry.message = message;
+    emit healthChanged(entry.mount, health, message);
+}
+
+QString MountHealthWatchdog::defaultPing(const NFSMount &mount, int timeoutMs)
+{
+    const RemoteNFSShare remoteShare = mount.remoteShare();
+    const QString host = remoteShare.hostAddress().isNull() ? remoteShare.hostName()
+                                                            : remoteShare.hostAddress().toString();
+    const quint32 version = mount.options().nfsVersion == NFSVersion::Version3 ? 3 : 4;
+    return rpcNullPing(host, NFSPort, NFSProgram, version, timeoutMs);
+}
+
+} // namespace NFSShareManager
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QTimer>
+#include <functional>
+#include "../core/nfsmount.h"
+
+namespace NFSShareManager {
+
+/**
+ * @brief Detects hung and stale NFS mounts without blocking the caller
+ *
+ * A stat() or statfs() on a hard-mounted NFS path whose server is gone
+ * sleeps uninterruptibly until the server comes back, so mounts are never
+ * touched from the thread that owns the watchdog. Each check runs on a
+ * disposable detached thread:
+ *
+ *  1. An RPC NULL call to the server's NFS port shows whether the server
+ *     answers at all. If it does not, the mount point is not touched.
+ *  2. statfs() on the mount point shows whether the mount itself answers.
+ *
+ * If no result arrives within pingTimeout() + probeTimeout(), the mount is
+ * reported Unresponsive. A thread that is stuck in the kernel is abandoned;
+ * no new check is started for that mount until it returns, so at most one
+ * thread per mount can ever be stuck.
+ */
+class MountHealthWatchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Result of the last check of a mount
+     */
+    enum class Health {
+        Unknown,            ///< Not checked yet
+        Healthy,            ///< Server and mount point answered
+        ServerUnreachable,  ///< The server did not answer the RPC NULL call
+        Unresponsive,       ///< The mount point did not answer before the deadline
+        Error               ///< The mount point answered with an error (e.g. ESTALE)
+    };
+    Q_ENUM(Health)
+
+    /**
+     * @brief Checks that a server answers RPC calls
+     * @return Error message, or an empty string if the server answered
+     */
+    using PingOperation = std::function<QString(const NFSMount &mount, int timeoutMs)>;
+
+    /**
+     * @brief Checks that a mount point answers file system calls
+     * @return Error message, or an empty string if the mount answered
+     */
+    using ProbeOperation = std::function<QString(const QString &mountPoint)>;
+
+    /// NFS RPC program number
+    static constexpr quint32 NFSProgram = 100003;
+
+    explicit MountHealthWatchdog(QObject *parent = nullptr);
+    ~MountHealthWatchdog();
+
+    /**
+     * @brief Set the mounts to watch
+     *
+     * Results of mounts that are no longer in the list are dropped.
+     *
+     * @param mounts The mounts to check
+     */
+    void setMounts(const QList<NFSMount> &mounts);
+
+    /**
+     * @brief Start periodic checks
+     * @param intervalMs Check interval in milliseconds
+     */
+    void start(int intervalMs = 15000);
+
+    /**
+     * @brief Stop periodic checks
+     */
+    void stop();
+
+    /**
+     * @brief Check if periodic checks are active
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Start a check of every watched mount; returns immediately
+     */
+    void checkNow();
+
+    /**
+     * @brief Set how long the RPC NULL call may take
+     * @param msecs Timeout in milliseconds (default: 3000)
+     */
+    void setPingTimeout(int msecs);
+
+    /**
+     * @brief Get how long the RPC NULL call may take
+     */
+    int pingTimeout() const;
+
+    /**
+     * @brief Set how long the mount point may take to answer after the ping
+     * @param msecs Timeout in milliseconds (default: 5000)
+     */
+    void setProbeTimeout(int msecs);
+
+    /**
+     * @brief Get how long the mount point may take to answer after the ping
+     */
+    int probeTimeout() const;
+
+    /**
+     * @brief Replace the server check (for testing)
+     */
+    void setPingOperation(const PingOperation &operation);
+
+    /**
+     * @brief Replace the mount point check (for testing)
+     */
+    void setProbeOperation(const ProbeOperation &operation);
+
+    /**
+     * @brief Get the result of the last check of a mount
+     * @param mountPoint The local mount point
+     */
+    Health health(const QString &mountPoint) const;
+
+    /**
+     * @brief Get the error message of the last check of a mount
+     * @param mountPoint The local mount point
+     * @return Message, empty while the mount is healthy or unchecked
+     */
+    QString healthMessage(const QString &mountPoint) const;
+
+    /**
+     * @brief Check if a check of a mount is still outstanding
+     * @param mountPoint The local mount point
+     */
+    bool isChecking(const QString &mountPoint) const;
+
+    /**
+     * @brief Send an RPC NULL call over TCP and wait for the reply
+     *
+     * Blocks for up to @p timeoutMs; call it from a worker thread.
+     *
+     * @param host Server host name or address
+     * @param port Server port
+     * @param program RPC program number
+     * @param version RPC program version
+     * @param timeoutMs Timeout for connecting and for the reply
+     * @return Error message, or an empty string if the server replied
+     */
+    static QString rpcNullPing(const QString &host, quint16 port, quint32 program, quint32 version, int timeoutMs);
+
+    /**
+     * @brief Build a record-marked RPC NULL call with AUTH_NONE
+     * @param xid Transaction id
+     * @param program RPC program number
+     * @param version RPC program version
+     */
+    static QByteArray buildRpcNullCall(quint32 xid, quint32 program, quint32 version);
+
+    /**
+     * @brief Check a record-marked RPC reply to a NULL call
+     *
+     * Any well-formed reply with the right xid counts as an answer, even a
+     * version mismatch: the server is alive either way.
+     *
+     * @param reply The reply bytes, starting with the record mark
+     * @param xid Transaction id of the call
+     * @return Error message, or an empty string for a valid reply
+     */
+    static QString checkRpcReply(const QByteArray &reply, quint32 xid);
+
+    /**
+     * @brief statfs() a mount point; blocks as long as the mount does
+     * @param mountPoint The local mount point
+     * @return Error message, or an empty string on success
+     */
+    static QString statfsProbe(const QString &mountPoint);
+
+signals:
+    /**
+     * @brief Emitted when the health of a mount changes
+     * @param mount The mount
+     * @param health The new health
+     * @param message Error message, empty for Healthy
+     */
+    void healthChanged(const NFSMount &mount, MountHealthWatchdog::Health health, const QString &message);
+
+private:
+    struct Entry {
+        NFSMount mount;                     ///< Watched mount
+        Health health = Health::Unknown;    ///< Result of the last check
+        QString message;                    ///< Error of the last check
+        quint64 generation = 0;             ///< Id of the outstanding check, 0 if none
+    };
+
+    void startCheck(const QString &mountPoint);
+    void finishCheck(const QString &mountPoint, quint64 generation, Health health, const QString &message);
+    void onDeadline(const QString &mountPoint, quint64 generation);
+    void report(Entry &entry, Health health, const QString &message);
+    static QString defaultPing(const NFSMount &mount, int timeoutMs);
+
+    QTimer *m_timer;                        ///< Periodic check timer
+    QHash<QString, Entry> m_entries;        ///< Watched mounts by mount point
+    PingOperation m_pingOperation;          ///< Server check
+    ProbeOperation m_probeOperation;        ///< Mount point check
+    int m_pingTimeout;                      ///< RPC NULL timeout in ms
+    int m_probeTimeout;                     ///< Mount point timeout in ms
+    quint64 m_nextGeneration;               ///< Id for the next check
+};
+
+} // namespace NFSShareManager
@@ -1,24 +1,248 @@
 #include "mountmanager.h"
 #include "../core/nfsmount.h"
 #include "../core/remotenfsshare.h"
+#include "../system/atomicfilewriter.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
 #include <QDebug>
+#include <algorithm>
 
 namespace NFSShareManager {
 
+namespace {
+
+/**
+ * @brief Split an NFS source such as "server:/export" or "[fd00::1]:/export"
+ */
+bool parseNFSSource(const QString &source, RemoteNFSShare *remoteShare)
+{
+    const int colon = source.indexOf(":/");
+    if (colon <= 0) {
+        return false;
+    }
+    QString server = source.left(colon);
+    if (server.startsWith('[') && server.endsWith(']')) {
+        server = server.mid(1, server.size() - 2);
+    }
+    const QHostAddress address(server);
+    *remoteShare = RemoteNFSShare(address.isNull() ? server : QString(), address, source.mid(colon + 1));
+    return true;
+}
+
+/**
+ * @brief Get the mount options of a mount table entry
+ *
+ * Options the kernel adds for its own bookkeeping are left out, so they do
+ * not end up in customOptions.
+ */
+MountOptions mountOptionsOf(const MountInfoEntry &entry)
+{
+    static const QStringList kernelOnly = {"addr", "clientaddr", "mountaddr", "mountvers", "mountport",
+                                           "mountproto", "namlen", "local_lock", "relatime", "seclabel"};
+    QStringList arguments;
+    for (const QString &option : entry.mountOptions + entry.superOptions) {
+        if (!kernelOnly.contains(option.section('=', 0, 0))) {
+            arguments << option;
+        }
+    }
+    return MountManager::fromMountArguments(arguments);
+}
+
+/**
+ * @brief Get the error of a command, or an empty string if it succeeded
+ */
+QString commandError(const NFSCommandResult &result)
+{
+    return result.success ? QString() : (result.error.isEmpty() ? result.command + " failed" : result.error);
+}
+
+/**
+ * @brief Mount a share with the options of a mount; blocks
+ */
+QString mountWith(NFSServiceInterface *nfsService, const RemoteNFSShare &remoteShare, const NFSMount &mount)
+{
+    const QString server = remoteShare.hostAddress().isNull() ? remoteShare.hostName()
+                                                              : remoteShare.hostAddress().toString();
+    return commandError(nfsService->mountNFSShare(server, remoteShare.exportPath(), mount.localMountPoint(),
+                                                  MountManager::toMountArguments(mount.options()),
+                                                  mount.options().nfsVersion));
+}
+
+/// Whether a tuner works on the system's backing devices, the only tree the helper writes
+bool tunesSystemDevices(const BdiTuner &tuner)
+{
+    return QDir::cleanPath(tuner.sysfsRoot()) == BdiTuner().sysfsRoot();
+}
+
+/// Write backing device settings the user cannot write to sysfs directly
+QString tuneWithPolicyKit(PolicyKitHelper *helper, const QString &device, const BdiSettings &settings)
+{
+    QVariantMap parameters;
+    parameters["device"] = device;
+    if (settings.readAheadKb >= 0) {
+        parameters["readAheadKb"] = settings.readAheadKb;
+    }
+    if (settings.maxRatio >= 0) {
+        parameters["maxRatio"] = settings.maxRatio;
+    }
+    QString error;
+    helper->executePrivilegedAction(PolicyKitHelper::Action::TuneBackingDevice, parameters, &error, nullptr);
+    return error;
+}
+
+} // namespace
+
 MountManager::MountManager(QObject *parent)
     : QObject(parent)
     , m_nfsService(nullptr)
     , m_policyKitHelper(nullptr)
-    , m_fsWatcher(nullptr)
-    , m_refreshTimer(nullptr)
+    , m_mountMonitor(new MountTableMonitor(this))
+    , m_statisticsTimer(new QTimer(this))
+    , m_autotuner(nullptr)
+    , m_benchmark(new MountBenchmark(this))
+    , m_orchestrator(new MountOrchestrator(this))
+    , m_healthWatchdog(new MountHealthWatchdog(this))
+    , m_replicaSelector(new ReplicaSelector(this))
+    , m_shutdownUnmounter(new ShutdownUnmounter(this))
+    , m_shutdownUnmountDone(false)
+    , m_systemd(new SystemdManager(this))
+    , m_fstab(FstabFile::defaultPath())
+    , m_persistenceMode(PersistenceMode::Boot)
+    , m_automountIdleTimeout(600)
     , m_defaultMountRoot("/mnt/nfs")
     , m_refreshInterval(30)
 {
+    m_nfsService = new NFSServiceInterface(this);
+    m_autotuner = new MountAutotuner(m_nfsService, this);
+    m_replicaMovePool.setMaxThreadCount(2);
+    // One at a time, so the last setting written for a device is the one that sticks
+    m_tuningPool.setMaxThreadCount(1);
+
+    // Sample client-side NFS statistics so rates are available per mount
+    m_statisticsTimer->setInterval(5000);
+    connect(m_statisticsTimer, &QTimer::timeout, this, &MountManager::onStatisticsTimer);
+
+    // Batch operations run on the orchestrator's pool; NFSServiceInterface is thread-safe
+    // Replicas are measured there too, so the race never blocks the GUI thread
+    NFSServiceInterface *nfsService = m_nfsService;
+    ReplicaSelector *replicaSelector = m_replicaSelector;
+    // Only read-only mounts may land on another server: a shared export path
+    // does not make a writable share the same data
+    m_orchestrator->setMountOperation([nfsService, replicaSelector](const NFSMount &mount) {
+        const RemoteNFSShare remoteShare = mount.options().readOnly
+            ? replicaSelector->selectForMount(mount.localMountPoint(), mount.remoteShare())
+            : mount.remoteShare();
+        return mountWith(nfsService, remoteShare, mount);
+    });
+    m_orchestrator->setUnmountOperation([nfsService](const QString &mountPoint, bool force) {
+        return commandError(nfsService->unmountNFSShare(mountPoint, force));
+    });
+
+    connect(m_orchestrator, &MountOrchestrator::mountStarted, this, [this](const NFSMount &mount) {
+        emit mountStarted(mount.remoteShare(), mount.localMountPoint());
+    });
+    connect(m_orchestrator, &MountOrchestrator::unmountStarted, this, &MountManager::unmountStarted);
+    connect(m_orchestrator, &MountOrchestrator::mountCompleted, this, [this](const NFSMount &completed) {
+        NFSMount mount = completed;
+        RemoteNFSShare replica;
+        if (m_replicaSelector->takeSelection(completed.localMountPoint(), &replica)
+            && !ReplicaSelector::isSameReplica(replica, completed.remoteShare())) {
+            mount = NFSMount(replica, completed.localMountPoint(), completed.options(), completed.isPersistent());
+        }
+        mount.setStatus(MountStatus::Mounted);
+        mount.setMountedAt(QDateTime::currentDateTime());
+        addMountToTracking(mount);
+        applyBdiSettings(mount);
+        // fstab keeps the replica the user chose
+        if (completed.isPersistent() && !isInFstab(completed)) {
+            addToFstab(completed);
+        }
+        emit mountCompleted(mount);
+    });
+    connect(m_orchestrator, &MountOrchestrator::mountFailed, this, &MountManager::onBatchMountFailed);
+    connect(m_orchestrator, &MountOrchestrator::unmountCompleted, this, [this](const QString &mountPoint) {
+        removeMountFromTracking(mountPoint);
+        emit unmountCompleted(mountPoint);
+    });
+    connect(m_orchestrator, &MountOrchestrator::unmountFailed, this,
+            [this](const QString &mountPoint, MountOrchestrator::FailureReason reason, const QString &error) {
+        Q_UNUSED(reason)
+        emit unmountFailed(mountPoint, error);
+    });
+    connect(m_orchestrator, &MountOrchestrator::finished, this, &MountManager::mountBatchFinished);
+
+    // Hung servers are detected off the GUI thread
+    connect(m_healthWatchdog, &MountHealthWatchdog::healthChanged, this, &MountManager::onMountHealthChanged);
+
+    // Mounted replicas are re-measured; slow read-only ones move to a faster mirror
+    connect(m_replicaSelector, &ReplicaSelector::replicaDegraded, this, &MountManager::onReplicaDegraded);
+
+    // Every escalation step at exit is logged, since nothing else outlives it
+    connect(m_shutdownUnmounter, &ShutdownUnmounter::stepFinished, this,
+            [](const QString &mountPoint, ShutdownUnmounter::Step step, bool success, const QString &error) {
+        if (success) {
+            qDebug() << "MountManager: unmounted" << mountPoint << "at exit with step" << step;
+        } else {
+            qWarning() << "MountManager: unmount step" << step << "failed for" << mountPoint << ":" << error;
+        }
+    });
+
+    // Mounts and unmounts, including ones made outside this application, are
+    // reported by the kernel as they happen instead of polling the mount table
+    connect(m_mountMonitor, &MountTableMonitor::mountAdded, this, &MountManager::onMountTableAdded);
+    connect(m_mountMonitor, &MountTableMonitor::mountRemoved, this, &MountManager::onMountTableRemoved);
+    connect(m_mountMonitor, &MountTableMonitor::mountChanged, this, &MountManager::onMountTableChanged);
+    m_mountMonitor->start();
+
+    // A readahead sweep leaves the mount as it was before, or as configured
+    connect(m_benchmark, &MountBenchmark::finished, this, [this](const BenchmarkResult &result) {
+        if (!m_readAheadRestores.contains(result.mountPoint)) {
+            return;
+        }
+        const QPair<QString, int> restore = m_readAheadRestores.take(result.mountPoint);
+        BdiSettings settings;
+        settings.readAheadKb = restore.second;
+
+        auto it = findMount(result.mountPoint);
+        if (it != m_managedMounts.end() && bdiSettingsOf(it->options()).readAheadKb >= 0) {
+            settings.readAheadKb = bdiSettingsOf(it->options()).readAheadKb;
+        }
+        if (settings.readAheadKb < 0) {
+            return;
+        }
+        const QString error = writeBdiSettings(result.mountPoint, restore.first, settings);
+        if (!error.isEmpty()) {
+            qWarning() << "MountManager: cannot restore readahead of" << result.mountPoint << ":" << error;
+            emit backingDeviceTuningFailed(result.mountPoint, error);
+        }
+    });
+
+    // fstab edits only reach systemd's generated units after a daemon reload
+    connect(m_systemd, &SystemdManager::daemonReloaded, this, &MountManager::onDaemonReloaded);
+    connect(m_systemd, &SystemdManager::jobFinished, this,
+            [](const QString &unit, SystemdManager::Operation operation, bool success, const QString &error) {
+        if (!success && unit.endsWith(".automount")) {
+            qWarning() << "MountManager:" << SystemdManager::methodForOperation(operation) << unit
+                       << "failed:" << error;
+        }
+    });
+
     qDebug() << "MountManager initialized (stub implementation)";
 }
 
 MountManager::~MountManager()
 {
+    // A readahead sweep may be in a helper call; the benchmark pool is joined with the children
+    m_benchmark->cancel();
+
+    // Privileged readahead writes use the helper, which outlives this manager
+    m_tuningPool.waitForDone();
+
+    // Replica moves use m_nfsService, which is deleted with the children
+    m_replicaMovePool.waitForDone();
 }
 
 MountManager::MountResult MountManager::mountShare(const RemoteNFSShare &remoteShare, 
@@ -53,21 +277,55 @@ bool MountManager::unmountShare(const NFSMount &mount, bool force)
     return true;
 }
 
+int MountManager::mountShares(const QList<NFSMount> &mounts)
+{
+    return m_orchestrator->mountAll(mounts);
+}
+
+int MountManager::unmountShares(const QStringList &mountPoints, bool force)
+{
+    return m_orchestrator->unmountAll(mountPoints, force);
+}
+
+int MountManager::restorePersistentMounts()
+{
+    // Entries already mounted at boot, left to systemd or marked noauto are not touched
+    QList<NFSMount> mounts;
+    for (const NFSMount &mount : loadPersistentMounts()) {
+        const QStringList options = m_fstab.entry(mount.localMountPoint()).options;
+        if (!m_mountMonitor->entryForMountPoint(mount.localMountPoint()).isNFS()
+            && !options.contains("noauto") && !options.contains("x-systemd.automount")) {
+            mounts << mount;
+        }
+    }
+    qDebug() << "Restoring" << mounts.size() << "persistent mounts";
+    return mounts.isEmpty() ? 0 : mountShares(mounts);
+}
+
+MountOrchestrator *MountManager::orchestrator() const
+{
+    return m_orchestrator;
+}
+
+NFSServiceInterface *MountManager::nfsService() const
+{
+    return m_nfsService;
+}
+
 QList<NFSMount> MountManager::getManagedMounts() const
 {
-    return QList<NFSMount>();
+    return m_managedMounts;
 }
 
 NFSMount MountManager::getMountByPath(const QString &mountPoint) const
 {
-    Q_UNUSED(mountPoint)
-    return NFSMount();
+    auto it = findMount(mountPoint);
+    return it != m_managedMounts.constEnd() ? *it : NFSMount();
 }
 
 bool MountManager::isManagedMount(const QString &mountPoint) const
 {
-    Q_UNUSED(mountPoint)
-    return false;
+    return findMount(mountPoint) != m_managedMounts.constEnd();
 }
 
 bool MountManager::validateMountPoint(const QString &mountPoint) const
@@ -96,45 +354,754 @@ bool MountManager::isMountPointSuitable(const QString &mountPoint) const
 
 void MountManager::refreshMountStatus()
 {
-    qDebug() << "MountManager::refreshMountStatus - stub implementation";
+    m_mountMonitor->rescan();
+    m_healthWatchdog->checkNow();
+}
+
+MountTableMonitor *MountManager::mountTableMonitor() const
+{
+    return m_mountMonitor;
+}
+
+MountHealthWatchdog::Health MountManager::getMountHealth(const QString &mountPoint) const
+{
+    return m_healthWatchdog->health(mountPoint);
+}
+
+MountHealthWatchdog *MountManager::healthWatchdog() const
+{
+    return m_healthWatchdog;
 }
 
 MountOptions MountManager::getDefaultMountOptions(const RemoteNFSShare &remoteShare) const
 {
-    Q_UNUSED(remoteShare)
-    return MountOptions();
+    MountOptions options;
+    
+    // Prefer options measured for this server by the autotuner
+    TuningCandidate tuned;
+    if (m_autotuner->loadTunedOptions(MountAutotuner::serverKey(remoteShare), &tuned)) {
+        options.nfsVersion = tuned.nfsVersion;
+        options.rsize = tuned.rsize;
+        options.wsize = tuned.wsize;
+        if (tuned.nconnect > 1) {
+            options.customOptions.insert("nconnect", tuned.nconnect);
+        }
+    }
+    
+    return options;
 }
 
-bool MountManager::addToFstab(const NFSMount &mount)
+bool MountManager::autotuneMountOptions(const RemoteNFSShare &remoteShare)
 {
-    Q_UNUSED(mount)
+    qDebug() << "Autotuning mount options for" << MountAutotuner::serverKey(remoteShare);
+    return m_autotuner->start(remoteShare);
+}
+
+bool MountManager::hasTunedMountOptions(const RemoteNFSShare &remoteShare) const
+{
+    return m_autotuner->loadTunedOptions(MountAutotuner::serverKey(remoteShare), nullptr);
+}
+
+MountAutotuner *MountManager::autotuner() const
+{
+    return m_autotuner;
+}
+
+bool MountManager::benchmarkMount(const QString &mountPoint, const BenchmarkConfig &config)
+{
+    auto it = findMount(mountPoint);
+    if (it == m_managedMounts.end() || it->status() != MountStatus::Mounted) {
+        qWarning() << "Cannot benchmark" << mountPoint << ": not mounted";
+        return false;
+    }
+    return m_benchmark->start(mountPoint, MountAutotuner::serverKey(it->remoteShare()), config);
+}
+
+MountBenchmark *MountManager::benchmark() const
+{
+    return m_benchmark;
+}
+
+void MountManager::setKnownShares(const QList<RemoteNFSShare> &shares)
+{
+    m_replicaSelector->setShares(shares);
+    m_replicaSelector->setMounts(m_managedMounts);
+}
+
+ReplicaSelector *MountManager::replicaSelector() const
+{
+    return m_replicaSelector;
+}
+
+QStringList MountManager::unmountForShutdown(int deadlineMs)
+{
+    if (m_shutdownUnmountDone) {
+        return m_shutdownRemaining;
+    }
+    m_shutdownUnmountDone = true;
+
+    // Mounts being moved to another replica are left to the switch in progress
+    QStringList mountPoints;
+    for (const NFSMount &mount : m_managedMounts) {
+        if (mount.status() == MountStatus::Mounted && !mount.isPersistent()
+            && !m_switchingReplicas.contains(mount.localMountPoint())) {
+            mountPoints << mount.localMountPoint();
+        }
+    }
+    if (mountPoints.isEmpty()) {
+        return QStringList();
+    }
+
+    qDebug() << "MountManager: unmounting" << mountPoints.size() << "temporary mounts within" << deadlineMs << "ms";
+    const QStringList remaining = m_shutdownUnmounter->run(mountPoints, deadlineMs);
+    for (const QString &mountPoint : mountPoints) {
+        if (!remaining.contains(mountPoint)) {
+            removeMountFromTracking(mountPoint);
+            emit unmountCompleted(mountPoint);
+        } else {
+            emit unmountFailed(mountPoint, tr("Still mounted after %1 ms").arg(deadlineMs));
+        }
+    }
+    m_shutdownRemaining = remaining;
+    return remaining;
+}
+
+ShutdownUnmounter *MountManager::shutdownUnmounter() const
+{
+    return m_shutdownUnmounter;
+}
+
+bool MountManager::tuneBackingDevice(const QString &mountPoint, const BdiSettings &settings)
+{
+    QString error;
+    if (!BdiTuner::validate(settings, &error)) {
+        qWarning() << "MountManager: invalid backing device settings for" << mountPoint << ":" << error;
+        return false;
+    }
+    auto it = findMount(mountPoint);
+    if (it == m_managedMounts.end()) {
+        qWarning() << "Cannot tune" << mountPoint << ": not a managed mount";
+        return false;
+    }
+
+    MountOptions options = it->options();
+    setBdiSettings(&options, settings);
+    NFSMount mount(it->remoteShare(), it->localMountPoint(), options, it->isPersistent());
+    mount.setStatus(it->status());
+    mount.setMountedAt(it->mountedAt());
+    mount.setErrorMessage(it->errorMessage());
+    addMountToTracking(mount);
+    if (mount.isPersistent() && !addToFstab(mount)) {
+        return false;
+    }
+    return mount.status() != MountStatus::Mounted || applyBdiSettings(mount);
+}
+
+BdiSettings MountManager::backingDeviceSettings(const QString &mountPoint) const
+{
+    const MountInfoEntry entry = m_mountMonitor->entryForMountPoint(mountPoint);
+    return entry.isNFS() ? m_bdiTuner.current(entry.device) : BdiSettings();
+}
+
+bool MountManager::measureReadAhead(const QString &mountPoint, const QList<int> &readAheadKb)
+{
+    auto it = findMount(mountPoint);
+    if (it == m_managedMounts.end() || it->status() != MountStatus::Mounted) {
+        qWarning() << "Cannot measure readahead of" << mountPoint << ": not mounted";
+        return false;
+    }
+    const MountInfoEntry entry = m_mountMonitor->entryForMountPoint(mountPoint);
+    if (!entry.isNFS() || !m_bdiTuner.exists(entry.device)) {
+        qWarning() << "Cannot measure readahead of" << mountPoint << ": no backing device";
+        return false;
+    }
+
+    // Buffered reads only; the other workloads do not depend on readahead
+    BenchmarkConfig config;
+    config.sequential = false;
+    config.randomIO = false;
+    config.metadata = false;
+    config.readAheadKb = readAheadKb;
+    const BdiTuner tuner = m_bdiTuner;
+    const QString device = entry.device;
+    PolicyKitHelper *helper = tunesSystemDevices(m_bdiTuner) ? m_policyKitHelper : nullptr;
+    config.applyReadAhead = [tuner, device, helper](int kb) {
+        BdiSettings settings;
+        settings.readAheadKb = kb;
+        QString error;
+        if (tuner.apply(device, settings, &error)) {
+            return QString();
+        }
+        if (!helper || !tuner.exists(device)) {
+            // A failed size fails the run instead of measuring the previous readahead again
+            return error.isEmpty() ? QString("Cannot set readahead of %1").arg(device) : error;
+        }
+        // The helper is thread-safe, so the benchmark thread calls it directly
+        return tuneWithPolicyKit(helper, device, settings);
+    };
+
+    const int previous = m_bdiTuner.current(device).readAheadKb;
+    if (!m_benchmark->start(mountPoint, MountAutotuner::serverKey(it->remoteShare()), config)) {
+        return false;
+    }
+    m_readAheadRestores.insert(mountPoint, qMakePair(device, previous));
     return true;
 }
 
+BdiTuner *MountManager::bdiTuner()
+{
+    return &m_bdiTuner;
+}
+
+void MountManager::setPolicyKitHelper(PolicyKitHelper *helper)
+{
+    m_policyKitHelper = helper;
+}
+
+BdiSettings MountManager::bdiSettingsOf(const MountOptions &options)
+{
+    const auto valueOf = [&options](const char *key) {
+        bool ok = false;
+        const int value = options.customOptions.value(key).toInt(&ok);
+        return ok && value >= 0 ? value : -1;
+    };
+    BdiSettings settings;
+    settings.readAheadKb = valueOf(ReadAheadOption);
+    settings.maxRatio = valueOf(MaxRatioOption);
+    return settings;
+}
+
+void MountManager::setBdiSettings(MountOptions *options, const BdiSettings &settings)
+{
+    // x- options are ignored by mount(8) and the kernel, but survive in fstab
+    const auto store = [options](const char *key, int value) {
+        if (value >= 0) {
+            options->customOptions.insert(key, value);
+        } else {
+            options->customOptions.remove(key);
+        }
+    };
+    store(ReadAheadOption, settings.readAheadKb);
+    store(MaxRatioOption, settings.maxRatio);
+}
+
+QStringList MountManager::toMountArguments(const MountOptions &options)
+{
+    QStringList arguments;
+    arguments << (options.readOnly ? "ro" : "rw");
+    arguments << (options.softMount ? "soft" : "hard");
+    if (options.backgroundMount) {
+        arguments << "bg";
+    }
+    if (options.timeoutSeconds > 0) {
+        // timeo is in tenths of a second
+        arguments << QString("timeo=%1").arg(options.timeoutSeconds * 10);
+    }
+    if (options.retryCount > 0) {
+        arguments << QString("retrans=%1").arg(options.retryCount);
+    }
+    if (options.rsize > 0) {
+        arguments << QString("rsize=%1").arg(options.rsize);
+    }
+    if (options.wsize > 0) {
+        arguments << QString("wsize=%1").arg(options.wsize);
+    }
+    if (!options.securityFlavor.isEmpty()) {
+        arguments << QString("sec=%1").arg(options.securityFlavor);
+    }
+    for (auto it = options.customOptions.constBegin(); it != options.customOptions.constEnd(); ++it) {
+        const QString value = it.value().toString();
+        arguments << (value.isEmpty() ? it.key() : QString("%1=%2").arg(it.key(), value));
+    }
+    return arguments;
+}
+
+MountOptions MountManager::fromMountArguments(const QStringList &arguments)
+{
+    MountOptions options;
+    for (const QString &argument : arguments) {
+        const int equals = argument.indexOf('=');
+        const QString key = equals < 0 ? argument : argument.left(equals);
+        const QString value = equals < 0 ? QString() : argument.mid(equals + 1);
+
+        if (key == "ro" || key == "rw") {
+            options.readOnly = key == "ro";
+        } else if (key == "soft" || key == "hard") {
+            options.softMount = key == "soft";
+        } else if (key == "bg" || key == "fg") {
+            options.backgroundMount = key == "bg";
+        } else if (key == "timeo") {
+            options.timeoutSeconds = value.toInt() / 10;
+        } else if (key == "retrans") {
+            options.retryCount = value.toInt();
+        } else if (key == "rsize") {
+            options.rsize = value.toInt();
+        } else if (key == "wsize") {
+            options.wsize = value.toInt();
+        } else if (key == "sec") {
+            options.securityFlavor = value;
+        } else if (key == "nfsvers" || key == "vers") {
+            if (value == "3") {
+                options.nfsVersion = NFSVersion::Version3;
+            } else if (value == "4" || value == "4.0") {
+                options.nfsVersion = NFSVersion::Version4;
+            } else if (value == "4.1") {
+                options.nfsVersion = NFSVersion::Version4_1;
+            } else if (value == "4.2") {
+                options.nfsVersion = NFSVersion::Version4_2;
+            }
+        } else if (key != "defaults" && key != "_netdev" && !key.startsWith("x-systemd.")) {
+            options.customOptions.insert(key, value);
+        }
+    }
+    return options;
+}
+
+QStringList MountManager::toFstabOptions(const NFSMount &mount)
+{
+    QStringList options = toMountArguments(mount.options());
+    switch (mount.options().nfsVersion) {
+    case NFSVersion::Version3:
+        options << "nfsvers=3";
+        break;
+    case NFSVersion::Version4:
+        options << "nfsvers=4";
+        break;
+    case NFSVersion::Version4_1:
+        options << "nfsvers=4.1";
+        break;
+    case NFSVersion::Version4_2:
+        options << "nfsvers=4.2";
+        break;
+    default:
+        break;
+    }
+    return options;
+}
+
+FstabEntry MountManager::toFstabEntry(const NFSMount &mount)
+{
+    const RemoteNFSShare remoteShare = mount.remoteShare();
+    const QString server = remoteShare.hostName().isEmpty() ? remoteShare.hostAddress().toString()
+                                                            : remoteShare.hostName();
+    return FstabEntry(QString("%1:%2").arg(server, QDir::cleanPath(remoteShare.exportPath())),
+                      QDir::cleanPath(mount.localMountPoint()), "nfs",
+                      toFstabOptions(mount) << "_netdev");
+}
+
+QStringList MountManager::automountOptions(int idleTimeoutSeconds)
+{
+    // mount-timeout bounds how long the first access blocks on a dead server
+    return QStringList({"x-systemd.automount",
+                        QString("x-systemd.idle-timeout=%1").arg(qMax(0, idleTimeoutSeconds)),
+                        "x-systemd.mount-timeout=30"});
+}
+
+void MountManager::setPersistenceMode(PersistenceMode mode)
+{
+    m_persistenceMode = mode;
+}
+
+MountManager::PersistenceMode MountManager::persistenceMode() const
+{
+    return m_persistenceMode;
+}
+
+void MountManager::setAutomountIdleTimeout(int seconds)
+{
+    m_automountIdleTimeout = qMax(0, seconds);
+}
+
+int MountManager::automountIdleTimeout() const
+{
+    return m_automountIdleTimeout;
+}
+
+bool MountManager::sampleMountStatistics()
+{
+    return m_nfsService->sampleMountStatistics();
+}
+
+MountStatsRate MountManager::getMountStatistics(const QString &mountPoint) const
+{
+    return m_nfsService->mountStatistics().latestRate(mountPoint);
+}
+
+QList<MountStatsRate> MountManager::getMountStatisticsHistory(const QString &mountPoint) const
+{
+    return m_nfsService->mountStatistics().rateHistory(mountPoint);
+}
+
+bool MountManager::hasMountStatistics(const QString &mountPoint) const
+{
+    return m_nfsService->mountStatistics().hasMount(mountPoint);
+}
+
+bool MountManager::addToFstab(const NFSMount &mount)
+{
+    return applyFstabChanges({mount}, QStringList());
+}
+
 bool MountManager::removeFromFstab(const NFSMount &mount)
 {
-    Q_UNUSED(mount)
-    return true;
+    return applyFstabChanges(QList<NFSMount>(), {mount.localMountPoint()});
 }
 
 bool MountManager::isInFstab(const NFSMount &mount) const
 {
-    Q_UNUSED(mount)
+    // A stat() unless fstab changed since the last parse
+    m_fstab.reloadIfChanged();
+    return m_fstab.contains(mount.localMountPoint());
+}
+
+bool MountManager::applyFstabChanges(const QList<NFSMount> &additions, const QStringList &removals,
+                                     QString *errorMessage)
+{
+    QString error;
+    if (!m_fstab.reloadIfChanged()) {
+        error = tr("Failed to read %1").arg(m_fstab.filePath());
+    } else {
+        // A mount point that is also added keeps its line and is rewritten in place
+        QSet<QString> added;
+        for (const NFSMount &mount : additions) {
+            added.insert(QDir::cleanPath(mount.localMountPoint()));
+        }
+
+        // Automount units of entries that go away or stop automounting must be stopped
+        QStringList automounted;
+        for (const QString &mountPoint : added.values() + removals) {
+            if (m_fstab.entry(mountPoint).options.contains("x-systemd.automount")) {
+                automounted << QDir::cleanPath(mountPoint);
+            }
+        }
+
+        for (const QString &mountPoint : removals) {
+            if (!added.contains(QDir::cleanPath(mountPoint))) {
+                m_fstab.removeEntry(mountPoint);
+            }
+        }
+        for (const NFSMount &mount : additions) {
+            m_fstab.setEntry(fstabEntryFor(mount));
+        }
+
+        if (!m_fstab.isModified()) {
+            return true;
+        }
+        bool saved = false;
+        if (!backupFstab()) {
+            error = tr("Failed to create backup of %1").arg(m_fstab.filePath());
+        } else {
+            saved = m_fstab.save(&error);
+        }
+
+        // The system fstab is owned by root; the helper makes the same edits there
+        if (!saved && m_policyKitHelper
+            && QFileInfo(m_fstab.filePath()).absoluteFilePath() == FstabFile::defaultPath()) {
+            qDebug() << "MountManager: updating fstab through PolicyKit:" << error;
+            saved = saveFstabWithPolicyKit(additions, removals, &error) && m_fstab.load(&error);
+        }
+
+        if (saved) {
+            qDebug() << "Updated" << m_fstab.filePath() << ":" << additions.size() << "added,"
+                     << removals.size() << "removed";
+
+            for (const QString &mountPoint : automounted) {
+                if (!m_fstab.entry(mountPoint).options.contains("x-systemd.automount")) {
+                    m_systemd->stopUnit(SystemdManager::unitNameForPath(mountPoint, "automount"));
+                }
+            }
+            for (const NFSMount &mount : additions) {
+                if (m_fstab.entry(mount.localMountPoint()).options.contains("x-systemd.automount")) {
+                    m_pendingAutomounts << SystemdManager::unitNameForPath(mount.localMountPoint(), "automount");
+                }
+            }
+            if (!m_systemd->reloadDaemon()) {
+                // Without systemd the entries take effect at the next boot
+                m_pendingAutomounts.clear();
+            }
+            return true;
+        }
+    }
+
+    // Drop the unsaved edits so the cache matches the file again
+    m_fstab.load();
+    qWarning() << "MountManager: fstab update failed:" << error;
+    if (errorMessage) {
+        *errorMessage = error;
+    }
     return false;
 }
 
+bool MountManager::saveFstabWithPolicyKit(const QList<NFSMount> &additions, const QStringList &removals,
+                                          QString *errorMessage)
+{
+    QStringList entries;
+    QSet<QString> added;
+    for (const NFSMount &mount : additions) {
+        entries << FstabFile::formatLine(fstabEntryFor(mount));
+        added.insert(QDir::cleanPath(mount.localMountPoint()));
+    }
+    QStringList removeMountPoints;
+    for (const QString &mountPoint : removals) {
+        if (!added.contains(QDir::cleanPath(mountPoint))) {
+            removeMountPoints << mountPoint;
+        }
+    }
+
+    QVariantMap parameters;
+    if (!entries.isEmpty()) {
+        parameters["fstabEntries"] = entries;
+    }
+    if (!removeMountPoints.isEmpty()) {
+        parameters["removeMountPoints"] = removeMountPoints;
+    }
+    return m_policyKitHelper->executePrivilegedAction(PolicyKitHelper::Action::ModifyFstab, parameters,
+                                                      errorMessage, nullptr);
+}
+
 QList<NFSMount> MountManager::loadPersistentMounts()
 {
-    return QList<NFSMount>();
+    return parseFstabEntries();
+}
+
+void MountManager::setFstabPath(const QString &filePath)
+{
+    m_fstab.setFilePath(filePath);
 }
 
-void MountManager::onRefreshTimer()
+QString MountManager::fstabPath() const
 {
+    return m_fstab.filePath();
 }
 
-void MountManager::onFileSystemChanged(const QString &path)
+void MountManager::onMountTableAdded(const MountInfoEntry &entry)
 {
-    Q_UNUSED(path)
+    if (!entry.isNFS()) {
+        return;
+    }
+
+    NFSMount mount;
+    auto it = findMount(entry.mountPoint);
+    if (it != m_managedMounts.end()) {
+        m_mountIds.insert(entry.mountId, entry.mountPoint);
+        if (it->status() == MountStatus::Mounted) {
+            // Completion of our own mount was reported first; its backing device exists only now
+            applyBdiSettings(*it);
+            return;
+        }
+        mount = *it;
+    } else {
+        // Mounted outside this application
+        RemoteNFSShare remoteShare;
+        if (!parseNFSSource(entry.source, &remoteShare)) {
+            return;
+        }
+        m_fstab.reloadIfChanged();
+        MountOptions options = mountOptionsOf(entry);
+        const bool persistent = m_fstab.contains(entry.mountPoint);
+        if (persistent) {
+            // Mounted at boot or by automount; the kernel does not know our x- options
+            setBdiSettings(&options, bdiSettingsOf(fromMountArguments(m_fstab.entry(entry.mountPoint).options)));
+        }
+        mount = NFSMount(remoteShare, entry.mountPoint, options, persistent);
+        m_mountIds.insert(entry.mountId, entry.mountPoint);
+    }
+
+    mount.setStatus(MountStatus::Mounted);
+    if (!mount.mountedAt().isValid()) {
+        mount.setMountedAt(QDateTime::currentDateTime());
+    }
+    addMountToTracking(mount);
+    applyBdiSettings(mount);
+    emit mountStatusChanged(mount);
+}
+
+void MountManager::onMountTableRemoved(const MountInfoEntry &entry)
+{
+    const QString mountPoint = m_mountIds.take(entry.mountId);
+    if (mountPoint.isEmpty() || m_switchingReplicas.contains(mountPoint)) {
+        return;
+    }
+    // The mount point stays mounted while another tracked mount is stacked on it
+    for (auto it = m_mountIds.cbegin(); it != m_mountIds.cend(); ++it) {
+        if (it.value() == mountPoint) {
+            return;
+        }
+    }
+
+    auto it = findMount(mountPoint);
+    if (it == m_managedMounts.end() || it->status() == MountStatus::NotMounted) {
+        return;
+    }
+    NFSMount mount = *it;
+    mount.setStatus(MountStatus::NotMounted);
+    if (mount.isPersistent()) {
+        addMountToTracking(mount);
+    } else {
+        removeMountFromTracking(mountPoint);
+    }
+    emit mountStatusChanged(mount);
+}
+
+void MountManager::onMountTableChanged(const MountInfoEntry &previous, const MountInfoEntry &current)
+{
+    if (previous.mountPoint != current.mountPoint) {
+        // mount --move
+        onMountTableRemoved(previous);
+        onMountTableAdded(current);
+        return;
+    }
+    if (!m_mountIds.contains(current.mountId)) {
+        return;
+    }
+    auto it = findMount(current.mountPoint);
+    if (it == m_managedMounts.end()) {
+        return;
+    }
+    if (previous.mountOptions == current.mountOptions) {
+        // Superblock options changed; make sure the tuning survived
+        applyBdiSettings(*it);
+        return;
+    }
+
+    // A remount changed the per-mount flags, e.g. rw to ro
+    MountOptions options = it->options();
+    options.readOnly = current.mountOptions.contains("ro");
+    NFSMount mount(it->remoteShare(), it->localMountPoint(), options, it->isPersistent());
+    mount.setStatus(it->status());
+    mount.setMountedAt(it->mountedAt());
+    mount.setErrorMessage(it->errorMessage());
+    *it = mount;
+    applyBdiSettings(mount);
+    emit mountStatusChanged(mount);
+}
+
+void MountManager::onStatisticsTimer()
+{
+    if (sampleMountStatistics()) {
+        emit mountStatisticsUpdated();
+    }
+}
+
+void MountManager::onBatchMountFailed(const NFSMount &mount, MountOrchestrator::FailureReason reason,
+                                      const QString &error)
+{
+    MountResult result = MountResult::NFSServiceError;
+    switch (reason) {
+    case MountOrchestrator::FailureReason::OperationFailed:
+        result = MountResult::NFSServiceError;
+        break;
+    case MountOrchestrator::FailureReason::DependencyFailed:
+        result = MountResult::SystemError;
+        break;
+    case MountOrchestrator::FailureReason::InvalidEntry:
+        result = MountResult::InvalidMountPoint;
+        break;
+    case MountOrchestrator::FailureReason::Cancelled:
+        result = MountResult::Cancelled;
+        break;
+    }
+    m_replicaSelector->takeSelection(mount.localMountPoint(), nullptr);
+    emit mountFailed(mount.remoteShare(), mount.localMountPoint(), result, error);
+}
+
+void MountManager::onMountHealthChanged(const NFSMount &mount, MountHealthWatchdog::Health health,
+                                       const QString &message)
+{
+    auto it = findMount(mount.localMountPoint());
+    if (it == m_managedMounts.end()) {
+        return;
+    }
+    if (updateMountStatus(*it)) {
+        qDebug() << "Mount health of" << mount.localMountPoint() << "changed:" << health << message;
+        emit mountStatusChanged(*it);
+    }
+}
+
+void MountManager::onReplicaDegraded(const NFSMount &mount, const RemoteNFSShare &better, double currentMs,
+                                     double betterMs)
+{
+    const QString mountPoint = mount.localMountPoint();
+    if (!mount.options().readOnly) {
+        // Moving would lose data that is written but not yet flushed
+        qWarning() << "MountManager:" << mountPoint << "has a faster replica but is mounted read-write, not moving it";
+        return;
+    }
+    if (m_switchingReplicas.contains(mountPoint)) {
+        return;
+    }
+    m_switchingReplicas.insert(mountPoint);
+    qDebug() << "Moving" << mountPoint << "to a faster replica:" << currentMs << "ms vs" << betterMs << "ms";
+
+    const NFSMount replacement(better, mountPoint, mount.options(), mount.isPersistent());
+    NFSServiceInterface *nfsService = m_nfsService;
+
+    // A busy mount point refuses the plain unmount and stays on its replica
+    m_replicaMovePool.start([this, nfsService, mount, replacement]() {
+        QString error = commandError(nfsService->unmountNFSShare(mount.localMountPoint(), false));
+        if (error.isEmpty()) {
+            error = mountWith(nfsService, replacement.remoteShare(), replacement);
+            if (!error.isEmpty()) {
+                const QString restoreError = mountWith(nfsService, mount.remoteShare(), mount);
+                if (!restoreError.isEmpty()) {
+                    error += "; remounting the previous replica failed: " + restoreError;
+                }
+            }
+        }
+
+        // The destructor waits for the pool, so this is still alive here
+        QMetaObject::invokeMethod(this, [this, mount, replacement, error]() {
+            onReplicaSwitched(mount, replacement, error);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MountManager::onReplicaSwitched(const NFSMount &previous, const NFSMount &replacement, const QString &error)
+{
+    const QString mountPoint = replacement.localMountPoint();
+    m_switchingReplicas.remove(mountPoint);
+    if (!error.isEmpty()) {
+        qWarning() << "MountManager: moving" << mountPoint << "to another replica failed:" << error;
+
+        // Mount table events were ignored during the move; the previous replica may be gone
+        m_mountMonitor->rescan();
+        auto it = findMount(mountPoint);
+        if (it != m_managedMounts.end() && !m_mountMonitor->entryForMountPoint(mountPoint).isNFS()) {
+            NFSMount mount = *it;
+            mount.setStatus(MountStatus::NotMounted);
+            mount.setErrorMessage(error);
+            if (mount.isPersistent()) {
+                addMountToTracking(mount);
+            } else {
+                removeMountFromTracking(mountPoint);
+            }
+            emit mountStatusChanged(mount);
+        }
+        return;
+    }
+
+    // fstab keeps the replica the user chose
+    NFSMount mount = replacement;
+    mount.setStatus(MountStatus::Mounted);
+    mount.setMountedAt(QDateTime::currentDateTime());
+    addMountToTracking(mount);
+    qDebug() << "Moved" << mountPoint << "from" << previous.remoteShare().hostName() << "to"
+             << replacement.remoteShare().hostName();
+    emit mountStatusChanged(mount);
+}
+
+void MountManager::onDaemonReloaded(bool success, const QString &errorMessage)
+{
+    const QStringList units = m_pendingAutomounts;
+    m_pendingAutomounts.clear();
+    if (!success) {
+        qWarning() << "MountManager: automount units not started, daemon reload failed:" << errorMessage;
+        return;
+    }
+    // Starting the .automount only arms the mount point; the share mounts on first access
+    for (const QString &unit : units) {
+        m_systemd->startUnit(unit);
+    }
 }
 
 void MountManager::onPolicyKitActionCompleted(PolicyKitHelper::Action action, bool success, const QString &errorMessage)
@@ -159,8 +1126,17 @@ bool MountManager::performUnmount(const QString &mountPoint, bool force)
 
 bool MountManager::updateMountStatus(NFSMount &mount)
 {
-    Q_UNUSED(mount)
-    return false;
+    // An unresponsive mount stays Mounted; the error marks it as degraded
+    const MountHealthWatchdog::Health health = m_healthWatchdog->health(mount.localMountPoint());
+    const QString message = health == MountHealthWatchdog::Health::Healthy
+                            || health == MountHealthWatchdog::Health::Unknown
+                                ? QString()
+                                : m_healthWatchdog->healthMessage(mount.localMountPoint());
+    if (mount.errorMessage() == message) {
+        return false;
+    }
+    mount.setErrorMessage(message);
+    return true;
 }
 
 QString MountManager::generateMountPoint(const RemoteNFSShare &remoteShare) const
@@ -177,34 +1153,154 @@ bool MountManager::validateMountOptions(const MountOptions &options) const
 
 QList<NFSMount> MountManager::parseFstabEntries() const
 {
-    return QList<NFSMount>();
+    m_fstab.reloadIfChanged();
+
+    QList<NFSMount> mounts;
+    const QList<FstabEntry> entries = m_fstab.entries();
+    for (const FstabEntry &entry : entries) {
+        RemoteNFSShare remoteShare;
+        if (entry.isNFS() && parseNFSSource(entry.source, &remoteShare)) {
+            mounts << NFSMount(remoteShare, entry.mountPoint, fromMountArguments(entry.options), true);
+        }
+    }
+    return mounts;
 }
 
-bool MountManager::backupFstab() const
+bool MountManager::applyBdiSettings(const NFSMount &mount)
 {
+    const BdiSettings settings = bdiSettingsOf(mount.options());
+    if (settings.isEmpty()) {
+        return true;
+    }
+    const MountInfoEntry entry = m_mountMonitor->entryForMountPoint(mount.localMountPoint());
+    if (!entry.isNFS()) {
+        // Applied when the kernel reports the mount
+        return false;
+    }
+
+    const QString error = writeBdiSettings(mount.localMountPoint(), entry.device, settings);
+    if (!error.isEmpty()) {
+        qWarning() << "MountManager: cannot tune backing device of" << mount.localMountPoint() << ":" << error;
+        emit backingDeviceTuningFailed(mount.localMountPoint(), error);
+        return false;
+    }
     return true;
 }
 
+QString MountManager::writeBdiSettings(const QString &mountPoint, const QString &device,
+                                      const BdiSettings &settings)
+{
+    QString error;
+    if (m_bdiTuner.apply(device, settings, &error)) {
+        return QString();
+    }
+    // Invalid settings or a missing device do not get better with privileges
+    if (!m_policyKitHelper || !BdiTuner::validate(settings) || !m_bdiTuner.exists(device)
+        || !tunesSystemDevices(m_bdiTuner)) {
+        return error;
+    }
+
+    // The helper may be busy with an export reload, which must not stall the GUI thread
+    qDebug() << "MountManager: tuning backing device" << device << "through PolicyKit:" << error;
+    PolicyKitHelper *helper = m_policyKitHelper;
+    m_tuningPool.start([this, helper, mountPoint, device, settings]() {
+        const QString helperError = tuneWithPolicyKit(helper, device, settings);
+        if (helperError.isEmpty()) {
+            return;
+        }
+        QMetaObject::invokeMethod(this, [this, mountPoint, helperError]() {
+            qWarning() << "MountManager: cannot tune backing device of" << mountPoint << ":" << helperError;
+            emit backingDeviceTuningFailed(mountPoint, helperError);
+        }, Qt::QueuedConnection);
+    });
+    return QString();
+}
+
+FstabEntry MountManager::fstabEntryFor(const NFSMount &mount) const
+{
+    FstabEntry entry = toFstabEntry(mount);
+    if (m_persistenceMode == PersistenceMode::Automount) {
+        entry.options << automountOptions(m_automountIdleTimeout);
+    }
+    return entry;
+}
+
+bool MountManager::backupFstab() const
+{
+    QFile fstab(m_fstab.filePath());
+    if (!fstab.exists()) {
+        return true;
+    }
+    if (!fstab.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // One rolling copy of the version before our last change
+    return AtomicFileWriter::writeFile(m_fstab.filePath() + ".backup", fstab.readAll());
+}
+
 void MountManager::addMountToTracking(const NFSMount &mount)
 {
-    Q_UNUSED(mount)
+    auto it = findMount(mount.localMountPoint());
+    if (it != m_managedMounts.end()) {
+        *it = mount;
+    } else {
+        m_managedMounts.append(mount);
+    }
+    m_healthWatchdog->setMounts(m_managedMounts);
+    m_replicaSelector->setMounts(m_managedMounts);
+    updateMonitoringTimers();
 }
 
 void MountManager::removeMountFromTracking(const QString &mountPoint)
 {
-    Q_UNUSED(mountPoint)
+    auto it = findMount(mountPoint);
+    if (it != m_managedMounts.end()) {
+        m_managedMounts.erase(it);
+        m_healthWatchdog->setMounts(m_managedMounts);
+        m_replicaSelector->setMounts(m_managedMounts);
+        updateMonitoringTimers();
+    }
+}
+
+void MountManager::updateMonitoringTimers()
+{
+    const bool anyMounted = std::any_of(m_managedMounts.constBegin(), m_managedMounts.constEnd(),
+                                        [](const NFSMount &mount) {
+        return mount.status() == MountStatus::Mounted;
+    });
+
+    // Idle sessions with nothing mounted should not wake up every few seconds
+    if (!anyMounted) {
+        m_statisticsTimer->stop();
+        m_healthWatchdog->stop();
+        m_replicaSelector->stop();
+        return;
+    }
+
+    if (!m_statisticsTimer->isActive()) {
+        m_statisticsTimer->start();
+    }
+    if (!m_healthWatchdog->isRunning()) {
+        m_healthWatchdog->start(m_refreshInterval * 1000);
+    }
+    if (!m_replicaSelector->isRunning()) {
+        m_replicaSelector->start();
+    }
 }
 
 QList<NFSMount>::iterator MountManager::findMount(const QString &mountPoint)
 {
-    Q_UNUSED(mountPoint)
-    return m_managedMounts.end();
+    return std::find_if(m_managedMounts.begin(), m_managedMounts.end(), [&mountPoint](const NFSMount &mount) {
+        return mount.localMountPoint() == mountPoint;
+    });
 }
 
 QList<NFSMount>::const_iterator MountManager::findMount(const QString &mountPoint) const
 {
-    Q_UNUSED(mountPoint)
-    return m_managedMounts.end();
+    return std::find_if(m_managedMounts.constBegin(), m_managedMounts.constEnd(), [&mountPoint](const NFSMount &mount) {
+        return mount.localMountPoint() == mountPoint;
+    });
 }
 
 } // namespace NFSShareManager
\ No newline at end of file
@@ -2,12 +2,24 @@
 
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QSet>
+#include <QThreadPool>
 #include <QTimer>
-#include <QFileSystemWatcher>
 #include "../core/nfsmount.h"
 #include "../core/remotenfsshare.h"
 #include "../system/nfsserviceinterface.h"
 #include "../system/policykithelper.h"
+#include "../system/bdituner.h"
+#include "../system/fstabfile.h"
+#include "../system/mounttablemonitor.h"
+#include "../system/systemdmanager.h"
+#include "mountautotuner.h"
+#include "mountbenchmark.h"
+#include "mounthealthwatchdog.h"
+#include "mountorchestrator.h"
+#include "replicaselector.h"
+#include "shutdownunmounter.h"
 
 namespace NFSShareManager {
 
@@ -40,6 +52,21 @@ public:
     };
     Q_ENUM(MountResult)
 
+    /**
+     * @brief How persistent mounts are brought up
+     */
+    enum class PersistenceMode {
+        Boot,           ///< Mounted at boot by remote-fs.target
+        Automount       ///< Mounted on first access and unmounted when idle (x-systemd.automount)
+    };
+    Q_ENUM(PersistenceMode)
+
+    /// Mount option holding the readahead of the mount's backing device in KiB
+    static constexpr const char *ReadAheadOption = "x-nfs-share-manager.read_ahead_kb";
+
+    /// Mount option holding the max_ratio of the mount's backing device in percent
+    static constexpr const char *MaxRatioOption = "x-nfs-share-manager.max_ratio";
+
     explicit MountManager(QObject *parent = nullptr);
     ~MountManager();
 
@@ -72,6 +99,52 @@ public:
      */
     bool unmountShare(const NFSMount &mount, bool force = false);
 
+    /**
+     * @brief Mount many shares concurrently
+     *
+     * Mounts nested in another mount of the batch wait for it; independent
+     * ones run in parallel. Each result is reported through mountCompleted()
+     * or mountFailed(), then mountBatchFinished() follows. A persistent
+     * mount without an fstab entry gets one once it is mounted. A batch
+     * that nests with one still running waits for it rather than failing;
+     * mountStarted() is emitted when each mount actually starts.
+     *
+     * @param mounts The mounts to perform
+     * @return Id of the batch, passed to mountBatchFinished()
+     */
+    int mountShares(const QList<NFSMount> &mounts);
+
+    /**
+     * @brief Unmount many mount points concurrently, nested ones first
+     * @param mountPoints The mount points to unmount
+     * @param force Whether to force unmount if busy
+     * @return Id of the batch, passed to mountBatchFinished()
+     */
+    int unmountShares(const QStringList &mountPoints, bool force = false);
+
+    /**
+     * @brief Mount every persistent mount from fstab as one batch
+     *
+     * Entries that are already mounted, marked noauto or automounted by
+     * systemd are skipped. Mounts and unmounts started while the restore
+     * waits on slow servers run beside it.
+     *
+     * @return Id of the batch, or 0 if there was nothing to restore
+     */
+    int restorePersistentMounts();
+
+    /**
+     * @brief Get the batch mount orchestrator
+     * @return The orchestrator owned by this manager
+     */
+    MountOrchestrator *orchestrator() const;
+
+    /**
+     * @brief Get the NFS service interface
+     * @return Wrapper around the NFS tools, owned by the mount manager
+     */
+    NFSServiceInterface *nfsService() const;
+
     /**
      * @brief Get list of currently managed mounts
      * @return List of active NFS mounts
@@ -122,9 +195,33 @@ public:
 
     /**
      * @brief Refresh the status of all managed mounts
+     *
+     * Re-reads the mount table and starts a health check of every managed
+     * mount, then returns immediately; changes arrive through
+     * mountStatusChanged(). Mounts and unmounts are tracked as the kernel
+     * reports them, so this is only needed to force a health check.
      */
     void refreshMountStatus();
 
+    /**
+     * @brief Get the kernel mount table monitor
+     * @return The monitor owned by this manager
+     */
+    MountTableMonitor *mountTableMonitor() const;
+
+    /**
+     * @brief Get the result of the last health check of a mount
+     * @param mountPoint The local mount point
+     * @return Health of the mount, Unknown if it was not checked yet
+     */
+    MountHealthWatchdog::Health getMountHealth(const QString &mountPoint) const;
+
+    /**
+     * @brief Get the mount health watchdog
+     * @return The watchdog owned by this manager
+     */
+    MountHealthWatchdog *healthWatchdog() const;
+
     /**
      * @brief Get the default mount options for a remote share
      * @param remoteShare The remote share to get options for
@@ -132,8 +229,259 @@ public:
      */
     MountOptions getDefaultMountOptions(const RemoteNFSShare &remoteShare) const;
 
+    /**
+     * @brief Benchmark candidate mount options for a share's server
+     *
+     * Mounts the share temporarily with several option sets, measures them
+     * and stores the best set, which getDefaultMountOptions() then returns
+     * for every share of that server. Runs on a worker thread; progress and
+     * the result are reported by autotuner().
+     *
+     * @param remoteShare The share to benchmark
+     * @return False if another tuning run is in progress
+     */
+    bool autotuneMountOptions(const RemoteNFSShare &remoteShare);
+
+    /**
+     * @brief Check if tuned options exist for a share's server
+     * @param remoteShare The remote share
+     * @return true if autotuning was run for the server
+     */
+    bool hasTunedMountOptions(const RemoteNFSShare &remoteShare) const;
+
+    /**
+     * @brief Get the mount option autotuner
+     * @return The autotuner owned by this manager
+     */
+    MountAutotuner *autotuner() const;
+
+    /**
+     * @brief Start an I/O benchmark of a mounted share
+     *
+     * Runs on worker threads; progress and the result are reported by
+     * benchmark(). The result is kept in the history of the mount point
+     * and of its server.
+     *
+     * @param mountPoint Mount point of a managed, mounted share
+     * @param config Workloads to run
+     * @return False if the mount is not mounted or a benchmark is already running
+     */
+    bool benchmarkMount(const QString &mountPoint, const BenchmarkConfig &config = BenchmarkConfig());
+
+    /**
+     * @brief Get the mount benchmark runner
+     * @return The benchmark runner owned by this manager
+     */
+    MountBenchmark *benchmark() const;
+
+    /**
+     * @brief Set the readahead and max_ratio of a managed mount
+     *
+     * The settings are stored in the mount's options, and in its fstab
+     * entry if it is persistent, and are applied again after every mount
+     * and remount.
+     *
+     * @param mountPoint Mount point of a managed mount
+     * @param settings The settings; -1 values return to the kernel default on the next mount
+     * @return False if the mount is unknown, the settings are invalid or could not be applied
+     */
+    bool tuneBackingDevice(const QString &mountPoint, const BdiSettings &settings);
+
+    /**
+     * @brief Get the settings the kernel currently uses for a mount
+     * @param mountPoint The mount point
+     * @return The settings, -1 where unknown
+     */
+    BdiSettings backingDeviceSettings(const QString &mountPoint) const;
+
+    /**
+     * @brief Compare buffered read throughput of a mount at several readahead sizes
+     *
+     * Runs through benchmark(); the result carries one ReadAheadSample per
+     * size. The previous readahead, or the configured one, is restored
+     * when the run ends.
+     *
+     * @param mountPoint Mount point of a managed, mounted share
+     * @param readAheadKb The readahead sizes to compare in KiB
+     * @return False if the mount is not mounted, has no backing device or a benchmark is already running
+     */
+    bool measureReadAhead(const QString &mountPoint,
+                          const QList<int> &readAheadKb = QList<int>({128, 512, 1024, 4096, 16384}));
+
+    /**
+     * @brief Get the backing device tuner
+     * @return The tuner used for all mounts
+     */
+    BdiTuner *bdiTuner();
+
+    /**
+     * @brief Let backing device settings go through PolicyKit
+     *
+     * Settings are written to sysfs directly first; where the user cannot
+     * write there they go through the TuneBackingDevice action, off the
+     * GUI thread. The helper must outlive the manager.
+     *
+     * @param helper The helper, or nullptr to write directly only
+     */
+    void setPolicyKitHelper(PolicyKitHelper *helper);
+
+    /**
+     * @brief Get the backing device settings stored in mount options
+     * @param options The mount options
+     */
+    static BdiSettings bdiSettingsOf(const MountOptions &options);
+
+    /**
+     * @brief Store backing device settings in mount options
+     * @param options The mount options to change
+     * @param settings The settings; -1 values are removed
+     */
+    static void setBdiSettings(MountOptions *options, const BdiSettings &settings);
+
+    /**
+     * @brief Set the shares known from network discovery
+     *
+     * Shares with the same export path on several servers are treated as
+     * replicas: batch mounts use the fastest one, and a read-only mount is
+     * moved to another replica when its own stays much slower.
+     *
+     * @param shares The discovered shares
+     */
+    void setKnownShares(const QList<RemoteNFSShare> &shares);
+
+    /**
+     * @brief Get the replica selector
+     * @return The replica selector owned by this manager
+     */
+    ReplicaSelector *replicaSelector() const;
+
+    /**
+     * @brief Unmount all temporary mounts before the application exits
+     *
+     * All unmounts run at once and the call returns by the deadline, even
+     * if servers are gone; mounts not gone in time are escalated to lazy
+     * and then forced unmounts (see ShutdownUnmounter). Persistent mounts
+     * are left to the system.
+     *
+     * Runs once; later calls return the mount points left by the first
+     * without retrying them, so exit paths may call it more than once.
+     *
+     * @param deadlineMs Time allowed for all unmounts
+     * @return Mount points that are still mounted
+     */
+    QStringList unmountForShutdown(int deadlineMs = 1000);
+
+    /**
+     * @brief Get the shutdown unmounter
+     * @return The shutdown unmounter owned by this manager
+     */
+    ShutdownUnmounter *shutdownUnmounter() const;
+
+    /**
+     * @brief Convert mount options into mount(8) -o arguments
+     *
+     * The NFS version is not included; it is passed separately to
+     * NFSServiceInterface::mountNFSShare().
+     *
+     * @param options The mount options
+     * @return List of option strings
+     */
+    static QStringList toMountArguments(const MountOptions &options);
+
+    /**
+     * @brief Convert mount(8) -o arguments back into mount options
+     *
+     * Inverse of toMountArguments(); nfsvers= and vers= set the NFS
+     * version, unknown options end up in customOptions.
+     *
+     * @param arguments List of option strings
+     * @return Mount options
+     */
+    static MountOptions fromMountArguments(const QStringList &arguments);
+
+    /**
+     * @brief Get the fstab options of a persistent mount
+     *
+     * toMountArguments() plus the NFS version, since fstab has no separate
+     * version field.
+     *
+     * @param mount The mount
+     * @return List of option strings
+     */
+    static QStringList toFstabOptions(const NFSMount &mount);
+
+    /**
+     * @brief Get the fstab entry of a persistent mount
+     * @param mount The mount
+     * @return Entry with _netdev added, so boot waits for the network
+     */
+    static FstabEntry toFstabEntry(const NFSMount &mount);
+
+    /**
+     * @brief Sample client-side NFS statistics for all mounts now
+     * @return true if the statistics could be read
+     */
+    bool sampleMountStatistics();
+
+    /**
+     * @brief Get the latest throughput and latency figures for a mount
+     * @param mountPoint The local mount point
+     * @return Latest rates (zeroed until two samples were taken)
+     */
+    MountStatsRate getMountStatistics(const QString &mountPoint) const;
+
+    /**
+     * @brief Get the recorded statistics history for a mount, oldest first
+     * @param mountPoint The local mount point
+     * @return Rate samples of the last MountStatistics::HistorySize intervals
+     */
+    QList<MountStatsRate> getMountStatisticsHistory(const QString &mountPoint) const;
+
+    /**
+     * @brief Check if statistics are available for a mount
+     * @param mountPoint The local mount point
+     * @return true if the mount appears in the kernel statistics
+     */
+    bool hasMountStatistics(const QString &mountPoint) const;
+
+    /**
+     * @brief Get the fstab options that make systemd automount an entry
+     * @param idleTimeoutSeconds Idle time before the share is unmounted, 0 to keep it mounted
+     * @return x-systemd.automount and its timeouts
+     */
+    static QStringList automountOptions(int idleTimeoutSeconds);
+
+    /**
+     * @brief Choose how persistent mounts written to fstab are brought up
+     *
+     * Only affects entries written afterwards. In automount mode boot does
+     * not wait for the servers; systemd mounts a share on first access.
+     *
+     * @param mode The persistence mode
+     */
+    void setPersistenceMode(PersistenceMode mode);
+
+    /**
+     * @brief Get the persistence mode of new fstab entries
+     */
+    PersistenceMode persistenceMode() const;
+
+    /**
+     * @brief Set how long an automounted share may stay unused
+     * @param seconds Idle time before systemd unmounts it, 0 to never unmount
+     */
+    void setAutomountIdleTimeout(int seconds);
+
+    /**
+     * @brief Get the automount idle timeout in seconds
+     */
+    int automountIdleTimeout() const;
+
     /**
      * @brief Add a persistent mount entry to fstab
+     *
+     * An existing entry for the mount point is replaced in place.
+     *
      * @param mount The mount to add to fstab
      * @return true if fstab was updated successfully
      */
@@ -153,12 +501,45 @@ public:
      */
     bool isInFstab(const NFSMount &mount) const;
 
+    /**
+     * @brief Add and remove several fstab entries with a single rewrite
+     *
+     * If the system fstab cannot be written directly, the rewrite goes
+     * through PolicyKit (see setPolicyKitHelper()).
+     *
+     * @param additions Mounts whose entry to add or replace
+     * @param removals Mount points whose entries to remove
+     * @param errorMessage Optional output for a description of the failure
+     * @return true if fstab holds the changes
+     */
+    bool applyFstabChanges(const QList<NFSMount> &additions, const QStringList &removals,
+                           QString *errorMessage = nullptr);
+
+    /**
+     * @brief Make the changes of applyFstabChanges() through the ModifyFstab action
+     *
+     * Used when the system fstab cannot be written directly.
+     */
+    bool saveFstabWithPolicyKit(const QList<NFSMount> &additions, const QStringList &removals,
+                                QString *errorMessage);
+
     /**
      * @brief Load persistent mounts from fstab
      * @return List of NFS mounts found in fstab
      */
     QList<NFSMount> loadPersistentMounts();
 
+    /**
+     * @brief Set the fstab file to manage (for testing)
+     * @param filePath Replacement for /etc/fstab
+     */
+    void setFstabPath(const QString &filePath);
+
+    /**
+     * @brief Get the managed fstab file path
+     */
+    QString fstabPath() const;
+
 signals:
     /**
      * @brief Emitted when a mount operation starts
@@ -183,6 +564,14 @@ signals:
     void mountFailed(const RemoteNFSShare &remoteShare, const QString &mountPoint, 
                      MountResult result, const QString &errorMessage);
 
+    /**
+     * @brief Emitted when a mountShares() or unmountShares() batch has finished
+     * @param batch Id returned when the batch was started
+     * @param succeeded Entries that completed
+     * @param failed Entries that failed or were skipped
+     */
+    void mountBatchFinished(int batch, int succeeded, int failed);
+
     /**
      * @brief Emitted when an unmount operation starts
      * @param mountPoint The mount point being unmounted
@@ -202,23 +591,69 @@ signals:
      */
     void unmountFailed(const QString &mountPoint, const QString &errorMessage);
 
+    /**
+     * @brief Emitted when the backing device settings of a mount could not be applied
+     * @param mountPoint The mount point
+     * @param errorMessage Detailed error message
+     */
+    void backingDeviceTuningFailed(const QString &mountPoint, const QString &errorMessage);
+
     /**
      * @brief Emitted when mount status changes
      * @param mount The mount with updated status
      */
     void mountStatusChanged(const NFSMount &mount);
 
+    /**
+     * @brief Emitted after a new statistics sample was taken
+     */
+    void mountStatisticsUpdated();
+
 private slots:
     /**
-     * @brief Handle mount status refresh timer
+     * @brief Track an NFS mount that appeared in the mount table
+     */
+    void onMountTableAdded(const MountInfoEntry &entry);
+
+    /**
+     * @brief Mark a tracked mount as unmounted when it leaves the mount table
+     */
+    void onMountTableRemoved(const MountInfoEntry &entry);
+
+    /**
+     * @brief Update a tracked mount after a remount or move
+     */
+    void onMountTableChanged(const MountInfoEntry &previous, const MountInfoEntry &current);
+
+    /**
+     * @brief Handle statistics sampling timer
+     */
+    void onStatisticsTimer();
+
+    /**
+     * @brief Handle a failed mount of a batch
+     */
+    void onBatchMountFailed(const NFSMount &mount, MountOrchestrator::FailureReason reason, const QString &error);
+
+    /**
+     * @brief Apply a health check result to the tracked mount
      */
-    void onRefreshTimer();
+    void onMountHealthChanged(const NFSMount &mount, MountHealthWatchdog::Health health, const QString &message);
 
     /**
-     * @brief Handle file system changes
-     * @param path The path that changed
+     * @brief Move a read-only mount from a degraded replica to a faster one
      */
-    void onFileSystemChanged(const QString &path);
+    void onReplicaDegraded(const NFSMount &mount, const RemoteNFSShare &better, double currentMs, double betterMs);
+
+    /**
+     * @brief Track the result of a replica move
+     */
+    void onReplicaSwitched(const NFSMount &previous, const NFSMount &replacement, const QString &error);
+
+    /**
+     * @brief Start the automount units systemd generated from the new fstab
+     */
+    void onDaemonReloaded(bool success, const QString &errorMessage);
 
     /**
      * @brief Handle PolicyKit action completion
@@ -245,7 +680,10 @@ private:
     bool performUnmount(const QString &mountPoint, bool force);
 
     /**
-     * @brief Update mount status by checking system state
+     * @brief Update mount status from the last health check
+     *
+     * Never touches the mount point itself; a hung server would block.
+     *
      * @param mount The mount to update
      * @return true if status was updated
      */
@@ -271,6 +709,34 @@ private:
      */
     QList<NFSMount> parseFstabEntries() const;
 
+    /**
+     * @brief Get the fstab entry of a mount in the current persistence mode
+     * @param mount The mount
+     * @return toFstabEntry() plus automountOptions() in automount mode
+     */
+    FstabEntry fstabEntryFor(const NFSMount &mount) const;
+
+    /**
+     * @brief Apply the backing device settings of a mount
+     * @param mount The mount
+     * @return False if the mount has settings that could not be applied (yet);
+     *         failures are reported through backingDeviceTuningFailed()
+     */
+    bool applyBdiSettings(const NFSMount &mount);
+
+    /**
+     * @brief Write backing device settings, through PolicyKit if sysfs is not writable
+     *
+     * The privileged write runs on m_tuningPool; if it fails, that is
+     * reported through backingDeviceTuningFailed().
+     *
+     * @param mountPoint Mount point the device belongs to, for the report
+     * @param device major:minor
+     * @param settings The settings to write
+     * @return Empty on success or once handed to the helper, the reason for the failure otherwise
+     */
+    QString writeBdiSettings(const QString &mountPoint, const QString &device, const BdiSettings &settings);
+
     /**
      * @brief Create backup of fstab before modification
      * @return true if backup was created successfully
@@ -289,6 +755,13 @@ private:
      */
     void removeMountFromTracking(const QString &mountPoint);
 
+    /**
+     * @brief Start or stop statistics, watchdog and replica timers
+     *
+     * They only run while at least one tracked share is mounted.
+     */
+    void updateMonitoringTimers();
+
     /**
      * @brief Find mount in tracking list
      * @param mountPoint The mount point to find
@@ -305,9 +778,28 @@ private:
 
     NFSServiceInterface *m_nfsService;      ///< NFS service interface
     PolicyKitHelper *m_policyKitHelper;     ///< PolicyKit helper for privileged operations
-    QFileSystemWatcher *m_fsWatcher;        ///< File system watcher for mount points
-    QTimer *m_refreshTimer;                 ///< Timer for periodic status refresh
+    MountTableMonitor *m_mountMonitor;      ///< Kernel mount table change notifications
+    QTimer *m_statisticsTimer;              ///< Timer for periodic statistics sampling
+    MountAutotuner *m_autotuner;            ///< Measured mount option tuning
+    MountBenchmark *m_benchmark;            ///< Per-mount I/O benchmarks
+    MountOrchestrator *m_orchestrator;      ///< Parallel batch mounts and unmounts
+    MountHealthWatchdog *m_healthWatchdog;  ///< Off-thread hung mount detection
+    ReplicaSelector *m_replicaSelector;     ///< Fastest-replica choice and degradation checks
+    QSet<QString> m_switchingReplicas;      ///< Mount points being moved to another replica
+    QThreadPool m_replicaMovePool;          ///< Runs the unmount and remount of replica moves
+    ShutdownUnmounter *m_shutdownUnmounter; ///< Deadline-bounded unmounts at exit
+    bool m_shutdownUnmountDone;             ///< unmountForShutdown() has run
+    QStringList m_shutdownRemaining;        ///< Mount points it left mounted
+    SystemdManager *m_systemd;              ///< Daemon reload and automount units over D-Bus
+    BdiTuner m_bdiTuner;                    ///< Readahead and max_ratio in sysfs
+    QThreadPool m_tuningPool;               ///< Runs privileged readahead writes off the GUI thread
+    QHash<QString, QPair<QString, int>> m_readAheadRestores;    ///< Device and readahead to restore after a sweep
+    mutable FstabFile m_fstab;              ///< Cached, mount point indexed fstab
+    PersistenceMode m_persistenceMode;      ///< How new fstab entries are brought up
+    int m_automountIdleTimeout;             ///< Automount idle timeout in seconds
+    QStringList m_pendingAutomounts;        ///< Automount units to start after the next daemon reload
     QList<NFSMount> m_managedMounts;        ///< List of managed mounts
+    QHash<int, QString> m_mountIds;         ///< Mount points of tracked mounts by kernel mount ID
     QString m_defaultMountRoot;             ///< Default root directory for mounts
     int m_refreshInterval;                  ///< Status refresh interval in seconds
 };
@@ -0,0 +1,390 @@
+#include "mountorchestrator.h"
+#include <QDebug>
+#include <QDir>
+#include <QEventLoop>
+#include <QSet>
+#include <QTimer>
+
+namespace NFSShareManager {
+
+MountOrchestrator::MountOrchestrator(QObject *parent)
+    : QObject(parent)
+    , m_nextBatch(1)
+    , m_active(0)
+{
+    qRegisterMetaType<MountOrchestrator::FailureReason>("MountOrchestrator::FailureReason");
+    setMaxConcurrency(8);
+}
+
+MountOrchestrator::~MountOrchestrator()
+{
+    // Results posted by still-running operations are dropped with this object
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void MountOrchestrator::setMountOperation(const MountOperation &operation)
+{
+    m_mountOperation = operation;
+}
+
+void MountOrchestrator::setUnmountOperation(const UnmountOperation &operation)
+{
+    m_unmountOperation = operation;
+}
+
+void MountOrchestrator::setMaxConcurrency(int count)
+{
+    m_pool.setMaxThreadCount(qMax(1, count));
+}
+
+int MountOrchestrator::maxConcurrency() const
+{
+    return m_pool.maxThreadCount();
+}
+
+bool MountOrchestrator::isRunning() const
+{
+    return !m_batches.isEmpty() || !m_queued.isEmpty();
+}
+
+int MountOrchestrator::mountAll(const QList<NFSMount> &mounts)
+{
+    Batch batch;
+    batch.mode = Mode::Mount;
+
+    QList<QPair<NFSMount, QString>> invalid;
+    for (const NFSMount &mount : mounts) {
+        const QString mountPoint = QDir::cleanPath(mount.localMountPoint());
+        if (mount.localMountPoint().isEmpty() || !QDir::isAbsolutePath(mountPoint)) {
+            invalid << qMakePair(mount, tr("Mount point must be an absolute path"));
+        } else if (batch.jobs.contains(mountPoint)) {
+            invalid << qMakePair(mount, tr("Mount point appears more than once in the batch"));
+        } else {
+            Job job;
+            job.mount = mount;
+            batch.jobs.insert(mountPoint, job);
+        }
+    }
+    batch.failed = invalid.size();
+    const int id = submit(batch);
+    qDebug() << "MountOrchestrator: batch" << id << "mounting" << batch.jobs.size() << "shares";
+
+    for (const auto &entry : invalid) {
+        emit mountFailed(entry.first, FailureReason::InvalidEntry, entry.second);
+    }
+    return id;
+}
+
+int MountOrchestrator::unmountAll(const QStringList &mountPoints, bool force)
+{
+    Batch batch;
+    batch.mode = Mode::Unmount;
+    batch.force = force;
+
+    QStringList invalid;
+    for (const QString &path : mountPoints) {
+        const QString mountPoint = QDir::cleanPath(path);
+        if (path.isEmpty() || !QDir::isAbsolutePath(mountPoint) || batch.jobs.contains(mountPoint)) {
+            invalid << path;
+        } else {
+            batch.jobs.insert(mountPoint, Job());
+        }
+    }
+    batch.failed = invalid.size();
+    const int id = submit(batch);
+    qDebug() << "MountOrchestrator: batch" << id << "unmounting" << batch.jobs.size() << "mount points, force:" << force;
+
+    for (const QString &path : invalid) {
+        emit unmountFailed(path, FailureReason::InvalidEntry, tr("Invalid or duplicate mount point"));
+    }
+    return id;
+}
+
+void MountOrchestrator::cancel()
+{
+    // Waiting batches join the running ones only to report their entries
+    for (Batch &batch : m_queued) {
+        m_batches.insert(batch.id, batch);
+    }
+    m_queued.clear();
+
+    const QList<int> ids = m_batches.keys();
+    for (int id : ids) {
+        Batch &batch = m_batches[id];
+        QStringList waiting;
+        for (auto it = batch.jobs.constBegin(); it != batch.jobs.constEnd(); ++it) {
+            if (it->state == State::Waiting) {
+                waiting << it.key();
+            }
+        }
+        waiting.sort();
+        for (const QString &mountPoint : waiting) {
+            failJob(batch, mountPoint, FailureReason::Cancelled, tr("Cancelled"));
+        }
+    }
+    QMetaObject::invokeMethod(this, &MountOrchestrator::schedule, Qt::QueuedConnection);
+}
+
+bool MountOrchestrator::waitForFinished(int msecs)
+{
+    if (!isRunning()) {
+        return true;
+    }
+
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    connect(this, &MountOrchestrator::finished, &loop, [this, &loop]() {
+        if (!isRunning()) {
+            loop.quit();
+        }
+    });
+    connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+    timeout.start(msecs);
+    loop.exec();
+    return !isRunning();
+}
+
+QHash<QString, QString> MountOrchestrator::buildDependencies(const QStringList &mountPoints)
+{
+    const QSet<QString> present(mountPoints.cbegin(), mountPoints.cend());
+    QHash<QString, QString> parents;
+
+    // Walk up each path; depth is small, so this is linear in practice
+    for (const QString &mountPoint : mountPoints) {
+        QString directory = mountPoint;
+        while (directory.size() > 1) {
+            const int slash = directory.lastIndexOf('/');
+            directory = slash > 0 ? directory.left(slash) : QString("/");
+            if (present.contains(directory)) {
+                parents.insert(mountPoint, directory);
+                break;
+            }
+        }
+    }
+    return parents;
+}
+
+void MountOrchestrator::linkJobs(Batch &batch)
+{
+    const QHash<QString, QString> parents = buildDependencies(batch.jobs.keys());
+    for (auto it = parents.constBegin(); it != parents.constEnd(); ++it) {
+        batch.jobs[it.key()].parent = it.value();
+        batch.jobs[it.value()].children << it.key();
+    }
+
+    // Mounts wait for their parent, unmounts for all of their children
+    for (auto it = batch.jobs.begin(); it != batch.jobs.end(); ++it) {
+        it->blockers = batch.mode == Mode::Mount ? (it->parent.isEmpty() ? 0 : 1) : it->children.size();
+        if (it->blockers == 0) {
+            batch.ready << it.key();
+        }
+    }
+    batch.ready.sort();
+}
+
+bool MountOrchestrator::overlaps(const Batch &first, const Batch &second)
+{
+    auto encloses = [](const QString &parent, const QString &path) {
+        return path == parent || parent == "/" || path.startsWith(parent + '/');
+    };
+    for (auto a = first.jobs.keyBegin(); a != first.jobs.keyEnd(); ++a) {
+        for (auto b = second.jobs.keyBegin(); b != second.jobs.keyEnd(); ++b) {
+            if (encloses(*a, *b) || encloses(*b, *a)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int MountOrchestrator::submit(Batch &batch)
+{
+    batch.id = m_nextBatch++;
+    linkJobs(batch);
+    m_queued << batch;
+
+    // Started from the event loop, so the caller has the id before finished()
+    QMetaObject::invokeMethod(this, &MountOrchestrator::schedule, Qt::QueuedConnection);
+    return batch.id;
+}
+
+void MountOrchestrator::admitQueued()
+{
+    // A batch starts once nothing it nests with is running or queued ahead of it
+    for (int i = 0; i < m_queued.size();) {
+        bool blocked = false;
+        for (auto it = m_batches.constBegin(); it != m_batches.constEnd() && !blocked; ++it) {
+            blocked = overlaps(it.value(), m_queued[i]);
+        }
+        for (int j = 0; j < i && !blocked; ++j) {
+            blocked = overlaps(m_queued[j], m_queued[i]);
+        }
+        if (blocked) {
+            ++i;
+            continue;
+        }
+        const Batch batch = m_queued.takeAt(i);
+        m_batches.insert(batch.id, batch);
+    }
+}
+
+void MountOrchestrator::schedule()
+{
+    admitQueued();
+
+    // Batches take turns, so a small batch is not stuck behind a large one
+    bool started = true;
+    while (started && m_active < maxConcurrency()) {
+        started = false;
+        const QList<int> ids = m_batches.keys();
+        for (int id : ids) {
+            auto it = m_batches.find(id);
+            if (m_active < maxConcurrency() && it != m_batches.end() && !it->ready.isEmpty()) {
+                startJob(id, it->ready.takeFirst());
+                started = true;
+            }
+        }
+    }
+
+    bool completed = false;
+    const QList<int> ids = m_batches.keys();
+    for (int id : ids) {
+        completed = completeIfIdle(id) || completed;
+    }
+    if (completed && !m_queued.isEmpty()) {
+        schedule();
+    }
+}
+
+void MountOrchestrator::startJob(int batchId, const QString &mountPoint)
+{
+    Batch &batch = m_batches[batchId];
+    Job &job = batch.jobs[mountPoint];
+    job.state = State::Running;
+    batch.active++;
+    m_active++;
+
+    const Mode mode = batch.mode;
+    const bool force = batch.force;
+    const NFSMount mount = job.mount;
+    const MountOperation mountOperation = m_mountOperation;
+    const UnmountOperation unmountOperation = m_unmountOperation;
+    m_pool.start([this, batchId, mode, force, mount, mountPoint, mountOperation, unmountOperation]() {
+        QString error;
+        if (mode == Mode::Mount) {
+            error = mountOperation ? mountOperation(mount) : QString("No mount operation set");
+        } else {
+            error = unmountOperation ? unmountOperation(mountPoint, force) : QString("No unmount operation set");
+        }
+        QMetaObject::invokeMethod(this, [this, batchId, mountPoint, error]() {
+            finishJob(batchId, mountPoint, error);
+        }, Qt::QueuedConnection);
+    });
+
+    if (mode == Mode::Mount) {
+        emit mountStarted(mount);
+    } else {
+        emit unmountStarted(mountPoint);
+    }
+}
+
+void MountOrchestrator::finishJob(int batchId, const QString &mountPoint, const QString &error)
+{
+    auto batchIt = m_batches.find(batchId);
+    if (batchIt == m_batches.end()) {
+        return;
+    }
+    Batch &batch = batchIt.value();
+    auto it = batch.jobs.find(mountPoint);
+    if (it == batch.jobs.end() || it->state != State::Running) {
+        return;
+    }
+    batch.active--;
+    m_active--;
+
+    if (!error.isEmpty()) {
+        it->state = State::Failed;
+        batch.failed++;
+        const Job job = it.value();
+        if (batch.mode == Mode::Mount) {
+            emit mountFailed(job.mount, FailureReason::OperationFailed, error);
+            for (const QString &child : job.children) {
+                failJob(batch, child, FailureReason::DependencyFailed, tr("Enclosing mount %1 failed").arg(mountPoint));
+            }
+        } else {
+            emit unmountFailed(mountPoint, FailureReason::OperationFailed, error);
+            if (!job.parent.isEmpty()) {
+                failJob(batch, job.parent, FailureReason::DependencyFailed,
+                        tr("Nested mount %1 is still mounted").arg(mountPoint));
+            }
+        }
+        schedule();
+        return;
+    }
+
+    it->state = State::Done;
+    batch.succeeded++;
+    const Job job = it.value();
+
+    // Release what was waiting for this entry
+    const QStringList dependents = batch.mode == Mode::Mount ? job.children
+                                                              : (job.parent.isEmpty() ? QStringList() : QStringList{job.parent});
+    for (const QString &dependent : dependents) {
+        Job &next = batch.jobs[dependent];
+        if (next.state == State::Waiting && --next.blockers == 0) {
+            batch.ready << dependent;
+        }
+    }
+
+    if (batch.mode == Mode::Mount) {
+        emit mountCompleted(job.mount);
+    } else {
+        emit unmountCompleted(mountPoint);
+    }
+    schedule();
+}
+
+void MountOrchestrator::failJob(Batch &batch, const QString &mountPoint, FailureReason reason, const QString &error)
+{
+    auto it = batch.jobs.find(mountPoint);
+    if (it == batch.jobs.end() || it->state != State::Waiting) {
+        return;
+    }
+    it->state = State::Failed;
+    batch.ready.removeAll(mountPoint);
+    batch.failed++;
+    const Job job = it.value();
+
+    // Everything that depends on a skipped entry is skipped for the same reason
+    const FailureReason propagated = reason == FailureReason::Cancelled ? reason : FailureReason::DependencyFailed;
+    if (batch.mode == Mode::Mount) {
+        emit mountFailed(job.mount, reason, error);
+        for (const QString &child : job.children) {
+            failJob(batch, child, propagated, reason == FailureReason::Cancelled
+                                                  ? error : tr("Enclosing mount %1 failed").arg(mountPoint));
+        }
+    } else {
+        emit unmountFailed(mountPoint, reason, error);
+        if (!job.parent.isEmpty()) {
+            failJob(batch, job.parent, propagated, reason == FailureReason::Cancelled
+                                                       ? error : tr("Nested mount %1 is still mounted").arg(mountPoint));
+        }
+    }
+}
+
+bool MountOrchestrator::completeIfIdle(int batchId)
+{
+    auto it = m_batches.find(batchId);
+    if (it == m_batches.end() || it->active > 0 || !it->ready.isEmpty()) {
+        return false;
+    }
+    const Batch batch = m_batches.take(batchId);
+    qDebug() << "MountOrchestrator: batch" << batchId << "finished," << batch.succeeded << "succeeded,"
+             << batch.failed << "failed";
+    emit finished(batchId, batch.succeeded, batch.failed);
+    return true;
+}
+
+} // namespace NFSShareManager
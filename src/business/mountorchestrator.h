@@ -0,0 +1,217 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <functional>
+#include "../core/nfsmount.h"
+
+namespace NFSShareManager {
+
+/**
+ * @brief Runs batches of mounts and unmounts in parallel, in dependency order
+ *
+ * A batch is turned into a forest by mount-point nesting: the parent of a
+ * mount point is the closest ancestor directory that is also in the batch.
+ * Mounts start as soon as their parent is mounted, unmounts as soon as all
+ * their children are unmounted, and up to maxConcurrency() operations run
+ * at once on a private thread pool. A batch therefore takes about as long
+ * as its slowest parent-to-child chain rather than the sum of all mounts.
+ *
+ * When a mount fails, the mounts nested in it are not attempted; when an
+ * unmount fails, its ancestors in the batch are left mounted.
+ *
+ * Batches are never refused. A new batch runs alongside the ones already
+ * in progress unless one of its mount points equals, encloses or is nested
+ * in a mount point of an unfinished batch; such a batch waits until those
+ * have finished, so ordering across batches holds too. Running batches
+ * take turns for the pool, so a single mount is not stuck behind a long
+ * restore.
+ *
+ * The operations are called on pool threads and must be thread-safe.
+ * All signals are emitted on the orchestrator's thread.
+ */
+class MountOrchestrator : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Why an entry of a batch did not complete
+     */
+    enum class FailureReason {
+        OperationFailed,    ///< The mount or unmount itself failed
+        DependencyFailed,   ///< A mount it depends on failed
+        InvalidEntry,       ///< Bad or duplicate mount point
+        Cancelled           ///< cancel() was called before it started
+    };
+    Q_ENUM(FailureReason)
+
+    /**
+     * @brief Mounts one share
+     * @return Error message, or an empty string on success
+     */
+    using MountOperation = std::function<QString(const NFSMount &mount)>;
+
+    /**
+     * @brief Unmounts one mount point
+     * @return Error message, or an empty string on success
+     */
+    using UnmountOperation = std::function<QString(const QString &mountPoint, bool force)>;
+
+    explicit MountOrchestrator(QObject *parent = nullptr);
+    ~MountOrchestrator();
+
+    /**
+     * @brief Set the function that performs one mount
+     */
+    void setMountOperation(const MountOperation &operation);
+
+    /**
+     * @brief Set the function that performs one unmount
+     */
+    void setUnmountOperation(const UnmountOperation &operation);
+
+    /**
+     * @brief Set how many operations may run at once
+     * @param count Maximum number of concurrent operations (default: 8)
+     */
+    void setMaxConcurrency(int count);
+
+    /**
+     * @brief Get how many operations may run at once
+     */
+    int maxConcurrency() const;
+
+    /**
+     * @brief Check if a batch is in progress or waiting
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Start mounting a batch
+     *
+     * Invalid entries are reported from within the call; the others start
+     * from the event loop.
+     *
+     * @param mounts Mounts to perform
+     * @return Id of the batch, passed to finished()
+     */
+    int mountAll(const QList<NFSMount> &mounts);
+
+    /**
+     * @brief Start unmounting a batch, children before parents
+     * @param mountPoints Mount points to unmount
+     * @param force Whether to force busy unmounts
+     * @return Id of the batch, passed to finished()
+     */
+    int unmountAll(const QStringList &mountPoints, bool force = false);
+
+    /**
+     * @brief Fail every entry of every batch that has not started yet
+     *
+     * Running operations finish normally; finished() follows for each batch
+     * once they have.
+     */
+    void cancel();
+
+    /**
+     * @brief Process events until every batch has finished
+     * @param msecs Maximum time to wait
+     * @return True if no batch is running any more
+     */
+    bool waitForFinished(int msecs = 30000);
+
+    /**
+     * @brief Find the parent of every mount point within a set
+     * @param mountPoints Cleaned absolute mount points
+     * @return Closest ancestor in the set per mount point; roots are absent
+     */
+    static QHash<QString, QString> buildDependencies(const QStringList &mountPoints);
+
+signals:
+    /**
+     * @brief Emitted when a mount of a batch is handed to the pool
+     */
+    void mountStarted(const NFSMount &mount);
+
+    /**
+     * @brief Emitted when a mount of the batch succeeded
+     */
+    void mountCompleted(const NFSMount &mount);
+
+    /**
+     * @brief Emitted when a mount of the batch failed or was skipped
+     */
+    void mountFailed(const NFSMount &mount, MountOrchestrator::FailureReason reason, const QString &error);
+
+    /**
+     * @brief Emitted when an unmount of a batch is handed to the pool
+     */
+    void unmountStarted(const QString &mountPoint);
+
+    /**
+     * @brief Emitted when an unmount of the batch succeeded
+     */
+    void unmountCompleted(const QString &mountPoint);
+
+    /**
+     * @brief Emitted when an unmount of the batch failed or was skipped
+     */
+    void unmountFailed(const QString &mountPoint, MountOrchestrator::FailureReason reason, const QString &error);
+
+    /**
+     * @brief Emitted once per batch, after every entry was reported
+     * @param batch Id returned by mountAll() or unmountAll()
+     * @param succeeded Entries that completed
+     * @param failed Entries that failed or were skipped
+     */
+    void finished(int batch, int succeeded, int failed);
+
+private:
+    enum class Mode { Mount, Unmount };
+    enum class State { Waiting, Running, Done, Failed };
+
+    struct Job {
+        NFSMount mount;             ///< Mount to perform (mount batches)
+        QString parent;             ///< Closest enclosing mount point in the batch
+        QStringList children;       ///< Mount points directly nested in this one
+        int blockers = 0;           ///< Dependencies that have not completed yet
+        State state = State::Waiting;
+    };
+
+    struct Batch {
+        int id = 0;
+        Mode mode = Mode::Mount;
+        bool force = false;         ///< Force flag of an unmount batch
+        QHash<QString, Job> jobs;   ///< Entries by mount point
+        QStringList ready;          ///< Entries whose dependencies completed, in start order
+        int active = 0;             ///< Operations of this batch currently running
+        int succeeded = 0;          ///< Completed entries
+        int failed = 0;             ///< Failed or skipped entries
+    };
+
+    static void linkJobs(Batch &batch);
+    static bool overlaps(const Batch &first, const Batch &second);
+    int submit(Batch &batch);
+    void admitQueued();
+    void schedule();
+    void startJob(int batchId, const QString &mountPoint);
+    void finishJob(int batchId, const QString &mountPoint, const QString &error);
+    void failJob(Batch &batch, const QString &mountPoint, FailureReason reason, const QString &error);
+    bool completeIfIdle(int batchId);
+
+    QThreadPool m_pool;                 ///< Runs the operations
+    MountOperation m_mountOperation;    ///< Performs one mount
+    UnmountOperation m_unmountOperation; ///< Performs one unmount
+    QMap<int, Batch> m_batches;         ///< Running batches by id
+    QList<Batch> m_queued;              ///< Batches waiting for an overlapping one, in submit order
+    int m_nextBatch;                    ///< Id of the next batch
+    int m_active;                       ///< Operations currently running across batches
+};
+
+} // namespace NFSShareManager
@@ -0,0 +1,324 @@
+#include "nfsdclienttracker.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+namespace NFSShareManager {
+
+namespace {
+
+QByteArray readProcFile(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+QString unquote(const QString &value)
+{
+    QString result = value.trimmed();
+    if (result.size() >= 2 && result.startsWith('"') && result.endsWith('"')) {
+        result = result.mid(1, result.size() - 2);
+    }
+    return result;
+}
+
+/**
+ * @brief Strip the port from "1.2.3.4:980" or "[fe80::1]:980"
+ */
+QString hostOfAddress(const QString &address)
+{
+    if (address.startsWith('[')) {
+        const int end = address.indexOf(']');
+        return end > 0 ? address.mid(1, end - 1) : address;
+    }
+    if (address.count(':') == 1) {
+        return address.left(address.indexOf(':'));
+    }
+    return address;
+}
+
+} // namespace
+
+NFSDClientTracker::NFSDClientTracker(QObject *parent)
+    : QObject(parent)
+    , m_nfsdRoot("/proc/fs/nfsd")
+    , m_rmtabPath("/var/lib/nfs/rmtab")
+    , m_rmtabSize(-1)
+    , m_infoReads(0)
+{
+    qRegisterMetaType<NFSClientInfo>("NFSClientInfo");
+}
+
+NFSDClientTracker::~NFSDClientTracker()
+{
+}
+
+bool NFSDClientTracker::isAvailable() const
+{
+    return QFileInfo(m_nfsdRoot + "/clients").isDir();
+}
+
+void NFSDClientTracker::setExports(const QStringList &exportPaths)
+{
+    m_exports.clear();
+    m_exportDevices.clear();
+    for (const QString &path : exportPaths) {
+        const QString cleaned = QDir::cleanPath(path);
+        m_exports << cleaned;
+        struct stat st;
+        if (::stat(QFile::encodeName(cleaned).constData(), &st) == 0) {
+            m_exportDevices.insert(cleaned, st.st_dev);
+        }
+    }
+    rebuildIndex();
+}
+
+bool NFSDClientTracker::refresh()
+{
+    // Both sources are checked every time; neither may short-circuit the other
+    const bool v4Changed = refreshV4Clients();
+    const bool v3Changed = refreshRmtab();
+    if (!v4Changed && !v3Changed) {
+        return false;
+    }
+
+    rebuildIndex();
+    emit clientsChanged();
+    return true;
+}
+
+QList<NFSClientInfo> NFSDClientTracker::clients() const
+{
+    QList<NFSClientInfo> result;
+    for (const V4Client &client : m_v4Clients) {
+        result << client.info;
+    }
+    result << m_v3Clients;
+    std::sort(result.begin(), result.end(), [](const NFSClientInfo &a, const NFSClientInfo &b) {
+        return a.address != b.address ? a.address < b.address : a.id < b.id;
+    });
+    return result;
+}
+
+QList<NFSClientInfo> NFSDClientTracker::activeClients(const QString &exportPath) const
+{
+    return m_byExport.value(QDir::cleanPath(exportPath));
+}
+
+int NFSDClientTracker::infoReads() const
+{
+    return m_infoReads;
+}
+
+void NFSDClientTracker::setNfsdRoot(const QString &nfsdRoot)
+{
+    m_nfsdRoot = nfsdRoot;
+    m_v4Clients.clear();
+}
+
+void NFSDClientTracker::setRmtabPath(const QString &filePath)
+{
+    m_rmtabPath = filePath;
+    m_rmtabSize = -1;
+    m_rmtabModified = QDateTime();
+    m_v3Clients.clear();
+}
+
+NFSClientInfo NFSDClientTracker::parseClientInfo(const QByteArray &data)
+{
+    // clientid: 0xc7f2a5cd5f3f7c04
+    // address: "192.168.1.10:980"
+    // name: "Linux NFSv4.2 client.example.com"
+    // minor version: 2
+    NFSClientInfo info;
+    info.protocol = "NFSv4";
+    const QList<QByteArray> lines = data.split('\n');
+    for (const QByteArray &line : lines) {
+        const int colon = line.indexOf(':');
+        if (colon < 0) {
+            continue;
+        }
+        const QByteArray key = line.left(colon).trimmed();
+        const QString value = QString::fromUtf8(line.mid(colon + 1));
+        if (key == "address") {
+            info.address = hostOfAddress(unquote(value));
+        } else if (key == "name") {
+            info.name = unquote(value);
+        } else if (key == "minor version") {
+            info.protocol = QString("NFSv4.%1").arg(value.trimmed().toInt());
+        }
+    }
+    return info;
+}
+
+QList<quint64> NFSDClientTracker::parseStateDevices(const QByteArray &data)
+{
+    // - 0x...: { type: open, access: rw, deny: --, superblock: "fd:01:1835021", filename: "a.txt", ... }
+    QList<quint64> devices;
+    const QByteArray marker = "superblock: \"";
+    const QList<QByteArray> lines = data.split('\n');
+    for (const QByteArray &line : lines) {
+        const int start = line.indexOf(marker);
+        if (start < 0) {
+            continue;
+        }
+        const int begin = start + marker.size();
+        const int end = line.indexOf('"', begin);
+        const QList<QByteArray> parts = line.mid(begin, end - begin).split(':');
+        if (parts.size() < 2) {
+            continue;
+        }
+        bool majorOk = false;
+        bool minorOk = false;
+        const unsigned int major = parts[0].toUInt(&majorOk, 16);
+        const unsigned int minor = parts[1].toUInt(&minorOk, 16);
+        if (majorOk && minorOk) {
+            devices << quint64(makedev(major, minor));
+        }
+    }
+    return devices;
+}
+
+QList<QPair<QString, QString>> NFSDClientTracker::parseRmtab(const QByteArray &data)
+{
+    // client.example.com:/srv/share:0x00000001
+    QList<QPair<QString, QString>> mounts;
+    const QList<QByteArray> lines = data.split('\n');
+    for (const QByteArray &raw : lines) {
+        const QString line = QString::fromUtf8(raw).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        const int first = line.indexOf(':');
+        const int last = line.lastIndexOf(':');
+        if (first <= 0 || last <= first + 1) {
+            continue;
+        }
+        mounts << qMakePair(line.left(first), QDir::cleanPath(line.mid(first + 1, last - first - 1)));
+    }
+    return mounts;
+}
+
+bool NFSDClientTracker::refreshV4Clients()
+{
+    const QString clientsDir = m_nfsdRoot + "/clients";
+    const QStringList entries = QDir(clientsDir).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    const QSet<QString> present(entries.cbegin(), entries.cend());
+    bool changed = false;
+
+    // Clients that unmounted or expired
+    for (auto it = m_v4Clients.begin(); it != m_v4Clients.end();) {
+        if (!present.contains(it.key())) {
+            it = m_v4Clients.erase(it);
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+
+    for (const QString &entry : entries) {
+        const QString clientDir = clientsDir + '/' + entry;
+        auto it = m_v4Clients.find(entry);
+        if (it == m_v4Clients.end()) {
+            // info does not change over a client's lifetime; read it once
+            V4Client client;
+            client.info = parseClientInfo(readProcFile(clientDir + "/info"));
+            client.info.id = entry;
+            m_infoReads++;
+            it = m_v4Clients.insert(entry, client);
+            changed = true;
+        }
+
+        const QList<quint64> stateDevices = parseStateDevices(readProcFile(clientDir + "/states"));
+        const QSet<quint64> devices(stateDevices.cbegin(), stateDevices.cend());
+        if (devices != it->devices || stateDevices.size() != it->info.openStates) {
+            it->devices = devices;
+            it->info.openStates = stateDevices.size();
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool NFSDClientTracker::refreshRmtab()
+{
+    const QFileInfo info(m_rmtabPath);
+    if (!info.exists()) {
+        const bool changed = !m_v3Clients.isEmpty();
+        m_v3Clients.clear();
+        m_rmtabSize = -1;
+        m_rmtabModified = QDateTime();
+        return changed;
+    }
+    if (info.size() == m_rmtabSize && info.lastModified() == m_rmtabModified) {
+        return false;
+    }
+    m_rmtabSize = info.size();
+    m_rmtabModified = info.lastModified();
+
+    QHash<QString, int> byHost;
+    QList<NFSClientInfo> clients;
+    for (const auto &mount : parseRmtab(readProcFile(m_rmtabPath))) {
+        auto it = byHost.constFind(mount.first);
+        if (it == byHost.constEnd()) {
+            NFSClientInfo client;
+            client.id = "v3:" + mount.first;
+            client.address = mount.first;
+            client.protocol = "NFSv3";
+            it = byHost.insert(mount.first, clients.size());
+            clients << client;
+        }
+        if (!clients[it.value()].exports.contains(mount.second)) {
+            clients[it.value()].exports << mount.second;
+        }
+    }
+
+    const bool changed = clients.size() != m_v3Clients.size() ||
+        !std::equal(clients.cbegin(), clients.cend(), m_v3Clients.cbegin(),
+                    [](const NFSClientInfo &a, const NFSClientInfo &b) {
+                        return a.address == b.address && a.exports == b.exports;
+                    });
+    m_v3Clients = clients;
+    return changed;
+}
+
+QStringList NFSDClientTracker::exportsOnDevices(const QSet<quint64> &devices) const
+{
+    QStringList exports;
+    for (const QString &path : m_exports) {
+        auto it = m_exportDevices.constFind(path);
+        if (it != m_exportDevices.constEnd() && devices.contains(it.value())) {
+            exports << path;
+        }
+    }
+    return exports;
+}
+
+void NFSDClientTracker::rebuildIndex()
+{
+    m_byExport.clear();
+
+    for (V4Client &client : m_v4Clients) {
+        client.info.exports = exportsOnDevices(client.devices);
+        for (const QString &path : client.info.exports) {
+            m_byExport[path] << client.info;
+        }
+    }
+
+    for (const NFSClientInfo &client : m_v3Clients) {
+        for (const QString &path : client.exports) {
+            if (m_exports.contains(path)) {
+                m_byExport[path] << client;
+            }
+        }
+    }
+}
+
+} // namespace NFSShareManager
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+namespace NFSShareManager {
+
+/**
+ * @brief One client of the local NFS server
+ */
+struct NFSClientInfo {
+    QString id;             ///< Directory name under clients/ (NFSv4) or "v3:<host>"
+    QString address;        ///< Client host or IP address, without port
+    QString name;           ///< Client-supplied identifier (NFSv4 only)
+    QString protocol;       ///< "NFSv4.2", "NFSv4.1", "NFSv4.0" or "NFSv3"
+    int openStates = 0;     ///< Opens, locks, delegations and layouts held (NFSv4 only)
+    QStringList exports;    ///< Exports the client is using, as far as can be told
+};
+
+/**
+ * @brief Tracks which clients use which local exports
+ *
+ * NFSv4 clients are read from /proc/fs/nfsd/clients/<id>/info and
+ * .../states. On refresh() only the directory listing of clients/ is
+ * compared with the known ids: info is read once for a new client, gone
+ * clients are dropped, and only the short states file of a known client
+ * is re-read. States name the device and inode of each open file, so a
+ * client is attributed to every export on the same device; a client with
+ * no open state cannot be attributed and is only listed by clients().
+ *
+ * NFSv3 mounts come from mountd's rmtab ("host:/export:0x..."), which is
+ * re-read only when its size or modification time changed.
+ */
+class NFSDClientTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NFSDClientTracker(QObject *parent = nullptr);
+    ~NFSDClientTracker();
+
+    /**
+     * @brief Check if the nfsd client directory is present (kernel 5.3+)
+     */
+    bool isAvailable() const;
+
+    /**
+     * @brief Set the exports clients are attributed to
+     * @param exportPaths Local paths of the active shares
+     */
+    void setExports(const QStringList &exportPaths);
+
+    /**
+     * @brief Update the client map from /proc and rmtab
+     * @return True if any client or attribution changed
+     */
+    bool refresh();
+
+    /**
+     * @brief Get all known clients
+     */
+    QList<NFSClientInfo> clients() const;
+
+    /**
+     * @brief Get the clients using an export
+     * @param exportPath Local path of the share
+     */
+    QList<NFSClientInfo> activeClients(const QString &exportPath) const;
+
+    /**
+     * @brief Get the number of client info files read so far
+     */
+    int infoReads() const;
+
+    /**
+     * @brief Set the nfsd directory (for testing)
+     * @param nfsdRoot Replacement for "/proc/fs/nfsd"
+     */
+    void setNfsdRoot(const QString &nfsdRoot);
+
+    /**
+     * @brief Set the rmtab file (for testing)
+     * @param filePath Replacement for "/var/lib/nfs/rmtab"
+     */
+    void setRmtabPath(const QString &filePath);
+
+    /**
+     * @brief Parse a clients/<id>/info file
+     * @param data File content
+     * @return Client with address, name and protocol filled in
+     */
+    static NFSClientInfo parseClientInfo(const QByteArray &data);
+
+    /**
+     * @brief Parse a clients/<id>/states file
+     * @param data File content
+     * @return Device number of every state's superblock, one entry per state
+     */
+    static QList<quint64> parseStateDevices(const QByteArray &data);
+
+    /**
+     * @brief Parse mountd's rmtab
+     * @param data File content
+     * @return (host, export path) per mount
+     */
+    static QList<QPair<QString, QString>> parseRmtab(const QByteArray &data);
+
+signals:
+    /**
+     * @brief Emitted by refresh() when the client map changed
+     */
+    void clientsChanged();
+
+private:
+    struct V4Client {
+        NFSClientInfo info;
+        QSet<quint64> devices;      ///< Devices with open state
+    };
+
+    bool refreshV4Clients();
+    bool refreshRmtab();
+    QStringList exportsOnDevices(const QSet<quint64> &devices) const;
+    void rebuildIndex();
+
+    QString m_nfsdRoot;                             ///< Root of the nfsd filesystem
+    QString m_rmtabPath;                            ///< mountd's remote mount table
+    QStringList m_exports;                          ///< Active export paths
+    QHash<QString, quint64> m_exportDevices;        ///< Device number per export
+    QHash<QString, V4Client> m_v4Clients;           ///< NFSv4 clients by clients/ entry
+    QList<NFSClientInfo> m_v3Clients;               ///< NFSv3 clients from rmtab
+    qint64 m_rmtabSize;                             ///< rmtab size at the last read
+    QDateTime m_rmtabModified;                      ///< rmtab mtime at the last read
+    QHash<QString, QList<NFSClientInfo>> m_byExport; ///< Clients per export
+    int m_infoReads;                                ///< info files read so far
+};
+
+} // namespace NFSShareManager
+
+Q_DECLARE_METATYPE(NFSShareManager::NFSClientInfo)
@@ -0,0 +1,378 @@
+#include "nfsdloadmonitor.h"
+#include <QDebug>
+
+#include <cstring>
+
+namespace NFSShareManager {
+
+namespace {
+
+// Fewer requests than this in the window are too few to call the pools starved
+constexpr quint64 MinimumArrivalsForStarvation = 20;
+
+const char *skipSpaces(const char *pos, const char *end)
+{
+    while (pos < end && (*pos == ' ' || *pos == '\t')) {
+        ++pos;
+    }
+    return pos;
+}
+
+const char *parseNumber(const char *pos, const char *end, quint64 *value)
+{
+    pos = skipSpaces(pos, end);
+    quint64 result = 0;
+    while (pos < end && *pos >= '0' && *pos <= '9') {
+        result = result * 10 + static_cast<quint64>(*pos - '0');
+        ++pos;
+    }
+    // Skip the rest of a non-integer field such as "0.000"
+    while (pos < end && *pos != ' ' && *pos != '\t') {
+        ++pos;
+    }
+    *value = result;
+    return pos;
+}
+
+bool startsWith(const char *pos, const char *end, const char *tag)
+{
+    const std::size_t length = std::strlen(tag);
+    return static_cast<std::size_t>(end - pos) > length
+        && std::memcmp(pos, tag, length) == 0 && (pos[length] == ' ' || pos[length] == '\t');
+}
+
+// "<tag> <count> <v1> ... <vcount>": sum of the values
+quint64 sumCountedValues(const char *pos, const char *end)
+{
+    quint64 count = 0;
+    pos = parseNumber(pos, end, &count);
+    quint64 sum = 0;
+    for (quint64 i = 0; i < count && pos < end; ++i) {
+        quint64 value = 0;
+        pos = parseNumber(pos, end, &value);
+        sum += value;
+    }
+    return sum;
+}
+
+quint64 delta(quint64 current, quint64 previous)
+{
+    return current >= previous ? current - previous : 0;
+}
+
+} // namespace
+
+NFSDLoadMonitor::NFSDLoadMonitor(QObject *parent)
+    : QObject(parent)
+    , m_sampleTimer(new QTimer(this))
+    , m_procRoot("/proc")
+    , m_previousTimestamp(0)
+    , m_hasPrevious(false)
+    , m_windowSize(10)
+    , m_starvationThreshold(0.1)
+    , m_starved(false)
+{
+    m_rpcNfsdBuffer.resize(16 * 1024);
+    m_poolStatsBuffer.resize(4 * 1024);
+    m_clock.start();
+    connect(m_sampleTimer, &QTimer::timeout, this, &NFSDLoadMonitor::onSampleTimer);
+}
+
+NFSDLoadMonitor::~NFSDLoadMonitor()
+{
+}
+
+bool NFSDLoadMonitor::isAvailable() const
+{
+    return QFile::exists(m_procRoot + "/net/rpc/nfsd");
+}
+
+void NFSDLoadMonitor::start(int intervalMs)
+{
+    openFiles();
+    m_sampleTimer->start(intervalMs);
+    qDebug() << "nfsd load monitoring started, interval" << intervalMs << "ms";
+}
+
+void NFSDLoadMonitor::stop()
+{
+    m_sampleTimer->stop();
+    m_rpcNfsdFile.close();
+    m_poolStatsFile.close();
+}
+
+bool NFSDLoadMonitor::isRunning() const
+{
+    return m_sampleTimer->isActive();
+}
+
+void NFSDLoadMonitor::openFiles()
+{
+    if (!m_rpcNfsdFile.isOpen()) {
+        m_rpcNfsdFile.setFileName(m_procRoot + "/net/rpc/nfsd");
+        m_rpcNfsdFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+    if (!m_poolStatsFile.isOpen()) {
+        m_poolStatsFile.setFileName(m_procRoot + "/fs/nfsd/pool_stats");
+        m_poolStatsFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+}
+
+qint64 NFSDLoadMonitor::readFile(QFile &file, QByteArray &buffer)
+{
+    if (!file.isOpen() || !file.seek(0)) {
+        return -1;
+    }
+    qint64 bytesRead = file.read(buffer.data(), buffer.size());
+    // Grow only if the file no longer fits; the next sample reads it in one go again
+    while (bytesRead == buffer.size()) {
+        buffer.resize(buffer.size() * 2);
+        if (!file.seek(0)) {
+            return -1;
+        }
+        bytesRead = file.read(buffer.data(), buffer.size());
+    }
+    return bytesRead;
+}
+
+bool NFSDLoadMonitor::sample()
+{
+    openFiles();
+    const qint64 rpcSize = readFile(m_rpcNfsdFile, m_rpcNfsdBuffer);
+    if (rpcSize < 0) {
+        // nfsd was unloaded; reopen on the next sample
+        m_rpcNfsdFile.close();
+        m_poolStatsFile.close();
+        m_hasPrevious = false;
+        return false;
+    }
+    qint64 poolSize = readFile(m_poolStatsFile, m_poolStatsBuffer);
+    if (poolSize < 0) {
+        m_poolStatsFile.close();
+        poolSize = 0;
+    }
+
+    // The threads file is a transaction file and has to be reopened for each read
+    char threadsBuffer[32];
+    qint64 threadsSize = 0;
+    QFile threadsFile(m_procRoot + "/fs/nfsd/threads");
+    if (threadsFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        threadsSize = qMax<qint64>(0, threadsFile.read(threadsBuffer, sizeof(threadsBuffer)));
+    }
+
+    sample(QByteArray::fromRawData(m_rpcNfsdBuffer.constData(), static_cast<int>(rpcSize)),
+           QByteArray::fromRawData(m_poolStatsBuffer.constData(), static_cast<int>(poolSize)),
+           QByteArray::fromRawData(threadsBuffer, static_cast<int>(threadsSize)),
+           m_clock.elapsed());
+    return true;
+}
+
+void NFSDLoadMonitor::parseRpcNfsd(const char *data, qint64 size, Counters &counters)
+{
+    const char *pos = data;
+    const char *const end = data + size;
+
+    while (pos < end) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+
+        // Only the lines we use are parsed; everything else is skipped by its tag
+        if (startsWith(pos, lineEnd, "rc")) {
+            const char *field = pos + 2;
+            field = parseNumber(field, lineEnd, &counters.replyCacheHits);
+            parseNumber(field, lineEnd, &counters.replyCacheMisses);
+        } else if (startsWith(pos, lineEnd, "io")) {
+            const char *field = pos + 2;
+            field = parseNumber(field, lineEnd, &counters.bytesRead);
+            parseNumber(field, lineEnd, &counters.bytesWritten);
+        } else if (startsWith(pos, lineEnd, "th")) {
+            quint64 threads = 0;
+            parseNumber(pos + 2, lineEnd, &threads);
+            counters.threads = static_cast<int>(threads);
+        } else if (startsWith(pos, lineEnd, "proc3")) {
+            counters.operations += sumCountedValues(pos + 5, lineEnd);
+        } else if (startsWith(pos, lineEnd, "proc4ops")) {
+            counters.operations += sumCountedValues(pos + 8, lineEnd);
+        }
+
+        pos = lineEnd + 1;
+    }
+}
+
+void NFSDLoadMonitor::parsePoolStats(const char *data, qint64 size, Counters &counters)
+{
+    const char *pos = data;
+    const char *const end = data + size;
+
+    // "# pool packets-arrived sockets-enqueued threads-woken threads-timedout", one line per pool
+    while (pos < end) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+
+        if (*pos != '#') {
+            quint64 pool = 0;
+            quint64 arrived = 0;
+            quint64 enqueued = 0;
+            quint64 woken = 0;
+            quint64 timedOut = 0;
+            const char *field = parseNumber(pos, lineEnd, &pool);
+            field = parseNumber(field, lineEnd, &arrived);
+            field = parseNumber(field, lineEnd, &enqueued);
+            field = parseNumber(field, lineEnd, &woken);
+            parseNumber(field, lineEnd, &timedOut);
+            counters.packetsArrived += arrived;
+            counters.socketsEnqueued += enqueued;
+            counters.threadsTimedOut += timedOut;
+        }
+
+        pos = lineEnd + 1;
+    }
+}
+
+void NFSDLoadMonitor::sample(const QByteArray &rpcNfsd, const QByteArray &poolStats,
+                             const QByteArray &threads, qint64 timestampMs)
+{
+    Counters current;
+    parseRpcNfsd(rpcNfsd.constData(), rpcNfsd.size(), current);
+    parsePoolStats(poolStats.constData(), poolStats.size(), current);
+    if (!threads.isEmpty()) {
+        quint64 threadCount = 0;
+        parseNumber(threads.constData(), threads.constData() + threads.size(), &threadCount);
+        current.threads = static_cast<int>(threadCount);
+    }
+
+    const bool hadPrevious = m_hasPrevious;
+    const Counters previous = m_previous;
+    const qint64 previousTimestamp = m_previousTimestamp;
+    m_previous = current;
+    m_previousTimestamp = timestampMs;
+    m_hasPrevious = true;
+
+    if (!hadPrevious || timestampMs <= previousTimestamp) {
+        return;
+    }
+
+    NFSDLoadSample loadSample;
+    loadSample.timestampMs = timestampMs;
+    loadSample.intervalSeconds = (timestampMs - previousTimestamp) / 1000.0;
+    loadSample.operations = delta(current.operations, previous.operations);
+    loadSample.bytesRead = delta(current.bytesRead, previous.bytesRead);
+    loadSample.bytesWritten = delta(current.bytesWritten, previous.bytesWritten);
+    loadSample.replyCacheHits = delta(current.replyCacheHits, previous.replyCacheHits);
+    loadSample.replyCacheMisses = delta(current.replyCacheMisses, previous.replyCacheMisses);
+    loadSample.packetsArrived = delta(current.packetsArrived, previous.packetsArrived);
+    loadSample.socketsEnqueued = delta(current.socketsEnqueued, previous.socketsEnqueued);
+    loadSample.threadsTimedOut = delta(current.threadsTimedOut, previous.threadsTimedOut);
+    loadSample.threads = current.threads;
+    m_history.push(loadSample);
+
+    NFSDLoadSummary currentSummary = summary();
+    emit loadUpdated(currentSummary);
+
+    if (currentSummary.starved && !m_starved) {
+        m_starved = true;
+        qWarning() << "nfsd thread pools starved:" << qRound(currentSummary.busyFraction * 100)
+                   << "% of requests found no idle thread with" << currentSummary.threads << "threads";
+        emit threadPoolStarved(currentSummary);
+    } else if (!currentSummary.starved && m_starved) {
+        m_starved = false;
+        qDebug() << "nfsd thread pools recovered";
+        emit threadPoolRecovered();
+    }
+}
+
+NFSDLoadSummary NFSDLoadMonitor::summary() const
+{
+    NFSDLoadSummary result;
+    const std::size_t count = qMin<std::size_t>(static_cast<std::size_t>(m_windowSize), m_history.size());
+    if (count == 0) {
+        return result;
+    }
+
+    double seconds = 0.0;
+    quint64 operations = 0;
+    quint64 bytesRead = 0;
+    quint64 bytesWritten = 0;
+    quint64 hits = 0;
+    quint64 misses = 0;
+    quint64 arrived = 0;
+    quint64 enqueued = 0;
+    for (std::size_t i = m_history.size() - count; i < m_history.size(); ++i) {
+        const NFSDLoadSample &entry = m_history.at(i);
+        seconds += entry.intervalSeconds;
+        operations += entry.operations;
+        bytesRead += entry.bytesRead;
+        bytesWritten += entry.bytesWritten;
+        hits += entry.replyCacheHits;
+        misses += entry.replyCacheMisses;
+        arrived += entry.packetsArrived;
+        enqueued += entry.socketsEnqueued;
+    }
+
+    result.sampleCount = static_cast<int>(count);
+    result.threads = m_history.last().threads;
+    if (seconds > 0.0) {
+        result.operationsPerSecond = operations / seconds;
+        result.readBytesPerSecond = bytesRead / seconds;
+        result.writeBytesPerSecond = bytesWritten / seconds;
+    }
+    if (hits + misses > 0) {
+        result.replyCacheHitRate = static_cast<double>(hits) / (hits + misses);
+    }
+    if (arrived > 0) {
+        result.busyFraction = qMin(1.0, static_cast<double>(enqueued) / arrived);
+    }
+    result.starved = arrived >= MinimumArrivalsForStarvation
+                     && result.busyFraction >= m_starvationThreshold;
+    return result;
+}
+
+QList<NFSDLoadSample> NFSDLoadMonitor::history() const
+{
+    QList<NFSDLoadSample> result;
+    result.reserve(static_cast<int>(m_history.size()));
+    for (std::size_t i = 0; i < m_history.size(); ++i) {
+        result << m_history.at(i);
+    }
+    return result;
+}
+
+void NFSDLoadMonitor::setWindowSize(int samples)
+{
+    m_windowSize = qBound(1, samples, static_cast<int>(HistorySize));
+}
+
+int NFSDLoadMonitor::windowSize() const
+{
+    return m_windowSize;
+}
+
+void NFSDLoadMonitor::setStarvationThreshold(double fraction)
+{
+    m_starvationThreshold = fraction;
+}
+
+double NFSDLoadMonitor::starvationThreshold() const
+{
+    return m_starvationThreshold;
+}
+
+void NFSDLoadMonitor::setProcRoot(const QString &procRoot)
+{
+    stop();
+    m_procRoot = procRoot;
+    m_hasPrevious = false;
+    m_history.clear();
+    m_starved = false;
+}
+
+void NFSDLoadMonitor::onSampleTimer()
+{
+    sample();
+}
+
+} // namespace NFSShareManager
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QTimer>
+#include "../system/ringbuffer.h"
+
+namespace NFSShareManager {
+
+/**
+ * @brief nfsd load figures for one sampling interval
+ */
+struct NFSDLoadSample {
+    qint64 timestampMs = 0;           ///< Monotonic time of the sample
+    double intervalSeconds = 0.0;     ///< Time since the previous sample
+    quint64 operations = 0;           ///< NFSv3 procedures and NFSv4 operations served
+    quint64 bytesRead = 0;            ///< Bytes read from disk on behalf of clients
+    quint64 bytesWritten = 0;         ///< Bytes written to disk on behalf of clients
+    quint64 replyCacheHits = 0;       ///< Duplicate request cache hits
+    quint64 replyCacheMisses = 0;     ///< Duplicate request cache misses
+    quint64 packetsArrived = 0;       ///< Requests that arrived on the thread pools
+    quint64 socketsEnqueued = 0;      ///< Requests that had to wait because no thread was idle
+    quint64 threadsTimedOut = 0;      ///< Idle threads that timed out waiting for work
+    int threads = 0;                  ///< Configured nfsd threads
+};
+
+/**
+ * @brief nfsd load aggregated over the rolling window
+ */
+struct NFSDLoadSummary {
+    double operationsPerSecond = 0.0;   ///< Operations served per second
+    double readBytesPerSecond = 0.0;    ///< Disk read throughput
+    double writeBytesPerSecond = 0.0;   ///< Disk write throughput
+    double replyCacheHitRate = 0.0;     ///< Reply cache hits / (hits + misses), 0 if no lookups
+    double busyFraction = 0.0;          ///< Share of requests that found every thread busy
+    int threads = 0;                    ///< Configured nfsd threads
+    int sampleCount = 0;                ///< Samples in the window
+    bool starved = false;               ///< Whether the thread pools are considered starved
+};
+
+/**
+ * @brief Server-side nfsd load sampler
+ *
+ * Reads /proc/net/rpc/nfsd (th/io/rc/proc3/proc4ops lines),
+ * /proc/fs/nfsd/pool_stats and /proc/fs/nfsd/threads, turns the
+ * cumulative counters into per-interval deltas and aggregates them over a
+ * rolling window. The statistics files are kept open and re-read with one
+ * read() each into reused buffers, so sampling every second is cheap.
+ *
+ * Thread pool starvation is detected from pool_stats: a request that
+ * arrives while no nfsd thread is idle is counted as "sockets-enqueued".
+ */
+class NFSDLoadMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Number of samples kept in the history
+    static constexpr std::size_t HistorySize = 300;
+
+    explicit NFSDLoadMonitor(QObject *parent = nullptr);
+    ~NFSDLoadMonitor();
+
+    /**
+     * @brief Check if the kernel NFS server statistics are present
+     * @return True if nfsd is loaded and its statistics can be read
+     */
+    bool isAvailable() const;
+
+    /**
+     * @brief Start periodic sampling
+     * @param intervalMs Sampling interval in milliseconds
+     */
+    void start(int intervalMs = 1000);
+
+    /**
+     * @brief Stop periodic sampling
+     */
+    void stop();
+
+    /**
+     * @brief Check if periodic sampling is active
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Read all statistics files and update the window
+     * @return True if /proc/net/rpc/nfsd could be read
+     */
+    bool sample();
+
+    /**
+     * @brief Update the window from already read statistics
+     * @param rpcNfsd Content of /proc/net/rpc/nfsd
+     * @param poolStats Content of /proc/fs/nfsd/pool_stats (may be empty)
+     * @param threads Content of /proc/fs/nfsd/threads (may be empty)
+     * @param timestampMs Monotonic time of the sample in ms
+     */
+    void sample(const QByteArray &rpcNfsd, const QByteArray &poolStats,
+                const QByteArray &threads, qint64 timestampMs);
+
+    /**
+     * @brief Get the load aggregated over the rolling window
+     */
+    NFSDLoadSummary summary() const;
+
+    /**
+     * @brief Get the recorded samples, oldest first
+     */
+    QList<NFSDLoadSample> history() const;
+
+    /**
+     * @brief Set the number of samples aggregated by summary()
+     * @param samples Window length, clamped to 1..HistorySize
+     */
+    void setWindowSize(int samples);
+
+    /**
+     * @brief Get the number of samples aggregated by summary()
+     */
+    int windowSize() const;
+
+    /**
+     * @brief Set the busy fraction at which the pools count as starved
+     * @param fraction Share of requests that found no idle thread (default 0.1)
+     */
+    void setStarvationThreshold(double fraction);
+
+    /**
+     * @brief Get the busy fraction at which the pools count as starved
+     */
+    double starvationThreshold() const;
+
+    /**
+     * @brief Set the directory holding the statistics files (for testing)
+     * @param procRoot Replacement for "/proc"
+     */
+    void setProcRoot(const QString &procRoot);
+
+signals:
+    /**
+     * @brief Emitted after every sample with the window summary
+     * @param summary Load aggregated over the rolling window
+     */
+    void loadUpdated(const NFSDLoadSummary &summary);
+
+    /**
+     * @brief Emitted when the thread pools become starved
+     * @param summary Load aggregated over the rolling window
+     */
+    void threadPoolStarved(const NFSDLoadSummary &summary);
+
+    /**
+     * @brief Emitted when the thread pools are no longer starved
+     */
+    void threadPoolRecovered();
+
+private slots:
+    /**
+     * @brief Handle the sampling timer
+     */
+    void onSampleTimer();
+
+private:
+    /**
+     * @brief Cumulative counters read from the statistics files
+     */
+    struct Counters {
+        quint64 operations = 0;
+        quint64 bytesRead = 0;
+        quint64 bytesWritten = 0;
+        quint64 replyCacheHits = 0;
+        quint64 replyCacheMisses = 0;
+        quint64 packetsArrived = 0;
+        quint64 socketsEnqueued = 0;
+        quint64 threadsTimedOut = 0;
+        int threads = 0;
+    };
+
+    /**
+     * @brief Read a whole statistics file with a single read into @p buffer
+     * @return Number of bytes read, or -1 on failure
+     */
+    static qint64 readFile(QFile &file, QByteArray &buffer);
+
+    static void parseRpcNfsd(const char *data, qint64 size, Counters &counters);
+    static void parsePoolStats(const char *data, qint64 size, Counters &counters);
+
+    void openFiles();
+
+    QTimer *m_sampleTimer;                            ///< Sampling timer
+    QElapsedTimer m_clock;                            ///< Monotonic clock for timestamps
+    QString m_procRoot;                               ///< Root of the proc filesystem
+    QFile m_rpcNfsdFile;                              ///< Kept open /proc/net/rpc/nfsd
+    QFile m_poolStatsFile;                            ///< Kept open /proc/fs/nfsd/pool_stats
+    QByteArray m_rpcNfsdBuffer;                       ///< Reused read buffer
+    QByteArray m_poolStatsBuffer;                     ///< Reused read buffer
+    Counters m_previous;                              ///< Counters of the previous sample
+    qint64 m_previousTimestamp;                       ///< Time of the previous sample
+    bool m_hasPrevious;                               ///< Whether m_previous is valid
+    RingBuffer<NFSDLoadSample, HistorySize> m_history;   ///< Per-interval samples
+    int m_windowSize;                                 ///< Samples aggregated by summary()
+    double m_starvationThreshold;                     ///< Busy fraction that counts as starved
+    bool m_starved;                                   ///< Current starvation state
+};
+
+} // namespace NFSShareManager
@@ -0,0 +1,476 @@
+#include "replicaselector.h"
+#include "mounthealthwatchdog.h"
+#include "../system/detachedcall.h"
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QTcpSocket>
+#include <QtEndian>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace NFSShareManager {
+
+namespace {
+
+constexpr quint16 NFSPort = 2049;
+constexpr quint32 LastFragment = 0x80000000u;
+
+/// Below this difference replicas are never considered degraded (LAN jitter)
+constexpr double MinimumDifferenceMs = 1.0;
+
+quint32 wordAt(const QByteArray &data, int offset)
+{
+    return qFromBigEndian<quint32>(data.constData() + offset);
+}
+
+QString serverOf(const RemoteNFSShare &share)
+{
+    return share.hostAddress().isNull() ? share.hostName() : share.hostAddress().toString();
+}
+
+double median(QList<double> values)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const int middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+}
+
+} // namespace
+
+ReplicaSelector::ReplicaSelector(QObject *parent)
+    : QObject(parent)
+    , m_rttOperation(&ReplicaSelector::defaultRtt)
+    , m_timeout(2000)
+    , m_timer(new QTimer(this))
+    , m_degradationFactor(2.0)
+    , m_degradationSamples(3)
+    , m_nextGeneration(1)
+{
+    connect(m_timer, &QTimer::timeout, this, &ReplicaSelector::checkNow);
+}
+
+ReplicaSelector::~ReplicaSelector()
+{
+    // Outstanding checks find the selector gone and drop their result
+}
+
+void ReplicaSelector::setShares(const QList<RemoteNFSShare> &shares)
+{
+    QHash<QString, QList<RemoteNFSShare>> groups;
+    for (const RemoteNFSShare &share : shares) {
+        QList<RemoteNFSShare> &group = groups[replicaKey(share)];
+        const bool known = std::any_of(group.cbegin(), group.cend(), [&share](const RemoteNFSShare &replica) {
+            return isSameReplica(replica, share);
+        });
+        if (!known) {
+            group << share;
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_groups = groups;
+}
+
+QString ReplicaSelector::replicaKey(const RemoteNFSShare &share) const
+{
+    MarkerOperation marker;
+    {
+        QMutexLocker locker(&m_mutex);
+        marker = m_markerOperation;
+    }
+
+    const QString path = QDir::cleanPath(share.exportPath());
+    const QString contentMarker = marker ? marker(share) : QString();
+    return contentMarker.isEmpty() ? path : path + '#' + contentMarker;
+}
+
+QList<RemoteNFSShare> ReplicaSelector::replicasOf(const RemoteNFSShare &share) const
+{
+    const QList<RemoteNFSShare> group = groupOf(share);
+    return group.isEmpty() ? QList<RemoteNFSShare>{share} : group;
+}
+
+bool ReplicaSelector::hasReplicas(const RemoteNFSShare &share) const
+{
+    return groupOf(share).size() > 1;
+}
+
+QList<QList<RemoteNFSShare>> ReplicaSelector::replicaGroups() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<QList<RemoteNFSShare>> groups;
+    for (const QList<RemoteNFSShare> &group : m_groups) {
+        if (group.size() > 1) {
+            groups << group;
+        }
+    }
+    return groups;
+}
+
+QList<ReplicaMeasurement> ReplicaSelector::measure(const QList<RemoteNFSShare> &replicas) const
+{
+    RttOperation rtt;
+    ProbeOperation probe;
+    int timeoutMs;
+    {
+        QMutexLocker locker(&m_mutex);
+        rtt = m_rttOperation;
+        probe = m_probeOperation;
+        timeoutMs = m_timeout;
+    }
+    return measureReplicas(replicas, rtt, probe, timeoutMs);
+}
+
+RemoteNFSShare ReplicaSelector::selectFastest(const RemoteNFSShare &share) const
+{
+    const QList<RemoteNFSShare> replicas = replicasOf(share);
+    if (replicas.size() < 2) {
+        return share;
+    }
+
+    const QList<ReplicaMeasurement> measurements = measure(replicas);
+    if (measurements.isEmpty() || !measurements.first().reachable) {
+        qWarning() << "ReplicaSelector: no replica of" << share.exportPath() << "answered, keeping" << serverOf(share);
+        return share;
+    }
+    const ReplicaMeasurement &fastest = measurements.first();
+    qDebug() << "ReplicaSelector: selected" << serverOf(fastest.replica) << "for" << share.exportPath()
+             << "(" << fastest.latencyMs() << "ms of" << replicas.size() << "replicas)";
+    return fastest.replica;
+}
+
+RemoteNFSShare ReplicaSelector::selectForMount(const QString &mountPoint, const RemoteNFSShare &share)
+{
+    const RemoteNFSShare replica = selectFastest(share);
+    QMutexLocker locker(&m_mutex);
+    m_selections.insert(mountPoint, replica);
+    return replica;
+}
+
+bool ReplicaSelector::takeSelection(const QString &mountPoint, RemoteNFSShare *replica)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_selections.find(mountPoint);
+    if (it == m_selections.end()) {
+        return false;
+    }
+    if (replica) {
+        *replica = it.value();
+    }
+    m_selections.erase(it);
+    return true;
+}
+
+void ReplicaSelector::setMounts(const QList<NFSMount> &mounts)
+{
+    QHash<QString, Watch> watches;
+    for (const NFSMount &mount : mounts) {
+        // Writable mounts are never moved, so there is nothing to watch
+        if (mount.status() != MountStatus::Mounted || !mount.options().readOnly
+            || !hasReplicas(mount.remoteShare())) {
+            continue;
+        }
+        Watch watch = m_watches.value(mount.localMountPoint());
+        if (!isSameReplica(watch.mount.remoteShare(), mount.remoteShare())) {
+            // Re-pointed to another replica; start counting afresh
+            watch.degradedChecks = 0;
+        }
+        watch.mount = mount;
+        watches.insert(mount.localMountPoint(), watch);
+    }
+    m_watches = watches;
+}
+
+void ReplicaSelector::start(int intervalMs)
+{
+    m_timer->start(intervalMs);
+}
+
+void ReplicaSelector::stop()
+{
+    m_timer->stop();
+}
+
+bool ReplicaSelector::isRunning() const
+{
+    return m_timer->isActive();
+}
+
+void ReplicaSelector::checkNow()
+{
+    const QStringList mountPoints = m_watches.keys();
+    for (const QString &mountPoint : mountPoints) {
+        startCheck(mountPoint);
+    }
+}
+
+bool ReplicaSelector::isChecking(const QString &mountPoint) const
+{
+    return m_watches.value(mountPoint).generation != 0;
+}
+
+void ReplicaSelector::setDegradationFactor(double factor)
+{
+    m_degradationFactor = qMax(1.0, factor);
+}
+
+double ReplicaSelector::degradationFactor() const
+{
+    return m_degradationFactor;
+}
+
+void ReplicaSelector::setDegradationSamples(int samples)
+{
+    m_degradationSamples = qMax(1, samples);
+}
+
+int ReplicaSelector::degradationSamples() const
+{
+    return m_degradationSamples;
+}
+
+void ReplicaSelector::setTimeout(int msecs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_timeout = qMax(1, msecs);
+}
+
+int ReplicaSelector::timeout() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_timeout;
+}
+
+void ReplicaSelector::setMarkerOperation(const MarkerOperation &operation)
+{
+    QMutexLocker locker(&m_mutex);
+    m_markerOperation = operation;
+}
+
+void ReplicaSelector::setRttOperation(const RttOperation &operation)
+{
+    QMutexLocker locker(&m_mutex);
+    m_rttOperation = operation;
+}
+
+void ReplicaSelector::setProbeOperation(const ProbeOperation &operation)
+{
+    QMutexLocker locker(&m_mutex);
+    m_probeOperation = operation;
+}
+
+bool ReplicaSelector::isSameReplica(const RemoteNFSShare &first, const RemoteNFSShare &second)
+{
+    return serverOf(first) == serverOf(second)
+        && QDir::cleanPath(first.exportPath()) == QDir::cleanPath(second.exportPath());
+}
+
+QString ReplicaSelector::pipelinedRpcRtt(const QString &host, quint16 port, quint32 program, quint32 version,
+                                         int pings, int timeoutMs, double *rttMs)
+{
+    pings = qMax(1, pings);
+    QDeadlineTimer deadline(timeoutMs);
+    QTcpSocket socket;
+    socket.connectToHost(host, port);
+    if (!socket.waitForConnected(static_cast<int>(deadline.remainingTime()))) {
+        return QString("Cannot connect to %1:%2: %3").arg(host).arg(port).arg(socket.errorString());
+    }
+    socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    // All calls leave in one write; every reply is timed from that moment
+    const quint32 firstXid = static_cast<quint32>(QDateTime::currentMSecsSinceEpoch()) ^ (program << 8) ^ version;
+    QByteArray calls;
+    for (int i = 0; i < pings; ++i) {
+        calls += MountHealthWatchdog::buildRpcNullCall(firstXid + static_cast<quint32>(i), program, version);
+    }
+    QElapsedTimer elapsed;
+    elapsed.start();
+    socket.write(calls);
+
+    QList<double> replyTimes;
+    QByteArray buffer;
+    while (replyTimes.size() < pings) {
+        if (deadline.hasExpired() || !socket.waitForReadyRead(static_cast<int>(deadline.remainingTime()))) {
+            return QString("%1 of %2 RPC replies from %3:%4").arg(replyTimes.size()).arg(pings).arg(host).arg(port);
+        }
+        const double arrivedMs = elapsed.nsecsElapsed() / 1e6;
+        buffer += socket.readAll();
+
+        while (buffer.size() >= 4) {
+            const qint64 length = 4 + static_cast<qint64>(wordAt(buffer, 0) & ~LastFragment);
+            if (length > 4096) {
+                return QString("Oversized RPC reply from %1:%2").arg(host).arg(port);
+            }
+            if (buffer.size() < length) {
+                break;
+            }
+            const QByteArray reply = buffer.left(length);
+            buffer.remove(0, length);
+            if (reply.size() < 8 || wordAt(reply, 4) - firstXid >= static_cast<quint32>(pings)) {
+                return QString("RPC reply for another call");
+            }
+            const QString error = MountHealthWatchdog::checkRpcReply(reply, wordAt(reply, 4));
+            if (!error.isEmpty()) {
+                return error;
+            }
+            replyTimes << arrivedMs;
+        }
+    }
+
+    if (rttMs) {
+        *rttMs = median(replyTimes);
+    }
+    return QString();
+}
+
+QList<RemoteNFSShare> ReplicaSelector::groupOf(const RemoteNFSShare &share) const
+{
+    {
+        // Known shares keep the group they were discovered in
+        QMutexLocker locker(&m_mutex);
+        for (const QList<RemoteNFSShare> &group : m_groups) {
+            for (const RemoteNFSShare &replica : group) {
+                if (isSameReplica(replica, share)) {
+                    return group;
+                }
+            }
+        }
+    }
+
+    const QString key = replicaKey(share);
+    QMutexLocker locker(&m_mutex);
+    return m_groups.value(key);
+}
+
+void ReplicaSelector::startCheck(const QString &mountPoint)
+{
+    auto it = m_watches.find(mountPoint);
+    if (it == m_watches.end() || it->generation != 0) {
+        return;
+    }
+
+    const quint64 generation = m_nextGeneration++;
+    it->generation = generation;
+
+    const QList<RemoteNFSShare> replicas = replicasOf(it->mount.remoteShare());
+    RttOperation rtt;
+    ProbeOperation probe;
+    int timeoutMs;
+    {
+        QMutexLocker locker(&m_mutex);
+        rtt = m_rttOperation;
+        probe = m_probeOperation;
+        timeoutMs = m_timeout;
+    }
+
+    DetachedCall::run(this, [replicas, rtt, probe, timeoutMs]() {
+        return measureReplicas(replicas, rtt, probe, timeoutMs);
+    }, [mountPoint, generation](ReplicaSelector *selector, const QList<ReplicaMeasurement> &measurements) {
+        selector->finishCheck(mountPoint, generation, measurements);
+    });
+}
+
+void ReplicaSelector::finishCheck(const QString &mountPoint, quint64 generation,
+                                  const QList<ReplicaMeasurement> &measurements)
+{
+    auto it = m_watches.find(mountPoint);
+    if (it == m_watches.end() || it->generation != generation) {
+        return;
+    }
+    it->generation = 0;
+
+    const RemoteNFSShare current = it->mount.remoteShare();
+    const ReplicaMeasurement *mounted = nullptr;
+    const ReplicaMeasurement *best = nullptr;
+    for (const ReplicaMeasurement &measurement : measurements) {
+        if (isSameReplica(measurement.replica, current)) {
+            mounted = &measurement;
+        } else if (!best && measurement.reachable) {
+            best = &measurement;
+        }
+    }
+    if (!best) {
+        // Nowhere better to go
+        it->degradedChecks = 0;
+        return;
+    }
+
+    const bool currentReachable = mounted && mounted->reachable;
+    const double currentMs = currentReachable ? mounted->latencyMs() : -1.0;
+    const bool degraded = !currentReachable
+        || (currentMs > m_degradationFactor * best->latencyMs() && currentMs - best->latencyMs() > MinimumDifferenceMs);
+    if (!degraded) {
+        it->degradedChecks = 0;
+        return;
+    }
+
+    if (++it->degradedChecks < m_degradationSamples) {
+        return;
+    }
+    it->degradedChecks = 0;
+    qWarning() << "ReplicaSelector:" << mountPoint << "on" << serverOf(current) << "is degraded:"
+               << currentMs << "ms," << serverOf(best->replica) << "answers in" << best->latencyMs() << "ms";
+    emit replicaDegraded(it->mount, best->replica, currentMs, best->latencyMs());
+}
+
+QList<ReplicaMeasurement> ReplicaSelector::measureReplicas(const QList<RemoteNFSShare> &replicas,
+                                                           const RttOperation &rtt, const ProbeOperation &probe,
+                                                           int timeoutMs)
+{
+    QList<ReplicaMeasurement> measurements(replicas.size());
+    std::vector<std::thread> workers;
+    workers.reserve(replicas.size());
+
+    // Every replica races at the same time; both operations are bounded by timeoutMs
+    for (int i = 0; i < replicas.size(); ++i) {
+        ReplicaMeasurement &measurement = measurements[i];
+        measurement.replica = replicas[i];
+        workers.emplace_back([&measurement, &rtt, &probe, timeoutMs]() {
+            double rttMs = 0.0;
+            measurement.errorMessage = rtt(measurement.replica, timeoutMs, &rttMs);
+            if (!measurement.errorMessage.isEmpty()) {
+                return;
+            }
+            measurement.rttMs = rttMs;
+            if (probe) {
+                QElapsedTimer elapsed;
+                elapsed.start();
+                measurement.errorMessage = probe(measurement.replica, timeoutMs);
+                if (!measurement.errorMessage.isEmpty()) {
+                    return;
+                }
+                measurement.probeMs = elapsed.nsecsElapsed() / 1e6;
+            }
+            measurement.reachable = true;
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    std::stable_sort(measurements.begin(), measurements.end(),
+                     [](const ReplicaMeasurement &first, const ReplicaMeasurement &second) {
+        if (first.reachable != second.reachable) {
+            return first.reachable;
+        }
+        return first.latencyMs() < second.latencyMs();
+    });
+    return measurements;
+}
+
+QString ReplicaSelector::defaultRtt(const RemoteNFSShare &replica, int timeoutMs, double *rttMs)
+{
+    // Any NFS server answers a v4 NULL call, if only with a version mismatch
+    return pipelinedRpcRtt(serverOf(replica), NFSPort, MountHealthWatchdog::NFSProgram, 4, PipelinedPings,
+                           timeoutMs, rttMs);
+}
+
+} // namespace NFSShareManager
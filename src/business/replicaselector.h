@@ -0,0 +1,291 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QTimer>
+#include <functional>
+#include "../core/nfsmount.h"
+#include "../core/remotenfsshare.h"
+
+namespace NFSShareManager {
+
+/**
+ * @brief Latency of one replica measured by ReplicaSelector
+ */
+struct ReplicaMeasurement {
+    RemoteNFSShare replica;     ///< The measured replica
+    bool reachable;             ///< Whether the server answered
+    double rttMs;               ///< Median RPC NULL round trip time
+    double probeMs;             ///< Duration of the short-read probe, 0 without one
+    QString errorMessage;       ///< Reason the replica is unreachable
+
+    ReplicaMeasurement() : reachable(false), rttMs(0.0), probeMs(0.0) {}
+
+    /**
+     * @brief Get the figure replicas are ranked by
+     */
+    double latencyMs() const { return rttMs + probeMs; }
+};
+
+/**
+ * @brief Picks the fastest of several servers exporting the same data
+ *
+ * Read-only datasets are often exported by several mirror servers. Shares
+ * with the same export path, and the same content marker if one is set,
+ * are grouped as replicas of each other.
+ *
+ * Before a mount, all replicas are measured in parallel: a burst of RPC
+ * NULL calls is pipelined on one connection to each server and the median
+ * round trip time is taken, optionally followed by a short-read probe. The
+ * replica with the lowest latency wins; unreachable replicas lose.
+ *
+ * Only read-only mounts are switched between replicas; a writable share is
+ * always mounted from the server the user picked.
+ *
+ * Mounted read-only replicas are measured again periodically on a detached thread.
+ * When the mounted replica is slower than degradationFactor() times the
+ * best alternative for degradationSamples() checks in a row,
+ * replicaDegraded() is emitted.
+ */
+class ReplicaSelector : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Derives a content marker of a share, e.g. a dataset id
+     * @return The marker, or an empty string if the share has none
+     */
+    using MarkerOperation = std::function<QString(const RemoteNFSShare &share)>;
+
+    /**
+     * @brief Measures the round trip time to a replica's server
+     * @param rttMs Receives the round trip time in milliseconds
+     * @return Error message, or an empty string if the server answered
+     */
+    using RttOperation = std::function<QString(const RemoteNFSShare &replica, int timeoutMs, double *rttMs)>;
+
+    /**
+     * @brief Reads a little data from a replica; must return within timeoutMs
+     * @return Error message, or an empty string on success
+     */
+    using ProbeOperation = std::function<QString(const RemoteNFSShare &replica, int timeoutMs)>;
+
+    /// RPC NULL calls pipelined per measurement
+    static constexpr int PipelinedPings = 5;
+
+    explicit ReplicaSelector(QObject *parent = nullptr);
+    ~ReplicaSelector();
+
+    /**
+     * @brief Set the known shares and group them into replicas
+     * @param shares Shares found by network discovery
+     */
+    void setShares(const QList<RemoteNFSShare> &shares);
+
+    /**
+     * @brief Get the replica group key of a share
+     * @param share The share
+     * @return Cleaned export path, plus the content marker if there is one
+     */
+    QString replicaKey(const RemoteNFSShare &share) const;
+
+    /**
+     * @brief Get every known replica of a share, including the share itself
+     * @param share The share
+     */
+    QList<RemoteNFSShare> replicasOf(const RemoteNFSShare &share) const;
+
+    /**
+     * @brief Check if a share is exported by more than one known server
+     * @param share The share
+     */
+    bool hasReplicas(const RemoteNFSShare &share) const;
+
+    /**
+     * @brief Get all groups with more than one replica
+     */
+    QList<QList<RemoteNFSShare>> replicaGroups() const;
+
+    /**
+     * @brief Measure replicas in parallel; blocks until all have answered or timed out
+     * @param replicas The replicas to measure
+     * @return The measurements, fastest reachable replica first
+     */
+    QList<ReplicaMeasurement> measure(const QList<RemoteNFSShare> &replicas) const;
+
+    /**
+     * @brief Get the fastest replica of a share; blocks while measuring
+     * @param share The share the user picked
+     * @return The fastest reachable replica, or share if it has none or none answered
+     */
+    RemoteNFSShare selectFastest(const RemoteNFSShare &share) const;
+
+    /**
+     * @brief selectFastest(), remembering the choice for a mount point
+     *
+     * Thread-safe, for use from mount worker threads.
+     *
+     * @param mountPoint The mount point the share is mounted to
+     * @param share The share the user picked
+     * @return The replica to mount
+     */
+    RemoteNFSShare selectForMount(const QString &mountPoint, const RemoteNFSShare &share);
+
+    /**
+     * @brief Get and forget the replica chosen by selectForMount()
+     * @param mountPoint The mount point
+     * @param replica Receives the chosen replica
+     * @return False if no replica was chosen for the mount point
+     */
+    bool takeSelection(const QString &mountPoint, RemoteNFSShare *replica);
+
+    /**
+     * @brief Set the mounts to watch for degradation
+     *
+     * Only mounted shares that have replicas are watched.
+     *
+     * @param mounts The managed mounts
+     */
+    void setMounts(const QList<NFSMount> &mounts);
+
+    /**
+     * @brief Start periodic degradation checks
+     * @param intervalMs Check interval in milliseconds
+     */
+    void start(int intervalMs = 60000);
+
+    /**
+     * @brief Stop periodic degradation checks
+     */
+    void stop();
+
+    /**
+     * @brief Check if periodic degradation checks are running
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Measure the replicas of every watched mount now; returns immediately
+     */
+    void checkNow();
+
+    /**
+     * @brief Check if a degradation check of a mount is outstanding
+     * @param mountPoint The mount point
+     */
+    bool isChecking(const QString &mountPoint) const;
+
+    /**
+     * @brief Set how much slower than the best alternative counts as degraded
+     * @param factor Latency ratio, at least 1 (default 2.0)
+     */
+    void setDegradationFactor(double factor);
+
+    /**
+     * @brief Get the degradation latency ratio
+     */
+    double degradationFactor() const;
+
+    /**
+     * @brief Set how many checks in a row must show degradation
+     * @param samples Number of consecutive checks (default 3)
+     */
+    void setDegradationSamples(int samples);
+
+    /**
+     * @brief Get the number of consecutive degraded checks required
+     */
+    int degradationSamples() const;
+
+    /**
+     * @brief Set the timeout of one replica measurement
+     * @param msecs Timeout in milliseconds (default 2000)
+     */
+    void setTimeout(int msecs);
+
+    /**
+     * @brief Get the timeout of one replica measurement
+     */
+    int timeout() const;
+
+    /**
+     * @brief Set how content markers are derived
+     * @param operation The marker function, or an empty function to group by export path only
+     */
+    void setMarkerOperation(const MarkerOperation &operation);
+
+    /**
+     * @brief Set the round trip time measurement
+     * @param operation The measurement (default: pipelined RPC NULL calls to port 2049)
+     */
+    void setRttOperation(const RttOperation &operation);
+
+    /**
+     * @brief Set the short-read probe run after the RTT measurement
+     * @param operation The probe, or an empty function to rank by RTT alone (default)
+     */
+    void setProbeOperation(const ProbeOperation &operation);
+
+    /**
+     * @brief Check if two shares are the same export of the same server
+     */
+    static bool isSameReplica(const RemoteNFSShare &first, const RemoteNFSShare &second);
+
+    /**
+     * @brief Send RPC NULL calls back to back on one connection and time the replies
+     * @param host Server address or hostname
+     * @param port TCP port
+     * @param program RPC program number
+     * @param version RPC program version
+     * @param pings Number of calls in flight
+     * @param timeoutMs Timeout for the connection and all replies
+     * @param rttMs Receives the median reply time in milliseconds
+     * @return Error message, or an empty string if every call was answered
+     */
+    static QString pipelinedRpcRtt(const QString &host, quint16 port, quint32 program, quint32 version,
+                                   int pings, int timeoutMs, double *rttMs);
+
+signals:
+    /**
+     * @brief Emitted when a mounted replica stayed much slower than another one
+     * @param mount The mount of the degraded replica
+     * @param better The fastest reachable alternative
+     * @param currentMs Latency of the mounted replica, or -1 if it did not answer
+     * @param betterMs Latency of the alternative
+     */
+    void replicaDegraded(const NFSMount &mount, const RemoteNFSShare &better, double currentMs, double betterMs);
+
+private:
+    struct Watch {
+        NFSMount mount;                 ///< Watched mount
+        int degradedChecks = 0;         ///< Consecutive checks that showed degradation
+        quint64 generation = 0;         ///< Id of the outstanding check, 0 if none
+    };
+
+    QList<RemoteNFSShare> groupOf(const RemoteNFSShare &share) const;
+    void startCheck(const QString &mountPoint);
+    void finishCheck(const QString &mountPoint, quint64 generation, const QList<ReplicaMeasurement> &measurements);
+    static QList<ReplicaMeasurement> measureReplicas(const QList<RemoteNFSShare> &replicas, const RttOperation &rtt,
+                                                     const ProbeOperation &probe, int timeoutMs);
+    static QString defaultRtt(const RemoteNFSShare &replica, int timeoutMs, double *rttMs);
+
+    mutable QMutex m_mutex;                             ///< Guards the members used by worker threads
+    QHash<QString, QList<RemoteNFSShare>> m_groups;     ///< Replicas by replicaKey()
+    QHash<QString, RemoteNFSShare> m_selections;        ///< selectForMount() results by mount point
+    MarkerOperation m_markerOperation;                  ///< Content marker, may be empty
+    RttOperation m_rttOperation;                        ///< Round trip time measurement
+    ProbeOperation m_probeOperation;                    ///< Short-read probe, may be empty
+    int m_timeout;                                      ///< Measurement timeout in ms
+
+    QTimer *m_timer;                    ///< Periodic check timer
+    QHash<QString, Watch> m_watches;    ///< Watched mounts by mount point
+    double m_degradationFactor;         ///< Latency ratio that counts as degraded
+    int m_degradationSamples;           ///< Consecutive degraded checks before reporting
+    quint64 m_nextGeneration;           ///< Id for the next check
+};
+
+} // namespace NFSShareManager
@@ -2,29 +2,95 @@
 #include "../core/nfsshare.h"
 #include "../core/shareconfiguration.h"
 #include "../core/permissionset.h"
+#include "../system/exportsdwriter.h"
 #include <QDebug>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <atomic>
+#include <vector>
 
 namespace NFSShareManager {
 
+namespace {
+
+const QString NFSServerUnit = "nfs-server.service";
+
+/**
+ * @brief Units whose state decides whether the NFS server is usable
+ *
+ * rpcbind and nfs-mountd are only needed for NFSv3 clients, so they count
+ * against the server only when they have failed, not when inactive or masked.
+ */
+QStringList nfsServerUnits()
+{
+    return {NFSServerUnit, "rpcbind.service", "nfs-mountd.service"};
+}
+
+} // namespace
+
 ShareManager::ShareManager(QObject *parent)
     : QObject(parent)
     , m_policyKitHelper(nullptr)
     , m_nfsService(new NFSServiceInterface(this))
+    , m_loadMonitor(new NFSDLoadMonitor(this))
+    , m_usageMonitor(new ShareUsageMonitor(this))
+    , m_serviceMonitor(new SystemdManager(this))
+    , m_clientTracker(new NFSDClientTracker(this))
     , m_fileWatcher(nullptr)
-    , m_refreshTimer(nullptr)
+    , m_refreshTimer(new QTimer(this))
+    , m_pathValidator(std::make_shared<SharePathValidator>())
+    , m_bulkRunning(false)
+    , m_bulkKind(BulkKind::Create)
     , m_initialized(false)
+    , m_nfsServerRunning(false)
 {
     qDebug() << "ShareManager initialized";
-    // Initialize the shares list
-    m_activeShares.clear();
+    qRegisterMetaType<ExportBatchResult>("ExportBatchResult");
+    qRegisterMetaType<NFSCommandResult>("NFSCommandResult");
+    m_validationPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), 16));
     
     // Connect NFSServiceInterface signals
     connect(m_nfsService, &NFSServiceInterface::commandFinished, 
             this, &ShareManager::onNFSCommandFinished);
+    
+    // Check for drift from the kernel export table; a pass is a single
+    // stat() unless etab or the managed shares changed
+    m_refreshTimer->setInterval(5000);
+    connect(m_refreshTimer, &QTimer::timeout, this, &ShareManager::onRefreshTimer);
+    m_refreshTimer->start();
+    
+    // Sample nfsd load once a second while the kernel NFS server is loaded
+    if (m_loadMonitor->isAvailable()) {
+        m_loadMonitor->start(1000);
+    }
+    
+    // Keep share sizes in step with the share list; subtotals from the
+    // previous session make the first scan incremental
+    m_usageMonitor->loadCache();
+    connect(this, &ShareManager::shareCreated, this, &ShareManager::syncShareMonitors);
+    connect(this, &ShareManager::shareRemoved, this, &ShareManager::syncShareMonitors);
+    connect(this, &ShareManager::sharesCreated, this, &ShareManager::syncShareMonitors);
+    connect(this, &ShareManager::sharesRemoved, this, &ShareManager::syncShareMonitors);
+    connect(this, &ShareManager::sharesRefreshed, this, &ShareManager::syncShareMonitors);
+    connect(m_clientTracker, &NFSDClientTracker::clientsChanged, this, &ShareManager::activeClientsChanged);
+    
+    // Server state follows systemd's unit signals; no polling of systemctl
+    m_nfsServerRunning = isNFSServerRunning();
+    connect(m_serviceMonitor, &SystemdManager::unitStateChanged, this, &ShareManager::onServiceStateChanged);
+    connect(m_serviceMonitor, &SystemdManager::jobFinished, this, &ShareManager::onServiceJobFinished);
+    for (const QString &unit : nfsServerUnits()) {
+        m_serviceMonitor->watchUnit(unit);
+    }
 }
 
 ShareManager::~ShareManager()
 {
+    // Validation chunks and bulk export transactions post back to this object
+    m_validationPool.waitForDone();
+    m_usageMonitor->saveCache();
 }
 
 bool ShareManager::createShare(const QString &path, const ShareConfiguration &config)
@@ -48,22 +114,20 @@ bool ShareManager::createShare(const QString &path, const ShareConfiguration &co
     newShare.setCreatedAt(QDateTime::currentDateTime());
     newShare.setActive(true);
     
-    // Actually export the directory using NFS tools
-    if (m_nfsService) {
-        qDebug() << "Exporting directory to NFS system:" << path;
-        NFSCommandResult result = m_nfsService->exportDirectory(path, config);
-        
-        if (!result.success) {
-            qDebug() << "Failed to export directory:" << result.error;
-            emit shareError(path, tr("Failed to export directory: %1").arg(result.error));
-            return false;
-        }
-        
-        qDebug() << "Directory exported successfully:" << result.output;
+    // Written to the exports files, so the share survives an exportfs -r
+    qDebug() << "Exporting directory to NFS system:" << path;
+    const ExportBatchResult result = applyExportBatch(ExportBatch() << ExportChange::add(path, config));
+    recoverExportBatch(result);
+    if (!result.success) {
+        const QString error = result.entries.isEmpty() ? result.reloadResult.error : result.entries.first().error;
+        qDebug() << "Failed to export directory:" << error;
+        emit shareError(path, tr("Failed to export directory: %1").arg(error));
+        return false;
     }
     
     // Add to our active shares list
-    m_activeShares.append(newShare);
+    m_activeShares.insert(newShare);
+    m_reconciler.invalidate();
     
     qDebug() << "Share created successfully:" << path << "Total shares:" << m_activeShares.size();
     
@@ -71,7 +135,7 @@ bool ShareManager::createShare(const QString &path, const ShareConfiguration &co
     emit shareCreated(newShare);
     
     // Save to configuration for persistence
-    emit sharesPersistenceRequested();
+    emit sharesPersistenceRequested({newShare.path()});
     
     return true;
 }
@@ -81,46 +145,535 @@ bool ShareManager::removeShare(const QString &path)
     qDebug() << "ShareManager::removeShare - removing share for path:" << path;
     
     // Find and remove the share
-    for (int i = 0; i < m_activeShares.size(); ++i) {
-        if (m_activeShares[i].path() == path) {
-            NFSShare removedShare = m_activeShares[i];
-            
-            // Actually unexport the directory from NFS system
-            if (m_nfsService) {
-                qDebug() << "Unexporting directory from NFS system:" << path;
-                NFSCommandResult result = m_nfsService->unexportDirectory(path);
-                
-                if (!result.success) {
-                    qDebug() << "Failed to unexport directory:" << result.error;
-                    emit shareError(path, tr("Failed to unexport directory: %1").arg(result.error));
-                    // Continue with removal from our list even if unexport failed
-                }
-                
-                qDebug() << "Directory unexported successfully:" << result.output;
-            }
-            
-            m_activeShares.removeAt(i);
-            
-            qDebug() << "Share removed successfully:" << path << "Remaining shares:" << m_activeShares.size();
-            
-            // Emit signal that share was removed
-            emit shareRemoved(path);
-            
-            // Save to configuration for persistence
-            emit sharesPersistenceRequested();
-            
-            return true;
+    const NFSShare *share = findShare(path);
+    if (share) {
+        // Dropped from the exports files too, so an exportfs -r cannot bring it back
+        qDebug() << "Unexporting directory from NFS system:" << path;
+        const ExportBatchResult result = applyExportBatch(ExportBatch() << ExportChange::remove(share->path()));
+        recoverExportBatch(result);
+        if (!result.success) {
+            const QString error = result.entries.isEmpty() ? result.reloadResult.error : result.entries.first().error;
+            qDebug() << "Failed to unexport directory:" << error;
+            emit shareError(path, tr("Failed to unexport directory: %1").arg(error));
+            return false;
         }
+        
+        m_activeShares.remove(path);
+        m_reconciler.invalidate();
+        
+        qDebug() << "Share removed successfully:" << path << "Remaining shares:" << m_activeShares.size();
+        
+        // Emit signal that share was removed
+        emit shareRemoved(path);
+        
+        // Save to configuration for persistence
+        emit sharesPersistenceRequested({path});
+        
+        return true;
     }
     
     qDebug() << "Share not found for removal:" << path;
     return false;
 }
 
+bool ShareManager::createShares(const QList<ShareRequest> &requests)
+{
+    qDebug() << "ShareManager::createShares - creating" << requests.size() << "shares";
+    if (m_bulkRunning) {
+        return false;
+    }
+    startBulkOperation(BulkKind::Create, QStringList(), QList<ShareRequest>(), requests);
+    return true;
+}
+
+bool ShareManager::removeShares(const QStringList &paths)
+{
+    qDebug() << "ShareManager::removeShares - removing" << paths.size() << "shares";
+    if (m_bulkRunning) {
+        return false;
+    }
+    startBulkOperation(BulkKind::Remove, paths, QList<ShareRequest>(), QList<ShareRequest>());
+    return true;
+}
+
+bool ShareManager::applyShareChanges(const QStringList &removals,
+                                     const QList<ShareRequest> &updates,
+                                     const QList<ShareRequest> &creations)
+{
+    qDebug() << "ShareManager::applyShareChanges -" << removals.size() << "removals,"
+             << updates.size() << "updates," << creations.size() << "creations";
+    if (m_bulkRunning) {
+        return false;
+    }
+    startBulkOperation(BulkKind::Changes, removals, updates, creations);
+    return true;
+}
+
+bool ShareManager::isBulkOperationRunning() const
+{
+    return m_bulkRunning;
+}
+
+void ShareManager::setPolicyKitHelper(PolicyKitHelper *helper)
+{
+    m_policyKitHelper = helper;
+}
+
+void ShareManager::startBulkOperation(BulkKind kind, const QStringList &removals,
+                                      const QList<ShareRequest> &updates, const QList<ShareRequest> &creations)
+{
+    m_bulkRunning = true;
+    m_bulkKind = kind;
+    m_bulkRemovals = removals;
+    m_bulkUpdates = updates;
+    m_bulkCreations = creations;
+
+    const int total = removals.size() + updates.size() + creations.size();
+    emit bulkOperationProgress(0, kind == BulkKind::Remove ? tr("Checking %n share(s)", "", total)
+                                                           : tr("Validating %n change(s)", "", total));
+    if (creations.isEmpty()) {
+        stageBulkOperation(QStringList(), QStringList());
+        return;
+    }
+
+    // Path checks hit the filesystem (statx, canonical paths) on a cold
+    // cache, so they run on the pool; each chunk only writes its own slots
+    struct Validation {
+        std::vector<QString> errors;
+        std::vector<QString> canonical;
+        std::atomic<int> validated{0};
+        std::atomic<int> remainingChunks{0};
+    };
+    const int count = creations.size();
+    const auto validation = std::make_shared<Validation>();
+    validation->errors.resize(count);
+    validation->canonical.resize(count);
+
+    QStringList paths;
+    for (const ShareRequest &request : creations) {
+        paths << request.path;
+    }
+
+    const std::shared_ptr<SharePathValidator> validator = m_pathValidator;
+    const int chunk = qMax(1, count / (m_validationPool.maxThreadCount() * 4));
+    validation->remainingChunks = (count + chunk - 1) / chunk;
+    for (int begin = 0; begin < count; begin += chunk) {
+        const int end = qMin(count, begin + chunk);
+        m_validationPool.start([this, validator, validation, paths, begin, end, count]() {
+            for (int i = begin; i < end; ++i) {
+                const PathValidation result = validator->validate(paths[i]);
+                if (!result.isValid()) {
+                    validation->errors[i] = result.errors.first();
+                } else {
+                    validation->canonical[i] = result.canonicalPath;
+                }
+            }
+            const int validated = validation->validated.fetch_add(end - begin) + end - begin;
+
+            // Posted before the chunk counts as done, so no progress can
+            // arrive after the last chunk has handed over the results
+            QMetaObject::invokeMethod(this, [this, validated, count]() {
+                emit bulkOperationProgress(validated * 40 / count,
+                                           tr("Validating %1 of %2 share(s)").arg(validated).arg(count));
+            }, Qt::QueuedConnection);
+
+            // The last chunk hands the results back to the GUI thread
+            if (validation->remainingChunks.fetch_sub(1) == 1) {
+                QMetaObject::invokeMethod(this, [this, validation]() {
+                    stageBulkOperation(QStringList(validation->errors.cbegin(), validation->errors.cend()),
+                                       QStringList(validation->canonical.cbegin(), validation->canonical.cend()));
+                }, Qt::QueuedConnection);
+            }
+        });
+    }
+}
+
+void ShareManager::stageBulkOperation(const QStringList &pathErrors, const QStringList &canonicalPaths)
+{
+    const QStringList creationErrors = checkShareRequests(m_bulkCreations, pathErrors, canonicalPaths);
+
+    ExportBatch batch;
+    QString status;
+    switch (m_bulkKind) {
+    case BulkKind::Create:
+        batch = stageCreations(creationErrors);
+        status = tr("Exporting %n share(s)", "", batch.size());
+        break;
+    case BulkKind::Remove:
+        batch = stageRemovals();
+        status = tr("Unexporting %n share(s)", "", batch.size());
+        break;
+    case BulkKind::Changes:
+        batch = stageChanges(creationErrors);
+        status = tr("Applying %n export change(s)", "", batch.size());
+        break;
+    }
+
+    if (batch.isEmpty()) {
+        finishBulkOperation(ExportBatchResult());
+        return;
+    }
+
+    // The helper or exportfs can block for seconds (authorisation, a slow
+    // reload), so the transaction runs on the pool; only its result comes back
+    emit bulkOperationProgress(50, status);
+    m_validationPool.start([this, batch]() {
+        const ExportBatchResult applied = applyExportBatch(batch);
+        QMetaObject::invokeMethod(this, [this, applied]() {
+            finishBulkOperation(applied);
+        }, Qt::QueuedConnection);
+    });
+}
+
+QStringList ShareManager::checkShareRequests(const QList<ShareRequest> &requests, const QStringList &pathErrors,
+                                             const QStringList &canonicalPaths) const
+{
+    // Checks against shared state stay on this thread
+    QStringList errors = pathErrors;
+    QSet<QString> seen;
+    for (int i = 0; i < requests.size(); ++i) {
+        if (!errors[i].isEmpty()) {
+            continue;
+        }
+        if (!validateShareConfiguration(requests[i].config)) {
+            errors[i] = tr("Invalid share configuration");
+        } else if (seen.contains(canonicalPaths[i])) {
+            errors[i] = tr("Path appears more than once in the batch");
+        } else if (isShared(requests[i].path)) {
+            errors[i] = tr("Path is already shared");
+        }
+        seen.insert(canonicalPaths[i]);
+    }
+    return errors;
+}
+
+ExportBatch ShareManager::stageCreations(const QStringList &creationErrors)
+{
+    const QList<ShareRequest> &requests = m_bulkCreations;
+
+    // Invalid entries are skipped; the rest goes out as one transaction
+    ExportBatch batch;
+    for (int i = 0; i < requests.size(); ++i) {
+        ExportEntryResult entry;
+        entry.path = requests[i].path;
+        entry.type = ExportChange::Type::Add;
+        entry.error = creationErrors[i];
+        m_bulkResult.entries << entry;
+
+        if (creationErrors[i].isEmpty()) {
+            batch << ExportChange::add(requests[i].path, requests[i].config);
+            m_bulkBatchIndex << i;
+        }
+    }
+    return batch;
+}
+
+ExportBatch ShareManager::stageRemovals()
+{
+    const QStringList &paths = m_bulkRemovals;
+
+    ExportBatch batch;
+    QSet<QString> seen;
+    for (int i = 0; i < paths.size(); ++i) {
+        ExportEntryResult entry;
+        entry.path = paths[i];
+        entry.type = ExportChange::Type::Remove;
+
+        const NFSShare *share = findShare(paths[i]);
+        if (!share) {
+            entry.error = tr("Share not found");
+        } else if (seen.contains(share->path())) {
+            entry.error = tr("Path appears more than once in the batch");
+        } else {
+            seen.insert(share->path());
+            batch << ExportChange::remove(share->path());
+            m_bulkBatchIndex << i;
+        }
+        m_bulkResult.entries << entry;
+    }
+    return batch;
+}
+
+ExportBatch ShareManager::stageChanges(const QStringList &creationErrors)
+{
+    const QStringList &removals = m_bulkRemovals;
+    const QList<ShareRequest> &updates = m_bulkUpdates;
+    const QList<ShareRequest> &creations = m_bulkCreations;
+
+    // Stage everything first; one invalid entry keeps the whole batch out
+    ExportBatch batch;
+    bool valid = true;
+    for (const QString &path : removals) {
+        ExportEntryResult entry;
+        entry.path = path;
+        entry.type = ExportChange::Type::Remove;
+        if (!findShare(path)) {
+            entry.error = tr("Share not found");
+            valid = false;
+        }
+        batch << ExportChange::remove(path);
+        m_bulkResult.entries << entry;
+    }
+    for (const ShareRequest &request : updates) {
+        ExportEntryResult entry;
+        entry.path = request.path;
+        entry.type = ExportChange::Type::Modify;
+        if (!findShare(request.path)) {
+            entry.error = tr("Share not found");
+            valid = false;
+        } else if (!validateShareConfiguration(request.config)) {
+            entry.error = tr("Invalid share configuration");
+            valid = false;
+        }
+        batch << ExportChange::modify(request.path, request.config);
+        m_bulkResult.entries << entry;
+    }
+    for (int i = 0; i < creations.size(); ++i) {
+        ExportEntryResult entry;
+        entry.path = creations[i].path;
+        entry.type = ExportChange::Type::Add;
+        entry.error = creationErrors[i];
+        valid = valid && entry.error.isEmpty();
+        batch << ExportChange::add(creations[i].path, creations[i].config);
+        m_bulkResult.entries << entry;
+    }
+
+    if (!valid) {
+        for (ExportEntryResult &entry : m_bulkResult.entries) {
+            if (entry.error.isEmpty()) {
+                entry.error = tr("Not applied: another entry in the batch is invalid");
+            }
+        }
+        return ExportBatch();
+    }
+
+    for (int i = 0; i < batch.size(); ++i) {
+        m_bulkBatchIndex << i;
+    }
+    return batch;
+}
+
+void ShareManager::finishBulkOperation(const ExportBatchResult &applied)
+{
+    m_bulkResult.reloadResult = applied.reloadResult;
+    m_bulkResult.rolledBack = applied.rolledBack;
+    for (int i = 0; i < applied.entries.size(); ++i) {
+        ExportEntryResult &entry = m_bulkResult.entries[m_bulkBatchIndex[i]];
+        entry.success = applied.entries[i].success;
+        entry.error = applied.entries[i].error;
+    }
+    if (!m_bulkBatchIndex.isEmpty()) {
+        recoverExportBatch(applied);
+    }
+
+    switch (m_bulkKind) {
+    case BulkKind::Create:
+        finishCreations();
+        break;
+    case BulkKind::Remove:
+        finishRemovals();
+        break;
+    case BulkKind::Changes:
+        finishChanges();
+        break;
+    }
+
+    const ExportBatchResult result = m_bulkResult;
+    m_bulkRunning = false;
+    m_bulkRemovals.clear();
+    m_bulkUpdates.clear();
+    m_bulkCreations.clear();
+    m_bulkResult = ExportBatchResult();
+    m_bulkBatchIndex.clear();
+    emit bulkOperationFinished(result);
+}
+
+void ShareManager::finishCreations()
+{
+    const QList<ShareRequest> &requests = m_bulkCreations;
+    QList<NFSShare> created;
+    QStringList createdPaths;
+    const QDateTime now = QDateTime::currentDateTime();
+    for (int i = 0; i < m_bulkResult.entries.size(); ++i) {
+        const ExportEntryResult &entry = m_bulkResult.entries[i];
+        if (!entry.success) {
+            emit shareError(entry.path, entry.error);
+            continue;
+        }
+        NFSShare share(requests[i].path, requests[i].path, requests[i].config);
+        share.setCreatedAt(now);
+        share.setActive(true);
+        m_activeShares.insert(share);
+        created << share;
+        createdPaths << share.path();
+    }
+
+    m_bulkResult.success = created.size() == requests.size();
+    qDebug() << "Created" << created.size() << "of" << requests.size() << "shares";
+
+    if (!created.isEmpty()) {
+        m_reconciler.invalidate();
+        emit bulkOperationProgress(90, tr("Saving configuration"));
+        emit sharesCreated(created);
+        emit sharesPersistenceRequested(createdPaths);
+    }
+
+    emit bulkOperationProgress(100, tr("Created %1 of %2 share(s)").arg(created.size()).arg(requests.size()));
+}
+
+void ShareManager::finishRemovals()
+{
+    const QStringList &paths = m_bulkRemovals;
+    QStringList removed;
+    for (const ExportEntryResult &entry : m_bulkResult.entries) {
+        if (!entry.success) {
+            emit shareError(entry.path, entry.error);
+            continue;
+        }
+        m_activeShares.remove(entry.path);
+        removed << entry.path;
+    }
+
+    m_bulkResult.success = removed.size() == paths.size();
+    qDebug() << "Removed" << removed.size() << "of" << paths.size() << "shares";
+
+    if (!removed.isEmpty()) {
+        m_reconciler.invalidate();
+        emit bulkOperationProgress(90, tr("Saving configuration"));
+        emit sharesRemoved(removed);
+        emit sharesPersistenceRequested(removed);
+    }
+
+    emit bulkOperationProgress(100, tr("Removed %1 of %2 share(s)").arg(removed.size()).arg(paths.size()));
+}
+
+void ShareManager::finishChanges()
+{
+    const QStringList &removals = m_bulkRemovals;
+    const QList<ShareRequest> &updates = m_bulkUpdates;
+    const QList<ShareRequest> &creations = m_bulkCreations;
+    const int total = removals.size() + updates.size() + creations.size();
+
+    QStringList removed;
+    QList<NFSShare> created;
+    QStringList changedPaths;
+    const QDateTime now = QDateTime::currentDateTime();
+    for (int i = 0; i < m_bulkResult.entries.size(); ++i) {
+        const ExportEntryResult &entry = m_bulkResult.entries[i];
+        if (!entry.success) {
+            emit shareError(entry.path, entry.error);
+            continue;
+        }
+        changedPaths << entry.path;
+        if (i < removals.size()) {
+            m_activeShares.remove(entry.path);
+            removed << entry.path;
+        } else if (i < removals.size() + updates.size()) {
+            // Removed by a single removeShare() while the batch was applied
+            NFSShare *share = findShare(entry.path);
+            if (share) {
+                share->setConfig(updates[i - removals.size()].config);
+                emit shareUpdated(*share);
+            }
+        } else {
+            const ShareRequest &request = creations[i - removals.size() - updates.size()];
+            NFSShare share(request.path, request.path, request.config);
+            share.setCreatedAt(now);
+            share.setActive(true);
+            m_activeShares.insert(share);
+            created << share;
+        }
+    }
+
+    m_bulkResult.success = changedPaths.size() == total;
+
+    if (!changedPaths.isEmpty()) {
+        m_reconciler.invalidate();
+        emit bulkOperationProgress(90, tr("Saving configuration"));
+        if (!removed.isEmpty()) {
+            emit sharesRemoved(removed);
+        }
+        if (!created.isEmpty()) {
+            emit sharesCreated(created);
+        }
+        emit sharesPersistenceRequested(changedPaths);
+    }
+
+    if (total > 0 && m_bulkBatchIndex.isEmpty()) {
+        emit bulkOperationProgress(100, tr("No changes applied"));
+    } else {
+        emit bulkOperationProgress(100, tr("Applied %1 of %2 change(s)").arg(changedPaths.size()).arg(total));
+    }
+}
+
+ExportBatchResult ShareManager::applyExportBatch(const ExportBatch &batch)
+{
+    // Single shares on the GUI thread and bulk batches on the pool write
+    // the same exports files
+    QMutexLocker locker(&m_exportMutex);
+    if (!m_policyKitHelper) {
+        return m_nfsService->applyExports(batch);
+    }
+
+    // One privileged action, so one authorisation and one reload, for the whole batch
+    QStringList shareEntries;
+    QStringList removePaths;
+    bool onlyAdds = true;
+    for (const ExportChange &change : batch) {
+        if (change.type == ExportChange::Type::Remove) {
+            removePaths << change.path;
+            onlyAdds = false;
+        } else {
+            shareEntries << change.exportLine;
+            onlyAdds = onlyAdds && change.type == ExportChange::Type::Add;
+        }
+    }
+
+    PolicyKitHelper::Action action;
+    QVariantMap parameters;
+    if (shareEntries.isEmpty()) {
+        action = PolicyKitHelper::Action::RemoveShare;
+        parameters["sharePaths"] = removePaths;
+    } else {
+        action = onlyAdds ? PolicyKitHelper::Action::CreateShare : PolicyKitHelper::Action::ModifyShare;
+        parameters["shareEntries"] = shareEntries;
+        if (!removePaths.isEmpty()) {
+            parameters["removeSharePaths"] = removePaths;
+        }
+    }
+
+    // The helper applies the batch all or nothing, so one outcome holds for every entry
+    QString error;
+    bool rolledBack = false;
+    const bool success = m_policyKitHelper->executePrivilegedAction(action, parameters, &error, &rolledBack);
+    ExportBatchResult result;
+    result.success = success;
+    result.rolledBack = rolledBack;
+    for (const ExportChange &change : batch) {
+        ExportEntryResult entry;
+        entry.path = change.path;
+        entry.type = change.type;
+        entry.success = success;
+        entry.error = error;
+        result.entries << entry;
+    }
+    return result;
+}
+
+void ShareManager::recoverExportBatch(const ExportBatchResult &result)
+{
+    // A batch that could not be restored left the exports somewhere in
+    // between; the kernel table tells which shares actually changed
+    if (!result.success && !result.rolledBack) {
+        m_reconciler.invalidate();
+        reconcileExports(true);
+    }
+}
+
 QList<NFSShare> ShareManager::getActiveShares() const
 {
     qDebug() << "ShareManager::getActiveShares - returning" << m_activeShares.size() << "shares";
-    return m_activeShares;
+    return m_activeShares.shares();
 }
 
 bool ShareManager::addExistingShare(const NFSShare &share)
@@ -134,7 +687,9 @@ bool ShareManager::addExistingShare(const NFSShare &share)
     }
     
     // Add the share to our list
-    m_activeShares.append(share);
+    m_activeShares.insert(share);
+    m_reconciler.invalidate();
+    syncShareMonitors();
     
     qDebug() << "Existing share added successfully:" << share.path() << "Total shares:" << m_activeShares.size();
     
@@ -146,17 +701,17 @@ bool ShareManager::updateSharePermissions(const QString &path, const PermissionS
     qDebug() << "ShareManager::updateSharePermissions - updating permissions for path:" << path;
     
     // Find and update the share permissions
-    for (int i = 0; i < m_activeShares.size(); ++i) {
-        if (m_activeShares[i].path() == path) {
-            m_activeShares[i].setPermissions(permissions);
-            
-            qDebug() << "Share permissions updated successfully:" << path;
-            
-            // Emit signal that share was updated
-            emit shareUpdated(m_activeShares[i]);
-            
-            return true;
-        }
+    NFSShare *share = findShare(path);
+    if (share) {
+        share->setPermissions(permissions);
+        m_reconciler.invalidate();
+        
+        qDebug() << "Share permissions updated successfully:" << path;
+        
+        // Emit signal that share was updated
+        emit shareUpdated(*share);
+        
+        return true;
     }
     
     qDebug() << "Share not found for permission update:" << path;
@@ -168,17 +723,17 @@ bool ShareManager::updateShareConfiguration(const QString &path, const ShareConf
     qDebug() << "ShareManager::updateShareConfiguration - updating share for path:" << path;
     
     // Find and update the share
-    for (int i = 0; i < m_activeShares.size(); ++i) {
-        if (m_activeShares[i].path() == path) {
-            m_activeShares[i].setConfig(config);
-            
-            qDebug() << "Share configuration updated successfully:" << path;
-            
-            // Emit signal that share was updated
-            emit shareUpdated(m_activeShares[i]);
-            
-            return true;
-        }
+    NFSShare *share = findShare(path);
+    if (share) {
+        share->setConfig(config);
+        m_reconciler.invalidate();
+        
+        qDebug() << "Share configuration updated successfully:" << path;
+        
+        // Emit signal that share was updated
+        emit shareUpdated(*share);
+        
+        return true;
     }
     
     qDebug() << "Share not found for update:" << path;
@@ -190,11 +745,10 @@ NFSShare ShareManager::getShare(const QString &path) const
     qDebug() << "ShareManager::getShare - looking for share at path:" << path;
     
     // Find the share by path
-    for (const NFSShare &share : m_activeShares) {
-        if (share.path() == path) {
-            qDebug() << "Share found:" << path;
-            return share;
-        }
+    const NFSShare *share = findShare(path);
+    if (share) {
+        qDebug() << "Share found:" << path;
+        return *share;
     }
     
     qDebug() << "Share not found:" << path;
@@ -204,73 +758,202 @@ NFSShare ShareManager::getShare(const QString &path) const
 bool ShareManager::isShared(const QString &path) const
 {
     // Check if the path is already in our active shares
-    for (const NFSShare &share : m_activeShares) {
-        if (share.path() == path) {
-            return true;
-        }
-    }
-    return false;
+    return m_activeShares.contains(path);
+}
+
+QString ShareManager::enclosingSharePath(const QString &path) const
+{
+    return m_activeShares.exportedAncestor(path);
+}
+
+QStringList ShareManager::nestedSharePaths(const QString &path) const
+{
+    return m_activeShares.exportedDescendants(path);
 }
 
 void ShareManager::refreshShares()
 {
     qDebug() << "ShareManager::refreshShares - refreshing share list";
     
-    // Query the actual system exports to sync with reality
-    if (m_nfsService) {
+    // Always run a full pass against the system exports
+    m_reconciler.invalidate();
+    reconcileExports(true);
+    
+    // Emit the signal to update the UI
+    emit sharesRefreshed();
+}
+
+QList<ExportDrift> ShareManager::getExportDrift() const
+{
+    return m_reconciler.currentDrift();
+}
+
+ExportReconciler *ShareManager::exportReconciler()
+{
+    return &m_reconciler;
+}
+
+void ShareManager::reconcileExports(bool force)
+{
+    ExportDriftDelta delta;
+    
+    if (m_reconciler.isEtabAvailable()) {
+        if (!m_reconciler.needsReconcile()) {
+            return;
+        }
+        delta = m_reconciler.reconcile(m_activeShares.shares());
+    } else if (force && m_nfsService) {
+        // No etab (e.g. different nfs-utils layout): ask exportfs instead
         NFSCommandResult result = m_nfsService->getExportedDirectories();
-        if (result.success) {
-            qDebug() << "Current system exports:" << result.output;
-            
-            // Parse the exports and update our internal list
-            QStringList systemExports = m_nfsService->parseExportfsOutput(result.output);
-            
-            // TODO: Sync our internal list with system exports
-            // For now, just log what we found
-            qDebug() << "Found" << systemExports.size() << "system exports";
-        } else {
+        if (!result.success) {
             qDebug() << "Failed to query system exports:" << result.error;
+            return;
         }
+        delta = m_reconciler.reconcile(m_activeShares.shares(), ExportReconciler::parseExportTable(result.output));
+    } else {
+        return;
     }
     
-    // Emit the signal to update the UI
-    emit sharesRefreshed();
+    if (delta.isEmpty()) {
+        return;
+    }
+    
+    for (const ExportDrift &drift : delta.detected) {
+        qDebug() << "Export drift detected:" << drift.path << "expected:" << drift.expected << "actual:" << drift.actual;
+    }
+    for (const QString &path : delta.resolved) {
+        qDebug() << "Export back in sync:" << path;
+    }
+    
+    emit exportDriftChanged(delta);
 }
 
 bool ShareManager::validateSharePath(const QString &path) const
 {
-    Q_UNUSED(path)
-    return true;
+    return m_pathValidator->validate(path).isValid();
 }
 
 QStringList ShareManager::getPathValidationErrors(const QString &path) const
 {
-    Q_UNUSED(path)
-    return QStringList();
+    return m_pathValidator->validate(path).errors;
+}
+
+QList<PathValidation> ShareManager::validateSharePaths(const QStringList &paths) const
+{
+    return m_pathValidator->validateBatch(paths);
+}
+
+void ShareManager::validateSharePathsAsync(const QStringList &paths)
+{
+    // The validator is shared so it outlives this object if the batch does
+    std::shared_ptr<SharePathValidator> validator = m_pathValidator;
+    QPointer<ShareManager> self(this);
+    QThreadPool::globalInstance()->start([validator, self, paths]() {
+        const QList<PathValidation> results = validator->validateBatch(paths);
+        if (self) {
+            QMetaObject::invokeMethod(self, [self, results]() {
+                if (self) {
+                    emit self->sharePathsValidated(results);
+                }
+            }, Qt::QueuedConnection);
+        }
+    });
 }
 
 QString ShareManager::generateExportsFileContent() const
 {
-    return QString();
+    QString content = "# /etc/exports\n# Generated by NFS Share Manager\n";
+    for (const NFSShare &share : m_activeShares.shares()) {
+        content += share.config().toExportLine(share.path()) + '\n';
+    }
+    return content;
 }
 
 bool ShareManager::isNFSServerRunning() const
 {
+    const UnitStatus server = m_serviceMonitor->unitStatus(NFSServerUnit);
+    if (!server.isKnown()) {
+        // Without systemd, a loaded nfsd is the best available signal
+        return m_loadMonitor->isAvailable();
+    }
+    if (!server.isActive()) {
+        return false;
+    }
+    for (const QString &unit : nfsServerUnits()) {
+        if (m_serviceMonitor->unitStatus(unit).activeState == "failed") {
+            return false;
+        }
+    }
     return true;
 }
 
 bool ShareManager::startNFSServer()
 {
-    qDebug() << "ShareManager::startNFSServer - stub implementation";
+    if (!m_serviceMonitor->startUnit(NFSServerUnit)) {
+        m_lastError = tr("systemd is not available to start the NFS server");
+        return false;
+    }
     return true;
 }
 
 bool ShareManager::restartNFSServer()
 {
-    qDebug() << "ShareManager::restartNFSServer - stub implementation";
+    if (!m_serviceMonitor->restartUnit(NFSServerUnit)) {
+        m_lastError = tr("systemd is not available to restart the NFS server");
+        return false;
+    }
+    return true;
+}
+
+bool ShareManager::reloadNFSServer()
+{
+    if (!m_serviceMonitor->reloadUnit(NFSServerUnit)) {
+        m_lastError = tr("systemd is not available to reload the NFS server");
+        return false;
+    }
     return true;
 }
 
+SystemdManager *ShareManager::serviceMonitor() const
+{
+    return m_serviceMonitor;
+}
+
+NFSServiceInterface *ShareManager::nfsService() const
+{
+    return m_nfsService;
+}
+
+NFSDLoadMonitor *ShareManager::loadMonitor() const
+{
+    return m_loadMonitor;
+}
+
+ShareUsageMonitor *ShareManager::usageMonitor() const
+{
+    return m_usageMonitor;
+}
+
+QList<NFSClientInfo> ShareManager::activeClients(const QString &path) const
+{
+    return m_clientTracker->activeClients(path);
+}
+
+NFSDClientTracker *ShareManager::clientTracker() const
+{
+    return m_clientTracker;
+}
+
+void ShareManager::syncShareMonitors()
+{
+    QStringList paths;
+    for (const NFSShare &share : m_activeShares.shares()) {
+        paths << share.path();
+    }
+    m_usageMonitor->setShares(paths);
+    m_clientTracker->setExports(paths);
+}
+
 void ShareManager::onPolicyKitActionCompleted(PolicyKitHelper::Action action, bool success, const QString &errorMessage)
 {
     Q_UNUSED(action)
@@ -290,6 +973,32 @@ void ShareManager::onFileSystemChanged(const QString &path)
 
 void ShareManager::onRefreshTimer()
 {
+    reconcileExports(false);
+    
+    // Lists clients/ and stats rmtab; only new clients are read in full
+    m_clientTracker->refresh();
+}
+
+void ShareManager::onServiceStateChanged(const QString &unit, const UnitStatus &status)
+{
+    qDebug() << "ShareManager: NFS unit" << unit << "is now" << status.activeState;
+    
+    const bool running = isNFSServerRunning();
+    if (running != m_nfsServerRunning) {
+        m_nfsServerRunning = running;
+        emit nfsServerStatusChanged(running);
+    }
+}
+
+void ShareManager::onServiceJobFinished(const QString &unit, SystemdManager::Operation operation,
+                                        bool success, const QString &errorMessage)
+{
+    Q_UNUSED(operation)
+    
+    if (!success) {
+        m_lastError = errorMessage;
+        emit nfsServiceOperationFailed(unit, errorMessage);
+    }
 }
 
 void ShareManager::initialize()
@@ -309,6 +1018,28 @@ bool ShareManager::validateShareConfiguration(const ShareConfiguration &config)
 
 bool ShareManager::updateExportsFile()
 {
+    ExportsDWriter writer(m_nfsService->exportsDirectory());
+    if (!writer.isAvailable()) {
+        qWarning() << "No exports directory to write shares to";
+        return false;
+    }
+
+    QHash<QString, QString> exportLines;
+    for (const NFSShare &share : m_activeShares.shares()) {
+        exportLines.insert(share.path(), share.config().toExportLine(share.path()));
+    }
+
+    // Only shares whose file differs are written, so this is cheap when in sync
+    const ExportsDSyncResult result = writer.sync(exportLines);
+    if (!result.success) {
+        qWarning() << "Failed to update exports directory:" << result.error;
+        return false;
+    }
+
+    if (!result.written.isEmpty() || !result.removed.isEmpty()) {
+        m_reconciler.invalidate();
+        return m_nfsService->reloadExports().success;
+    }
     return true;
 }
 
@@ -317,27 +1048,24 @@ bool ShareManager::backupExportsFile()
     return true;
 }
 
-QList<NFSShare>::iterator ShareManager::findShare(const QString &path)
+NFSShare *ShareManager::findShare(const QString &path)
 {
-    Q_UNUSED(path)
-    return m_activeShares.end();
+    return m_activeShares.find(path);
 }
 
-QList<NFSShare>::const_iterator ShareManager::findShare(const QString &path) const
+const NFSShare *ShareManager::findShare(const QString &path) const
 {
-    Q_UNUSED(path)
-    return m_activeShares.end();
+    return m_activeShares.find(path);
 }
 
 QString ShareManager::normalizePath(const QString &path) const
 {
-    return path;
+    return ShareRegistry::canonicalPath(path);
 }
 
 bool ShareManager::checkDirectoryPermissions(const QString &path) const
 {
-    Q_UNUSED(path)
-    return true;
+    return m_pathValidator->validate(path).isValid();
 }
 
 QString ShareManager::generateExportPath(const QString &basePath) const
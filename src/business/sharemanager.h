@@ -2,18 +2,39 @@
 
 #include <QObject>
 #include <QList>
+#include <QMutex>
 #include <QString>
 #include <QStringList>
 #include <QTimer>
+#include <QThreadPool>
 #include <QFileSystemWatcher>
 #include "../core/nfsshare.h"
 #include "../core/shareconfiguration.h"
 #include "../core/permissionset.h"
 #include "../system/policykithelper.h"
 #include "../system/nfsserviceinterface.h"
+#include "../system/systemdmanager.h"
+#include "nfsdloadmonitor.h"
+#include "shareregistry.h"
+#include "exportreconciler.h"
+#include "sharepathvalidator.h"
+#include "shareusagemonitor.h"
+#include "nfsdclienttracker.h"
+#include <memory>
 
 namespace NFSShareManager {
 
+/**
+ * @brief One share to create with ShareManager::createShares()
+ */
+struct ShareRequest {
+    QString path;               ///< Local directory path to share
+    ShareConfiguration config;  ///< Share configuration settings
+
+    ShareRequest() = default;
+    ShareRequest(const QString &p, const ShareConfiguration &c) : path(p), config(c) {}
+};
+
 /**
  * @brief Share manager class for local NFS share management
  * 
@@ -44,6 +65,69 @@ public:
      */
     bool removeShare(const QString &path);
 
+    /**
+     * @brief Create many shares with a single export transaction
+     *
+     * Paths are validated in parallel on a worker pool; invalid entries are
+     * reported and skipped. The valid ones are applied with one export
+     * transaction (see setPolicyKitHelper()), then announced with one
+     * sharesCreated() and one sharesPersistenceRequested(). Progress is
+     * reported through bulkOperationProgress(), the outcome through
+     * bulkOperationFinished().
+     *
+     * @param requests Paths and configurations to share
+     * @return False if another bulk operation is still running
+     */
+    bool createShares(const QList<ShareRequest> &requests);
+
+    /**
+     * @brief Remove many shares with a single export transaction
+     *
+     * Unknown paths are reported and skipped; the outcome is reported
+     * through bulkOperationFinished(), before this returns if none of
+     * the paths is shared.
+     *
+     * @param paths Local directory paths of the shares to remove
+     * @return False if another bulk operation is still running
+     */
+    bool removeShares(const QStringList &paths);
+
+    /**
+     * @brief Remove, update and create shares with a single export transaction
+     *
+     * Changes are staged in that order and go out as one export
+     * transaction, which applies or rejects the batch as a whole. Used by
+     * DesiredStateReconciler to execute a plan. The per-entry results
+     * (removals, then updates, then creations) are reported through
+     * bulkOperationFinished().
+     *
+     * @param removals Paths of managed shares to unexport
+     * @param updates Managed shares to re-export with a new configuration
+     * @param creations New shares to export
+     * @return False if another bulk operation is still running
+     */
+    bool applyShareChanges(const QStringList &removals,
+                           const QList<ShareRequest> &updates,
+                           const QList<ShareRequest> &creations);
+
+    /**
+     * @brief Check whether a bulk operation is running
+     */
+    bool isBulkOperationRunning() const;
+
+    /**
+     * @brief Let export changes go through PolicyKit
+     *
+     * With a helper, every export transaction (single shares and bulk
+     * operations alike) is one privileged action with one authorisation,
+     * written to /etc/exports.d and reloaded once by the helper. Without
+     * one, NFSServiceInterface::applyExports() writes the exports files
+     * directly, which needs root (or a simulated command backend).
+     *
+     * @param helper The helper, or nullptr to write directly
+     */
+    void setPolicyKitHelper(PolicyKitHelper *helper);
+
     /**
      * @brief Get list of all active shares
      * @return List of currently active NFS shares
@@ -80,12 +164,37 @@ public:
      */
     bool isShared(const QString &path) const;
 
+    /**
+     * @brief Get the share that encloses a path
+     * @param path Local directory path to check
+     * @return Path of the closest exported parent directory, or empty if none
+     */
+    QString enclosingSharePath(const QString &path) const;
+
+    /**
+     * @brief Get the shares nested inside a path
+     * @param path Local directory path to check
+     * @return Paths of the exported directories below the path
+     */
+    QStringList nestedSharePaths(const QString &path) const;
+
     /**
      * @brief Refresh the list of active shares from system
      * This synchronizes internal state with actual system exports
      */
     void refreshShares();
 
+    /**
+     * @brief Get the differences found by the last reconcile pass
+     * @return Shares missing from, extra in or drifted from the kernel export table
+     */
+    QList<ExportDrift> getExportDrift() const;
+
+    /**
+     * @brief Get the reconciler comparing shares with the kernel export table
+     */
+    ExportReconciler *exportReconciler();
+
     /**
      * @brief Validate a directory path for sharing
      * @param path Directory path to validate
@@ -93,6 +202,22 @@ public:
      */
     bool validateSharePath(const QString &path) const;
 
+    /**
+     * @brief Validate many candidate paths in parallel
+     * @param paths Directory paths to validate
+     * @return One result per path, in input order
+     */
+    QList<PathValidation> validateSharePaths(const QStringList &paths) const;
+
+    /**
+     * @brief Validate many candidate paths on a worker thread
+     *
+     * The results arrive through sharePathsValidated().
+     *
+     * @param paths Directory paths to validate
+     */
+    void validateSharePathsAsync(const QStringList &paths);
+
     /**
      * @brief Add an existing share (for loading from configuration)
      * @param share The NFSShare to add
@@ -121,16 +246,59 @@ public:
 
     /**
      * @brief Start NFS server service
-     * @return True if service was started successfully
+     * @return True if the start job was queued; nfsServerStatusChanged() reports the result
      */
     bool startNFSServer();
 
     /**
      * @brief Restart NFS server service
-     * @return True if service was restarted successfully
+     * @return True if the restart job was queued; nfsServerStatusChanged() reports the result
      */
     bool restartNFSServer();
 
+    /**
+     * @brief Ask the NFS server to re-read its configuration without a restart
+     * @return True if the reload job was queued
+     */
+    bool reloadNFSServer();
+
+    /**
+     * @brief Get the systemd unit monitor
+     * @return Tracks nfs-server, rpcbind and nfs-mountd, owned by the share manager
+     */
+    SystemdManager *serviceMonitor() const;
+
+    /**
+     * @brief Get the NFS service interface
+     * @return Wrapper around the NFS tools, owned by the share manager
+     */
+    NFSServiceInterface *nfsService() const;
+
+    /**
+     * @brief Get the nfsd load monitor
+     * @return Sampler for server-side nfsd load, owned by the share manager
+     */
+    NFSDLoadMonitor *loadMonitor() const;
+
+    /**
+     * @brief Get the disk-usage monitor for the active shares
+     * @return Size and file count accounting, owned by the share manager
+     */
+    ShareUsageMonitor *usageMonitor() const;
+
+    /**
+     * @brief Get the clients currently using a share
+     * @param path The share path
+     * @return NFSv4 clients with open state on the share and NFSv3 clients that mounted it
+     */
+    QList<NFSClientInfo> activeClients(const QString &path) const;
+
+    /**
+     * @brief Get the NFS client tracker
+     * @return Client to export map, owned by the share manager
+     */
+    NFSDClientTracker *clientTracker() const;
+
 signals:
     /**
      * @brief Emitted when a new share is created
@@ -144,6 +312,31 @@ signals:
      */
     void shareRemoved(const QString &path);
 
+    /**
+     * @brief Emitted once per createShares() call
+     * @param shares The shares that were created
+     */
+    void sharesCreated(const QList<NFSShare> &shares);
+
+    /**
+     * @brief Emitted once per removeShares() call
+     * @param paths The paths of the removed shares
+     */
+    void sharesRemoved(const QStringList &paths);
+
+    /**
+     * @brief Emitted once a createShares(), removeShares() or applyShareChanges() call is done
+     * @param result Per-entry results, in request order
+     */
+    void bulkOperationFinished(const ExportBatchResult &result);
+
+    /**
+     * @brief Emitted while createShares() or removeShares() runs
+     * @param progress Progress value (0-100)
+     * @param statusMessage Current step
+     */
+    void bulkOperationProgress(int progress, const QString &statusMessage);
+
     /**
      * @brief Emitted when a share is updated
      * @param share The updated share
@@ -157,6 +350,12 @@ signals:
      */
     void shareError(const QString &path, const QString &error);
 
+    /**
+     * @brief Emitted when a validateSharePathsAsync() batch finishes
+     * @param results One result per path, in input order
+     */
+    void sharePathsValidated(const QList<PathValidation> &results);
+
     /**
      * @brief Emitted when share list is refreshed
      */
@@ -168,10 +367,29 @@ signals:
      */
     void nfsServerStatusChanged(bool running);
 
+    /**
+     * @brief Emitted when clients start or stop using shares
+     */
+    void activeClientsChanged();
+
+    /**
+     * @brief Emitted when a start, restart or reload of an NFS unit fails
+     * @param unit The systemd unit
+     * @param error Reason reported by systemd or D-Bus
+     */
+    void nfsServiceOperationFailed(const QString &unit, const QString &error);
+
     /**
      * @brief Emitted when shares need to be persisted to configuration
+     * @param sharePaths The shares that were created or removed
+     */
+    void sharesPersistenceRequested(const QStringList &sharePaths);
+
+    /**
+     * @brief Emitted when a reconcile pass finds new drift or drift clears
+     * @param delta Drift detected or resolved since the previous pass
      */
-    void sharesPersistenceRequested();
+    void exportDriftChanged(const ExportDriftDelta &delta);
 
 private slots:
     /**
@@ -199,6 +417,19 @@ private slots:
      */
     void onRefreshTimer();
 
+    /**
+     * @brief Track NFS unit state changes reported by systemd
+     * @param unit The unit that changed
+     * @param status Its new state
+     */
+    void onServiceStateChanged(const QString &unit, const UnitStatus &status);
+
+    /**
+     * @brief Report failed NFS unit jobs
+     */
+    void onServiceJobFinished(const QString &unit, SystemdManager::Operation operation,
+                              bool success, const QString &errorMessage);
+
 private:
     /**
      * @brief Initialize the share manager
@@ -210,6 +441,106 @@ private:
      */
     void loadExistingShares();
 
+    /**
+     * @brief Compare the shares with the kernel export table
+     * @param force Fall back to "exportfs -v" when etab cannot be read
+     */
+    void reconcileExports(bool force);
+
+    /**
+     * @brief Point the usage monitor and client tracker at the current set of active shares
+     */
+    void syncShareMonitors();
+
+    /**
+     * @brief Kind of the running bulk operation
+     */
+    enum class BulkKind {
+        Create,     ///< createShares(): invalid entries are skipped
+        Remove,     ///< removeShares(): unknown entries are skipped
+        Changes     ///< applyShareChanges(): all or nothing
+    };
+
+    /**
+     * @brief Validate the creations of a bulk operation on the worker pool, then commit it
+     */
+    void startBulkOperation(BulkKind kind, const QStringList &removals,
+                            const QList<ShareRequest> &updates, const QList<ShareRequest> &creations);
+
+    /**
+     * @brief Stage the running bulk operation once its paths are validated
+     *
+     * Checks against the managed shares stay on this thread; the export
+     * transaction then runs on the worker pool.
+     *
+     * @param pathErrors Path error per creation, empty for valid ones
+     * @param canonicalPaths Canonical path per valid creation
+     */
+    void stageBulkOperation(const QStringList &pathErrors, const QStringList &canonicalPaths);
+
+    /**
+     * @brief Check creations against configuration and shared state; GUI thread only
+     */
+    QStringList checkShareRequests(const QList<ShareRequest> &requests, const QStringList &pathErrors,
+                                   const QStringList &canonicalPaths) const;
+
+    /**
+     * @brief Stage the valid creations of createShares()
+     * @param creationErrors Error per creation, empty for valid ones
+     * @return Export changes to apply
+     */
+    ExportBatch stageCreations(const QStringList &creationErrors);
+
+    /**
+     * @brief Stage the known shares of removeShares()
+     * @return Export changes to apply
+     */
+    ExportBatch stageRemovals();
+
+    /**
+     * @brief Stage every change of applyShareChanges(), or none
+     * @param creationErrors Error per creation, empty for valid ones
+     * @return Export changes to apply; empty if any entry is invalid
+     */
+    ExportBatch stageChanges(const QStringList &creationErrors);
+
+    /**
+     * @brief Take over the outcome of the bulk export transaction; GUI thread only
+     * @param applied Result of the staged batch, entries in batch order
+     */
+    void finishBulkOperation(const ExportBatchResult &applied);
+
+    /**
+     * @brief Announce the shares created by createShares()
+     */
+    void finishCreations();
+
+    /**
+     * @brief Announce the shares removed by removeShares()
+     */
+    void finishRemovals();
+
+    /**
+     * @brief Announce the changes made by applyShareChanges()
+     */
+    void finishChanges();
+
+    /**
+     * @brief Apply an export transaction through PolicyKit or NFSServiceInterface
+     *
+     * Either path applies the whole batch or none of it. Safe to call from
+     * the worker pool: transactions are serialised and only read the
+     * helper and the service.
+     */
+    ExportBatchResult applyExportBatch(const ExportBatch &batch);
+
+    /**
+     * @brief Re-read the export drift after a failed batch that could not be restored
+     *
+     * The kernel table then tells which shares actually changed. GUI thread only.
+     */
+    void recoverExportBatch(const ExportBatchResult &result);
+
     /**
      * @brief Validate share configuration
      * @param config Configuration to validate
@@ -232,21 +563,21 @@ private:
     /**
      * @brief Find share by path
      * @param path Directory path to find
-     * @return Iterator to the share, or end() if not found
+     * @return The share, or nullptr if not found
      */
-    QList<NFSShare>::iterator findShare(const QString &path);
+    NFSShare *findShare(const QString &path);
 
     /**
      * @brief Find share by path (const version)
      * @param path Directory path to find
-     * @return Const iterator to the share, or end() if not found
+     * @return The share, or nullptr if not found
      */
-    QList<NFSShare>::const_iterator findShare(const QString &path) const;
+    const NFSShare *findShare(const QString &path) const;
 
     /**
      * @brief Normalize directory path
      * @param path Path to normalize
-     * @return Normalized absolute path
+     * @return Canonical absolute path (symlinks resolved)
      */
     QString normalizePath(const QString &path) const;
 
@@ -266,11 +597,27 @@ private:
 
     PolicyKitHelper *m_policyKitHelper;     ///< PolicyKit integration
     NFSServiceInterface *m_nfsService;      ///< NFS service interface
-    QList<NFSShare> m_activeShares;         ///< List of active shares
+    NFSDLoadMonitor *m_loadMonitor;         ///< Server-side nfsd load sampler
+    ShareUsageMonitor *m_usageMonitor;      ///< Per-share size and file counts
+    SystemdManager *m_serviceMonitor;       ///< NFS unit state and control over D-Bus
+    NFSDClientTracker *m_clientTracker;     ///< Which clients use which shares
+    ShareRegistry m_activeShares;           ///< Active shares indexed by path
     QFileSystemWatcher *m_fileWatcher;      ///< File system watcher
     QTimer *m_refreshTimer;                 ///< Periodic refresh timer
+    ExportReconciler m_reconciler;          ///< Detects drift from the kernel export table
+    std::shared_ptr<SharePathValidator> m_pathValidator; ///< Cached share path checks
     QString m_lastError;                    ///< Last error message
+    QThreadPool m_validationPool;           ///< Validates and applies bulk operations
+    bool m_bulkRunning;                     ///< A bulk operation is validating or applying
+    BulkKind m_bulkKind;                    ///< Kind of the running bulk operation
+    QStringList m_bulkRemovals;             ///< Removals of the running bulk operation
+    QList<ShareRequest> m_bulkUpdates;      ///< Updates of the running bulk operation
+    QList<ShareRequest> m_bulkCreations;    ///< Creations of the running bulk operation
+    ExportBatchResult m_bulkResult;         ///< Per-entry results of the running bulk operation
+    QList<int> m_bulkBatchIndex;            ///< Entry in m_bulkResult of each staged change
+    QMutex m_exportMutex;                   ///< Serialises export transactions across threads
     bool m_initialized;                     ///< Initialization status
+    bool m_nfsServerRunning;                ///< Last reported NFS server state
 };
 
 } // namespace NFSShareManager
\ No newline at end of file
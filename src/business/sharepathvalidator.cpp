@@ -0,0 +1,268 @@
+#include "sharepathvalidator.h"
+#include "../system/octalescape.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+namespace NFSShareManager {
+
+namespace {
+
+bool isUnderDirectory(const QString &path, const QString &directory)
+{
+    if (directory == "/") {
+        return path.startsWith('/');
+    }
+    return path == directory || path.startsWith(directory + '/');
+}
+
+} // namespace
+
+SharePathValidator::SharePathValidator()
+    : m_mountInfoPath("/proc/self/mountinfo")
+    , m_mountTableLoaded(false)
+    , m_cacheHits(0)
+{
+}
+
+PathValidation SharePathValidator::validate(const QString &path) const
+{
+    PathValidation result;
+    result.path = path;
+
+    if (path.trimmed().isEmpty()) {
+        result.errors << tr("Path cannot be empty");
+        return result;
+    }
+
+    FileState state;
+    if (!statPath(path, &state)) {
+        result.errors << (errno == ENOENT || errno == ENOTDIR ? tr("Directory does not exist")
+                                                              : tr("Directory is not accessible"));
+        return result;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_cache.constFind(path);
+        if (it != m_cache.constEnd() && it->state.sameFile(state)) {
+            m_cacheHits++;
+            return it->result;
+        }
+    }
+
+    result = check(path, state);
+
+    QMutexLocker locker(&m_mutex);
+    m_cache.insert(path, CacheEntry{state, result});
+    return result;
+}
+
+QList<PathValidation> SharePathValidator::validateBatch(const QStringList &paths) const
+{
+    const int count = paths.size();
+    std::vector<PathValidation> results(count);
+
+    // Each task fills its own slots; validate() itself is thread-safe
+    QThreadPool pool;
+    pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), 16));
+    const int chunk = qMax(1, count / (pool.maxThreadCount() * 4));
+    for (int begin = 0; begin < count; begin += chunk) {
+        const int end = qMin(count, begin + chunk);
+        pool.start([this, &paths, &results, begin, end]() {
+            for (int i = begin; i < end; ++i) {
+                results[i] = validate(paths[i]);
+            }
+        });
+    }
+    pool.waitForDone();
+
+    return QList<PathValidation>(results.cbegin(), results.cend());
+}
+
+void SharePathValidator::setMountInfoPath(const QString &filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_mountInfoPath = filePath;
+    m_mountTableLoaded = false;
+    m_cache.clear();
+}
+
+void SharePathValidator::clearCache()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+    m_mountTableLoaded = false;
+    m_cacheHits = 0;
+}
+
+int SharePathValidator::cacheHits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cacheHits;
+}
+
+QStringList SharePathValidator::systemDirectories()
+{
+    return {"/", "/bin", "/boot", "/dev", "/etc", "/lib", "/lib32", "/lib64", "/proc",
+            "/root", "/run", "/sbin", "/sys", "/usr", "/var"};
+}
+
+bool SharePathValidator::statPath(const QString &path, FileState *state)
+{
+    const QByteArray encoded = QFile::encodeName(path);
+
+#ifdef STATX_BASIC_STATS
+    unsigned int mask = STATX_BASIC_STATS;
+#ifdef STATX_MNT_ID
+    mask |= STATX_MNT_ID;
+#endif
+    struct statx stx;
+    if (::statx(AT_FDCWD, encoded.constData(), AT_STATX_SYNC_AS_STAT, mask, &stx) == 0) {
+        state->device = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+        state->inode = stx.stx_ino;
+        state->ctimeNs = qint64(stx.stx_ctime.tv_sec) * 1000000000 + stx.stx_ctime.tv_nsec;
+        state->mode = stx.stx_mode;
+        state->owner = stx.stx_uid;
+#ifdef STATX_MNT_ID
+        if (stx.stx_mask & STATX_MNT_ID) {
+            state->mountId = stx.stx_mnt_id;
+            state->hasMountId = true;
+        }
+#endif
+        return true;
+    }
+    if (errno != ENOSYS) {
+        return false;
+    }
+#endif
+
+    struct stat st;
+    if (::stat(encoded.constData(), &st) != 0) {
+        return false;
+    }
+    state->device = st.st_dev;
+    state->inode = st.st_ino;
+    state->ctimeNs = qint64(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec;
+    state->mode = st.st_mode;
+    state->owner = st.st_uid;
+    return true;
+}
+
+QString SharePathValidator::fileSystemOf(const QString &canonicalPath, const FileState &state) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_mountTableLoaded) {
+        loadMountTableLocked();
+    }
+
+    if (state.hasMountId) {
+        if (!m_mountTypes.contains(state.mountId)) {
+            // Mounted since the table was read
+            loadMountTableLocked();
+        }
+        auto it = m_mountTypes.constFind(state.mountId);
+        if (it != m_mountTypes.constEnd()) {
+            return it.value();
+        }
+    }
+
+    for (const auto &mount : m_mountPoints) {
+        if (isUnderDirectory(canonicalPath, mount.first)) {
+            return mount.second;
+        }
+    }
+    return QString();
+}
+
+void SharePathValidator::loadMountTableLocked() const
+{
+    m_mountTableLoaded = true;
+    m_mountTypes.clear();
+    m_mountPoints.clear();
+
+    QFile file(m_mountInfoPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return;
+    }
+
+    // "36 35 98:0 /root /mnt rw,noatime master:1 - ext4 /dev/sda1 rw"
+    const QStringList lines = QString::fromUtf8(file.readAll()).split('\n', Qt::SkipEmptyParts);
+    for (const QString &line : lines) {
+        const QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+        const int separator = fields.indexOf("-");
+        if (fields.size() < 5 || separator < 0 || separator + 1 >= fields.size()) {
+            continue;
+        }
+
+        bool ok = false;
+        const quint64 mountId = fields[0].toULongLong(&ok);
+        const QString type = fields[separator + 1];
+        if (ok) {
+            m_mountTypes.insert(mountId, type);
+        }
+        m_mountPoints.prepend(qMakePair(OctalEscape::unescape(fields[4]), type));
+    }
+
+    // Longest mount point first; later mounts over the same point stay ahead
+    std::stable_sort(m_mountPoints.begin(), m_mountPoints.end(), [](const auto &a, const auto &b) {
+        return a.first.size() > b.first.size();
+    });
+}
+
+PathValidation SharePathValidator::check(const QString &path, const FileState &state) const
+{
+    PathValidation result;
+    result.path = path;
+    result.canonicalPath = QFileInfo(path).canonicalFilePath();
+
+    if (!S_ISDIR(state.mode)) {
+        result.errors << tr("Path is not a directory");
+        return result;
+    }
+
+    const QString canonical = result.canonicalPath.isEmpty() ? path : result.canonicalPath;
+    if (systemDirectories().contains(canonical) || isUnderDirectory(canonical, "/proc") ||
+        isUnderDirectory(canonical, "/sys") || isUnderDirectory(canonical, "/dev")) {
+        result.errors << tr("Cannot share system directory: %1").arg(canonical);
+        return result;
+    }
+
+    if (::access(QFile::encodeName(path).constData(), R_OK | X_OK) != 0) {
+        result.errors << tr("Directory is not accessible");
+    }
+
+    if (!(state.mode & S_IXOTH)) {
+        result.warnings << tr("Directory is not searchable by other users; "
+                              "clients mapped to an anonymous user cannot enter it");
+    }
+
+    result.fileSystem = fileSystemOf(canonical, state);
+    const QString &fs = result.fileSystem;
+    if (fs == "nfs" || fs == "nfs4") {
+        result.errors << tr("Cannot re-export a directory on an NFS mount");
+    } else if (fs == "proc" || fs == "sysfs" || fs == "devtmpfs" || fs.startsWith("cgroup")) {
+        result.errors << tr("Cannot share system directory: %1").arg(canonical);
+    } else if (fs.startsWith("fuse")) {
+        result.warnings << tr("FUSE filesystems need an explicit fsid= export option "
+                              "and may not support NFS export");
+    } else if (fs == "tmpfs" || fs == "ramfs") {
+        result.warnings << tr("%1 has no stable filesystem id; set an explicit fsid= export option").arg(fs);
+    } else if (fs == "overlay") {
+        result.warnings << tr("Overlay filesystems can only be exported with an explicit fsid= "
+                              "and may return stale file handles");
+    }
+
+    return result;
+}
+
+} // namespace NFSShareManager
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+namespace NFSShareManager {
+
+/**
+ * @brief Outcome of validating one candidate share path
+ */
+struct PathValidation {
+    QString path;           ///< Path as requested
+    QString canonicalPath;  ///< Absolute path with symlinks resolved
+    QString fileSystem;     ///< Filesystem type of the directory (e.g. "ext4")
+    QStringList errors;     ///< Reasons the path cannot be shared
+    QStringList warnings;   ///< Reasons the export may misbehave
+
+    bool isValid() const { return errors.isEmpty(); }
+};
+
+/**
+ * @brief Validates directories for sharing, with a per-inode result cache
+ *
+ * A check costs one statx() call (falling back to stat() where statx is
+ * not available), which yields the mount id, inode, mode, owner and
+ * ctime of the directory. The filesystem type is looked up by mount id in
+ * a cached copy of /proc/self/mountinfo, so NFS mounts (which cannot be
+ * re-exported), FUSE and tmpfs (which need an explicit fsid=) are
+ * recognised without further syscalls.
+ *
+ * Results are cached by path and reused while the directory keeps the
+ * same device, inode and ctime; a warm check is a single statx(). All
+ * methods are thread-safe, and validateBatch() spreads a list of paths
+ * over a thread pool.
+ */
+class SharePathValidator
+{
+    Q_DECLARE_TR_FUNCTIONS(SharePathValidator)
+
+public:
+    SharePathValidator();
+
+    /**
+     * @brief Validate one path
+     * @param path Directory to check
+     * @return Errors and warnings for the path
+     */
+    PathValidation validate(const QString &path) const;
+
+    /**
+     * @brief Validate many paths in parallel
+     * @param paths Directories to check
+     * @return One result per path, in input order
+     */
+    QList<PathValidation> validateBatch(const QStringList &paths) const;
+
+    /**
+     * @brief Set the mount table used to resolve filesystem types
+     * @param filePath Path to a mountinfo file (default: /proc/self/mountinfo)
+     */
+    void setMountInfoPath(const QString &filePath);
+
+    /**
+     * @brief Drop all cached results and the cached mount table
+     */
+    void clearCache();
+
+    /**
+     * @brief Get the number of validations answered from the cache
+     */
+    int cacheHits() const;
+
+    /**
+     * @brief Get the directories that must never be shared
+     */
+    static QStringList systemDirectories();
+
+private:
+    struct FileState {
+        quint64 device = 0;
+        quint64 inode = 0;
+        qint64 ctimeNs = 0;
+        quint32 mode = 0;
+        quint32 owner = 0;
+        quint64 mountId = 0;
+        bool hasMountId = false;
+
+        bool sameFile(const FileState &other) const
+        {
+            return device == other.device && inode == other.inode && ctimeNs == other.ctimeNs;
+        }
+    };
+
+    struct CacheEntry {
+        FileState state;
+        PathValidation result;
+    };
+
+    static bool statPath(const QString &path, FileState *state);
+    QString fileSystemOf(const QString &canonicalPath, const FileState &state) const;
+    void loadMountTableLocked() const;
+    PathValidation check(const QString &path, const FileState &state) const;
+
+    QString m_mountInfoPath;                            ///< Mount table to parse
+    mutable QMutex m_mutex;                             ///< Guards everything below
+    mutable QHash<QString, CacheEntry> m_cache;         ///< Results by requested path
+    mutable QHash<quint64, QString> m_mountTypes;       ///< Filesystem type by mount id
+    mutable QList<QPair<QString, QString>> m_mountPoints; ///< (mount point, type), longest first
+    mutable bool m_mountTableLoaded;                    ///< Whether the mount table was parsed
+    mutable int m_cacheHits;                            ///< Validations served from the cache
+};
+
+} // namespace NFSShareManager
+
+Q_DECLARE_METATYPE(NFSShareManager::PathValidation)
@@ -0,0 +1,281 @@
+#include "shareregistry.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <sys/stat.h>
+
+namespace NFSShareManager {
+
+ShareRegistry::ShareRegistry()
+    : m_nextSequence(0)
+{
+}
+
+ShareRegistry::~ShareRegistry() = default;
+
+bool ShareRegistry::insert(const NFSShare &share)
+{
+    const QString key = canonicalPath(share.path());
+    if (key.isEmpty() || !resolveKey(key).isEmpty()) {
+        return false;
+    }
+
+    Entry entry;
+    entry.share = share;
+    entry.sequence = m_nextSequence++;
+    entry.hasFileId = fileIdOf(key, &entry.fileId);
+
+    if (entry.hasFileId) {
+        m_byFileId.insert(entry.fileId, key);
+    }
+    m_order.insert(entry.sequence, key);
+    m_entries.insert(key, entry);
+    trieInsert(key);
+    return true;
+}
+
+bool ShareRegistry::remove(const QString &path)
+{
+    const QString key = resolveKey(path);
+    if (key.isEmpty()) {
+        return false;
+    }
+
+    const Entry entry = m_entries.take(key);
+    if (entry.hasFileId) {
+        m_byFileId.remove(entry.fileId);
+    }
+    m_order.remove(entry.sequence);
+    trieRemove(key);
+    return true;
+}
+
+void ShareRegistry::clear()
+{
+    m_entries.clear();
+    m_byFileId.clear();
+    m_order.clear();
+    m_root.children.clear();
+    m_root.exportsBelow = 0;
+    m_root.exported = false;
+}
+
+NFSShare *ShareRegistry::find(const QString &path)
+{
+    const QString key = resolveKey(path);
+    if (key.isEmpty()) {
+        return nullptr;
+    }
+    auto it = m_entries.find(key);
+    return it == m_entries.end() ? nullptr : &it->share;
+}
+
+const NFSShare *ShareRegistry::find(const QString &path) const
+{
+    const QString key = resolveKey(path);
+    if (key.isEmpty()) {
+        return nullptr;
+    }
+    auto it = m_entries.constFind(key);
+    return it == m_entries.constEnd() ? nullptr : &it->share;
+}
+
+bool ShareRegistry::contains(const QString &path) const
+{
+    return !resolveKey(path).isEmpty();
+}
+
+QList<NFSShare> ShareRegistry::shares() const
+{
+    QList<NFSShare> result;
+    result.reserve(m_order.size());
+    for (const QString &key : m_order) {
+        result << m_entries.value(key).share;
+    }
+    return result;
+}
+
+int ShareRegistry::size() const
+{
+    return m_entries.size();
+}
+
+bool ShareRegistry::isEmpty() const
+{
+    return m_entries.isEmpty();
+}
+
+QString ShareRegistry::exportedAncestor(const QString &path) const
+{
+    const QString key = canonicalPath(path);
+    if (key.isEmpty()) {
+        return QString();
+    }
+
+    // Walk down from the root and remember the deepest export passed
+    const QStringList parts = components(key);
+    const TrieNode *node = &m_root;
+    QString current;
+    QString ancestor = m_root.exported && !parts.isEmpty() ? QStringLiteral("/") : QString();
+
+    for (int i = 0; i + 1 < parts.size(); ++i) {
+        auto it = node->children.find(parts[i]);
+        if (it == node->children.end()) {
+            break;
+        }
+        node = it->second.get();
+        current += '/' + parts[i];
+        if (node->exported) {
+            ancestor = current;
+        }
+    }
+    return ancestor;
+}
+
+bool ShareRegistry::hasExportedDescendant(const QString &path) const
+{
+    const TrieNode *node = trieFind(canonicalPath(path));
+    return node && node->exportsBelow > 0;
+}
+
+QStringList ShareRegistry::exportedDescendants(const QString &path) const
+{
+    const QString key = canonicalPath(path);
+    const TrieNode *node = trieFind(key);
+    QStringList result;
+    if (!node || node->exportsBelow == 0) {
+        return result;
+    }
+
+    for (const auto &child : node->children) {
+        collectExports(child.second.get(), (key == "/" ? QString() : key) + '/' + child.first, result);
+    }
+    result.sort();
+    return result;
+}
+
+QString ShareRegistry::canonicalPath(const QString &path)
+{
+    if (path.isEmpty()) {
+        return QString();
+    }
+
+    const QFileInfo info(path);
+    const QString canonical = info.canonicalFilePath();
+    if (!canonical.isEmpty()) {
+        return canonical;
+    }
+    return QDir::cleanPath(info.absoluteFilePath());
+}
+
+QString ShareRegistry::resolveKey(const QString &path) const
+{
+    if (path.isEmpty() || m_entries.isEmpty()) {
+        return QString();
+    }
+
+    // Keys are canonical, so a canonical query needs no filesystem access
+    const QString cleaned = QDir::cleanPath(path);
+    if (m_entries.contains(cleaned)) {
+        return cleaned;
+    }
+
+    const QString canonical = canonicalPath(path);
+    if (m_entries.contains(canonical)) {
+        return canonical;
+    }
+
+    // Same directory under another name, e.g. through a bind mount
+    FileId id;
+    if (!m_byFileId.isEmpty() && fileIdOf(canonical, &id)) {
+        return m_byFileId.value(id);
+    }
+    return QString();
+}
+
+bool ShareRegistry::fileIdOf(const QString &path, FileId *id)
+{
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0) {
+        return false;
+    }
+    id->device = static_cast<quint64>(st.st_dev);
+    id->inode = static_cast<quint64>(st.st_ino);
+    return true;
+}
+
+QStringList ShareRegistry::components(const QString &canonicalPath)
+{
+    return canonicalPath.split('/', Qt::SkipEmptyParts);
+}
+
+void ShareRegistry::trieInsert(const QString &key)
+{
+    TrieNode *node = &m_root;
+    for (const QString &part : components(key)) {
+        node->exportsBelow++;
+        std::unique_ptr<TrieNode> &child = node->children[part];
+        if (!child) {
+            child = std::make_unique<TrieNode>();
+        }
+        node = child.get();
+    }
+    node->exported = true;
+}
+
+void ShareRegistry::trieRemove(const QString &key)
+{
+    const QStringList parts = components(key);
+
+    TrieNode *node = &m_root;
+    for (int i = 0; i < parts.size(); ++i) {
+        auto it = node->children.find(parts[i]);
+        if (it == node->children.end()) {
+            return;
+        }
+        node->exportsBelow--;
+
+        // Drop the first subtree on the path that holds nothing but this export
+        TrieNode *child = it->second.get();
+        const bool isTarget = (i == parts.size() - 1);
+        const int remainingBelow = child->exportsBelow - (isTarget ? 0 : 1);
+        if ((isTarget || !child->exported) && remainingBelow == 0) {
+            node->children.erase(it);
+            return;
+        }
+        node = child;
+    }
+    node->exported = false;
+}
+
+const ShareRegistry::TrieNode *ShareRegistry::trieFind(const QString &key) const
+{
+    if (key.isEmpty()) {
+        return nullptr;
+    }
+
+    const TrieNode *node = &m_root;
+    for (const QString &part : components(key)) {
+        auto it = node->children.find(part);
+        if (it == node->children.end()) {
+            return nullptr;
+        }
+        node = it->second.get();
+    }
+    return node;
+}
+
+void ShareRegistry::collectExports(const TrieNode *node, const QString &prefix, QStringList &out)
+{
+    if (node->exported) {
+        out << prefix;
+    }
+    if (node->exportsBelow == 0) {
+        return;
+    }
+    for (const auto &child : node->children) {
+        collectExports(child.second.get(), prefix + '/' + child.first, out);
+    }
+}
+
+} // namespace NFSShareManager
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <unordered_map>
+#include "../core/nfsshare.h"
+
+namespace NFSShareManager {
+
+/**
+ * @brief Path-indexed store of the active shares
+ *
+ * Shares are keyed by their canonical path (symlinks resolved) and, for
+ * directories that exist, by device and inode as well, so the same
+ * directory reached through a bind mount or a different spelling maps to
+ * the same share. Lookups are O(1) hash probes; a query that is already
+ * canonical is answered without touching the filesystem.
+ *
+ * A trie of path components answers nesting questions ("is this path
+ * inside an export", "are there exports below this path") in O(depth)
+ * regardless of the number of shares.
+ *
+ * Enumeration returns shares in insertion order.
+ */
+class ShareRegistry
+{
+public:
+    ShareRegistry();
+    ~ShareRegistry();
+
+    ShareRegistry(const ShareRegistry &) = delete;
+    ShareRegistry &operator=(const ShareRegistry &) = delete;
+
+    /**
+     * @brief Add a share
+     * @param share The share to add
+     * @return False if a share for the same directory already exists
+     */
+    bool insert(const NFSShare &share);
+
+    /**
+     * @brief Remove the share for a path
+     * @param path Path of the share (any spelling of the same directory)
+     * @return True if a share was removed
+     */
+    bool remove(const QString &path);
+
+    /**
+     * @brief Remove all shares
+     */
+    void clear();
+
+    /**
+     * @brief Find the share for a path
+     * @param path Path of the share (any spelling of the same directory)
+     * @return The share, or nullptr if the path is not shared
+     */
+    NFSShare *find(const QString &path);
+    const NFSShare *find(const QString &path) const;
+
+    /**
+     * @brief Check if a path is shared
+     */
+    bool contains(const QString &path) const;
+
+    /**
+     * @brief Get all shares in insertion order
+     */
+    QList<NFSShare> shares() const;
+
+    /**
+     * @brief Get the number of shares
+     */
+    int size() const;
+
+    /**
+     * @brief Check if the registry is empty
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Get the closest exported directory strictly above a path
+     * @param path Path to check
+     * @return Canonical path of the enclosing export, or empty if there is none
+     */
+    QString exportedAncestor(const QString &path) const;
+
+    /**
+     * @brief Check if any export lies strictly below a path
+     * @param path Path to check
+     * @return True if an exported directory is nested inside the path
+     */
+    bool hasExportedDescendant(const QString &path) const;
+
+    /**
+     * @brief Get the exports strictly below a path
+     * @param path Path to check
+     * @return Canonical paths of the nested exports, sorted
+     */
+    QStringList exportedDescendants(const QString &path) const;
+
+    /**
+     * @brief Get the key a path is stored under
+     *
+     * Resolves symlinks for existing paths; paths that do not exist are
+     * made absolute and cleaned.
+     *
+     * @param path Path to canonicalise
+     * @return Canonical absolute path, or empty for an empty path
+     */
+    static QString canonicalPath(const QString &path);
+
+private:
+    /**
+     * @brief Device/inode pair identifying a directory
+     */
+    struct FileId {
+        quint64 device = 0;
+        quint64 inode = 0;
+
+        bool operator==(const FileId &other) const
+        {
+            return device == other.device && inode == other.inode;
+        }
+
+        friend size_t qHash(const FileId &id, size_t seed = 0) noexcept
+        {
+            return qHashMulti(seed, id.device, id.inode);
+        }
+    };
+
+    struct Entry {
+        NFSShare share;
+        quint64 sequence = 0;   ///< Insertion order
+        FileId fileId;          ///< Device/inode when the directory exists
+        bool hasFileId = false;
+    };
+
+    struct TrieNode {
+        std::unordered_map<QString, std::unique_ptr<TrieNode>> children;
+        int exportsBelow = 0;   ///< Exports in this subtree, excluding this node
+        bool exported = false;
+    };
+
+    /**
+     * @brief Resolve a path to the key of an existing entry
+     * @return The key, or empty if no share matches
+     */
+    QString resolveKey(const QString &path) const;
+
+    static bool fileIdOf(const QString &path, FileId *id);
+    static QStringList components(const QString &canonicalPath);
+
+    void trieInsert(const QString &key);
+    void trieRemove(const QString &key);
+    const TrieNode *trieFind(const QString &key) const;
+    static void collectExports(const TrieNode *node, const QString &prefix, QStringList &out);
+
+    QHash<QString, Entry> m_entries;          ///< Shares by canonical path
+    QHash<FileId, QString> m_byFileId;        ///< Canonical path by device/inode
+    QMap<quint64, QString> m_order;           ///< Canonical path by insertion sequence
+    quint64 m_nextSequence;                   ///< Sequence of the next insert
+    TrieNode m_root;                          ///< Path component trie rooted at "/"
+};
+
+} // namespace NFSShareManager
@@ -0,0 +1,669 @@
+#include "shareusagemonitor.h"
+#include "../system/filesystemwatcher.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+namespace NFSShareManager {
+
+namespace {
+
+const quint32 CacheMagic = 0x4e465355;  // "NFSU"
+const qint32 CacheVersion = 2;
+
+struct EntryState {
+    quint64 device = 0;
+    quint64 inode = 0;
+    qint64 mtimeNs = 0;
+    qint64 ctimeNs = 0;
+    qint64 size = 0;
+    quint32 mode = 0;
+    quint64 links = 0;
+};
+
+/**
+ * @brief statx() an entry relative to a directory descriptor, without following symlinks
+ */
+bool statEntry(int dirFd, const char *name, EntryState *state)
+{
+#ifdef STATX_BASIC_STATS
+    struct statx stx;
+    const unsigned int mask = STATX_TYPE | STATX_MODE | STATX_NLINK | STATX_INO | STATX_SIZE |
+                              STATX_MTIME | STATX_CTIME;
+    if (::statx(dirFd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, mask, &stx) == 0) {
+        state->device = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+        state->inode = stx.stx_ino;
+        state->mtimeNs = qint64(stx.stx_mtime.tv_sec) * 1000000000 + stx.stx_mtime.tv_nsec;
+        state->ctimeNs = qint64(stx.stx_ctime.tv_sec) * 1000000000 + stx.stx_ctime.tv_nsec;
+        state->size = qint64(stx.stx_size);
+        state->mode = stx.stx_mode;
+        state->links = stx.stx_nlink;
+        return true;
+    }
+    if (errno != ENOSYS) {
+        return false;
+    }
+#endif
+
+    struct stat st;
+    if (::fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return false;
+    }
+    state->device = st.st_dev;
+    state->inode = st.st_ino;
+    state->mtimeNs = qint64(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    state->ctimeNs = qint64(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec;
+    state->size = qint64(st.st_size);
+    state->mode = st.st_mode;
+    state->links = st.st_nlink;
+    return true;
+}
+
+/**
+ * @brief Call @p visit for every entry name of an open directory except "." and ".."
+ *
+ * Uses getdents64() directly so a directory is read in 32 KiB batches
+ * without the per-entry overhead of readdir().
+ */
+template<typename Visitor>
+void forEachEntry(int fd, Visitor visit)
+{
+#ifdef SYS_getdents64
+    struct LinuxDirent64 {
+        quint64 d_ino;
+        qint64 d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+
+    alignas(8) char buffer[32768];
+    for (;;) {
+        const long count = ::syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        if (count <= 0) {
+            break;
+        }
+        for (long offset = 0; offset < count;) {
+            const auto *entry = reinterpret_cast<const LinuxDirent64 *>(buffer + offset);
+            offset += entry->d_reclen;
+            const char *name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+            visit(name);
+        }
+    }
+#else
+    DIR *dir = ::fdopendir(::dup(fd));
+    if (!dir) {
+        return;
+    }
+    while (const struct dirent *entry = ::readdir(dir)) {
+        const char *name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        visit(name);
+    }
+    ::closedir(dir);
+#endif
+}
+
+bool isUnderDirectory(const QString &path, const QString &directory)
+{
+    return path == directory || path.startsWith(directory + '/');
+}
+
+} // namespace
+
+struct ShareUsageMonitor::Scan {
+    QString sharePath;              ///< Share being scanned
+    quint64 device = 0;             ///< Device of the share root; other devices are not entered
+    bool checkFiles = false;        ///< Whether files of unchanged directories are statx()ed too
+    std::atomic<int> pending{0};    ///< Directories queued or being read
+};
+
+ShareUsageMonitor::ShareUsageMonitor(QObject *parent)
+    : QObject(parent)
+    , m_watcher(new FileSystemWatcher(this))
+    , m_maxWatchedDirectories(1024)
+    , m_directoriesRead(0)
+    , m_stopping(false)
+{
+    qRegisterMetaType<ShareUsage>("ShareUsage");
+
+    m_pool.setMaxThreadCount(4);
+
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!cacheDir.isEmpty()) {
+        m_cacheFilePath = cacheDir + "/usage.cache";
+    }
+
+    // The debounced signal collapses bursts of writes into one rescan per directory
+    connect(m_watcher, &FileSystemWatcher::pathChanged, this,
+            [this](const QString &path) { onDirectoryChanged(path); });
+}
+
+ShareUsageMonitor::~ShareUsageMonitor()
+{
+    m_stopping = true;
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void ShareUsageMonitor::setShares(const QStringList &sharePaths)
+{
+    QStringList shares;
+    for (const QString &path : sharePaths) {
+        const QString cleaned = QDir::cleanPath(path);
+        if (!cleaned.isEmpty() && !shares.contains(cleaned)) {
+            shares << cleaned;
+        }
+    }
+
+    for (const QString &share : m_shares) {
+        if (shares.contains(share)) {
+            continue;
+        }
+        for (const QString &dir : m_watched.take(share)) {
+            m_watcher->removeDirectory(dir);
+        }
+        m_usage.remove(share);
+        m_pendingRescans.remove(share);
+        m_pendingFileChecks.remove(share);
+        QMutexLocker locker(&m_mutex);
+        dropSubtreeLocked(share);
+    }
+
+    const QStringList previous = m_shares;
+    m_shares = shares;
+    for (const QString &share : shares) {
+        if (!previous.contains(share)) {
+            startScan(share, {share}, false, true);
+        }
+    }
+}
+
+QStringList ShareUsageMonitor::shares() const
+{
+    return m_shares;
+}
+
+ShareUsage ShareUsageMonitor::usage(const QString &sharePath) const
+{
+    return m_usage.value(QDir::cleanPath(sharePath));
+}
+
+void ShareUsageMonitor::refresh(const QString &sharePath)
+{
+    const QString share = QDir::cleanPath(sharePath);
+    if (m_shares.contains(share)) {
+        startScan(share, {share}, false, true);
+    }
+}
+
+void ShareUsageMonitor::refreshAll()
+{
+    for (const QString &share : m_shares) {
+        startScan(share, {share}, false, true);
+    }
+}
+
+void ShareUsageMonitor::invalidate(const QString &dirPath)
+{
+    QString dir = QDir::cleanPath(dirPath);
+    const QString share = shareOf(dir);
+    if (share.isEmpty()) {
+        return;
+    }
+
+    // A deleted directory is accounted for by re-reading its parent
+    while (dir != share && !QFileInfo::exists(dir)) {
+        dir = QFileInfo(dir).path();
+    }
+    startScan(share, {dir}, true, false);
+}
+
+bool ShareUsageMonitor::isScanning() const
+{
+    return !m_scanning.isEmpty() || !m_pendingRescans.isEmpty();
+}
+
+void ShareUsageMonitor::setMaxThreadCount(int count)
+{
+    m_pool.setMaxThreadCount(qMax(1, count));
+}
+
+void ShareUsageMonitor::setMaxWatchedDirectories(int count)
+{
+    m_maxWatchedDirectories = qMax(0, count);
+}
+
+FileSystemWatcher *ShareUsageMonitor::watcher() const
+{
+    return m_watcher;
+}
+
+void ShareUsageMonitor::setCacheFilePath(const QString &filePath)
+{
+    m_cacheFilePath = filePath;
+}
+
+bool ShareUsageMonitor::loadCache()
+{
+    QFile file(m_cacheFilePath);
+    if (m_cacheFilePath.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    qint32 version = 0;
+    in >> magic >> version;
+    if (magic != CacheMagic || version != CacheVersion) {
+        qWarning() << "ShareUsageMonitor: Ignoring usage cache with unknown format:" << m_cacheFilePath;
+        return false;
+    }
+
+    QHash<QString, DirectoryRecord> directories;
+    quint32 count = 0;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString path;
+        DirectoryRecord record;
+        quint32 fileCount = 0;
+        in >> path >> record.device >> record.inode >> record.mtimeNs >> record.ctimeNs
+           >> record.subdirectories >> fileCount;
+        for (quint32 j = 0; j < fileCount && in.status() == QDataStream::Ok; ++j) {
+            FileStamp file;
+            in >> file.name >> file.device >> file.inode >> file.size >> file.mtimeNs >> file.linked;
+            record.files << file;
+        }
+        tallyFiles(record);
+        directories.insert(path, record);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "ShareUsageMonitor: Usage cache is truncated:" << m_cacheFilePath;
+        return false;
+    }
+
+    // Records are trusted only until the next scan compares them with statx()
+    QMutexLocker locker(&m_mutex);
+    for (auto it = directories.cbegin(); it != directories.cend(); ++it) {
+        if (!m_directories.contains(it.key())) {
+            m_directories.insert(it.key(), it.value());
+        }
+    }
+    return true;
+}
+
+bool ShareUsageMonitor::saveCache() const
+{
+    if (m_cacheFilePath.isEmpty()) {
+        return false;
+    }
+    QDir().mkpath(QFileInfo(m_cacheFilePath).path());
+
+    QSaveFile file(m_cacheFilePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "ShareUsageMonitor: Cannot write usage cache:" << m_cacheFilePath;
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << CacheMagic << CacheVersion;
+    {
+        QMutexLocker locker(&m_mutex);
+        QStringList paths;
+        for (auto it = m_directories.cbegin(); it != m_directories.cend(); ++it) {
+            if (!shareOf(it.key()).isEmpty()) {
+                paths << it.key();
+            }
+        }
+        out << quint32(paths.size());
+        for (const QString &path : paths) {
+            const DirectoryRecord record = m_directories.value(path);
+            out << path << record.device << record.inode << record.mtimeNs << record.ctimeNs
+                << record.subdirectories << quint32(record.files.size());
+            for (const FileStamp &file : record.files) {
+                out << file.name << file.device << file.inode << file.size << file.mtimeNs << file.linked;
+            }
+        }
+    }
+    return file.commit();
+}
+
+int ShareUsageMonitor::directoriesRead() const
+{
+    return m_directoriesRead;
+}
+
+void ShareUsageMonitor::onDirectoryChanged(const QString &dirPath)
+{
+    invalidate(dirPath);
+}
+
+void ShareUsageMonitor::tallyFiles(DirectoryRecord &record)
+{
+    record.ownBytes = 0;
+    record.ownFiles = 0;
+    record.hardLinks.clear();
+    for (const FileStamp &file : record.files) {
+        if (file.linked) {
+            record.hardLinks << HardLink{file.device, file.inode, file.size};
+        } else {
+            record.ownBytes += file.size;
+            record.ownFiles++;
+        }
+    }
+}
+
+bool ShareUsageMonitor::restatFiles(const QByteArray &dirPath, DirectoryRecord &record)
+{
+    const int fd = ::open(dirPath.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool changed = false;
+    for (int i = record.files.size() - 1; i >= 0; --i) {
+        FileStamp &file = record.files[i];
+        EntryState entry;
+        if (!statEntry(fd, QFile::encodeName(file.name).constData(), &entry)) {
+            // Gone between the directory check and now; the next event re-reads it
+            record.files.removeAt(i);
+            changed = true;
+        } else if (entry.size != file.size || entry.mtimeNs != file.mtimeNs || entry.inode != file.inode ||
+                   (entry.links > 1) != file.linked) {
+            file.device = entry.device;
+            file.inode = entry.inode;
+            file.size = entry.size;
+            file.mtimeNs = entry.mtimeNs;
+            file.linked = entry.links > 1;
+            changed = true;
+        }
+    }
+    ::close(fd);
+
+    if (changed) {
+        tallyFiles(record);
+    }
+    return changed;
+}
+
+void ShareUsageMonitor::startScan(const QString &sharePath, const QStringList &dirPaths, bool force, bool checkFiles)
+{
+    if (m_scanning.contains(sharePath)) {
+        // One scan per share at a time; re-read these once it ends
+        for (const QString &dir : dirPaths) {
+            m_pendingRescans[sharePath].insert(dir);
+        }
+        if (checkFiles) {
+            m_pendingFileChecks.insert(sharePath);
+        }
+        return;
+    }
+
+    // Skip directories that are below another one being rescanned
+    QStringList dirs = dirPaths;
+    std::sort(dirs.begin(), dirs.end());
+    QStringList roots;
+    for (const QString &dir : dirs) {
+        if (roots.isEmpty() || !isUnderDirectory(dir, roots.last())) {
+            roots << dir;
+        }
+    }
+
+    auto scan = std::make_shared<Scan>();
+    scan->sharePath = sharePath;
+    scan->checkFiles = checkFiles;
+    EntryState rootState;
+    if (statEntry(AT_FDCWD, QFile::encodeName(sharePath).constData(), &rootState)) {
+        scan->device = rootState.device;
+    }
+
+    m_scanning.insert(sharePath);
+    scan->pending = 1;
+    for (const QString &dir : roots) {
+        queueDirectory(scan, dir, force);
+    }
+    if (--scan->pending == 0) {
+        QMetaObject::invokeMethod(this, [this, sharePath]() { finishScan(sharePath); }, Qt::QueuedConnection);
+    }
+}
+
+void ShareUsageMonitor::queueDirectory(const std::shared_ptr<Scan> &scan, const QString &dirPath, bool force)
+{
+    scan->pending++;
+    m_pool.start([this, scan, dirPath, force]() {
+        scanDirectory(scan, dirPath, force);
+        if (--scan->pending == 0) {
+            const QString sharePath = scan->sharePath;
+            QMetaObject::invokeMethod(this, [this, sharePath]() { finishScan(sharePath); }, Qt::QueuedConnection);
+        }
+    });
+}
+
+void ShareUsageMonitor::scanDirectory(const std::shared_ptr<Scan> &scan, const QString &dirPath, bool force)
+{
+    if (m_stopping) {
+        return;
+    }
+
+    const QByteArray encoded = QFile::encodeName(dirPath);
+    EntryState dirState;
+    if (!statEntry(AT_FDCWD, encoded.constData(), &dirState) || !S_ISDIR(dirState.mode)) {
+        QMutexLocker locker(&m_mutex);
+        dropSubtreeLocked(dirPath);
+        return;
+    }
+
+    // Unchanged directory: same entries, so reuse its subtotal and only descend
+    if (!force) {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_directories.constFind(dirPath);
+        if (it != m_directories.constEnd() && it->device == dirState.device && it->inode == dirState.inode &&
+            it->mtimeNs == dirState.mtimeNs && it->ctimeNs == dirState.ctimeNs) {
+            DirectoryRecord cached = it.value();
+            locker.unlock();
+
+            // A file growing in place changes neither the directory's mtime nor its ctime
+            if (scan->checkFiles && restatFiles(encoded, cached)) {
+                QMutexLocker relock(&m_mutex);
+                if (m_directories.contains(dirPath)) {
+                    m_directories.insert(dirPath, cached);
+                }
+            }
+            const QStringList subdirectories = cached.subdirectories;
+            for (const QString &subdirectory : subdirectories) {
+                queueDirectory(scan, subdirectory, false);
+            }
+            return;
+        }
+    }
+
+    DirectoryRecord record;
+    record.device = dirState.device;
+    record.inode = dirState.inode;
+    record.mtimeNs = dirState.mtimeNs;
+    record.ctimeNs = dirState.ctimeNs;
+
+    const int fd = ::open(encoded.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0) {
+        qWarning() << "ShareUsageMonitor: Cannot read directory" << dirPath << ":" << strerror(errno);
+    } else {
+        const QString prefix = dirPath.endsWith('/') ? dirPath : dirPath + '/';
+        forEachEntry(fd, [&](const char *name) {
+            EntryState entry;
+            if (!statEntry(fd, name, &entry)) {
+                return;
+            }
+            if (S_ISDIR(entry.mode)) {
+                // Do not cross into other filesystems mounted below the share
+                if (entry.device == scan->device) {
+                    record.subdirectories << prefix + QFile::decodeName(name);
+                }
+            } else {
+                FileStamp file;
+                file.name = QFile::decodeName(name);
+                file.device = entry.device;
+                file.inode = entry.inode;
+                file.size = entry.size;
+                file.mtimeNs = entry.mtimeNs;
+                file.linked = entry.links > 1;
+                record.files << file;
+            }
+        });
+        ::close(fd);
+        m_directoriesRead++;
+        tallyFiles(record);
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        auto old = m_directories.constFind(dirPath);
+        if (old != m_directories.constEnd()) {
+            const QSet<QString> current(record.subdirectories.cbegin(), record.subdirectories.cend());
+            const QStringList previous = old->subdirectories;
+            for (const QString &subdirectory : previous) {
+                if (!current.contains(subdirectory)) {
+                    dropSubtreeLocked(subdirectory);
+                }
+            }
+        }
+        m_directories.insert(dirPath, record);
+    }
+
+    for (const QString &subdirectory : record.subdirectories) {
+        queueDirectory(scan, subdirectory, false);
+    }
+}
+
+void ShareUsageMonitor::finishScan(const QString &sharePath)
+{
+    m_scanning.remove(sharePath);
+
+    if (!m_shares.contains(sharePath)) {
+        // Removed while the scan was running
+        m_pendingRescans.remove(sharePath);
+        m_pendingFileChecks.remove(sharePath);
+        QMutexLocker locker(&m_mutex);
+        dropSubtreeLocked(sharePath);
+        return;
+    }
+
+    ShareUsage usage;
+    {
+        QMutexLocker locker(&m_mutex);
+        usage = computeUsageLocked(sharePath);
+    }
+    usage.complete = true;
+    usage.updatedAt = QDateTime::currentDateTime();
+    m_usage.insert(sharePath, usage);
+
+    updateWatches(sharePath);
+    emit usageUpdated(sharePath, usage);
+
+    if (m_pendingRescans.contains(sharePath)) {
+        const QSet<QString> dirs = m_pendingRescans.take(sharePath);
+        startScan(sharePath, QStringList(dirs.cbegin(), dirs.cend()), true, m_pendingFileChecks.remove(sharePath));
+    }
+}
+
+void ShareUsageMonitor::dropSubtreeLocked(const QString &dirPath)
+{
+    QStringList stack = {dirPath};
+    while (!stack.isEmpty()) {
+        auto it = m_directories.find(stack.takeLast());
+        if (it != m_directories.end()) {
+            stack << it->subdirectories;
+            m_directories.erase(it);
+        }
+    }
+}
+
+ShareUsage ShareUsageMonitor::computeUsageLocked(const QString &sharePath) const
+{
+    ShareUsage usage;
+    QSet<QPair<quint64, quint64>> seenLinks;
+    QStringList stack = {sharePath};
+    while (!stack.isEmpty()) {
+        auto it = m_directories.constFind(stack.takeLast());
+        if (it == m_directories.constEnd()) {
+            continue;
+        }
+        usage.directories++;
+        usage.bytes += it->ownBytes;
+        usage.files += it->ownFiles;
+        for (const HardLink &link : it->hardLinks) {
+            const auto key = qMakePair(link.device, link.inode);
+            if (!seenLinks.contains(key)) {
+                seenLinks.insert(key);
+                usage.bytes += link.size;
+                usage.files++;
+            }
+        }
+        stack << it->subdirectories;
+    }
+    return usage;
+}
+
+void ShareUsageMonitor::updateWatches(const QString &sharePath)
+{
+    // Watch the shallowest directories first, up to the per-share limit
+    QStringList wanted;
+    {
+        QMutexLocker locker(&m_mutex);
+        QStringList queue = {sharePath};
+        for (int i = 0; i < queue.size() && wanted.size() < m_maxWatchedDirectories; ++i) {
+            auto it = m_directories.constFind(queue[i]);
+            if (it == m_directories.constEnd()) {
+                continue;
+            }
+            wanted << queue[i];
+            queue << it->subdirectories;
+        }
+    }
+
+    const QStringList watched = m_watched.value(sharePath);
+    const QSet<QString> wantedSet(wanted.cbegin(), wanted.cend());
+    const QSet<QString> watchedSet(watched.cbegin(), watched.cend());
+    for (const QString &dir : watched) {
+        if (!wantedSet.contains(dir)) {
+            m_watcher->removeDirectory(dir);
+        }
+    }
+    for (const QString &dir : wanted) {
+        if (!watchedSet.contains(dir)) {
+            m_watcher->addDirectory(dir);
+        }
+    }
+    m_watched.insert(sharePath, wanted);
+}
+
+QString ShareUsageMonitor::shareOf(const QString &path) const
+{
+    QString best;
+    for (const QString &share : m_shares) {
+        if (isUnderDirectory(path, share) && share.size() > best.size()) {
+            best = share;
+        }
+    }
+    return best;
+}
+
+} // namespace NFSShareManager
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+#include <QMetaType>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+
+namespace NFSShareManager {
+
+class FileSystemWatcher;
+
+/**
+ * @brief Size and file count of one local share
+ */
+struct ShareUsage {
+    qint64 bytes = 0;           ///< Apparent size of all files, hard links counted once
+    qint64 files = 0;           ///< Number of non-directory entries, hard links counted once
+    qint64 directories = 0;     ///< Number of directories including the share root
+    bool complete = false;      ///< Whether at least one full scan has finished
+    QDateTime updatedAt;        ///< When the totals last changed
+};
+
+/**
+ * @brief Parallel, incremental disk-usage accounting for local shares
+ *
+ * Each directory is read with getdents64() and its entries are examined
+ * with statx() relative to the directory descriptor, on a thread pool;
+ * subdirectories are queued as separate tasks so wide and deep trees are
+ * walked in parallel. Mount points below a share are not crossed.
+ *
+ * Per-directory subtotals (own bytes and files, plus the inodes of files
+ * with more than one link) and the size and mtime of every file are kept
+ * and can be persisted with saveCache(). A later refresh statx()es every
+ * directory but only re-reads those whose mtime or ctime changed; the
+ * files of an unchanged directory are statx()ed by name and compared with
+ * their recorded size and mtime, so a file growing in place is seen
+ * without a getdents64() pass. Hard links are counted once per share by
+ * inode.
+ *
+ * Directory events from the owned FileSystemWatcher trigger a rescan of
+ * the changed directory only. They do not report writes to existing
+ * files; those are picked up by the next refresh() or refreshAll().
+ */
+class ShareUsageMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ShareUsageMonitor(QObject *parent = nullptr);
+    ~ShareUsageMonitor();
+
+    /**
+     * @brief Replace the set of monitored shares
+     * @param sharePaths Share root directories
+     *
+     * Shares that are new are scanned; shares no longer listed are dropped.
+     */
+    void setShares(const QStringList &sharePaths);
+
+    /**
+     * @brief Get the monitored share roots
+     */
+    QStringList shares() const;
+
+    /**
+     * @brief Get the last computed usage of a share
+     * @param sharePath Share root directory
+     */
+    ShareUsage usage(const QString &sharePath) const;
+
+    /**
+     * @brief Incrementally rescan one share, re-checking the size of every file
+     * @param sharePath Share root directory
+     */
+    void refresh(const QString &sharePath);
+
+    /**
+     * @brief Incrementally rescan all shares, re-checking the size of every file
+     */
+    void refreshAll();
+
+    /**
+     * @brief Re-read one directory and rescan incrementally below it
+     * @param dirPath Directory inside a monitored share
+     */
+    void invalidate(const QString &dirPath);
+
+    /**
+     * @brief Check whether any scan is running or queued
+     */
+    bool isScanning() const;
+
+    /**
+     * @brief Set the number of scanner threads
+     * @param count Maximum concurrent directory reads (default: 4)
+     */
+    void setMaxThreadCount(int count);
+
+    /**
+     * @brief Set how many directories per share are watched for changes
+     * @param count Watch limit; deeper directories rely on refresh()
+     */
+    void setMaxWatchedDirectories(int count);
+
+    /**
+     * @brief Get the watcher that drives incremental rescans
+     */
+    FileSystemWatcher *watcher() const;
+
+    /**
+     * @brief Set the file used by loadCache() and saveCache()
+     * @param filePath Cache file (default: usage.cache in the app cache dir)
+     */
+    void setCacheFilePath(const QString &filePath);
+
+    /**
+     * @brief Load per-directory subtotals saved by a previous session
+     * @return True if the cache was read
+     */
+    bool loadCache();
+
+    /**
+     * @brief Persist per-directory subtotals
+     * @return True if the cache was written
+     */
+    bool saveCache() const;
+
+    /**
+     * @brief Get the number of directories read with getdents64 so far
+     */
+    int directoriesRead() const;
+
+signals:
+    /**
+     * @brief Emitted when a scan of a share finishes and its totals are known
+     * @param sharePath Share root directory
+     * @param usage New totals
+     */
+    void usageUpdated(const QString &sharePath, const ShareUsage &usage);
+
+private slots:
+    void onDirectoryChanged(const QString &dirPath);
+
+private:
+    struct HardLink {
+        quint64 device;
+        quint64 inode;
+        qint64 size;
+    };
+
+    struct FileStamp {
+        QString name;                   ///< Entry name within its directory
+        quint64 device = 0;
+        quint64 inode = 0;
+        qint64 size = 0;
+        qint64 mtimeNs = 0;
+        bool linked = false;            ///< More than one link
+    };
+
+    struct DirectoryRecord {
+        quint64 device = 0;
+        quint64 inode = 0;
+        qint64 mtimeNs = -1;
+        qint64 ctimeNs = -1;
+        qint64 ownBytes = 0;            ///< Files with a single link
+        qint64 ownFiles = 0;
+        QList<HardLink> hardLinks;      ///< Files with more than one link
+        QList<FileStamp> files;         ///< Every non-directory entry, for in-place growth checks
+        QStringList subdirectories;     ///< Absolute paths on the same device
+    };
+
+    struct Scan;
+
+    static void tallyFiles(DirectoryRecord &record);
+    static bool restatFiles(const QByteArray &dirPath, DirectoryRecord &record);
+    void startScan(const QString &sharePath, const QStringList &dirPaths, bool force, bool checkFiles);
+    void queueDirectory(const std::shared_ptr<Scan> &scan, const QString &dirPath, bool force);
+    void scanDirectory(const std::shared_ptr<Scan> &scan, const QString &dirPath, bool force);
+    void finishScan(const QString &sharePath);
+    void dropSubtreeLocked(const QString &dirPath);
+    ShareUsage computeUsageLocked(const QString &sharePath) const;
+    void updateWatches(const QString &sharePath);
+    QString shareOf(const QString &path) const;
+
+    FileSystemWatcher *m_watcher;                   ///< Directory change notifications
+    QThreadPool m_pool;                             ///< Directory scanner threads
+    QString m_cacheFilePath;                        ///< Persisted subtotals
+    int m_maxWatchedDirectories;                    ///< Watch limit per share
+    QStringList m_shares;                           ///< Monitored share roots
+    QHash<QString, ShareUsage> m_usage;             ///< Last totals per share
+    QHash<QString, QSet<QString>> m_pendingRescans; ///< Directories to re-read once a share's scan ends
+    QSet<QString> m_pendingFileChecks;              ///< Shares whose pending rescan also re-checks files
+    QSet<QString> m_scanning;                       ///< Shares with a scan in flight
+    QHash<QString, QStringList> m_watched;          ///< Directories watched per share
+
+    mutable QMutex m_mutex;                         ///< Guards m_directories
+    QHash<QString, DirectoryRecord> m_directories;  ///< Subtotals by directory path
+    std::atomic<int> m_directoriesRead;             ///< getdents64 passes performed
+    std::atomic<bool> m_stopping;                   ///< Set by the destructor
+};
+
+} // namespace NFSShareManager
+
+Q_DECLARE_METATYPE(NFSShareManager::ShareUsage)
@@ -0,0 +1,164 @@
+#include "shutdownunmounter.h"
+#include "../system/detachedcall.h"
+#include "../system/toolregistry.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QProcess>
+#include <QSet>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace NFSShareManager {
+
+namespace {
+
+struct StepResult {
+    QString mountPoint;
+    ShutdownUnmounter::Step step;
+    QString errorMessage;
+};
+
+/**
+ * @brief Results handed from the unmount threads to run()
+ *
+ * Shared ownership: abandoned threads may return after run() did.
+ */
+struct SharedResults {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<StepResult> results;
+};
+
+} // namespace
+
+ShutdownUnmounter::ShutdownUnmounter(QObject *parent)
+    : QObject(parent)
+    , m_unmountOperation(&ShutdownUnmounter::umountCommand)
+{
+    qRegisterMetaType<ShutdownUnmounter::Step>("ShutdownUnmounter::Step");
+}
+
+ShutdownUnmounter::~ShutdownUnmounter()
+{
+}
+
+QStringList ShutdownUnmounter::run(const QStringList &mountPoints, int deadlineMs)
+{
+    const auto shared = std::make_shared<SharedResults>();
+    const UnmountOperation operation = m_unmountOperation;
+    const qint64 lazyAfter = qint64(deadlineMs) * LazyAfterPercent / 100;
+    const qint64 forceAfter = qint64(deadlineMs) * ForceAfterPercent / 100;
+
+    QHash<QString, Step> current;       // Latest step started per pending mount point
+    QSet<QString> pending;
+    QStringList remaining;
+
+    const auto launch = [this, &current, shared, operation](const QString &mountPoint, Step step) {
+        current.insert(mountPoint, step);
+        emit stepStarted(mountPoint, step);
+        // Detached: a thread stuck in the kernel must never be joined. run() waits
+        // without an event loop, so results go through the shared list instead
+        DetachedCall::run([shared, operation, mountPoint, step]() {
+            const QString error = operation(mountPoint, step);
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->results.push_back({mountPoint, step, error});
+            shared->changed.notify_all();
+        });
+    };
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    for (const QString &mountPoint : mountPoints) {
+        if (!pending.contains(mountPoint)) {
+            pending.insert(mountPoint);
+            launch(mountPoint, Step::Unmount);
+        }
+    }
+
+    while (!pending.isEmpty() && elapsed.elapsed() < deadlineMs) {
+        // Escalate whatever is still pending when its time is up
+        const qint64 now = elapsed.elapsed();
+        const Step due = now >= forceAfter ? Step::Force : now >= lazyAfter ? Step::Lazy : Step::Unmount;
+        for (const QString &mountPoint : pending) {
+            if (current.value(mountPoint) < due) {
+                launch(mountPoint, due);
+            }
+        }
+
+        const qint64 wakeAt = now < lazyAfter ? lazyAfter : now < forceAfter ? forceAfter : deadlineMs;
+        std::vector<StepResult> results;
+        {
+            std::unique_lock<std::mutex> lock(shared->mutex);
+            shared->changed.wait_for(lock, std::chrono::milliseconds(qMax<qint64>(1, wakeAt - now)),
+                                     [&shared]() { return !shared->results.empty(); });
+            results.swap(shared->results);
+        }
+
+        for (const StepResult &result : results) {
+            const bool success = result.errorMessage.isEmpty();
+            emit stepFinished(result.mountPoint, result.step, success, result.errorMessage);
+            if (!pending.contains(result.mountPoint)) {
+                continue;
+            }
+            if (success) {
+                pending.remove(result.mountPoint);
+            } else if (result.step == current.value(result.mountPoint)) {
+                // Failed outright (e.g. busy): no point in waiting for the timer
+                if (result.step == Step::Force) {
+                    pending.remove(result.mountPoint);
+                    remaining << result.mountPoint;
+                } else {
+                    launch(result.mountPoint, result.step == Step::Unmount ? Step::Lazy : Step::Force);
+                }
+            }
+        }
+    }
+
+    for (const QString &mountPoint : mountPoints) {
+        if (pending.contains(mountPoint) && !remaining.contains(mountPoint)) {
+            remaining << mountPoint;
+        }
+    }
+    if (!remaining.isEmpty()) {
+        qWarning() << "ShutdownUnmounter: still mounted after" << elapsed.elapsed() << "ms:" << remaining;
+    }
+    return remaining;
+}
+
+void ShutdownUnmounter::setUnmountOperation(const UnmountOperation &operation)
+{
+    m_unmountOperation = operation;
+}
+
+QString ShutdownUnmounter::umountCommand(const QString &mountPoint, Step step)
+{
+    const QString program = ToolRegistry::instance().resolvedPath("umount");
+    if (program.isEmpty()) {
+        return QString("Command not found: umount");
+    }
+
+    QStringList arguments;
+    if (step == Step::Lazy) {
+        arguments << "-l";
+    } else if (step == Step::Force) {
+        arguments << "-f";
+    }
+    arguments << mountPoint;
+
+    QProcess process;
+    process.start(program, arguments);
+    if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit) {
+        return process.errorString();
+    }
+    if (process.exitCode() != 0) {
+        const QString error = QString::fromUtf8(process.readAllStandardError()).trimmed();
+        return error.isEmpty() ? QString("umount %1 failed").arg(arguments.join(' ')) : error;
+    }
+    return QString();
+}
+
+} // namespace NFSShareManager
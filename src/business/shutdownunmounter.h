@@ -0,0 +1,105 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+namespace NFSShareManager {
+
+/**
+ * @brief Unmounts many mounts at exit within a fixed time
+ *
+ * An unmount of a hard NFS mount whose server is gone blocks for
+ * timeo * retrans or longer, and done one after another a dozen stale
+ * mounts would hold up logout for minutes. Every unmount therefore runs
+ * on its own detached thread, all at once, and the caller waits only
+ * until the deadline.
+ *
+ * A mount that is not gone in time, or whose unmount fails, is escalated:
+ * first to a lazy unmount (umount -l), which detaches it from the
+ * namespace at once, then to a forced one (umount -f), which aborts its
+ * outstanding RPCs. Each step is reported through stepStarted() and
+ * stepFinished(). Threads still stuck in the kernel at the deadline are
+ * abandoned.
+ *
+ * run() blocks without an event loop, so it also works from
+ * QCoreApplication::aboutToQuit, where nested event loops return at once.
+ */
+class ShutdownUnmounter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Escalation steps, in order
+     */
+    enum class Step {
+        Unmount,    ///< Plain umount
+        Lazy,       ///< umount -l
+        Force       ///< umount -f
+    };
+    Q_ENUM(Step)
+
+    /**
+     * @brief Unmounts a mount point; may block indefinitely
+     * @return Error message, or an empty string on success
+     */
+    using UnmountOperation = std::function<QString(const QString &mountPoint, Step step)>;
+
+    /// Share of the deadline after which a pending unmount is retried lazily
+    static constexpr int LazyAfterPercent = 40;
+
+    /// Share of the deadline after which a pending unmount is forced
+    static constexpr int ForceAfterPercent = 70;
+
+    explicit ShutdownUnmounter(QObject *parent = nullptr);
+    ~ShutdownUnmounter();
+
+    /**
+     * @brief Unmount all mount points concurrently; blocks until done or the deadline passed
+     * @param mountPoints The mount points to unmount
+     * @param deadlineMs Time allowed for all of them
+     * @return Mount points that are still mounted
+     */
+    QStringList run(const QStringList &mountPoints, int deadlineMs = 1000);
+
+    /**
+     * @brief Set the unmount operation
+     * @param operation The operation (default: umountCommand())
+     */
+    void setUnmountOperation(const UnmountOperation &operation);
+
+    /**
+     * @brief Run umount(8) with the flag of a step
+     *
+     * Does not use NFSServiceInterface: a thread stuck in the kernel may
+     * outlive every other object of the application.
+     *
+     * @param mountPoint The mount point
+     * @param step The escalation step
+     * @return Error message, or an empty string on success
+     */
+    static QString umountCommand(const QString &mountPoint, Step step);
+
+signals:
+    /**
+     * @brief Emitted when a step is started for a mount point
+     */
+    void stepStarted(const QString &mountPoint, ShutdownUnmounter::Step step);
+
+    /**
+     * @brief Emitted when a step has returned
+     * @param mountPoint The mount point
+     * @param step The step
+     * @param success Whether the mount point is unmounted
+     * @param errorMessage Error of a failed step
+     */
+    void stepFinished(const QString &mountPoint, ShutdownUnmounter::Step step, bool success,
+                      const QString &errorMessage);
+
+private:
+    UnmountOperation m_unmountOperation;    ///< Runs one step
+};
+
+} // namespace NFSShareManager
@@ -0,0 +1,104 @@
+#include "atomicfilewriter.h"
+#include <QFile>
+#include <QFileInfo>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace NFSShareManager {
+
+namespace {
+
+QString errnoString(const QString &what, const QString &path)
+{
+    return QString("%1 %2: %3").arg(what, path, QString::fromLocal8Bit(std::strerror(errno)));
+}
+
+void syncDirectory(const QString &dirPath)
+{
+    int fd = ::open(QFile::encodeName(dirPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+} // namespace
+
+bool AtomicFileWriter::writeFile(const QString &filePath, const QByteArray &content, QString *errorMessage)
+{
+    QFileInfo info(filePath);
+    const QString dirPath = info.absolutePath();
+    QByteArray tmpTemplate = QFile::encodeName(dirPath + "/." + info.fileName() + ".XXXXXX");
+
+    int fd = ::mkostemp(tmpTemplate.data(), O_CLOEXEC);
+    if (fd < 0) {
+        if (errorMessage) {
+            *errorMessage = errnoString("Failed to create temporary file in", dirPath);
+        }
+        return false;
+    }
+
+    // Keep the permissions of the file being replaced; default to 0644
+    struct stat st;
+    mode_t mode = (::stat(QFile::encodeName(filePath).constData(), &st) == 0) ? (st.st_mode & 07777) : 0644;
+    ::fchmod(fd, mode);
+
+    const char *data = content.constData();
+    qint64 remaining = content.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, data, static_cast<size_t>(remaining));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errorMessage) {
+                *errorMessage = errnoString("Failed to write", QFile::decodeName(tmpTemplate));
+            }
+            ::close(fd);
+            ::unlink(tmpTemplate.constData());
+            return false;
+        }
+        data += written;
+        remaining -= written;
+    }
+
+    if (::fsync(fd) != 0) {
+        if (errorMessage) {
+            *errorMessage = errnoString("Failed to sync", QFile::decodeName(tmpTemplate));
+        }
+        ::close(fd);
+        ::unlink(tmpTemplate.constData());
+        return false;
+    }
+    ::close(fd);
+
+    if (::rename(tmpTemplate.constData(), QFile::encodeName(filePath).constData()) != 0) {
+        if (errorMessage) {
+            *errorMessage = errnoString("Failed to replace", filePath);
+        }
+        ::unlink(tmpTemplate.constData());
+        return false;
+    }
+
+    syncDirectory(dirPath);
+    return true;
+}
+
+bool AtomicFileWriter::removeFile(const QString &filePath, QString *errorMessage)
+{
+    if (::unlink(QFile::encodeName(filePath).constData()) != 0 && errno != ENOENT) {
+        if (errorMessage) {
+            *errorMessage = errnoString("Failed to remove", filePath);
+        }
+        return false;
+    }
+
+    syncDirectory(QFileInfo(filePath).absolutePath());
+    return true;
+}
+
+} // namespace NFSShareManager
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+
+namespace NFSShareManager {
+
+/**
+ * @brief Crash-safe replacement of system configuration files
+ *
+ * Writes the new content to a temporary file in the same directory,
+ * fsyncs it, renames it over the destination and fsyncs the directory.
+ * Readers therefore always see either the old or the new file, never a
+ * truncated one.
+ */
+class AtomicFileWriter
+{
+public:
+    /**
+     * @brief Atomically replace (or create) a file
+     * @param filePath Destination file path
+     * @param content New file content
+     * @param errorMessage Optional output for a description of the failure
+     * @return True if the new content is durably in place
+     */
+    static bool writeFile(const QString &filePath, const QByteArray &content,
+                          QString *errorMessage = nullptr);
+
+    /**
+     * @brief Remove a file and fsync its directory
+     * @param filePath File to remove
+     * @param errorMessage Optional output for a description of the failure
+     * @return True if the file no longer exists
+     */
+    static bool removeFile(const QString &filePath, QString *errorMessage = nullptr);
+};
+
+} // namespace NFSShareManager
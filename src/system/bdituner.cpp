@@ -0,0 +1,129 @@
+#include "bdituner.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QDebug>
+
+namespace NFSShareManager {
+
+namespace {
+
+/// The kernel caps max_ratio at 100 percent; readahead has no hard cap, but beyond 1 GiB is a typo
+constexpr int MaxReadAheadKb = 1024 * 1024;
+
+} // namespace
+
+BdiTuner::BdiTuner(const QString &sysfsRoot)
+    : m_sysfsRoot(sysfsRoot)
+{
+}
+
+void BdiTuner::setSysfsRoot(const QString &sysfsRoot)
+{
+    m_sysfsRoot = sysfsRoot;
+}
+
+QString BdiTuner::sysfsRoot() const
+{
+    return m_sysfsRoot;
+}
+
+QString BdiTuner::devicePath(const QString &device) const
+{
+    return QDir(m_sysfsRoot).filePath(device);
+}
+
+bool BdiTuner::exists(const QString &device) const
+{
+    return isDeviceName(device) && QFileInfo(devicePath(device)).isDir();
+}
+
+bool BdiTuner::isDeviceName(const QString &device)
+{
+    static const QRegularExpression devicePattern(QStringLiteral("^\\d+:\\d+$"));
+    return devicePattern.match(device).hasMatch();
+}
+
+bool BdiTuner::apply(const QString &device, const BdiSettings &settings, QString *errorMessage) const
+{
+    if (!validate(settings, errorMessage)) {
+        return false;
+    }
+    if (!exists(device)) {
+        if (errorMessage) {
+            *errorMessage = QString("No backing device %1").arg(device);
+        }
+        return false;
+    }
+
+    if (settings.readAheadKb >= 0 && !writeValue(device, "read_ahead_kb", settings.readAheadKb, errorMessage)) {
+        return false;
+    }
+    if (settings.maxRatio >= 0 && !writeValue(device, "max_ratio", settings.maxRatio, errorMessage)) {
+        return false;
+    }
+    return true;
+}
+
+BdiSettings BdiTuner::current(const QString &device) const
+{
+    BdiSettings settings;
+    if (exists(device)) {
+        settings.readAheadKb = readValue(device, "read_ahead_kb");
+        settings.maxRatio = readValue(device, "max_ratio");
+    }
+    return settings;
+}
+
+bool BdiTuner::validate(const BdiSettings &settings, QString *errorMessage)
+{
+    QString problem;
+    if (settings.readAheadKb > MaxReadAheadKb) {
+        problem = QString("Readahead of %1 KiB exceeds %2 KiB").arg(settings.readAheadKb).arg(MaxReadAheadKb);
+    } else if (settings.maxRatio > 100) {
+        problem = QString("max_ratio of %1 exceeds 100 percent").arg(settings.maxRatio);
+    }
+    if (problem.isEmpty()) {
+        return true;
+    }
+    if (errorMessage) {
+        *errorMessage = problem;
+    }
+    return false;
+}
+
+bool BdiTuner::writeValue(const QString &device, const QString &name, int value, QString *errorMessage) const
+{
+    QFile file(QDir(devicePath(device)).filePath(name));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        if (errorMessage) {
+            *errorMessage = QString("Cannot open %1: %2").arg(file.fileName(), file.errorString());
+        }
+        return false;
+    }
+
+    // sysfs takes the whole value in a single write
+    const QByteArray content = QByteArray::number(value) + '\n';
+    if (file.write(content) != content.size() || !file.flush()) {
+        if (errorMessage) {
+            *errorMessage = QString("Cannot write %1: %2").arg(file.fileName(), file.errorString());
+        }
+        return false;
+    }
+    qDebug() << "BdiTuner: set" << file.fileName() << "to" << value;
+    return true;
+}
+
+int BdiTuner::readValue(const QString &device, const QString &name) const
+{
+    QFile file(QDir(devicePath(device)).filePath(name));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    bool ok = false;
+    const int value = file.readAll().trimmed().toInt(&ok);
+    return ok ? value : -1;
+}
+
+} // namespace NFSShareManager
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QString>
+
+namespace NFSShareManager {
+
+/**
+ * @brief Tunables of a backing device (BDI)
+ *
+ * A value of -1 leaves the kernel's setting alone.
+ */
+struct BdiSettings {
+    int readAheadKb = -1;   ///< read_ahead_kb: how far sequential reads are read ahead
+    int maxRatio = -1;      ///< max_ratio: share of the dirty page limit in percent (0-100)
+
+    bool isEmpty() const { return readAheadKb < 0 && maxRatio < 0; }
+
+    bool operator==(const BdiSettings &other) const {
+        return readAheadKb == other.readAheadKb && maxRatio == other.maxRatio;
+    }
+    bool operator!=(const BdiSettings &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Reads and writes backing device settings in sysfs
+ *
+ * Every NFS superblock gets its own backing device, named after the
+ * major:minor of the mount (see MountInfoEntry::device), under
+ * /sys/class/bdi. The kernel sizes its readahead from rsize, which is far
+ * too small for streaming reads over a long fat network. The device is
+ * created with the mount, so settings have to be applied again after
+ * every new mount of a share.
+ */
+class BdiTuner
+{
+public:
+    /**
+     * @brief Create a tuner for a sysfs tree
+     * @param sysfsRoot Directory holding one directory per backing device
+     */
+    explicit BdiTuner(const QString &sysfsRoot = QStringLiteral("/sys/class/bdi"));
+
+    /**
+     * @brief Set the directory holding the backing devices
+     */
+    void setSysfsRoot(const QString &sysfsRoot);
+
+    /**
+     * @brief Get the directory holding the backing devices
+     */
+    QString sysfsRoot() const;
+
+    /**
+     * @brief Get the sysfs directory of a backing device
+     * @param device major:minor, e.g. "0:52"
+     */
+    QString devicePath(const QString &device) const;
+
+    /**
+     * @brief Check if a backing device exists
+     * @param device major:minor; any other name (".", "..") is rejected
+     */
+    bool exists(const QString &device) const;
+
+    /**
+     * @brief Check that a name has the major:minor form mountinfo reports
+     *
+     * Only such a name stays inside the sysfs root when joined to it.
+     */
+    static bool isDeviceName(const QString &device);
+
+    /**
+     * @brief Write the settings that are set (not -1)
+     * @param device major:minor
+     * @param settings The settings to apply
+     * @param errorMessage Optional output for a description of the failure
+     * @return True if every set value was written
+     */
+    bool apply(const QString &device, const BdiSettings &settings, QString *errorMessage = nullptr) const;
+
+    /**
+     * @brief Read the current settings of a backing device
+     * @param device major:minor
+     * @return The settings; values that cannot be read are -1
+     */
+    BdiSettings current(const QString &device) const;
+
+    /**
+     * @brief Check that the settings are within the kernel's limits
+     * @param settings The settings to check
+     * @param errorMessage Optional output for a description of the problem
+     */
+    static bool validate(const BdiSettings &settings, QString *errorMessage = nullptr);
+
+private:
+    bool writeValue(const QString &device, const QString &name, int value, QString *errorMessage) const;
+    int readValue(const QString &device, const QString &name) const;
+
+    QString m_sysfsRoot;    ///< Usually /sys/class/bdi
+};
+
+} // namespace NFSShareManager
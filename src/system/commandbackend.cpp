@@ -0,0 +1,77 @@
+#include "commandbackend.h"
+#include "simulatedcommandbackend.h"
+#include "toolregistry.h"
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QProcess>
+
+namespace NFSShareManager {
+
+namespace {
+
+QMutex defaultBackendMutex;
+std::shared_ptr<CommandBackend> defaultBackendInstance;
+
+} // namespace
+
+std::shared_ptr<CommandBackend> CommandBackend::defaultBackend()
+{
+    QMutexLocker locker(&defaultBackendMutex);
+    if (!defaultBackendInstance) {
+        const QByteArray simulate = qgetenv("NFS_SHARE_MANAGER_SIMULATE");
+        if (!simulate.isEmpty() && simulate != "0") {
+            qWarning() << "Using the simulated NFS toolchain (NFS_SHARE_MANAGER_SIMULATE is set)";
+            defaultBackendInstance = SimulatedCommandBackend::fromSpec(QString::fromLocal8Bit(simulate));
+        } else {
+            defaultBackendInstance = std::make_shared<ProcessCommandBackend>();
+        }
+    }
+    return defaultBackendInstance;
+}
+
+void CommandBackend::setDefaultBackend(std::shared_ptr<CommandBackend> backend)
+{
+    QMutexLocker locker(&defaultBackendMutex);
+    defaultBackendInstance = std::move(backend);
+}
+
+QString ProcessCommandBackend::name() const
+{
+    return QStringLiteral("process");
+}
+
+bool ProcessCommandBackend::isAvailable(const QString &program)
+{
+    // Resolved once per process (and cached across runs) by the registry
+    return ToolRegistry::instance().isAvailable(program);
+}
+
+NFSCommandResult ProcessCommandBackend::execute(const QString &program, const QStringList &arguments, int timeout)
+{
+    const QString command = program + " " + arguments.join(" ");
+
+    // Resolve the program once through the registry instead of scanning PATH
+    const QString programPath = ToolRegistry::instance().resolvedPath(program);
+    if (programPath.isEmpty()) {
+        return NFSCommandResult(false, -1, "", QString("Command not found: %1").arg(program), command);
+    }
+
+    QProcess process;
+    process.start(programPath, arguments);
+
+    // Wait for the process to finish with timeout
+    if (!process.waitForFinished(timeout)) {
+        process.kill();
+        process.waitForFinished(1000); // Give it a second to die
+        return NFSCommandResult(false, -1, "", "Command execution timed out", command);
+    }
+
+    int exitCode = process.exitCode();
+    QString output = QString::fromUtf8(process.readAllStandardOutput());
+    QString error = QString::fromUtf8(process.readAllStandardError());
+
+    return NFSCommandResult(exitCode == 0, exitCode, output, error, command);
+}
+
+} // namespace NFSShareManager
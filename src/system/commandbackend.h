@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include "nfsserviceinterface.h"
+
+namespace NFSShareManager {
+
+/**
+ * @brief Executes the NFS command-line tools on behalf of NFSServiceInterface
+ *
+ * The default backend runs the real binaries. SimulatedCommandBackend
+ * emulates them in-process so export and mount paths can be exercised
+ * without root or a running nfsd.
+ *
+ * Implementations must be thread-safe: one backend is usually shared by
+ * every NFSServiceInterface in the process.
+ */
+class CommandBackend
+{
+public:
+    virtual ~CommandBackend() = default;
+
+    /**
+     * @brief Get a short name identifying the backend
+     */
+    virtual QString name() const = 0;
+
+    /**
+     * @brief Check if a tool can be executed
+     * @param program Tool name (e.g. "exportfs")
+     * @return True if the tool is available
+     */
+    virtual bool isAvailable(const QString &program) = 0;
+
+    /**
+     * @brief Execute a tool and wait for it to finish
+     * @param program Tool name (e.g. "exportfs")
+     * @param arguments Command arguments
+     * @param timeout Timeout in milliseconds
+     * @return Command result
+     */
+    virtual NFSCommandResult execute(const QString &program, const QStringList &arguments, int timeout) = 0;
+
+    /**
+     * @brief Get the exports file this backend's exportfs re-reads
+     * @return The file, or an empty string for the system's exports table
+     */
+    virtual QString exportsFilePath() const { return QString(); }
+
+    /**
+     * @brief Get the backend used by newly created NFSServiceInterface objects
+     *
+     * Unless one was set with setDefaultBackend(), this is the process
+     * backend, or a simulator configured from the NFS_SHARE_MANAGER_SIMULATE
+     * environment variable if it is set (see SimulatedCommandBackend::fromSpec()).
+     */
+    static std::shared_ptr<CommandBackend> defaultBackend();
+
+    /**
+     * @brief Replace the backend used by newly created NFSServiceInterface objects
+     * @param backend The backend, or nullptr to restore the built-in default
+     */
+    static void setDefaultBackend(std::shared_ptr<CommandBackend> backend);
+};
+
+/**
+ * @brief Backend that runs the real tools with QProcess
+ *
+ * Tools are resolved to absolute paths through ToolRegistry.
+ */
+class ProcessCommandBackend : public CommandBackend
+{
+public:
+    QString name() const override;
+    bool isAvailable(const QString &program) override;
+    NFSCommandResult execute(const QString &program, const QStringList &arguments, int timeout) override;
+};
+
+} // namespace NFSShareManager
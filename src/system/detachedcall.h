@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QCoreApplication>
+#include <QMetaObject>
+#include <QPointer>
+#include <thread>
+#include <utility>
+
+namespace NFSShareManager {
+
+/**
+ * @brief Runs calls that may block in the kernel forever on detached threads
+ *
+ * A statfs(), ping or umount of a hard NFS mount whose server is gone can
+ * hang without a timeout, and a thread stuck like that must never be
+ * joined: not by a thread pool's waitForDone(), not by a destructor. Such
+ * calls therefore get a thread of their own that nobody waits for, and
+ * whatever they capture must stay valid on its own (copies, shared
+ * pointers, thread-safe services that outlive the application objects).
+ */
+class DetachedCall
+{
+public:
+    /**
+     * @brief Run a call on a detached thread
+     * @param work Callable without arguments; its result is discarded
+     */
+    template<typename Work>
+    static void run(Work work)
+    {
+        std::thread(std::move(work)).detach();
+    }
+
+    /**
+     * @brief Run a call on a detached thread and post its result back
+     *
+     * @p done runs on the application's thread with the receiver and the
+     * result of @p work. It is dropped if the receiver was deleted or the
+     * application has quit by then.
+     *
+     * @param receiver Object the result is for
+     * @param work Callable without arguments returning the result
+     * @param done Callable taking (Receiver *, result)
+     */
+    template<typename Receiver, typename Work, typename Done>
+    static void run(Receiver *receiver, Work work, Done done)
+    {
+        QPointer<Receiver> guard(receiver);
+        std::thread([guard, work = std::move(work), done = std::move(done)]() {
+            auto result = work();
+
+            // Posted to the application: the receiver may be gone already
+            QCoreApplication *application = QCoreApplication::instance();
+            if (!application) {
+                return;
+            }
+            QMetaObject::invokeMethod(application, [guard, done, result]() {
+                if (guard) {
+                    done(guard.data(), result);
+                }
+            }, Qt::QueuedConnection);
+        }).detach();
+    }
+};
+
+} // namespace NFSShareManager
@@ -0,0 +1,499 @@
+#include "exportsdwriter.h"
+#include "atomicfilewriter.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSet>
+#include <QDebug>
+#include <algorithm>
+#include <utility>
+
+namespace NFSShareManager {
+
+namespace {
+
+const QString managedPrefix = QStringLiteral("nfs-share-manager-");
+const QString exportsSuffix = QStringLiteral(".exports");
+const QString managedHeader = QStringLiteral("# Managed by NFS Share Manager; changes will be overwritten\n");
+const int maxSlugLength = 64;
+
+} // namespace
+
+ExportsDWriter::ExportsDWriter(const QString &directory)
+    : m_directory(directory)
+{
+}
+
+QString ExportsDWriter::defaultDirectory()
+{
+    return QStringLiteral("/etc/exports.d");
+}
+
+QString ExportsDWriter::directory() const
+{
+    return m_directory;
+}
+
+bool ExportsDWriter::isAvailable() const
+{
+    return !m_directory.isEmpty() && QDir(m_directory).exists();
+}
+
+QString ExportsDWriter::fileNameForShare(const QString &sharePath)
+{
+    const QString path = QDir::cleanPath(sharePath);
+
+    QString slug;
+    slug.reserve(path.size());
+    for (const QChar ch : path) {
+        if (ch == '/') {
+            if (!slug.isEmpty() && !slug.endsWith('-')) {
+                slug += '-';
+            }
+        } else if (ch.isLetterOrNumber() && ch.unicode() < 128) {
+            slug += ch;
+        } else if (ch == '.' || ch == '_' || ch == '-') {
+            slug += ch;
+        } else {
+            slug += '_';
+        }
+    }
+    if (slug.endsWith('-')) {
+        slug.chop(1);
+    }
+    if (slug.size() > maxSlugLength) {
+        slug.truncate(maxSlugLength);
+    }
+    if (slug.isEmpty()) {
+        slug = QStringLiteral("root");
+    }
+
+    const QByteArray hash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Sha1).toHex().left(8);
+    return managedPrefix + slug + '-' + QString::fromLatin1(hash) + exportsSuffix;
+}
+
+QString ExportsDWriter::filePathForShare(const QString &sharePath) const
+{
+    return QDir(m_directory).filePath(fileNameForShare(sharePath));
+}
+
+QString ExportsDWriter::readShare(const QString &sharePath) const
+{
+    QFile file(filePathForShare(sharePath));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QString();
+    }
+
+    const QStringList lines = QString::fromUtf8(file.readAll()).split('\n', Qt::SkipEmptyParts);
+    for (const QString &line : lines) {
+        const QString trimmed = line.trimmed();
+        if (!trimmed.isEmpty() && !trimmed.startsWith('#')) {
+            return trimmed;
+        }
+    }
+    return QString();
+}
+
+bool ExportsDWriter::writeShare(const QString &sharePath, const QString &exportLine,
+                                bool *changed, QString *errorMessage)
+{
+    if (changed) {
+        *changed = false;
+    }
+
+    const QString line = exportLine.trimmed();
+    if (exportPathOfLine(line) != QDir::cleanPath(sharePath)) {
+        if (errorMessage) {
+            *errorMessage = QString("Export line does not match share path %1").arg(sharePath);
+        }
+        return false;
+    }
+
+    if (readShare(sharePath) == line) {
+        return true;
+    }
+
+    const QByteArray content = (managedHeader + line + '\n').toUtf8();
+    if (!AtomicFileWriter::writeFile(filePathForShare(sharePath), content, errorMessage)) {
+        return false;
+    }
+
+    if (changed) {
+        *changed = true;
+    }
+    return true;
+}
+
+bool ExportsDWriter::removeShare(const QString &sharePath, QString *errorMessage)
+{
+    return AtomicFileWriter::removeFile(filePathForShare(sharePath), errorMessage);
+}
+
+QHash<QString, QString> ExportsDWriter::readAll() const
+{
+    QHash<QString, QString> shares;
+
+    const QDir dir(m_directory);
+    const QStringList files = dir.entryList({managedPrefix + "*" + exportsSuffix}, QDir::Files);
+    for (const QString &fileName : files) {
+        QFile file(dir.filePath(fileName));
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qWarning() << "Failed to read" << file.fileName() << ":" << file.errorString();
+            continue;
+        }
+
+        const QStringList lines = QString::fromUtf8(file.readAll()).split('\n', Qt::SkipEmptyParts);
+        for (const QString &line : lines) {
+            const QString trimmed = line.trimmed();
+            if (!trimmed.isEmpty() && !trimmed.startsWith('#')) {
+                shares.insert(exportPathOfLine(trimmed), trimmed);
+                break;
+            }
+        }
+    }
+
+    return shares;
+}
+
+ExportsDSyncResult ExportsDWriter::sync(const QHash<QString, QString> &exportLines)
+{
+    ExportsDSyncResult result;
+    const QHash<QString, QString> current = readAll();
+
+    for (auto it = exportLines.constBegin(); it != exportLines.constEnd(); ++it) {
+        const QString path = QDir::cleanPath(it.key());
+        if (current.value(path) == it.value().trimmed()) {
+            result.unchanged++;
+            continue;
+        }
+
+        bool changed = false;
+        if (!writeShare(path, it.value(), &changed, &result.error)) {
+            return result;
+        }
+        result.written << path;
+    }
+
+    QSet<QString> wanted;
+    for (auto it = exportLines.constBegin(); it != exportLines.constEnd(); ++it) {
+        wanted.insert(QDir::cleanPath(it.key()));
+    }
+    for (auto it = current.constBegin(); it != current.constEnd(); ++it) {
+        if (wanted.contains(it.key())) {
+            continue;
+        }
+        if (!removeShare(it.key(), &result.error)) {
+            return result;
+        }
+        result.removed << it.key();
+    }
+
+    result.success = true;
+    return result;
+}
+
+QList<QStringList> ExportsDWriter::reexportCommands(const QString &oldLine, const QString &newLine)
+{
+    QList<QStringList> commands;
+
+    const QString oldPath = exportPathOfLine(oldLine);
+    const QString newPath = exportPathOfLine(newLine);
+    const QList<QPair<QString, QString>> oldClients = clientsOfLine(oldLine);
+    const QList<QPair<QString, QString>> newClients = clientsOfLine(newLine);
+
+    for (const auto &client : oldClients) {
+        bool kept = oldPath == newPath;
+        if (kept) {
+            kept = std::any_of(newClients.cbegin(), newClients.cend(), [&client](const auto &c) {
+                return c.first == client.first;
+            });
+        }
+        if (!kept) {
+            commands << QStringList({"-u", client.first + ':' + oldPath});
+        }
+    }
+
+    for (const auto &client : newClients) {
+        QStringList args = {"-i"};
+        if (!client.second.isEmpty()) {
+            args << "-o" << client.second;
+        }
+        args << client.first + ':' + newPath;
+        commands << args;
+    }
+
+    return commands;
+}
+
+QString ExportsDWriter::exportPathOfLine(const QString &exportLine)
+{
+    const QString trimmed = exportLine.trimmed();
+    if (trimmed.isEmpty() || trimmed.startsWith('#')) {
+        return QString();
+    }
+
+    if (trimmed.startsWith('"')) {
+        const int end = trimmed.indexOf('"', 1);
+        return QDir::cleanPath(end > 0 ? trimmed.mid(1, end - 1) : trimmed.mid(1));
+    }
+    return QDir::cleanPath(trimmed.section(QRegularExpression("\\s+"), 0, 0));
+}
+
+QList<QPair<QString, QString>> ExportsDWriter::clientsOfLine(const QString &exportLine)
+{
+    static const QRegularExpression whitespace("\\s+");
+
+    QList<QPair<QString, QString>> clients;
+    QString trimmed = exportLine.trimmed();
+    if (trimmed.isEmpty() || trimmed.startsWith('#')) {
+        return clients;
+    }
+
+    // Drop the path, quoted or not
+    if (trimmed.startsWith('"')) {
+        const int end = trimmed.indexOf('"', 1);
+        trimmed = end > 0 ? trimmed.mid(end + 1) : QString();
+    } else {
+        const int end = trimmed.indexOf(whitespace);
+        trimmed = end > 0 ? trimmed.mid(end) : QString();
+    }
+
+    const QStringList specs = trimmed.split(whitespace, Qt::SkipEmptyParts);
+    for (const QString &spec : specs) {
+        const int open = spec.indexOf('(');
+        QString client = open < 0 ? spec : spec.left(open);
+        QString options;
+        if (open >= 0) {
+            const int close = spec.lastIndexOf(')');
+            options = spec.mid(open + 1, close > open ? close - open - 1 : -1);
+        }
+        if (client.isEmpty()) {
+            client = "*";
+        }
+        clients.append(qMakePair(client, options));
+    }
+    return clients;
+}
+
+ExportTransaction::ExportTransaction(const QString &exportsFile, const QString &directory,
+                                     ExportfsRunner runExportfs)
+    : m_exportsFile(exportsFile)
+    , m_writer(directory)
+    , m_useDirectory(!directory.isEmpty())
+    , m_runExportfs(std::move(runExportfs))
+{
+}
+
+bool ExportTransaction::load(QString *errorMessage)
+{
+    if (m_useDirectory && !m_writer.isAvailable()) {
+        if (errorMessage) {
+            *errorMessage = QString("Exports directory %1 does not exist").arg(m_writer.directory());
+        }
+        return false;
+    }
+
+    // A missing exports table is an empty one
+    m_tableContent.clear();
+    QFile file(m_exportsFile);
+    if (file.exists()) {
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            if (errorMessage) {
+                *errorMessage = QString("Failed to read %1: %2").arg(m_exportsFile, file.errorString());
+            }
+            return false;
+        }
+        m_tableContent = QString::fromUtf8(file.readAll());
+    }
+
+    m_records.clear();
+    const QStringList lines = m_tableContent.split('\n');
+    QString pending;
+    for (int i = 0; i < lines.size(); ++i) {
+        const QString &line = lines[i];
+        if (i == lines.size() - 1 && line.isEmpty()) {
+            break; // Trailing newline
+        }
+
+        pending += line;
+        if (line.endsWith('\\') && i < lines.size() - 1) {
+            pending += '\n';
+            continue;
+        }
+
+        Record record;
+        record.text = pending;
+        record.path = ExportsDWriter::exportPathOfLine(pending);
+        m_records << record;
+        pending.clear();
+    }
+
+    m_files = m_useDirectory ? m_writer.readAll() : QHash<QString, QString>();
+    return true;
+}
+
+QString ExportTransaction::currentLine(const QString &sharePath) const
+{
+    const QString path = QDir::cleanPath(sharePath);
+    const QString fileLine = m_files.value(path);
+    if (!fileLine.isEmpty()) {
+        return fileLine;
+    }
+    for (const Record &record : m_records) {
+        if (record.path == path) {
+            return QString(record.text).replace("\\\n", " ");
+        }
+    }
+    return QString();
+}
+
+void ExportTransaction::setShare(const QString &sharePath, const QString &exportLine)
+{
+    const QString path = QDir::cleanPath(sharePath);
+    if (!m_staged.contains(path)) {
+        m_order << path;
+    }
+    m_staged.insert(path, exportLine.trimmed());
+}
+
+bool ExportTransaction::rewritesTable() const
+{
+    if (!m_useDirectory) {
+        return !m_order.isEmpty();
+    }
+    return std::any_of(m_records.cbegin(), m_records.cend(), [this](const Record &record) {
+        return !record.path.isEmpty() && m_staged.contains(record.path);
+    });
+}
+
+QString ExportTransaction::stagedTable() const
+{
+    // A staged share replaces its first entry in place and drops any other;
+    // with a directory its file holds it, so the table keeps none
+    QString content;
+    QSet<QString> written;
+    for (const Record &record : m_records) {
+        if (record.path.isEmpty() || !m_staged.contains(record.path)) {
+            content += record.text + '\n';
+            continue;
+        }
+        const QString line = m_staged.value(record.path);
+        if (!m_useDirectory && !line.isEmpty() && !written.contains(record.path)) {
+            content += line + '\n';
+            written.insert(record.path);
+        }
+    }
+
+    if (!m_useDirectory) {
+        for (const QString &path : m_order) {
+            const QString line = m_staged.value(path);
+            if (!line.isEmpty() && !written.contains(path)) {
+                content += line + '\n';
+            }
+        }
+    }
+    return content;
+}
+
+ExportTransactionResult ExportTransaction::commit()
+{
+    ExportTransactionResult result;
+    if (m_order.isEmpty()) {
+        result.success = true;
+        return result;
+    }
+
+    // sync() only writes or removes the files of shares that changed
+    bool filesWritten = false;
+    if (m_useDirectory) {
+        QHash<QString, QString> files = m_files;
+        for (const QString &path : m_order) {
+            const QString line = m_staged.value(path);
+            if (line.isEmpty()) {
+                files.remove(path);
+            } else {
+                files.insert(path, line);
+            }
+        }
+
+        const ExportsDSyncResult synced = m_writer.sync(files);
+        filesWritten = !synced.written.isEmpty() || !synced.removed.isEmpty();
+        if (!synced.success) {
+            result.error = QString("Failed to update exports directory %1: %2").arg(m_writer.directory(), synced.error);
+            return rollBack(result, filesWritten, false, false);
+        }
+    }
+
+    // Migrated shares leave the table for good, or the next exportfs -r would bring them back
+    bool tableWritten = false;
+    if (rewritesTable()) {
+        QString error;
+        if (!AtomicFileWriter::writeFile(m_exportsFile, stagedTable().toUtf8(), &error)) {
+            result.error = QString("Failed to write %1: %2").arg(m_exportsFile, error);
+            return rollBack(result, filesWritten, false, false);
+        }
+        tableWritten = true;
+    }
+
+    if (!reexport(&result.error)) {
+        result.reexportFailed = true;
+        return rollBack(result, filesWritten, tableWritten, true);
+    }
+
+    result.success = true;
+    return result;
+}
+
+bool ExportTransaction::reexport(QString *errorMessage)
+{
+    // Re-export only the touched shares; past a point one full reload is cheaper
+    if (m_order.size() > ExportsDWriter::maxTargetedReexports) {
+        return m_runExportfs({"-r"}, errorMessage);
+    }
+
+    for (const QString &path : m_order) {
+        const QList<QStringList> commands = ExportsDWriter::reexportCommands(currentLine(path), m_staged.value(path));
+        for (const QStringList &args : commands) {
+            if (!m_runExportfs(args, errorMessage)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+ExportTransactionResult ExportTransaction::rollBack(ExportTransactionResult result, bool filesWritten,
+                                                    bool tableWritten, bool reexported)
+{
+    if (!filesWritten && !tableWritten) {
+        return result;
+    }
+
+    bool restored = true;
+    if (filesWritten) {
+        const ExportsDSyncResult synced = m_writer.sync(m_files);
+        if (!synced.success) {
+            qWarning() << "Failed to restore export files in" << m_writer.directory() << ":" << synced.error;
+            restored = false;
+        }
+    }
+
+    QString error;
+    if (tableWritten && !AtomicFileWriter::writeFile(m_exportsFile, m_tableContent.toUtf8(), &error)) {
+        qWarning() << "Failed to restore exports table" << m_exportsFile << ":" << error;
+        restored = false;
+    }
+
+    // The re-export may have stopped half way, so the restored files are re-read as a whole
+    if (restored && reexported && !m_runExportfs({"-r"}, &error)) {
+        qWarning() << "Failed to restore the kernel export table:" << error;
+        restored = false;
+    }
+
+    result.rolledBack = restored;
+    result.restoreFailed = !restored;
+    return result;
+}
+
+} // namespace NFSShareManager
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+namespace NFSShareManager {
+
+/**
+ * @brief Outcome of ExportsDWriter::sync()
+ */
+struct ExportsDSyncResult {
+    bool success;           ///< Whether every file operation succeeded
+    QString error;          ///< Description of the first failure
+    QStringList written;    ///< Shares whose file was created or replaced
+    QStringList removed;    ///< Shares whose file was deleted
+    int unchanged;          ///< Shares whose file already had the right content
+
+    ExportsDSyncResult() : success(false), unchanged(0) {}
+};
+
+/**
+ * @brief Manages one exports(5) file per share under /etc/exports.d
+ *
+ * exportfs reads every "*.exports" file in /etc/exports.d in addition to
+ * /etc/exports. Keeping each share in a file of its own means creating,
+ * changing or removing a share is a single atomic file operation
+ * (AtomicFileWriter), however many shares exist, and nothing ever
+ * rewrites or appends to /etc/exports.
+ *
+ * Files written here carry a fixed prefix so foreign files in the
+ * directory are never touched.
+ */
+class ExportsDWriter
+{
+public:
+    /// Batches with more changes than this are re-exported with one "exportfs -r"
+    static constexpr int maxTargetedReexports = 32;
+
+    /**
+     * @brief Create a writer for a directory
+     * @param directory The exports.d directory (default: /etc/exports.d)
+     */
+    explicit ExportsDWriter(const QString &directory = defaultDirectory());
+
+    /**
+     * @brief Get the system exports.d directory
+     */
+    static QString defaultDirectory();
+
+    /**
+     * @brief Get the managed directory
+     */
+    QString directory() const;
+
+    /**
+     * @brief Check if the managed directory exists
+     */
+    bool isAvailable() const;
+
+    /**
+     * @brief Get the file name used for a share
+     *
+     * A readable slug of the path plus a hash of the full path, so
+     * different paths never collide, e.g.
+     * "nfs-share-manager-srv-data-1a2b3c4d.exports".
+     *
+     * @param sharePath Exported directory
+     */
+    static QString fileNameForShare(const QString &sharePath);
+
+    /**
+     * @brief Get the full path of the file used for a share
+     */
+    QString filePathForShare(const QString &sharePath) const;
+
+    /**
+     * @brief Read the export line stored for a share
+     * @param sharePath Exported directory
+     * @return The exports(5) line, or empty if the share has no file
+     */
+    QString readShare(const QString &sharePath) const;
+
+    /**
+     * @brief Write the file of one share if its content differs
+     *
+     * A building block of sync(); everything else goes through sync() so
+     * it stays the only place that creates or deletes managed files.
+     *
+     * @param sharePath Exported directory
+     * @param exportLine Complete exports(5) line
+     * @param changed Optional output: false if the file was already up to date
+     * @param errorMessage Optional output for a description of the failure
+     * @return True if the file holds the line
+     */
+    bool writeShare(const QString &sharePath, const QString &exportLine,
+                    bool *changed = nullptr, QString *errorMessage = nullptr);
+
+    /**
+     * @brief Remove the file of one share; a building block of sync()
+     * @param sharePath Exported directory
+     * @param errorMessage Optional output for a description of the failure
+     * @return True if the share no longer has a file
+     */
+    bool removeShare(const QString &sharePath, QString *errorMessage = nullptr);
+
+    /**
+     * @brief Read all managed files
+     * @return Export line by exported directory
+     */
+    QHash<QString, QString> readAll() const;
+
+    /**
+     * @brief Make the managed files match a set of shares
+     *
+     * Only files whose content differs are written, and only files of
+     * shares no longer in the set are removed.
+     *
+     * @param exportLines Export line by exported directory
+     * @return Which files were written or removed
+     */
+    ExportsDSyncResult sync(const QHash<QString, QString> &exportLines);
+
+    /**
+     * @brief Get the exportfs invocations that move the kernel from one line to another
+     *
+     * Clients only present in the old line are unexported with
+     * "exportfs -u client:path"; every client of the new line is
+     * (re)exported with "exportfs -i -o options client:path". An empty new
+     * line unexports the share, an empty old line exports it.
+     *
+     * @param oldLine Previous exports(5) line, or empty
+     * @param newLine New exports(5) line, or empty
+     * @return Argument lists for exportfs, in execution order
+     */
+    static QList<QStringList> reexportCommands(const QString &oldLine, const QString &newLine);
+
+    /**
+     * @brief Get the exported directory of an exports(5) line
+     */
+    static QString exportPathOfLine(const QString &exportLine);
+
+private:
+    /**
+     * @brief Split an exports(5) line into its client specifications
+     * @return Options by client; "*" for a bare "(options)" specification
+     */
+    static QList<QPair<QString, QString>> clientsOfLine(const QString &exportLine);
+
+    QString m_directory;    ///< Managed exports.d directory
+};
+
+/**
+ * @brief Outcome of ExportTransaction::commit()
+ */
+struct ExportTransactionResult {
+    bool success;           ///< Whether every share was written and re-exported
+    bool reexportFailed;    ///< Whether exportfs failed, rather than a file operation
+    bool rolledBack;        ///< Whether files and kernel table were restored after a failure
+    bool restoreFailed;     ///< Whether changes were made and could not all be undone
+    QString error;          ///< Description of the first failure
+
+    ExportTransactionResult() : success(false), reexportFailed(false), rolledBack(false), restoreFailed(false) {}
+};
+
+/**
+ * @brief Applies a batch of share changes to the exports files and the kernel, all or nothing
+ *
+ * With an exports.d directory every share has a file of its own, written
+ * and restored with ExportsDWriter::sync(), and touched shares still
+ * listed in the exports table are migrated out of it. Without one, the lines of the exports table are
+ * replaced, dropped or appended in place. The touched shares are then
+ * re-exported one by one, or with a single "exportfs -r" past
+ * ExportsDWriter::maxTargetedReexports. If anything fails, the previous
+ * files are restored and re-exported as a whole.
+ *
+ * NFSServiceInterface and PolicyKitHelper both apply share batches
+ * through this class; they only differ in how exportfs is run.
+ */
+class ExportTransaction
+{
+public:
+    /// Runs exportfs with the given arguments; on failure returns false and describes why
+    using ExportfsRunner = std::function<bool(const QStringList &arguments, QString *errorMessage)>;
+
+    /**
+     * @brief Create a transaction
+     * @param exportsFile The exports table; with a directory, the table shares are migrated out of
+     * @param directory The exports.d directory, or empty to keep every share in the exports table
+     * @param runExportfs Runs exportfs
+     */
+    ExportTransaction(const QString &exportsFile, const QString &directory, ExportfsRunner runExportfs);
+
+    /**
+     * @brief Read the exports table and the current line of every share
+     * @param errorMessage Optional output for a description of the failure
+     * @return False if the directory is missing or the table cannot be read
+     */
+    bool load(QString *errorMessage = nullptr);
+
+    /**
+     * @brief Get the line a share has before the transaction
+     * @param sharePath Exported directory
+     * @return The exports(5) line from its file or the exports table, or empty if not exported
+     */
+    QString currentLine(const QString &sharePath) const;
+
+    /**
+     * @brief Stage the new line of a share
+     *
+     * A later call for the same share replaces the earlier one.
+     *
+     * @param sharePath Exported directory
+     * @param exportLine Complete exports(5) line, or empty to remove the share
+     */
+    void setShare(const QString &sharePath, const QString &exportLine);
+
+    /**
+     * @brief Check if commit() rewrites the exports table
+     */
+    bool rewritesTable() const;
+
+    /**
+     * @brief Write and re-export every staged share
+     *
+     * load() must have succeeded first. A failure before anything was
+     * written leaves the system untouched and ExportTransactionResult::rolledBack
+     * unset.
+     */
+    ExportTransactionResult commit();
+
+private:
+    /**
+     * @brief One logical entry of the exports table (continuation lines joined)
+     */
+    struct Record {
+        QString text;           ///< Original text, including any continuation lines
+        QString path;           ///< Exported path, empty for comments and blank lines
+    };
+
+    /**
+     * @brief Get the exports table content with the staged changes applied
+     */
+    QString stagedTable() const;
+
+    /**
+     * @brief Re-export the staged shares, or reload everything for large batches
+     */
+    bool reexport(QString *errorMessage);
+
+    /**
+     * @brief Put back the files and table of a failed commit and re-read them
+     * @param result Result of the failed commit
+     * @param filesWritten Whether any share file was written or removed
+     * @param tableWritten Whether the exports table was rewritten
+     * @param reexported Whether exportfs already ran
+     * @return The result with rolledBack or restoreFailed set
+     */
+    ExportTransactionResult rollBack(ExportTransactionResult result, bool filesWritten,
+                                     bool tableWritten, bool reexported);
+
+    QString m_exportsFile;                  ///< Exports table
+    ExportsDWriter m_writer;                ///< Per-share files, if a directory was given
+    bool m_useDirectory;                    ///< Whether shares live in the exports.d directory
+    ExportfsRunner m_runExportfs;           ///< Runs exportfs
+    QString m_tableContent;                 ///< Exports table as loaded
+    QList<Record> m_records;                ///< Entries of the exports table as loaded
+    QHash<QString, QString> m_files;        ///< Line of each share file as loaded
+    QStringList m_order;                    ///< Staged shares, in staging order
+    QHash<QString, QString> m_staged;       ///< New line of each staged share
+};
+
+} // namespace NFSShareManager
@@ -0,0 +1,274 @@
+#include "fstabfile.h"
+#include "atomicfilewriter.h"
+#include "octalescape.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QDebug>
+
+namespace NFSShareManager {
+
+namespace {
+
+QString indexKey(const QString &mountPoint)
+{
+    return QDir::cleanPath(mountPoint);
+}
+
+} // namespace
+
+FstabFile::FstabFile(const QString &filePath)
+    : m_filePath(filePath)
+    , m_loaded(false)
+    , m_modified(false)
+    , m_trailingNewline(true)
+    , m_size(-1)
+{
+}
+
+QString FstabFile::defaultPath()
+{
+    return QStringLiteral("/etc/fstab");
+}
+
+QString FstabFile::filePath() const
+{
+    return m_filePath;
+}
+
+void FstabFile::setFilePath(const QString &filePath)
+{
+    m_filePath = filePath;
+    m_lines.clear();
+    m_index.clear();
+    m_loaded = false;
+    m_modified = false;
+    m_trailingNewline = true;
+    m_lastModified = QDateTime();
+    m_size = -1;
+}
+
+bool FstabFile::load(QString *errorMessage)
+{
+    QByteArray content;
+    QFile file(m_filePath);
+    if (file.exists()) {
+        if (!file.open(QIODevice::ReadOnly)) {
+            if (errorMessage) {
+                *errorMessage = file.errorString();
+            }
+            qWarning() << "FstabFile: cannot read" << m_filePath << file.errorString();
+            return false;
+        }
+        content = file.readAll();
+    }
+
+    parse(content);
+    m_loaded = true;
+    rememberFileState();
+    return true;
+}
+
+bool FstabFile::reloadIfChanged()
+{
+    if (!m_loaded) {
+        return load();
+    }
+
+    const QFileInfo info(m_filePath);
+    const QDateTime lastModified = info.exists() ? info.lastModified() : QDateTime();
+    const qint64 size = info.exists() ? info.size() : -1;
+    if (lastModified == m_lastModified && size == m_size) {
+        return true;
+    }
+    qDebug() << "FstabFile:" << m_filePath << "changed on disk, re-reading";
+    return load();
+}
+
+void FstabFile::parse(const QByteArray &content)
+{
+    m_lines.clear();
+    m_modified = false;
+
+    QStringList lines = QString::fromUtf8(content).split('\n');
+    m_trailingNewline = content.isEmpty() || content.endsWith('\n');
+    if (content.isEmpty() || m_trailingNewline) {
+        lines.removeLast();
+    }
+
+    m_lines.reserve(lines.size());
+    for (const QString &text : lines) {
+        Line line;
+        line.text = text;
+        line.isEntry = parseLine(text, &line.entry);
+        m_lines.append(line);
+    }
+    rebuildIndex();
+}
+
+QByteArray FstabFile::serialize() const
+{
+    QString content;
+    for (int i = 0; i < m_lines.size(); ++i) {
+        content += m_lines[i].text;
+        if (i + 1 < m_lines.size() || m_trailingNewline) {
+            content += '\n';
+        }
+    }
+    return content.toUtf8();
+}
+
+bool FstabFile::save(QString *errorMessage)
+{
+    if (!m_modified) {
+        return true;
+    }
+
+    QString error;
+    if (!AtomicFileWriter::writeFile(m_filePath, serialize(), &error)) {
+        if (errorMessage) {
+            *errorMessage = error;
+        }
+        qWarning() << "FstabFile: cannot write" << m_filePath << error;
+        return false;
+    }
+    m_modified = false;
+    m_loaded = true;
+    rememberFileState();
+    return true;
+}
+
+bool FstabFile::isModified() const
+{
+    return m_modified;
+}
+
+bool FstabFile::contains(const QString &mountPoint) const
+{
+    return m_index.contains(indexKey(mountPoint));
+}
+
+FstabEntry FstabFile::entry(const QString &mountPoint) const
+{
+    const int line = m_index.value(indexKey(mountPoint), -1);
+    return line >= 0 ? m_lines[line].entry : FstabEntry();
+}
+
+QList<FstabEntry> FstabFile::entries() const
+{
+    QList<FstabEntry> result;
+    for (const Line &line : m_lines) {
+        if (line.isEntry) {
+            result << line.entry;
+        }
+    }
+    return result;
+}
+
+bool FstabFile::setEntry(const FstabEntry &entry)
+{
+    const QString key = indexKey(entry.mountPoint);
+    const int first = m_index.value(key, -1);
+    if (first < 0) {
+        Line line;
+        line.text = formatLine(entry);
+        line.isEntry = true;
+        line.entry = entry;
+        m_lines.append(line);
+        m_index.insert(key, m_lines.size() - 1);
+        m_trailingNewline = true;
+        m_modified = true;
+        return true;
+    }
+
+    // Drop duplicates below the first entry, then rewrite it in place
+    bool changed = false;
+    for (int i = m_lines.size() - 1; i > first; --i) {
+        if (m_lines[i].isEntry && indexKey(m_lines[i].entry.mountPoint) == key) {
+            m_lines.removeAt(i);
+            changed = true;
+        }
+    }
+    if (m_lines[first].entry != entry) {
+        m_lines[first].text = formatLine(entry);
+        m_lines[first].entry = entry;
+        changed = true;
+    }
+    if (changed) {
+        rebuildIndex();
+        m_modified = true;
+    }
+    return changed;
+}
+
+bool FstabFile::removeEntry(const QString &mountPoint)
+{
+    const QString key = indexKey(mountPoint);
+    if (!m_index.contains(key)) {
+        return false;
+    }
+
+    for (int i = m_lines.size() - 1; i >= 0; --i) {
+        if (m_lines[i].isEntry && indexKey(m_lines[i].entry.mountPoint) == key) {
+            m_lines.removeAt(i);
+        }
+    }
+    rebuildIndex();
+    m_modified = true;
+    return true;
+}
+
+bool FstabFile::parseLine(const QString &line, FstabEntry *entry)
+{
+    // server:/export /mnt/point nfs rw,hard,_netdev 0 0
+    static const QRegularExpression whitespace("\\s+");
+
+    const QString trimmed = line.trimmed();
+    if (trimmed.isEmpty() || trimmed.startsWith('#')) {
+        return false;
+    }
+    const QStringList fields = trimmed.split(whitespace, Qt::SkipEmptyParts);
+    if (fields.size() < 3) {
+        return false;
+    }
+
+    FstabEntry parsed(OctalEscape::unescape(fields[0]), OctalEscape::unescape(fields[1]), fields[2],
+                      fields.size() > 3 ? fields[3].split(',', Qt::SkipEmptyParts) : QStringList());
+    parsed.dump = fields.size() > 4 ? fields[4].toInt() : 0;
+    parsed.pass = fields.size() > 5 ? fields[5].toInt() : 0;
+    if (entry) {
+        *entry = parsed;
+    }
+    return true;
+}
+
+QString FstabFile::formatLine(const FstabEntry &entry)
+{
+    const QStringList fields = {OctalEscape::escape(entry.source), OctalEscape::escape(entry.mountPoint),
+                                entry.type, entry.options.isEmpty() ? QString("defaults") : entry.options.join(','),
+                                QString::number(entry.dump), QString::number(entry.pass)};
+    return fields.join(' ');
+}
+
+void FstabFile::rebuildIndex()
+{
+    m_index.clear();
+    for (int i = 0; i < m_lines.size(); ++i) {
+        if (m_lines[i].isEntry) {
+            const QString key = indexKey(m_lines[i].entry.mountPoint);
+            if (!m_index.contains(key)) {
+                m_index.insert(key, i);
+            }
+        }
+    }
+}
+
+void FstabFile::rememberFileState()
+{
+    const QFileInfo info(m_filePath);
+    m_lastModified = info.exists() ? info.lastModified() : QDateTime();
+    m_size = info.exists() ? info.size() : -1;
+}
+
+} // namespace NFSShareManager
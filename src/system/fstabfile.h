@@ -0,0 +1,185 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+namespace NFSShareManager {
+
+/**
+ * @brief One mount line of fstab(5)
+ */
+struct FstabEntry {
+    QString source;         ///< Device or "server:/export"
+    QString mountPoint;     ///< Mount point, unescaped
+    QString type;           ///< File system type
+    QStringList options;    ///< Mount options
+    int dump;               ///< dump(8) frequency
+    int pass;               ///< fsck(8) pass number
+
+    FstabEntry() : dump(0), pass(0) {}
+    FstabEntry(const QString &src, const QString &target, const QString &fsType,
+               const QStringList &opts, int dumpFrequency = 0, int passNumber = 0)
+        : source(src), mountPoint(target), type(fsType), options(opts), dump(dumpFrequency), pass(passNumber) {}
+
+    /**
+     * @brief Check if the entry is an NFS mount
+     */
+    bool isNFS() const { return type == "nfs" || type == "nfs4"; }
+
+    bool operator==(const FstabEntry &other) const {
+        return source == other.source && mountPoint == other.mountPoint && type == other.type &&
+               options == other.options && dump == other.dump && pass == other.pass;
+    }
+    bool operator!=(const FstabEntry &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Lossless, mount point indexed view of an fstab file
+ *
+ * Every line is kept as read, so comments, blank lines, column alignment
+ * and ordering survive a load/save round trip byte for byte. Only lines
+ * that are changed through setEntry() are reformatted; removed lines are
+ * dropped and new entries are appended at the end.
+ *
+ * Lookups by mount point are O(1). reloadIfChanged() re-parses only when
+ * the file's modification time or size changed, so callers can check it
+ * before every lookup at the cost of a stat(). save() replaces the file
+ * atomically (AtomicFileWriter).
+ */
+class FstabFile
+{
+public:
+    /**
+     * @brief Create a view of an fstab file; nothing is read yet
+     * @param filePath The file (default: /etc/fstab)
+     */
+    explicit FstabFile(const QString &filePath = defaultPath());
+
+    /**
+     * @brief Get the system fstab path
+     */
+    static QString defaultPath();
+
+    /**
+     * @brief Get the file path
+     */
+    QString filePath() const;
+
+    /**
+     * @brief Point the view at another file and drop the cached parse
+     */
+    void setFilePath(const QString &filePath);
+
+    /**
+     * @brief Read and parse the file; a missing file is an empty table
+     * @param errorMessage Optional output for a description of the failure
+     * @return False if the file exists but cannot be read
+     */
+    bool load(QString *errorMessage = nullptr);
+
+    /**
+     * @brief Re-read the file if it changed since the last load or save
+     *
+     * Unsaved edits are discarded when the file is re-read.
+     *
+     * @return False if the file exists but cannot be read
+     */
+    bool reloadIfChanged();
+
+    /**
+     * @brief Replace the table with parsed content
+     * @param content fstab(5) content
+     */
+    void parse(const QByteArray &content);
+
+    /**
+     * @brief Get the content with all edits applied
+     */
+    QByteArray serialize() const;
+
+    /**
+     * @brief Atomically write the table if it has unsaved edits
+     * @param errorMessage Optional output for a description of the failure
+     * @return True if the file holds the current table
+     */
+    bool save(QString *errorMessage = nullptr);
+
+    /**
+     * @brief Check if there are unsaved edits
+     */
+    bool isModified() const;
+
+    /**
+     * @brief Check if a mount point has an entry
+     * @param mountPoint The mount point
+     */
+    bool contains(const QString &mountPoint) const;
+
+    /**
+     * @brief Get the entry of a mount point
+     * @param mountPoint The mount point
+     * @return The entry, or a default entry if there is none
+     */
+    FstabEntry entry(const QString &mountPoint) const;
+
+    /**
+     * @brief Get all entries in file order
+     */
+    QList<FstabEntry> entries() const;
+
+    /**
+     * @brief Add or replace the entry of a mount point
+     *
+     * An existing entry is rewritten in place; further entries for the
+     * same mount point are removed. Setting an identical entry is a no-op.
+     *
+     * @param entry The entry
+     * @return True if the table changed
+     */
+    bool setEntry(const FstabEntry &entry);
+
+    /**
+     * @brief Remove every entry of a mount point
+     * @param mountPoint The mount point
+     * @return True if the table changed
+     */
+    bool removeEntry(const QString &mountPoint);
+
+    /**
+     * @brief Parse one fstab line
+     * @param line The line
+     * @param entry Output for the entry
+     * @return False for comments, blank and malformed lines
+     */
+    static bool parseLine(const QString &line, FstabEntry *entry);
+
+    /**
+     * @brief Format an entry as an fstab line, escaping blanks as \\040
+     */
+    static QString formatLine(const FstabEntry &entry);
+
+private:
+    struct Line {
+        QString text;           ///< Line as read or formatted
+        bool isEntry = false;   ///< Whether the line is a mount entry
+        FstabEntry entry;       ///< Parsed entry (isEntry only)
+    };
+
+    void rebuildIndex();
+    void rememberFileState();
+
+    QString m_filePath;             ///< fstab file
+    QList<Line> m_lines;            ///< All lines in file order
+    QHash<QString, int> m_index;    ///< Line of the first entry per cleaned mount point
+    bool m_loaded;                  ///< Whether the file was read
+    bool m_modified;                ///< Whether there are unsaved edits
+    bool m_trailingNewline;         ///< Whether the content ended with a newline
+    QDateTime m_lastModified;       ///< Modification time at the last load or save
+    qint64 m_size;                  ///< Size at the last load or save
+};
+
+} // namespace NFSShareManager
@@ -0,0 +1,400 @@
+#include "mountstatistics.h"
+#include "octalescape.h"
+#include <QDebug>
+#include <QFile>
+
+#include <cstring>
+
+namespace NFSShareManager {
+
+namespace {
+
+struct OpName {
+    const char *name;
+    NFSOperation operation;
+};
+
+// NFSv3 and NFSv4 operation names mapped onto the tracked operations
+const OpName opNames[] = {
+    {"READ", NFSOperation::Read},
+    {"WRITE", NFSOperation::Write},
+    {"COMMIT", NFSOperation::Commit},
+    {"GETATTR", NFSOperation::Getattr},
+    {"SETATTR", NFSOperation::Setattr},
+    {"LOOKUP", NFSOperation::Lookup},
+    {"LOOKUP_ROOT", NFSOperation::Lookup},
+    {"ACCESS", NFSOperation::Access},
+    {"OPEN", NFSOperation::Open},
+    {"OPEN_NOATTR", NFSOperation::Open},
+    {"CLOSE", NFSOperation::Close},
+    {"READDIR", NFSOperation::Readdir},
+    {"READDIRPLUS", NFSOperation::Readdir},
+    {"CREATE", NFSOperation::Create},
+    {"REMOVE", NFSOperation::Remove},
+    {"RENAME", NFSOperation::Rename},
+};
+
+/**
+ * @brief Minimal allocation-free tokenizer over one line
+ */
+class LineTokenizer
+{
+public:
+    LineTokenizer(const char *begin, const char *end) : m_pos(begin), m_end(end) {}
+
+    bool next(const char **token, int *length)
+    {
+        while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\t')) {
+            ++m_pos;
+        }
+        if (m_pos >= m_end) {
+            return false;
+        }
+        *token = m_pos;
+        while (m_pos < m_end && *m_pos != ' ' && *m_pos != '\t') {
+            ++m_pos;
+        }
+        *length = static_cast<int>(m_pos - *token);
+        return true;
+    }
+
+    /// Parse up to @p max unsigned numbers; returns how many were read
+    int numbers(quint64 *values, int max)
+    {
+        int count = 0;
+        const char *token;
+        int length;
+        while (count < max && next(&token, &length)) {
+            quint64 value = 0;
+            for (int i = 0; i < length && token[i] >= '0' && token[i] <= '9'; ++i) {
+                value = value * 10 + static_cast<quint64>(token[i] - '0');
+            }
+            values[count++] = value;
+        }
+        return count;
+    }
+
+private:
+    const char *m_pos;
+    const char *m_end;
+};
+
+bool tokenEquals(const char *token, int length, const char *literal)
+{
+    return static_cast<int>(std::strlen(literal)) == length && std::memcmp(token, literal, length) == 0;
+}
+
+int operationIndex(const char *name, int length)
+{
+    for (const OpName &entry : opNames) {
+        if (tokenEquals(name, length, entry.name)) {
+            return static_cast<int>(entry.operation);
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+QString nfsOperationToString(NFSOperation operation)
+{
+    switch (operation) {
+    case NFSOperation::Read: return "READ";
+    case NFSOperation::Write: return "WRITE";
+    case NFSOperation::Commit: return "COMMIT";
+    case NFSOperation::Getattr: return "GETATTR";
+    case NFSOperation::Setattr: return "SETATTR";
+    case NFSOperation::Lookup: return "LOOKUP";
+    case NFSOperation::Access: return "ACCESS";
+    case NFSOperation::Open: return "OPEN";
+    case NFSOperation::Close: return "CLOSE";
+    case NFSOperation::Readdir: return "READDIR";
+    case NFSOperation::Create: return "CREATE";
+    case NFSOperation::Remove: return "REMOVE";
+    case NFSOperation::Rename: return "RENAME";
+    case NFSOperation::Total: return "TOTAL";
+    case NFSOperation::Count: break;
+    }
+    return QString();
+}
+
+MountStatistics::MountStatistics()
+    : m_statsFilePath("/proc/self/mountstats")
+{
+    m_readBuffer.resize(64 * 1024);
+    m_clock.start();
+}
+
+bool MountStatistics::sample()
+{
+    QFile file(m_statsFilePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        qWarning() << "Cannot read NFS mount statistics from" << m_statsFilePath << ":" << file.errorString();
+        return false;
+    }
+
+    // procfs reports a size of 0, so read until EOF, growing the buffer only when it fills up
+    qint64 used = 0;
+    for (;;) {
+        if (used == m_readBuffer.size()) {
+            m_readBuffer.resize(m_readBuffer.size() * 2);
+        }
+        qint64 bytesRead = file.read(m_readBuffer.data() + used, m_readBuffer.size() - used);
+        if (bytesRead < 0) {
+            qWarning() << "Error reading" << m_statsFilePath << ":" << file.errorString();
+            return false;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+        used += bytesRead;
+    }
+
+    sample(QByteArray::fromRawData(m_readBuffer.constData(), static_cast<int>(used)), m_clock.elapsed());
+    return true;
+}
+
+void MountStatistics::sample(const QByteArray &content, qint64 timestampMs)
+{
+    MountState *current = nullptr;
+    bool inPerOpSection = false;
+
+    const char *pos = content.constData();
+    const char *const end = pos + content.size();
+
+    while (pos < end) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        LineTokenizer tokens(pos, lineEnd);
+        const bool indented = (*pos == '\t' || *pos == ' ');
+        pos = lineEnd + 1;
+
+        const char *token;
+        int length;
+        if (!tokens.next(&token, &length)) {
+            continue;
+        }
+
+        if (!indented) {
+            current = nullptr;
+            inPerOpSection = false;
+            if (!tokenEquals(token, length, "device")) {
+                continue;
+            }
+
+            // device <source> mounted on <mountpoint> with fstype <type> ...
+            const char *mountPoint = nullptr;
+            int mountPointLength = 0;
+            const char *fsType = nullptr;
+            int fsTypeLength = 0;
+            int index = 0;
+            while (tokens.next(&token, &length)) {
+                ++index;
+                if (index == 4) {
+                    mountPoint = token;
+                    mountPointLength = length;
+                } else if (index == 7) {
+                    fsType = token;
+                    fsTypeLength = length;
+                    break;
+                }
+            }
+            if (!mountPoint || !fsType
+                || !(tokenEquals(fsType, fsTypeLength, "nfs") || tokenEquals(fsType, fsTypeLength, "nfs4"))) {
+                continue;
+            }
+
+            auto it = m_mounts.find(QByteArray::fromRawData(mountPoint, mountPointLength));
+            if (it == m_mounts.end()) {
+                it = m_mounts.insert(QByteArray(mountPoint, mountPointLength), MountState());
+            }
+            current = &it.value();
+            current->previous = current->current;
+            current->current = MountStatsSnapshot();
+            current->current.timestampMs = timestampMs;
+            current->seen = true;
+            ++current->samples;
+            continue;
+        }
+
+        if (!current) {
+            continue;
+        }
+
+        MountStatsSnapshot &snapshot = current->current;
+        if (tokenEquals(token, length, "bytes:")) {
+            quint64 values[8] = {};
+            tokens.numbers(values, 8);
+            snapshot.bytesRead = values[0] + values[2];
+            snapshot.bytesWritten = values[1] + values[3];
+        } else if (tokenEquals(token, length, "xprt:")) {
+            // Several xprt lines appear with nconnect; they are summed
+            const char *transport;
+            int transportLength;
+            if (!tokens.next(&transport, &transportLength)) {
+                continue;
+            }
+            quint64 values[10] = {};
+            int count = tokens.numbers(values, 10);
+            const bool udp = tokenEquals(transport, transportLength, "udp");
+            const int sendsIndex = udp ? 2 : 5;
+            const int backlogIndex = udp ? 6 : 9;
+            if (count > backlogIndex) {
+                snapshot.xprtSends += values[sendsIndex];
+                snapshot.xprtBacklog += values[backlogIndex];
+            }
+        } else if (tokenEquals(token, length, "per-op")) {
+            inPerOpSection = true;
+        } else if (inPerOpSection && length > 1 && token[length - 1] == ':') {
+            quint64 values[9] = {};
+            if (tokens.numbers(values, 9) < 8) {
+                continue;
+            }
+            NFSOpCounters counters;
+            counters.operations = values[0];
+            counters.transmissions = values[1];
+            counters.timeouts = values[2];
+            counters.bytesSent = values[3];
+            counters.bytesReceived = values[4];
+            counters.queueMs = values[5];
+            counters.rttMs = values[6];
+            counters.executeMs = values[7];
+            counters.errors = values[8];
+
+            auto accumulate = [&counters](NFSOpCounters &target) {
+                target.operations += counters.operations;
+                target.transmissions += counters.transmissions;
+                target.timeouts += counters.timeouts;
+                target.bytesSent += counters.bytesSent;
+                target.bytesReceived += counters.bytesReceived;
+                target.queueMs += counters.queueMs;
+                target.rttMs += counters.rttMs;
+                target.executeMs += counters.executeMs;
+                target.errors += counters.errors;
+            };
+
+            int index = operationIndex(token, length - 1);
+            if (index >= 0) {
+                accumulate(snapshot.ops[index]);
+            }
+            accumulate(snapshot.ops[static_cast<std::size_t>(NFSOperation::Total)]);
+        }
+    }
+
+    for (auto it = m_mounts.begin(); it != m_mounts.end();) {
+        if (!it->seen) {
+            it = m_mounts.erase(it);
+            continue;
+        }
+        if (it->samples >= 2) {
+            updateRate(it.value());
+        }
+        it->seen = false;
+        ++it;
+    }
+}
+
+void MountStatistics::updateRate(MountState &state)
+{
+    const MountStatsSnapshot &current = state.current;
+    const MountStatsSnapshot &previous = state.previous;
+    const std::size_t total = static_cast<std::size_t>(NFSOperation::Total);
+
+    // Counters went backwards: the mount was replaced, start over from this sample
+    if (current.ops[total].operations < previous.ops[total].operations
+        || current.bytesRead < previous.bytesRead || current.bytesWritten < previous.bytesWritten) {
+        state.rates.clear();
+        return;
+    }
+
+    const double interval = (current.timestampMs - previous.timestampMs) / 1000.0;
+    if (interval <= 0.0) {
+        return;
+    }
+
+    MountStatsRate rate;
+    rate.timestampMs = current.timestampMs;
+    rate.intervalSeconds = interval;
+    rate.readBytesPerSecond = (current.bytesRead - previous.bytesRead) / interval;
+    rate.writeBytesPerSecond = (current.bytesWritten - previous.bytesWritten) / interval;
+
+    const quint64 sends = current.xprtSends - qMin(current.xprtSends, previous.xprtSends);
+    const quint64 backlog = current.xprtBacklog - qMin(current.xprtBacklog, previous.xprtBacklog);
+    rate.averageBacklog = sends > 0 ? static_cast<double>(backlog) / sends : 0.0;
+
+    for (std::size_t i = 0; i < NFSOperationCount; ++i) {
+        const NFSOpCounters &now = current.ops[i];
+        const NFSOpCounters &before = previous.ops[i];
+        const quint64 operations = now.operations - qMin(now.operations, before.operations);
+        const quint64 transmissions = now.transmissions - qMin(now.transmissions, before.transmissions);
+
+        NFSOpRate &opRate = rate.ops[i];
+        opRate.operationsPerSecond = operations / interval;
+        opRate.retransmissions = transmissions > operations ? transmissions - operations : 0;
+        opRate.errors = now.errors - qMin(now.errors, before.errors);
+        if (operations > 0) {
+            opRate.averageRttMs = static_cast<double>(now.rttMs - qMin(now.rttMs, before.rttMs)) / operations;
+            opRate.averageExecuteMs = static_cast<double>(now.executeMs - qMin(now.executeMs, before.executeMs)) / operations;
+        }
+    }
+
+    state.rates.push(rate);
+}
+
+QStringList MountStatistics::mountPoints() const
+{
+    QStringList result;
+    for (auto it = m_mounts.constBegin(); it != m_mounts.constEnd(); ++it) {
+        result << OctalEscape::unescape(QString::fromUtf8(it.key()));
+    }
+    return result;
+}
+
+bool MountStatistics::hasMount(const QString &mountPoint) const
+{
+    return m_mounts.contains(OctalEscape::escape(mountPoint).toUtf8());
+}
+
+MountStatsRate MountStatistics::latestRate(const QString &mountPoint) const
+{
+    auto it = m_mounts.constFind(OctalEscape::escape(mountPoint).toUtf8());
+    if (it == m_mounts.constEnd() || it->rates.isEmpty()) {
+        return MountStatsRate();
+    }
+    return it->rates.last();
+}
+
+QList<MountStatsRate> MountStatistics::rateHistory(const QString &mountPoint) const
+{
+    QList<MountStatsRate> history;
+    auto it = m_mounts.constFind(OctalEscape::escape(mountPoint).toUtf8());
+    if (it == m_mounts.constEnd()) {
+        return history;
+    }
+    history.reserve(static_cast<int>(it->rates.size()));
+    for (std::size_t i = 0; i < it->rates.size(); ++i) {
+        history << it->rates.at(i);
+    }
+    return history;
+}
+
+MountStatsSnapshot MountStatistics::lastSnapshot(const QString &mountPoint) const
+{
+    auto it = m_mounts.constFind(OctalEscape::escape(mountPoint).toUtf8());
+    return it == m_mounts.constEnd() ? MountStatsSnapshot() : it->current;
+}
+
+void MountStatistics::setStatsFilePath(const QString &filePath)
+{
+    m_statsFilePath = filePath;
+    m_mounts.clear();
+}
+
+QString MountStatistics::statsFilePath() const
+{
+    return m_statsFilePath;
+}
+
+} // namespace NFSShareManager
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "ringbuffer.h"
+#include <array>
+#include <cstddef>
+
+namespace NFSShareManager {
+
+/**
+ * @brief NFS operations tracked individually in the statistics
+ */
+enum class NFSOperation {
+    Read,
+    Write,
+    Commit,
+    Getattr,
+    Setattr,
+    Lookup,
+    Access,
+    Open,
+    Close,
+    Readdir,
+    Create,
+    Remove,
+    Rename,
+    Total,      ///< Sum over all operations, including untracked ones
+    Count       ///< Number of entries, not an operation
+};
+
+constexpr std::size_t NFSOperationCount = static_cast<std::size_t>(NFSOperation::Count);
+
+/**
+ * @brief Get the display name of an NFS operation
+ */
+QString nfsOperationToString(NFSOperation operation);
+
+/**
+ * @brief Cumulative per-operation counters from mountstats
+ */
+struct NFSOpCounters {
+    quint64 operations = 0;      ///< Operations issued
+    quint64 transmissions = 0;   ///< RPC transmissions (ops + retransmits)
+    quint64 timeouts = 0;        ///< Major timeouts
+    quint64 bytesSent = 0;       ///< Bytes sent including RPC headers
+    quint64 bytesReceived = 0;   ///< Bytes received including RPC headers
+    quint64 queueMs = 0;         ///< Cumulative backlog wait in ms
+    quint64 rttMs = 0;           ///< Cumulative round trip time in ms
+    quint64 executeMs = 0;       ///< Cumulative total execution time in ms
+    quint64 errors = 0;          ///< Operations that completed with an error
+};
+
+/**
+ * @brief Raw cumulative counters for one NFS mount at one point in time
+ */
+struct MountStatsSnapshot {
+    qint64 timestampMs = 0;      ///< Monotonic sample time in ms
+    quint64 bytesRead = 0;       ///< Application bytes read (normal + O_DIRECT)
+    quint64 bytesWritten = 0;    ///< Application bytes written (normal + O_DIRECT)
+    quint64 xprtSends = 0;       ///< RPC requests sent on the transport
+    quint64 xprtBacklog = 0;     ///< Cumulative backlog queue length at send time
+    std::array<NFSOpCounters, NFSOperationCount> ops{};   ///< Counters by NFSOperation
+};
+
+/**
+ * @brief Per-operation rates between two samples
+ */
+struct NFSOpRate {
+    double operationsPerSecond = 0.0;   ///< Operations per second
+    double averageRttMs = 0.0;          ///< Mean round trip time per operation
+    double averageExecuteMs = 0.0;      ///< Mean execution time per operation
+    quint64 retransmissions = 0;        ///< Retransmissions in the interval
+    quint64 errors = 0;                 ///< Errors in the interval
+};
+
+/**
+ * @brief Rates for one NFS mount between two consecutive samples
+ */
+struct MountStatsRate {
+    qint64 timestampMs = 0;             ///< Time of the later sample
+    double intervalSeconds = 0.0;       ///< Time between the two samples
+    double readBytesPerSecond = 0.0;    ///< Application read throughput
+    double writeBytesPerSecond = 0.0;   ///< Application write throughput
+    double averageBacklog = 0.0;        ///< Mean transport backlog per request sent
+    std::array<NFSOpRate, NFSOperationCount> ops{};   ///< Rates by NFSOperation
+
+    /**
+     * @brief Get the rates of one operation
+     */
+    const NFSOpRate &op(NFSOperation operation) const { return ops[static_cast<std::size_t>(operation)]; }
+};
+
+/**
+ * @brief Client-side NFS performance telemetry from /proc/self/mountstats
+ *
+ * Each call to sample() parses the kernel's per-mount RPC statistics and
+ * turns the cumulative counters into rates against the previous sample.
+ * Rates are kept per mount in a fixed-size ring buffer, and the file is
+ * read into a reused buffer, so steady-state sampling does not allocate.
+ */
+class MountStatistics
+{
+public:
+    /// Number of rate samples kept per mount
+    static constexpr std::size_t HistorySize = 120;
+
+    MountStatistics();
+
+    /**
+     * @brief Read the statistics file and update all mounts
+     * @return True if the file could be read
+     */
+    bool sample();
+
+    /**
+     * @brief Update all mounts from already read mountstats content
+     * @param content Content in /proc/self/mountstats format
+     * @param timestampMs Monotonic time of the sample in ms
+     */
+    void sample(const QByteArray &content, qint64 timestampMs);
+
+    /**
+     * @brief Get the NFS mount points seen in the last sample
+     */
+    QStringList mountPoints() const;
+
+    /**
+     * @brief Check if statistics exist for a mount point
+     */
+    bool hasMount(const QString &mountPoint) const;
+
+    /**
+     * @brief Get the most recent rates for a mount
+     * @param mountPoint Local mount point
+     * @return Latest rates, or a zeroed structure if fewer than two samples exist
+     */
+    MountStatsRate latestRate(const QString &mountPoint) const;
+
+    /**
+     * @brief Get the rate history for a mount, oldest first
+     * @param mountPoint Local mount point
+     * @return Up to HistorySize rate samples
+     */
+    QList<MountStatsRate> rateHistory(const QString &mountPoint) const;
+
+    /**
+     * @brief Get the raw counters of the last sample for a mount
+     * @param mountPoint Local mount point
+     * @return Last snapshot, or a zeroed structure if the mount is unknown
+     */
+    MountStatsSnapshot lastSnapshot(const QString &mountPoint) const;
+
+    /**
+     * @brief Set the statistics file (default: /proc/self/mountstats)
+     */
+    void setStatsFilePath(const QString &filePath);
+
+    /**
+     * @brief Get the statistics file
+     */
+    QString statsFilePath() const;
+
+private:
+    struct MountState {
+        MountStatsSnapshot current;
+        MountStatsSnapshot previous;
+        RingBuffer<MountStatsRate, HistorySize> rates;
+        quint64 samples = 0;    ///< Number of snapshots taken so far
+        bool seen = false;      ///< Present in the sample being parsed
+    };
+
+    /**
+     * @brief Compute the rate between previous and current and store it
+     */
+    static void updateRate(MountState &state);
+
+    QHash<QByteArray, MountState> m_mounts;   ///< State by escaped mount point
+    QByteArray m_readBuffer;                  ///< Reused buffer for the statistics file
+    QString m_statsFilePath;                  ///< Statistics file
+    QElapsedTimer m_clock;                    ///< Monotonic clock for sample timestamps
+};
+
+} // namespace NFSShareManager
@@ -0,0 +1,230 @@
+#include "mounttablemonitor.h"
+#include "octalescape.h"
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QDebug>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace NFSShareManager {
+
+MountTableMonitor::MountTableMonitor(QObject *parent)
+    : QObject(parent)
+    , m_mountInfoPath("/proc/self/mountinfo")
+    , m_fd(-1)
+    , m_notifier(nullptr)
+{
+    qRegisterMetaType<MountInfoEntry>("MountInfoEntry");
+}
+
+MountTableMonitor::~MountTableMonitor()
+{
+    stop();
+}
+
+void MountTableMonitor::setMountInfoPath(const QString &filePath)
+{
+    const bool running = isRunning();
+    stop();
+    m_mountInfoPath = filePath;
+    if (running) {
+        start();
+    }
+}
+
+QString MountTableMonitor::mountInfoPath() const
+{
+    return m_mountInfoPath;
+}
+
+bool MountTableMonitor::start()
+{
+    if (isRunning()) {
+        return true;
+    }
+
+    m_fd = ::open(QFile::encodeName(m_mountInfoPath).constData(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) {
+        qWarning() << "MountTableMonitor: cannot open" << m_mountInfoPath << ":" << qt_error_string(errno);
+        return false;
+    }
+
+    // mountinfo signals changes as an exceptional condition (POLLPRI); it is always readable
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Exception, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &MountTableMonitor::onTableChanged);
+    return rescan();
+}
+
+void MountTableMonitor::stop()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool MountTableMonitor::isRunning() const
+{
+    return m_notifier != nullptr;
+}
+
+bool MountTableMonitor::rescan()
+{
+    QByteArray content;
+    if (!readTable(&content)) {
+        return false;
+    }
+    if (content != m_content) {
+        applyTable(content);
+    }
+    return true;
+}
+
+QList<MountInfoEntry> MountTableMonitor::entries() const
+{
+    QList<MountInfoEntry> result;
+    result.reserve(m_order.size());
+    for (int mountId : m_order) {
+        result << m_entries.value(mountId);
+    }
+    return result;
+}
+
+MountInfoEntry MountTableMonitor::entry(int mountId) const
+{
+    return m_entries.value(mountId);
+}
+
+MountInfoEntry MountTableMonitor::entryForMountPoint(const QString &mountPoint) const
+{
+    // Later lines are mounted on top of earlier ones
+    const QString cleaned = QDir::cleanPath(mountPoint);
+    for (int i = m_order.size() - 1; i >= 0; --i) {
+        const MountInfoEntry &candidate = m_entries[m_order[i]];
+        if (candidate.mountPoint == cleaned) {
+            return candidate;
+        }
+    }
+    return MountInfoEntry();
+}
+
+QList<MountInfoEntry> MountTableMonitor::parse(const QByteArray &content)
+{
+    QList<MountInfoEntry> entries;
+    const QStringList lines = QString::fromUtf8(content).split('\n', Qt::SkipEmptyParts);
+    for (const QString &line : lines) {
+        MountInfoEntry entry;
+        if (parseLine(line, &entry)) {
+            entries << entry;
+        }
+    }
+    return entries;
+}
+
+bool MountTableMonitor::parseLine(const QString &line, MountInfoEntry *entry)
+{
+    // 36 35 0:52 / /mnt/data rw,relatime shared:1 - nfs4 server:/srv/data rw,vers=4.2,rsize=1048576
+    const QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+    const int separator = fields.indexOf("-", 6);
+    if (separator < 0 || separator + 2 >= fields.size()) {
+        return false;
+    }
+
+    bool idOk = false;
+    bool parentOk = false;
+    MountInfoEntry parsed;
+    parsed.mountId = fields[0].toInt(&idOk);
+    parsed.parentId = fields[1].toInt(&parentOk);
+    if (!idOk || !parentOk) {
+        return false;
+    }
+    parsed.device = fields[2];
+    parsed.root = OctalEscape::unescape(fields[3]);
+    parsed.mountPoint = OctalEscape::unescape(fields[4]);
+    parsed.mountOptions = fields[5].split(',', Qt::SkipEmptyParts);
+    parsed.fsType = fields[separator + 1];
+    parsed.source = OctalEscape::unescape(fields[separator + 2]);
+    if (separator + 3 < fields.size()) {
+        parsed.superOptions = fields[separator + 3].split(',', Qt::SkipEmptyParts);
+    }
+    if (entry) {
+        *entry = parsed;
+    }
+    return true;
+}
+
+void MountTableMonitor::onTableChanged()
+{
+    // Reading the table to the end acknowledges the event
+    rescan();
+}
+
+bool MountTableMonitor::readTable(QByteArray *content)
+{
+    if (m_fd < 0) {
+        QFile file(m_mountInfoPath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "MountTableMonitor: cannot read" << m_mountInfoPath << file.errorString();
+            return false;
+        }
+        *content = file.readAll();
+        return true;
+    }
+
+    if (::lseek(m_fd, 0, SEEK_SET) < 0) {
+        return false;
+    }
+    content->clear();
+    char buffer[16384];
+    for (;;) {
+        const ssize_t count = ::read(m_fd, buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            qWarning() << "MountTableMonitor: cannot read" << m_mountInfoPath << ":" << qt_error_string(errno);
+            return false;
+        }
+        if (count == 0) {
+            return true;
+        }
+        content->append(buffer, count);
+    }
+}
+
+void MountTableMonitor::applyTable(const QByteArray &content)
+{
+    const QList<MountInfoEntry> parsed = parse(content);
+    const QHash<int, MountInfoEntry> previous = m_entries;
+    const QList<int> previousOrder = m_order;
+
+    m_content = content;
+    m_entries.clear();
+    m_order.clear();
+    m_order.reserve(parsed.size());
+    for (const MountInfoEntry &current : parsed) {
+        m_entries.insert(current.mountId, current);
+        m_order << current.mountId;
+    }
+
+    // Children before parents, the order in which they were unmounted
+    for (int i = previousOrder.size() - 1; i >= 0; --i) {
+        if (!m_entries.contains(previousOrder[i])) {
+            emit mountRemoved(previous.value(previousOrder[i]));
+        }
+    }
+    for (const MountInfoEntry &current : parsed) {
+        auto it = previous.constFind(current.mountId);
+        if (it == previous.constEnd()) {
+            emit mountAdded(current);
+        } else if (it.value() != current) {
+            emit mountChanged(it.value(), current);
+        }
+    }
+}
+
+} // namespace NFSShareManager
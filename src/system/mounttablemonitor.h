@@ -0,0 +1,170 @@
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+class QSocketNotifier;
+
+namespace NFSShareManager {
+
+/**
+ * @brief One line of /proc/self/mountinfo
+ */
+struct MountInfoEntry {
+    int mountId = -1;           ///< Unique mount ID, stable until unmounted
+    int parentId = -1;          ///< Mount ID of the parent mount
+    QString device;             ///< major:minor of the filesystem; also the BDI name of NFS mounts
+    QString root;               ///< Root of the mount within its filesystem
+    QString mountPoint;         ///< Mount point, unescaped
+    QStringList mountOptions;   ///< Per-mount options (ro, nosuid, ...)
+    QString fsType;             ///< Filesystem type
+    QString source;             ///< Device or "server:/export"
+    QStringList superOptions;   ///< Per-superblock options (vers=, rsize=, ...)
+
+    bool isValid() const { return mountId >= 0; }
+
+    /**
+     * @brief Check if the entry is an NFS mount
+     */
+    bool isNFS() const { return fsType == "nfs" || fsType == "nfs4"; }
+
+    bool operator==(const MountInfoEntry &other) const {
+        return mountId == other.mountId && parentId == other.parentId && device == other.device &&
+               root == other.root &&
+               mountPoint == other.mountPoint && mountOptions == other.mountOptions &&
+               fsType == other.fsType && source == other.source && superOptions == other.superOptions;
+    }
+    bool operator!=(const MountInfoEntry &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Event-driven view of the kernel mount table
+ *
+ * The kernel flags /proc/self/mountinfo with POLLPRI whenever a mount is
+ * added, removed or changed in the process's mount namespace. The table
+ * is re-read only then, and compared with the previous read by mount ID,
+ * so each change is reported once through mountAdded(), mountRemoved() or
+ * mountChanged(). No timer is involved; an idle mount table costs no
+ * wakeups.
+ */
+class MountTableMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MountTableMonitor(QObject *parent = nullptr);
+    ~MountTableMonitor();
+
+    /**
+     * @brief Set the mount table to read (for testing)
+     * @param filePath Path to a mountinfo file (default: /proc/self/mountinfo)
+     */
+    void setMountInfoPath(const QString &filePath);
+
+    /**
+     * @brief Get the mount table path
+     */
+    QString mountInfoPath() const;
+
+    /**
+     * @brief Read the table and subscribe to change notifications
+     *
+     * Every mount of the initial read is reported through mountAdded(),
+     * so connect before starting.
+     *
+     * @return False if the table cannot be opened
+     */
+    bool start();
+
+    /**
+     * @brief Stop listening for changes; the last table is kept
+     */
+    void stop();
+
+    /**
+     * @brief Check if change notifications are being received
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Re-read the table now and report the differences
+     * @return False if the table cannot be read
+     */
+    bool rescan();
+
+    /**
+     * @brief Get all mounts in table order
+     */
+    QList<MountInfoEntry> entries() const;
+
+    /**
+     * @brief Get a mount by ID
+     * @param mountId Mount ID
+     * @return The mount, or an invalid entry if there is none
+     */
+    MountInfoEntry entry(int mountId) const;
+
+    /**
+     * @brief Get the topmost mount on a mount point
+     * @param mountPoint The mount point
+     * @return The mount, or an invalid entry if nothing is mounted there
+     */
+    MountInfoEntry entryForMountPoint(const QString &mountPoint) const;
+
+    /**
+     * @brief Parse mountinfo content
+     * @param content proc_pid_mountinfo(5) content
+     * @return Entries in table order; malformed lines are skipped
+     */
+    static QList<MountInfoEntry> parse(const QByteArray &content);
+
+    /**
+     * @brief Parse one mountinfo line
+     * @param line The line
+     * @param entry Output for the entry
+     * @return False for malformed lines
+     */
+    static bool parseLine(const QString &line, MountInfoEntry *entry);
+
+signals:
+    /**
+     * @brief Emitted when a mount appears
+     * @param entry The new mount
+     */
+    void mountAdded(const MountInfoEntry &entry);
+
+    /**
+     * @brief Emitted when a mount disappears
+     * @param entry The mount as last seen
+     */
+    void mountRemoved(const MountInfoEntry &entry);
+
+    /**
+     * @brief Emitted when a mount keeps its ID but changes, e.g. on remount or move
+     * @param previous The mount as last seen
+     * @param current The mount now
+     */
+    void mountChanged(const MountInfoEntry &previous, const MountInfoEntry &current);
+
+private slots:
+    void onTableChanged();
+
+private:
+    bool readTable(QByteArray *content);
+    void applyTable(const QByteArray &content);
+
+    QString m_mountInfoPath;                ///< Mount table file
+    int m_fd;                               ///< Open table for polling, -1 if stopped
+    QSocketNotifier *m_notifier;            ///< POLLPRI notifier on m_fd
+    QByteArray m_content;                   ///< Last content read
+    QList<int> m_order;                     ///< Mount IDs in table order
+    QHash<int, MountInfoEntry> m_entries;   ///< Mounts by ID
+};
+
+} // namespace NFSShareManager
+
+Q_DECLARE_METATYPE(NFSShareManager::MountInfoEntry)
@@ -1,26 +1,85 @@
 #include "nfsserviceinterface.h"
 #include "../core/remotenfsshare.h"
 #include "../core/shareconfiguration.h"
+#include "commandbackend.h"
+#include "exportsdwriter.h"
 #include <QProcess>
 #include <QTimer>
 #include <QDir>
 #include <QFileInfo>
 #include <QRegularExpression>
-#include <QStandardPaths>
 #include <QDebug>
 #include <QHostAddress>
+#include <QSet>
 
 namespace NFSShareManager {
 
+namespace {
+
+void failExportBatch(ExportBatchResult &batchResult, const ExportBatch &batch, const QString &error)
+{
+    batchResult.entries.clear();
+    for (const ExportChange &change : batch) {
+        ExportEntryResult entry;
+        entry.path = change.path;
+        entry.type = change.type;
+        entry.error = error;
+        batchResult.entries << entry;
+    }
+}
+
+} // namespace
+
+ExportChange ExportChange::add(const QString &path, const ShareConfiguration &config)
+{
+    ExportChange change;
+    change.type = Type::Add;
+    change.path = path;
+    change.exportLine = config.toExportLine(path);
+    return change;
+}
+
+ExportChange ExportChange::remove(const QString &path)
+{
+    ExportChange change;
+    change.type = Type::Remove;
+    change.path = path;
+    return change;
+}
+
+ExportChange ExportChange::modify(const QString &path, const ShareConfiguration &config)
+{
+    ExportChange change;
+    change.type = Type::Modify;
+    change.path = path;
+    change.exportLine = config.toExportLine(path);
+    return change;
+}
+
+QStringList ExportBatchResult::failedPaths() const
+{
+    QStringList paths;
+    for (const ExportEntryResult &entry : entries) {
+        if (!entry.success) {
+            paths << entry.path;
+        }
+    }
+    return paths;
+}
+
 NFSServiceInterface::NFSServiceInterface(QObject *parent)
     : QObject(parent)
     , m_currentProcess(nullptr)
     , m_timeoutTimer(new QTimer(this))
     , m_defaultTimeout(10000)
+    , m_exportsFilePath("/etc/exports")
+    , m_exportsRedirected(false)
     , m_toolsChecked(false)
 {
     m_timeoutTimer->setSingleShot(true);
     connect(m_timeoutTimer, &QTimer::timeout, this, &NFSServiceInterface::onCommandTimeout);
+
+    setCommandBackend(CommandBackend::defaultBackend());
 }
 
 NFSServiceInterface::~NFSServiceInterface()
@@ -66,6 +125,37 @@ QStringList NFSServiceInterface::getMissingTools() const
     return missing;
 }
 
+void NFSServiceInterface::setCommandBackend(std::shared_ptr<CommandBackend> backend)
+{
+    m_commandBackend = backend ? std::move(backend) : CommandBackend::defaultBackend();
+
+    // Availability depends on the backend
+    m_toolAvailability.clear();
+    m_toolsChecked = false;
+
+    // A backend with an exports table of its own keeps applyExports() away from the real one
+    const QString backendExportsFile = m_commandBackend->exportsFilePath();
+    if (!backendExportsFile.isEmpty()) {
+        if (!m_exportsRedirected) {
+            m_savedExportsFilePath = m_exportsFilePath;
+            m_savedExportsDirectory = m_exportsDirectory;
+            m_exportsRedirected = true;
+        }
+        m_exportsFilePath = backendExportsFile;
+        m_exportsDirectory.clear();
+        QDir().mkpath(QFileInfo(m_exportsFilePath).absolutePath());
+    } else if (m_exportsRedirected) {
+        m_exportsFilePath = m_savedExportsFilePath;
+        m_exportsDirectory = m_savedExportsDirectory;
+        m_exportsRedirected = false;
+    }
+}
+
+std::shared_ptr<CommandBackend> NFSServiceInterface::commandBackend() const
+{
+    return m_commandBackend;
+}
+
 NFSCommandResult NFSServiceInterface::exportDirectory(const QString &exportPath, const ShareConfiguration &config)
 {
     if (!isCommandAvailable("exportfs")) {
@@ -150,6 +240,135 @@ NFSCommandResult NFSServiceInterface::reloadExports()
     return executeCommand("exportfs", args);
 }
 
+ExportBatchResult NFSServiceInterface::applyExports(const ExportBatch &batch)
+{
+    ExportBatchResult batchResult;
+
+    if (batch.isEmpty()) {
+        batchResult.success = true;
+        return batchResult;
+    }
+
+    if (!isCommandAvailable("exportfs")) {
+        failExportBatch(batchResult, batch, "exportfs command not available");
+        return batchResult;
+    }
+
+    // Keep the first failed exportfs; a rollback reload must not replace it
+    batchResult.reloadResult = NFSCommandResult(true, 0, "", "", "exportfs");
+    ExportTransaction transaction(m_exportsFilePath, m_exportsDirectory,
+                                  [this, &batchResult](const QStringList &arguments, QString *errorMessage) {
+        const NFSCommandResult result = executeCommand("exportfs", arguments);
+        if (batchResult.reloadResult.success) {
+            batchResult.reloadResult = result;
+        }
+        if (!result.success && errorMessage) {
+            *errorMessage = result.error.trimmed();
+        }
+        return result.success;
+    });
+
+    QString loadError;
+    if (!transaction.load(&loadError)) {
+        failExportBatch(batchResult, batch, loadError);
+        return batchResult;
+    }
+
+    // Validate every entry before touching anything
+    if (!validateExportBatch(batch, [&transaction](const QString &key) {
+            return !transaction.currentLine(key).isEmpty();
+        }, batchResult)) {
+        return batchResult;
+    }
+
+    for (const ExportChange &change : batch) {
+        transaction.setShare(change.path, change.type == ExportChange::Type::Remove ? QString() : change.exportLine);
+    }
+
+    const ExportTransactionResult committed = transaction.commit();
+    if (!committed.success) {
+        qWarning() << "Failed to apply exports, rolling back:" << committed.error;
+        failExportBatch(batchResult, batch,
+                        committed.reexportFailed ? QString("Export reload failed: %1").arg(committed.error)
+                                                 : committed.error);
+        batchResult.rolledBack = committed.rolledBack;
+        return batchResult;
+    }
+
+    for (ExportEntryResult &entry : batchResult.entries) {
+        entry.success = true;
+    }
+    batchResult.success = true;
+    return batchResult;
+}
+
+bool NFSServiceInterface::validateExportBatch(const ExportBatch &batch,
+                                              const std::function<bool(const QString &)> &isExported,
+                                              ExportBatchResult &batchResult) const
+{
+    bool batchValid = true;
+    QSet<QString> seenPaths;
+    for (const ExportChange &change : batch) {
+        ExportEntryResult entry;
+        entry.path = change.path;
+        entry.type = change.type;
+
+        const QString key = QDir::cleanPath(change.path);
+        if (change.path.isEmpty()) {
+            entry.error = "Export path cannot be empty";
+        } else if (!QDir::isAbsolutePath(change.path)) {
+            entry.error = "Export path must be absolute";
+        } else if (seenPaths.contains(key)) {
+            entry.error = "Path appears more than once in the batch";
+        } else if (change.type != ExportChange::Type::Remove &&
+                   ExportsDWriter::exportPathOfLine(change.exportLine) != key) {
+            entry.error = "Failed to generate export configuration";
+        } else if (change.type == ExportChange::Type::Add && isExported(key)) {
+            entry.error = "Path is already exported";
+        } else if (change.type != ExportChange::Type::Add && !isExported(key)) {
+            entry.error = "Path is not exported";
+        }
+
+        seenPaths.insert(key);
+        if (!entry.error.isEmpty()) {
+            batchValid = false;
+        }
+        batchResult.entries << entry;
+    }
+
+    if (!batchValid) {
+        for (ExportEntryResult &entry : batchResult.entries) {
+            if (entry.error.isEmpty()) {
+                entry.error = "Not applied: another entry in the batch is invalid";
+            }
+        }
+    }
+    return batchValid;
+}
+
+void NFSServiceInterface::setExportsFilePath(const QString &filePath)
+{
+    m_exportsFilePath = filePath;
+    m_exportsDirectory.clear();
+    m_exportsRedirected = false;
+}
+
+QString NFSServiceInterface::exportsFilePath() const
+{
+    return m_exportsFilePath;
+}
+
+void NFSServiceInterface::setExportsDirectory(const QString &directory)
+{
+    m_exportsDirectory = directory;
+    m_exportsRedirected = false;
+}
+
+QString NFSServiceInterface::exportsDirectory() const
+{
+    return m_exportsDirectory;
+}
+
 NFSCommandResult NFSServiceInterface::queryRemoteExports(const QHostAddress &hostAddress, int timeout)
 {
     return queryRemoteExports(hostAddress.toString(), timeout);
@@ -262,6 +481,16 @@ bool NFSServiceInterface::isNFSMountPoint(const QString &path)
     return false;
 }
 
+bool NFSServiceInterface::sampleMountStatistics()
+{
+    return m_mountStatistics.sample();
+}
+
+const MountStatistics &NFSServiceInterface::mountStatistics() const
+{
+    return m_mountStatistics;
+}
+
 QStringList NFSServiceInterface::parseExportfsOutput(const QString &output)
 {
     QStringList exports;
@@ -434,35 +663,15 @@ void NFSServiceInterface::onCommandTimeout()
 
 NFSCommandResult NFSServiceInterface::executeCommand(const QString &program, const QStringList &arguments, int timeout)
 {
-    // Check if the program exists first
-    if (!isCommandAvailable(program)) {
-        return NFSCommandResult(false, -1, "", QString("Command not found: %1").arg(program), program + " " + arguments.join(" "));
-    }
-    
     QString command = program + " " + arguments.join(" ");
     
-    // Create a temporary process for this command
-    QProcess process;
-    process.start(program, arguments);
-    
-    emit commandStarted(command);
-    
-    // Wait for the process to finish with timeout
-    if (!process.waitForFinished(timeout)) {
-        process.kill();
-        process.waitForFinished(1000); // Give it a second to die
-        
-        NFSCommandResult result(false, -1, "", "Command execution timed out", command);
-        emit commandFinished(result);
-        return result;
+    if (!m_commandBackend->isAvailable(program)) {
+        return NFSCommandResult(false, -1, "", QString("Command not found: %1").arg(program), command);
     }
     
-    // Get the results
-    int exitCode = process.exitCode();
-    QString output = QString::fromUtf8(process.readAllStandardOutput());
-    QString error = QString::fromUtf8(process.readAllStandardError());
+    emit commandStarted(command);
     
-    NFSCommandResult result(exitCode == 0, exitCode, output, error, command);
+    NFSCommandResult result = m_commandBackend->execute(program, arguments, timeout);
     emit commandFinished(result);
     
     return result;
@@ -470,9 +679,7 @@ NFSCommandResult NFSServiceInterface::executeCommand(const QString &program, con
 
 bool NFSServiceInterface::isCommandAvailable(const QString &command) const
 {
-    // Check if command exists in PATH
-    QString path = QStandardPaths::findExecutable(command);
-    return !path.isEmpty();
+    return m_commandBackend->isAvailable(command);
 }
 
 QString NFSServiceInterface::generateMountOptions(const QStringList &options, NFSVersion nfsVersion) const
@@ -495,19 +702,10 @@ QString NFSServiceInterface::generateMountOptions(const QStringList &options, NF
         break;
     }
     
-    // Add some sensible defaults if not specified
-    if (!allOptions.contains(QRegularExpression("^rsize="))) {
-        allOptions << "rsize=8192";
-    }
-    if (!allOptions.contains(QRegularExpression("^wsize="))) {
-        allOptions << "wsize=8192";
-    }
-    if (!allOptions.contains(QRegularExpression("^timeo="))) {
-        allOptions << "timeo=14";
-    }
-    if (!allOptions.contains(QRegularExpression("^retrans="))) {
-        allOptions << "retrans=3";
-    }
+    // rsize/wsize/timeo/retrans are left to the kernel unless the caller sets
+    // them: client and server negotiate the largest transfer size (usually
+    // 1 MiB), and the TCP defaults for timeo/retrans are already sensible.
+    // MountAutotuner provides measured values per server.
     
     return allOptions.join(",");
 }
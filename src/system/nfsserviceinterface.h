@@ -7,10 +7,14 @@
 #include <QHostAddress>
 #include <QTimer>
 #include <QHash>
+#include <functional>
+#include <memory>
 #include "../core/types.h"
+#include "mountstatistics.h"
 
 namespace NFSShareManager {
 
+class CommandBackend;
 class RemoteNFSShare;
 class ShareConfiguration;
 
@@ -42,6 +46,61 @@ struct MountInfo {
     MountInfo() : isNFS(false) {}
 };
 
+/**
+ * @brief A single staged change in an export batch
+ */
+struct ExportChange {
+    /**
+     * @brief Kind of change applied to the exports table
+     */
+    enum class Type {
+        Add,        ///< Add a new export entry
+        Remove,     ///< Remove an existing export entry
+        Modify      ///< Replace the options of an existing export entry
+    };
+
+    Type type;             ///< Kind of change
+    QString path;          ///< Exported directory path
+    QString exportLine;    ///< Complete exports(5) line for Add/Modify
+
+    ExportChange() : type(Type::Add) {}
+
+    static ExportChange add(const QString &path, const ShareConfiguration &config);
+    static ExportChange remove(const QString &path);
+    static ExportChange modify(const QString &path, const ShareConfiguration &config);
+};
+
+using ExportBatch = QList<ExportChange>;
+
+/**
+ * @brief Outcome of one entry of an export batch
+ */
+struct ExportEntryResult {
+    QString path;              ///< Exported directory path
+    ExportChange::Type type;   ///< Kind of change that was requested
+    bool success;              ///< Whether the change is in effect
+    QString error;             ///< Reason for the failure, if any
+
+    ExportEntryResult() : type(ExportChange::Type::Add), success(false) {}
+};
+
+/**
+ * @brief Outcome of a whole export batch
+ */
+struct ExportBatchResult {
+    bool success;                       ///< Whether every entry was applied
+    bool rolledBack;                    ///< Whether files and kernel table were restored after a failure
+    QList<ExportEntryResult> entries;   ///< Per-entry results, in batch order
+    NFSCommandResult reloadResult;      ///< Result of the export reload
+
+    ExportBatchResult() : success(false), rolledBack(false) {}
+
+    /**
+     * @brief Get the paths of all entries that failed
+     */
+    QStringList failedPaths() const;
+};
+
 /**
  * @brief NFS service interface wrapper
  * 
@@ -69,6 +128,24 @@ public:
      */
     QStringList getMissingTools() const;
 
+    /**
+     * @brief Replace the backend that runs the NFS tools
+     *
+     * A backend with its own exports table (CommandBackend::exportsFilePath(),
+     * e.g. SimulatedCommandBackend) also redirects applyExports() to it, so
+     * nothing under /etc is touched. Switching
+     * back to a real backend restores the previous exports table and
+     * directory, unless they were set explicitly in between.
+     *
+     * @param backend The backend; nullptr restores CommandBackend::defaultBackend()
+     */
+    void setCommandBackend(std::shared_ptr<CommandBackend> backend);
+
+    /**
+     * @brief Get the backend that runs the NFS tools
+     */
+    std::shared_ptr<CommandBackend> commandBackend() const;
+
     // Export management methods
     
     /**
@@ -98,6 +175,56 @@ public:
      */
     NFSCommandResult reloadExports();
 
+    /**
+     * @brief Apply a batch of export changes as one transaction
+     *
+     * All entries are validated before anything is touched. With an
+     * exports directory set (see setExportsDirectory()), each changed share
+     * is one atomic file operation under that directory followed by a
+     * targeted exportfs for that share only. Otherwise the exports table
+     * is written once and the changed shares are re-exported the same way.
+     * With an exports directory, a share the batch touches that is still
+     * listed in the exports table (from before the directory was used)
+     * counts as exported and is dropped from the table.
+     * Large batches are followed by a single reload instead. If writing or
+     * re-exporting fails the previous files are restored and reloaded, and
+     * every entry is reported as failed; ExportBatchResult::rolledBack
+     * tells whether everything was restored. The transaction itself is
+     * ExportTransaction, shared with PolicyKitHelper.
+     *
+     * @param batch The staged adds, removes and modifications
+     * @return Batch result with per-entry status
+     */
+    ExportBatchResult applyExports(const ExportBatch &batch);
+
+    /**
+     * @brief Set the exports table used by applyExports()
+     *
+     * Also clears the exports directory, so applyExports() edits this table.
+     *
+     * @param filePath Path to the exports file (default: /etc/exports)
+     */
+    void setExportsFilePath(const QString &filePath);
+
+    /**
+     * @brief Get the exports table used by applyExports()
+     * @return Path to the exports file
+     */
+    QString exportsFilePath() const;
+
+    /**
+     * @brief Set the directory applyExports() keeps per-share files in
+     * @param directory exports.d directory; empty to use the exports table instead
+     *                  (default: empty; /etc/exports.d is written by PolicyKitHelper)
+     */
+    void setExportsDirectory(const QString &directory);
+
+    /**
+     * @brief Get the directory applyExports() keeps per-share files in
+     * @return exports.d directory, or empty when the exports table is used
+     */
+    QString exportsDirectory() const;
+
     // Network discovery methods
     
     /**
@@ -167,6 +294,18 @@ public:
      */
     bool isNFSMountPoint(const QString &path);
 
+    /**
+     * @brief Take a new sample of the client-side NFS mount statistics
+     * @return True if /proc/self/mountstats could be read
+     */
+    bool sampleMountStatistics();
+
+    /**
+     * @brief Get the client-side NFS mount statistics
+     * @return Per-mount counters and rates from the samples taken so far
+     */
+    const MountStatistics &mountStatistics() const;
+
     // Parsing methods
     
     /**
@@ -250,6 +389,16 @@ private:
      */
     bool isCommandAvailable(const QString &command) const;
 
+    /**
+     * @brief Validate a batch before anything is changed
+     * @param batch The batch to validate
+     * @param isExported Whether a (cleaned) path currently has an entry
+     * @param batchResult Receives one entry per change
+     * @return True if every change is valid
+     */
+    bool validateExportBatch(const ExportBatch &batch, const std::function<bool(const QString &)> &isExported,
+                             ExportBatchResult &batchResult) const;
+
     /**
      * @brief Generate mount options string from configuration
      * @param options List of mount options
@@ -274,10 +423,21 @@ private:
     QTimer *m_timeoutTimer;           ///< Timeout timer for commands
     QString m_currentCommand;         ///< Currently executing command
     int m_defaultTimeout;             ///< Default command timeout in ms
+    QString m_exportsFilePath;        ///< Exports table written by applyExports()
+    QString m_exportsDirectory;       ///< Per-share exports.d directory, empty to use m_exportsFilePath
+    QString m_savedExportsFilePath;   ///< m_exportsFilePath before a simulated backend redirected it
+    QString m_savedExportsDirectory;  ///< m_exportsDirectory before a simulated backend redirected it
+    bool m_exportsRedirected;         ///< Whether a simulated backend owns the exports paths
+    MountStatistics m_mountStatistics; ///< Client-side per-mount NFS telemetry
+
+    std::shared_ptr<CommandBackend> m_commandBackend; ///< Runs (or simulates) the NFS tools
 
     // Tool availability cache
     mutable QHash<QString, bool> m_toolAvailability;
     mutable bool m_toolsChecked;
 };
 
-} // namespace NFSShareManager
\ No newline at end of file
+} // namespace NFSShareManager
+
+Q_DECLARE_METATYPE(NFSShareManager::NFSCommandResult)
+Q_DECLARE_METATYPE(NFSShareManager::ExportBatchResult)
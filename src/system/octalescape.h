@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QString>
+
+namespace NFSShareManager {
+
+/**
+ * @brief The \ooo escaping of fstab, mountinfo and etab fields
+ *
+ * These tables separate fields with blanks, so the kernel and libmount
+ * write space, tab, newline and backslash inside a field as a backslash
+ * followed by three octal digits (a blank in a path becomes \040).
+ */
+class OctalEscape
+{
+public:
+    /**
+     * @brief Undo the \ooo escapes of a field
+     * @param field Field as read from the table
+     * @return Field with every valid escape replaced by its character
+     */
+    static QString unescape(const QString &field)
+    {
+        if (!field.contains('\\')) {
+            return field;
+        }
+
+        QString result;
+        result.reserve(field.size());
+        for (int i = 0; i < field.size(); ++i) {
+            if (field[i] == '\\' && i + 3 < field.size() && isOctalDigit(field[i + 1])
+                && isOctalDigit(field[i + 2]) && isOctalDigit(field[i + 3])) {
+                result += QChar(field.mid(i + 1, 3).toInt(nullptr, 8));
+                i += 3;
+            } else {
+                result += field[i];
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Escape the characters a field cannot hold literally
+     * @param field Field value
+     * @return Field with blanks and backslashes written as \ooo
+     */
+    static QString escape(const QString &field)
+    {
+        QString result;
+        result.reserve(field.size());
+        for (const QChar ch : field) {
+            if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\\') {
+                result += QString("\\%1").arg(ch.unicode(), 3, 8, QChar('0'));
+            } else {
+                result += ch;
+            }
+        }
+        return result;
+    }
+
+private:
+    static bool isOctalDigit(QChar ch)
+    {
+        return ch >= '0' && ch <= '7';
+    }
+};
+
+} // namespace NFSShareManager
@@ -1,4 +1,7 @@
 #include "policykithelper.h"
+#include "bdituner.h"
+#include "exportsdwriter.h"
+#include "fstabfile.h"
 
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
@@ -8,7 +11,9 @@
 #include <QProcess>
 #include <QFile>
 #include <QFileInfo>
+#include <QMutexLocker>
 #include <QDir>
+#include <QRegularExpression>
 #include <QDateTime>
 #include <QStandardPaths>
 #include <QLoggingCategory>
@@ -22,6 +27,7 @@ PolicyKitHelper::PolicyKitHelper(QObject *parent)
     : QObject(parent)
     , m_policyKitInterface(nullptr)
     , m_isAvailable(false)
+    , m_rolledBack(false)
 {
     initializePolicyKit();
 }
@@ -83,6 +89,12 @@ bool PolicyKitHelper::isPolicyKitAvailable() const
     return m_isAvailable;
 }
 
+QString PolicyKitHelper::lastError() const
+{
+    QMutexLocker locker(&m_actionMutex);
+    return m_lastError;
+}
+
 PolicyKitHelper::AuthResult PolicyKitHelper::checkAuthorization(Action action)
 {
     if (!m_isAvailable || !m_policyKitInterface) {
@@ -121,8 +133,30 @@ PolicyKitHelper::AuthResult PolicyKitHelper::checkAuthorization(Action action)
     }
 }
 
+bool PolicyKitHelper::executePrivilegedAction(Action action, const QVariantMap &parameters,
+                                              QString *errorMessage, bool *rolledBack)
+{
+    QMutexLocker locker(&m_actionMutex);
+    const bool success = runPrivilegedAction(action, parameters);
+    if (errorMessage) {
+        *errorMessage = success ? QString() : m_lastError;
+    }
+    if (rolledBack) {
+        *rolledBack = m_rolledBack;
+    }
+    return success;
+}
+
 bool PolicyKitHelper::executePrivilegedAction(Action action, const QVariantMap &parameters)
 {
+    QMutexLocker locker(&m_actionMutex);
+    return runPrivilegedAction(action, parameters);
+}
+
+bool PolicyKitHelper::runPrivilegedAction(Action action, const QVariantMap &parameters)
+{
+    m_rolledBack = false;
+
     if (!m_isAvailable || !m_policyKitInterface) {
         qCWarning(policyKitLog) << "PolicyKit not available for privileged action";
         m_lastError = tr("PolicyKit is not available");
@@ -159,6 +193,7 @@ bool PolicyKitHelper::executePrivilegedAction(Action action, const QVariantMap &
         }
         
         qCWarning(policyKitLog) << "Authorization failed for action:" << static_cast<int>(action) << errorMsg;
+        m_lastError = errorMsg;
         emit actionCompleted(action, false, errorMsg);
         return false;
     }
@@ -181,32 +216,8 @@ bool PolicyKitHelper::performPrivilegedOperation(Action action, const QVariantMa
     switch (action) {
     case Action::CreateShare:
     case Action::ModifyShare:
-    case Action::RemoveShare: {
-        QString exportsFile = parameters.value("exportsFile", "/etc/exports").toString();
-        QString shareEntry = parameters.value("shareEntry").toString();
-        
-        if (!createBackup(exportsFile)) {
-            m_lastError = tr("Failed to create backup of exports file");
-            return false;
-        }
-
-        // For this implementation, we'll use a simple approach
-        // In a real implementation, you'd want more sophisticated exports file management
-        if (action == Action::CreateShare || action == Action::ModifyShare) {
-            QFile file(exportsFile);
-            if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
-                m_lastError = tr("Failed to open exports file for writing: %1").arg(file.errorString());
-                return false;
-            }
-            
-            QTextStream stream(&file);
-            stream << shareEntry << "\n";
-            file.close();
-        }
-
-        // Reload NFS exports
-        return executeSystemCommand("exportfs", {"-ra"});
-    }
+    case Action::RemoveShare:
+        return updateShareExports(action, parameters);
 
     case Action::MountRemoteShare: {
         QString source = parameters.value("source").toString();
@@ -234,35 +245,21 @@ bool PolicyKitHelper::performPrivilegedOperation(Action action, const QVariantMa
         return executeSystemCommand("umount", {target});
     }
 
-    case Action::ModifyFstab: {
-        QString fstabFile = "/etc/fstab";
-        QString fstabEntry = parameters.value("fstabEntry").toString();
-        
-        if (!createBackup(fstabFile)) {
-            m_lastError = tr("Failed to create backup of fstab");
-            return false;
-        }
-
-        QFile file(fstabFile);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
-            m_lastError = tr("Failed to open fstab for writing: %1").arg(file.errorString());
-            return false;
-        }
-        
-        QTextStream stream(&file);
-        stream << fstabEntry << "\n";
-        file.close();
-        return true;
-    }
+    case Action::ModifyFstab:
+        return updateFstab(parameters);
 
     case Action::RestartNFSService: {
-        // Try systemctl first, then fall back to service command
-        if (executeSystemCommand("systemctl", {"restart", "nfs-server"})) {
-            return true;
+        // Ask systemd directly; fall back to the init script only without systemd
+        QDBusConnectionInterface *bus = QDBusConnection::systemBus().interface();
+        if (bus && bus->isServiceRegistered("org.freedesktop.systemd1")) {
+            return restartSystemdUnit("nfs-server.service");
         }
         return executeSystemCommand("service", {"nfs-kernel-server", "restart"});
     }
 
+    case Action::TuneBackingDevice:
+        return tuneBackingDevice(parameters);
+
     case Action::ModifySystemFiles: {
         QString filePath = parameters.value("filePath").toString();
         QString content = parameters.value("content").toString();
@@ -290,6 +287,151 @@ bool PolicyKitHelper::performPrivilegedOperation(Action action, const QVariantMa
     }
 }
 
+bool PolicyKitHelper::updateShareExports(Action action, const QVariantMap &parameters)
+{
+    const bool useDirectory = !parameters.contains("exportsFile") &&
+        (parameters.contains("exportsDirectory") || QDir(ExportsDWriter::defaultDirectory()).exists());
+
+    // With exports.d, shares from before it may still be listed in the exports table
+    const QString exportsFile = useDirectory ? parameters.value("legacyExportsFile", "/etc/exports").toString()
+                                             : parameters.value("exportsFile", "/etc/exports").toString();
+    const QString exportsDirectory = useDirectory
+        ? parameters.value("exportsDirectory", ExportsDWriter::defaultDirectory()).toString()
+        : QString();
+
+    ExportTransaction transaction(exportsFile, exportsDirectory,
+                                  [this](const QStringList &arguments, QString *errorMessage) {
+        if (executeSystemCommand("exportfs", arguments)) {
+            return true;
+        }
+        if (errorMessage) {
+            *errorMessage = m_lastError;
+        }
+        return false;
+    });
+
+    QString error;
+    if (!transaction.load(&error)) {
+        m_lastError = tr("Failed to read exports: %1").arg(error);
+        return false;
+    }
+
+    // An empty line removes the share
+    if (action == Action::RemoveShare) {
+        QStringList sharePaths = parameters.value("sharePaths").toStringList();
+        if (parameters.contains("sharePath")) {
+            sharePaths.prepend(parameters.value("sharePath").toString());
+        }
+        for (const QString &sharePath : sharePaths) {
+            transaction.setShare(sharePath, QString());
+        }
+    } else {
+        if (action == Action::ModifyShare) {
+            for (const QString &sharePath : parameters.value("removeSharePaths").toStringList()) {
+                transaction.setShare(sharePath, QString());
+            }
+        }
+        QStringList shareEntries = parameters.value("shareEntries").toStringList();
+        if (parameters.contains("shareEntry")) {
+            shareEntries.prepend(parameters.value("shareEntry").toString());
+        }
+        for (const QString &shareEntry : shareEntries) {
+            transaction.setShare(ExportsDWriter::exportPathOfLine(shareEntry), shareEntry);
+        }
+    }
+
+    if (transaction.rewritesTable() && !createBackup(exportsFile)) {
+        m_lastError = tr("Failed to create backup of exports file");
+        return false;
+    }
+
+    const ExportTransactionResult result = transaction.commit();
+    if (!result.success) {
+        m_lastError = result.restoreFailed ? tr("%1\nThe previous exports could not be restored").arg(result.error)
+                                           : result.error;
+        m_rolledBack = result.rolledBack;
+        return false;
+    }
+    return true;
+}
+
+bool PolicyKitHelper::updateFstab(const QVariantMap &parameters)
+{
+    // Entries replace the line of their mount point in place; nothing is appended twice
+    QStringList fstabEntries = parameters.value("fstabEntries").toStringList();
+    if (parameters.contains("fstabEntry")) {
+        fstabEntries.prepend(parameters.value("fstabEntry").toString());
+    }
+    const QStringList removals = parameters.value("removeMountPoints").toStringList();
+
+    // Fixed here, like the sysfs tree of TuneBackingDevice
+    FstabFile fstab(FstabFile::defaultPath());
+    QString error;
+    if (!fstab.load(&error)) {
+        m_lastError = tr("Failed to read fstab: %1").arg(error);
+        return false;
+    }
+
+    for (const QString &mountPoint : removals) {
+        fstab.removeEntry(mountPoint);
+    }
+    for (const QString &line : fstabEntries) {
+        FstabEntry entry;
+        if (!FstabFile::parseLine(line, &entry)) {
+            m_lastError = tr("Invalid fstab entry: %1").arg(line);
+            return false;
+        }
+        fstab.setEntry(entry);
+    }
+
+    if (!fstab.isModified()) {
+        return true;
+    }
+    if (!createBackup(fstab.filePath())) {
+        m_lastError = tr("Failed to create backup of fstab");
+        return false;
+    }
+    if (!fstab.save(&error)) {
+        m_lastError = tr("Failed to write fstab: %1").arg(error);
+        return false;
+    }
+    return true;
+}
+
+bool PolicyKitHelper::tuneBackingDevice(const QVariantMap &parameters)
+{
+    BdiSettings settings;
+    settings.readAheadKb = parameters.value("readAheadKb", -1).toInt();
+    settings.maxRatio = parameters.value("maxRatio", -1).toInt();
+
+    // Fixed here: the device check only keeps the write inside this tree
+    const BdiTuner tuner(QStringLiteral("/sys/class/bdi"));
+    QString error;
+    if (!tuner.apply(parameters.value("device").toString(), settings, &error)) {
+        m_lastError = tr("Failed to tune backing device: %1").arg(error);
+        return false;
+    }
+    return true;
+}
+
+bool PolicyKitHelper::restartSystemdUnit(const QString &unit)
+{
+    QDBusMessage call = QDBusMessage::createMethodCall("org.freedesktop.systemd1",
+                                                       "/org/freedesktop/systemd1",
+                                                       "org.freedesktop.systemd1.Manager",
+                                                       "RestartUnit");
+    call << unit << QString("replace");
+
+    // The reply arrives once the job is queued, not when the restart is done
+    const QDBusMessage reply = QDBusConnection::systemBus().call(call, QDBus::Block, 30000);
+    if (reply.type() == QDBusMessage::ErrorMessage) {
+        m_lastError = tr("Failed to restart %1: %2").arg(unit, reply.errorMessage());
+        qCWarning(policyKitLog) << "RestartUnit failed:" << unit << reply.errorMessage();
+        return false;
+    }
+    return true;
+}
+
 bool PolicyKitHelper::executeSystemCommand(const QString &command, const QStringList &arguments)
 {
     QProcess process;
@@ -340,10 +482,23 @@ bool PolicyKitHelper::validateParameters(Action action, const QVariantMap &param
     switch (action) {
     case Action::CreateShare:
     case Action::ModifyShare:
+        if (action == Action::ModifyShare && parameters.contains("removeSharePaths")) {
+            const QStringList paths = parameters.value("removeSharePaths").toStringList();
+            const QStringList entries = parameters.value("shareEntries").toStringList();
+            return !paths.isEmpty() && !paths.contains(QString()) && !entries.contains(QString());
+        }
+        if (parameters.contains("shareEntries")) {
+            const QStringList entries = parameters.value("shareEntries").toStringList();
+            return !entries.isEmpty() && !entries.contains(QString());
+        }
         return parameters.contains("shareEntry") && 
                !parameters.value("shareEntry").toString().isEmpty();
 
     case Action::RemoveShare:
+        if (parameters.contains("sharePaths")) {
+            const QStringList paths = parameters.value("sharePaths").toStringList();
+            return !paths.isEmpty() && !paths.contains(QString());
+        }
         return parameters.contains("sharePath") && 
                !parameters.value("sharePath").toString().isEmpty();
 
@@ -357,13 +512,30 @@ bool PolicyKitHelper::validateParameters(Action action, const QVariantMap &param
                !parameters.value("target").toString().isEmpty();
 
     case Action::ModifyFstab:
-        return parameters.contains("fstabEntry") && 
-               !parameters.value("fstabEntry").toString().isEmpty();
+        // A caller-chosen file would let the action write anywhere as root
+        if (parameters.contains("fstabFile")) {
+            return false;
+        }
+        return (parameters.contains("fstabEntry") && !parameters.value("fstabEntry").toString().isEmpty()) ||
+               !parameters.value("fstabEntries").toStringList().isEmpty() ||
+               !parameters.value("removeMountPoints").toStringList().isEmpty();
 
     case Action::ModifySystemFiles:
         return parameters.contains("filePath") && parameters.contains("content") &&
                !parameters.value("filePath").toString().isEmpty();
 
+    case Action::TuneBackingDevice: {
+        // Only a major:minor name, so the write cannot leave the device's directory;
+        // a caller-chosen sysfs tree would let it write anywhere as root
+        if (parameters.contains("sysfsRoot") || !BdiTuner::isDeviceName(parameters.value("device").toString())) {
+            return false;
+        }
+        BdiSettings settings;
+        settings.readAheadKb = parameters.value("readAheadKb", -1).toInt();
+        settings.maxRatio = parameters.value("maxRatio", -1).toInt();
+        return !settings.isEmpty() && BdiTuner::validate(settings);
+    }
+
     case Action::RestartNFSService:
         return true; // No parameters needed
 
@@ -391,6 +563,8 @@ QString PolicyKitHelper::getActionId(Action action)
         return "org.kde.nfs-share-manager.restart-service";
     case Action::ModifySystemFiles:
         return "org.kde.nfs-share-manager.modify-system-files";
+    case Action::TuneBackingDevice:
+        return "org.kde.nfs-share-manager.tune-backing-device";
     default:
         return QString();
     }
@@ -415,6 +589,8 @@ QString PolicyKitHelper::getActionDescription(Action action)
         return tr("Restart the NFS service");
     case Action::ModifySystemFiles:
         return tr("Modify system configuration files");
+    case Action::TuneBackingDevice:
+        return tr("Tune the readahead of an NFS mount");
     default:
         return tr("Unknown action");
     }
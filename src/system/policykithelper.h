@@ -3,6 +3,7 @@
 #include <QObject>
 #include <QDBusInterface>
 #include <QDBusReply>
+#include <QMutex>
 #include <QVariantMap>
 #include <QString>
 #include <QStringList>
@@ -15,6 +16,11 @@ namespace NFSShareManager {
  * This class provides a secure interface for performing privileged operations
  * through PolicyKit authentication. It handles D-Bus communication with the
  * PolicyKit daemon and manages authentication for NFS-related system operations.
+ *
+ * The helper is thread-safe: executePrivilegedAction() and lastError() may
+ * be called from any thread, and privileged actions run one at a time. An
+ * action can take seconds (authorisation, an export reload), so callers
+ * should not run it on the GUI thread where that can be avoided.
  */
 class PolicyKitHelper : public QObject
 {
@@ -32,7 +38,8 @@ public:
         UnmountShare,       ///< Unmount NFS share
         ModifyFstab,        ///< Modify /etc/fstab for persistent mounts
         RestartNFSService,  ///< Restart NFS server service
-        ModifySystemFiles   ///< General system file modifications
+        ModifySystemFiles,  ///< General system file modifications
+        TuneBackingDevice   ///< Set readahead and max_ratio of an NFS mount in /sys/class/bdi
     };
     Q_ENUM(Action)
 
@@ -66,6 +73,18 @@ public:
      */
     bool executePrivilegedAction(Action action, const QVariantMap &parameters = QVariantMap());
 
+    /**
+     * @brief Execute a privileged action and report how a failure left the system
+     * @param action The action to execute
+     * @param parameters Action-specific parameters
+     * @param errorMessage Receives the reason the action failed (optional)
+     * @param rolledBack Set when a failed share batch had changed exports and
+     *                   they were all restored (optional)
+     * @return true if the action was executed successfully, false otherwise
+     */
+    bool executePrivilegedAction(Action action, const QVariantMap &parameters,
+                                 QString *errorMessage, bool *rolledBack);
+
     /**
      * @brief Get human-readable description for an action
      * @param action The action to get description for
@@ -86,6 +105,12 @@ public:
      */
     bool isPolicyKitAvailable() const;
 
+    /**
+     * @brief Get the reason the last privileged action failed
+     * @return Localized error message, empty if none failed yet
+     */
+    QString lastError() const;
+
 signals:
     /**
      * @brief Emitted when an authorization check completes
@@ -122,6 +147,11 @@ private:
      */
     bool initializePolicyKit();
 
+    /**
+     * @brief executePrivilegedAction() without taking m_actionMutex
+     */
+    bool runPrivilegedAction(Action action, const QVariantMap &parameters);
+
     /**
      * @brief Perform actual privileged operation after authentication
      * @param action The action to perform
@@ -130,6 +160,51 @@ private:
      */
     bool performPrivilegedOperation(Action action, const QVariantMap &parameters);
 
+    /**
+     * @brief Apply a CreateShare, ModifyShare or RemoveShare action
+     *
+     * CreateShare and ModifyShare take "shareEntry"/"shareEntries"; a
+     * ModifyShare may also drop shares listed in "removeSharePaths", so a
+     * mixed batch needs a single authorisation. The batch is applied by
+     * ExportTransaction, like NFSServiceInterface::applyExports(): one file
+     * per share in /etc/exports.d (or the "exportsDirectory" parameter)
+     * with a targeted exportfs per share; a share still listed in
+     * /etc/exports (or the "legacyExportsFile" parameter) is dropped from
+     * there. With an "exportsFile" parameter, or without an exports.d
+     * directory, the share's line in the exports table is replaced or
+     * dropped. The batch is all or nothing: if a write or re-export fails,
+     * every touched file is restored and the exports are re-read.
+     *
+     * @param action The share action
+     * @param parameters Action parameters
+     * @return true if successful, false otherwise
+     */
+    bool updateShareExports(Action action, const QVariantMap &parameters);
+
+    /**
+     * @brief Apply fstab entry changes for ModifyFstab
+     *
+     * "fstabEntry"/"fstabEntries" lines add or replace the entry of their
+     * mount point in place, "removeMountPoints" drops entries. Only
+     * /etc/fstab is written, atomically and once.
+     *
+     * @param parameters Action parameters
+     * @return true if successful, false otherwise
+     */
+    bool updateFstab(const QVariantMap &parameters);
+
+    /**
+     * @brief Write backing device settings for TuneBackingDevice
+     *
+     * "device" names the backing device (major:minor) in /sys/class/bdi;
+     * "readAheadKb" and "maxRatio" are written when given. A request that
+     * names another sysfs tree is rejected.
+     *
+     * @param parameters Action parameters
+     * @return true if every given value was written
+     */
+    bool tuneBackingDevice(const QVariantMap &parameters);
+
     /**
      * @brief Execute system command with proper error handling
      * @param command The command to execute
@@ -138,6 +213,13 @@ private:
      */
     bool executeSystemCommand(const QString &command, const QStringList &arguments);
 
+    /**
+     * @brief Queue a restart of a systemd unit over D-Bus
+     * @param unit The unit to restart
+     * @return true if systemd accepted the job
+     */
+    bool restartSystemdUnit(const QString &unit);
+
     /**
      * @brief Create backup of system file before modification
      * @param filePath Path to the file to backup
@@ -156,6 +238,8 @@ private:
     QDBusInterface *m_policyKitInterface;   ///< D-Bus interface to PolicyKit
     bool m_isAvailable;                     ///< Whether PolicyKit is available
     QString m_lastError;                    ///< Last error message
+    bool m_rolledBack;                      ///< Whether the last action undid its export changes
+    mutable QMutex m_actionMutex;           ///< Serialises privileged actions and guards their outcome
 };
 
 } // namespace NFSShareManager
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace NFSShareManager {
+
+/**
+ * @brief Fixed-capacity ring buffer that overwrites its oldest element
+ */
+template<typename T, std::size_t N>
+class RingBuffer
+{
+public:
+    void push(const T &value)
+    {
+        m_items[(m_start + m_size) % N] = value;
+        if (m_size < N) {
+            ++m_size;
+        } else {
+            m_start = (m_start + 1) % N;
+        }
+    }
+
+    /// Element @p index counted from the oldest one
+    const T &at(std::size_t index) const { return m_items[(m_start + index) % N]; }
+    const T &last() const { return at(m_size - 1); }
+    std::size_t size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    void clear() { m_start = 0; m_size = 0; }
+    static constexpr std::size_t capacity() { return N; }
+
+private:
+    std::array<T, N> m_items{};
+    std::size_t m_start = 0;
+    std::size_t m_size = 0;
+};
+
+} // namespace NFSShareManager
@@ -0,0 +1,541 @@
+#include "simulatedcommandbackend.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QThread>
+#include <algorithm>
+
+namespace NFSShareManager {
+
+namespace {
+
+const QStringList simulatedTools = {
+    "exportfs", "showmount", "rpcinfo", "mount", "umount"
+};
+
+QString defaultSimulatedExportsFile()
+{
+    return QDir::tempPath() + QString("/nfs-share-manager-sim-%1/exports").arg(QCoreApplication::applicationPid());
+}
+
+} // namespace
+
+SimulatedCommandBackend::SimulatedCommandBackend(quint32 seed)
+    : m_random(seed)
+    , m_defaultFailureRate(0.0)
+    , m_exportsFilePath(defaultSimulatedExportsFile())
+{
+}
+
+SimulatedCommandBackend::~SimulatedCommandBackend() = default;
+
+std::shared_ptr<SimulatedCommandBackend> SimulatedCommandBackend::fromSpec(const QString &spec)
+{
+    int latency = 0;
+    int jitter = 0;
+    double failure = 0.0;
+    quint32 seed = 0;
+    int servers = 0;
+    int exportsPerServer = 10;
+
+    const QStringList pairs = spec.split(',', Qt::SkipEmptyParts);
+    for (const QString &pair : pairs) {
+        const int equals = pair.indexOf('=');
+        if (equals <= 0) {
+            continue;
+        }
+        const QString key = pair.left(equals).trimmed().toLower();
+        const QString value = pair.mid(equals + 1).trimmed();
+
+        if (key == "latency") {
+            latency = std::max(0, value.toInt());
+        } else if (key == "jitter") {
+            jitter = std::max(0, value.toInt());
+        } else if (key == "failure") {
+            failure = std::clamp(value.toDouble(), 0.0, 1.0);
+        } else if (key == "seed") {
+            seed = value.toUInt();
+        } else if (key == "servers") {
+            servers = std::max(0, value.toInt());
+        } else if (key == "exports") {
+            exportsPerServer = std::max(0, value.toInt());
+        } else {
+            qWarning() << "Ignoring unknown simulator option:" << key;
+        }
+    }
+
+    auto backend = std::make_shared<SimulatedCommandBackend>(seed);
+    backend->setLatency(latency, jitter);
+    backend->setFailureRate(failure);
+    if (servers > 0) {
+        backend->populateRemoteServers(servers, exportsPerServer);
+    }
+    return backend;
+}
+
+QString SimulatedCommandBackend::name() const
+{
+    return QStringLiteral("simulated");
+}
+
+bool SimulatedCommandBackend::isAvailable(const QString &program)
+{
+    QMutexLocker locker(&m_mutex);
+    return simulatedTools.contains(program) && !m_unavailableTools.contains(program);
+}
+
+NFSCommandResult SimulatedCommandBackend::execute(const QString &program, const QStringList &arguments, int timeout)
+{
+    const QString command = program + " " + arguments.join(" ");
+
+    int delayMs = 0;
+    bool injectFailure = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!simulatedTools.contains(program) || m_unavailableTools.contains(program)) {
+            return NFSCommandResult(false, -1, "", QString("Command not found: %1").arg(program), command);
+        }
+        m_commandCounts[program]++;
+
+        const Latency latency = m_latency.value(program, m_defaultLatency);
+        delayMs = latency.baseMs;
+        if (latency.jitterMs > 0) {
+            std::uniform_int_distribution<int> jitter(0, latency.jitterMs);
+            delayMs += jitter(m_random);
+        }
+
+        const double failureRate = m_failureRate.value(program, m_defaultFailureRate);
+        if (m_failNext.value(program) > 0) {
+            m_failNext[program]--;
+            injectFailure = true;
+        } else if (failureRate > 0.0) {
+            std::uniform_real_distribution<double> chance(0.0, 1.0);
+            injectFailure = chance(m_random) < failureRate;
+        }
+    }
+
+    // Sleep outside the lock so concurrent callers overlap like real processes
+    if (timeout > 0 && delayMs > timeout) {
+        QThread::msleep(static_cast<unsigned long>(timeout));
+        return NFSCommandResult(false, -1, "", "Command execution timed out", command);
+    }
+    if (delayMs > 0) {
+        QThread::msleep(static_cast<unsigned long>(delayMs));
+    }
+
+    if (injectFailure) {
+        return failed(1, QString("%1: simulated failure").arg(program), command);
+    }
+
+    if (program == "exportfs") {
+        return runExportfs(arguments, command);
+    } else if (program == "showmount") {
+        return runShowmount(arguments, command);
+    } else if (program == "rpcinfo") {
+        return runRpcinfo(arguments, command);
+    } else if (program == "mount") {
+        return runMount(arguments, command);
+    }
+    return runUmount(arguments, command);
+}
+
+void SimulatedCommandBackend::setLatency(int baseMs, int jitterMs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_defaultLatency.baseMs = std::max(0, baseMs);
+    m_defaultLatency.jitterMs = std::max(0, jitterMs);
+}
+
+void SimulatedCommandBackend::setCommandLatency(const QString &program, int baseMs, int jitterMs)
+{
+    QMutexLocker locker(&m_mutex);
+    Latency latency;
+    latency.baseMs = std::max(0, baseMs);
+    latency.jitterMs = std::max(0, jitterMs);
+    m_latency.insert(program, latency);
+}
+
+void SimulatedCommandBackend::setFailureRate(double rate)
+{
+    QMutexLocker locker(&m_mutex);
+    m_defaultFailureRate = std::clamp(rate, 0.0, 1.0);
+}
+
+void SimulatedCommandBackend::setCommandFailureRate(const QString &program, double rate)
+{
+    QMutexLocker locker(&m_mutex);
+    m_failureRate.insert(program, std::clamp(rate, 0.0, 1.0));
+}
+
+void SimulatedCommandBackend::failNext(const QString &program, int count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_failNext.insert(program, std::max(0, count));
+}
+
+void SimulatedCommandBackend::setToolAvailable(const QString &program, bool available)
+{
+    QMutexLocker locker(&m_mutex);
+    if (available) {
+        m_unavailableTools.remove(program);
+    } else {
+        m_unavailableTools.insert(program);
+    }
+}
+
+void SimulatedCommandBackend::addRemoteServer(const QString &host, const QStringList &exports)
+{
+    QMutexLocker locker(&m_mutex);
+    m_remoteServers.insert(host, exports);
+}
+
+void SimulatedCommandBackend::removeRemoteServer(const QString &host)
+{
+    QMutexLocker locker(&m_mutex);
+    m_remoteServers.remove(host);
+}
+
+void SimulatedCommandBackend::populateRemoteServers(int servers, int exportsPerServer)
+{
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < servers; ++i) {
+        const QString host = QString("10.99.%1.%2").arg(i / 254).arg(i % 254 + 1);
+        QStringList exports;
+        exports.reserve(exportsPerServer);
+        for (int j = 0; j < exportsPerServer; ++j) {
+            exports << QString("/export/share%1").arg(j, 4, 10, QChar('0'));
+        }
+        m_remoteServers.insert(host, exports);
+    }
+}
+
+QStringList SimulatedCommandBackend::remoteServers() const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList hosts = m_remoteServers.keys();
+    hosts.sort();
+    return hosts;
+}
+
+void SimulatedCommandBackend::setExportsFilePath(const QString &filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_exportsFilePath = filePath;
+}
+
+QString SimulatedCommandBackend::exportsFilePath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_exportsFilePath;
+}
+
+QStringList SimulatedCommandBackend::exportedPaths() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_exports.keys();
+}
+
+QStringList SimulatedCommandBackend::mountPoints() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_mounts.keys();
+}
+
+int SimulatedCommandBackend::commandCount(const QString &program) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_commandCounts.value(program, 0);
+}
+
+void SimulatedCommandBackend::resetCounters()
+{
+    QMutexLocker locker(&m_mutex);
+    m_commandCounts.clear();
+}
+
+NFSCommandResult SimulatedCommandBackend::runExportfs(const QStringList &arguments, const QString &command)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QString options;
+    bool unexport = false;
+    bool reload = false;
+    bool all = false;
+    bool verbose = false;
+    QStringList targets;
+
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString &arg = arguments[i];
+        if (arg == "-o") {
+            if (i + 1 >= arguments.size()) {
+                return failed(1, "exportfs: option requires an argument -- 'o'", command);
+            }
+            options = arguments[++i];
+        } else if (arg.startsWith('-')) {
+            // Combined flags such as -ra or -rv
+            for (int c = 1; c < arg.size(); ++c) {
+                switch (arg[c].toLatin1()) {
+                case 'r':
+                    reload = true;
+                    break;
+                case 'a':
+                    all = true;
+                    break;
+                case 'u':
+                    unexport = true;
+                    break;
+                case 'v':
+                    verbose = true;
+                    break;
+                case 'f':
+                case 'i':
+                case 's':
+                    break;
+                default:
+                    return failed(1, QString("exportfs: invalid option -- '%1'").arg(arg[c]), command);
+                }
+            }
+        } else {
+            targets << arg;
+        }
+    }
+
+    if (unexport && all) {
+        // exportfs -ua unexports everything, whatever the exports file says
+        m_exports.clear();
+    } else if (reload || all) {
+        QString error;
+        if (!reloadExportsLocked(&error)) {
+            return failed(1, error, command);
+        }
+    }
+
+    for (const QString &target : targets) {
+        // Accept both "client:/path" and a bare "/path" (exported to everyone)
+        QString client = "*";
+        QString path = target;
+        const int colon = target.indexOf(":/");
+        if (colon > 0) {
+            client = target.left(colon);
+            path = target.mid(colon + 1);
+        }
+        if (!path.startsWith('/')) {
+            return failed(1, QString("exportfs: Invalid export syntax: %1").arg(target), command);
+        }
+
+        if (unexport) {
+            if (!m_exports.contains(path)) {
+                return failed(1, QString("exportfs: Could not find '%1:%2' to unexport.").arg(client, path), command);
+            }
+            m_exports.remove(path);
+        } else {
+            if (!QFileInfo(path).isDir()) {
+                return failed(1, QString("exportfs: Failed to stat %1: No such file or directory").arg(path), command);
+            }
+            m_exports.insert(path, QString("%1(%2)").arg(client, options.isEmpty() ? QString("ro,sync") : options));
+        }
+    }
+
+    if (verbose || (targets.isEmpty() && !reload && !all)) {
+        QString output;
+        for (auto it = m_exports.constBegin(); it != m_exports.constEnd(); ++it) {
+            output += it.key() + "\t" + it.value() + "\n";
+        }
+        return succeeded(output, command);
+    }
+
+    return succeeded(QString(), command);
+}
+
+NFSCommandResult SimulatedCommandBackend::runShowmount(const QStringList &arguments, const QString &command)
+{
+    QString host;
+    for (const QString &arg : arguments) {
+        if (!arg.startsWith('-')) {
+            host = arg;
+        }
+    }
+    if (host.isEmpty()) {
+        host = "localhost";
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_remoteServers.constFind(host);
+    if (it == m_remoteServers.constEnd()) {
+        return failed(1, QString("clnt_create: RPC: Unable to receive; errno = Connection refused"), command);
+    }
+
+    QString output = QString("Export list for %1:\n").arg(host);
+    for (const QString &exportPath : it.value()) {
+        output += exportPath + " *\n";
+    }
+    return succeeded(output, command);
+}
+
+NFSCommandResult SimulatedCommandBackend::runRpcinfo(const QStringList &arguments, const QString &command)
+{
+    QString host;
+    for (const QString &arg : arguments) {
+        if (!arg.startsWith('-')) {
+            host = arg;
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (!host.isEmpty() && !m_remoteServers.contains(host)) {
+        return failed(1, QString("rpcinfo: can't contact portmapper: RPC: Remote system error - Connection refused"), command);
+    }
+
+    const QString output =
+        "   program vers proto   port  service\n"
+        "    100000    4   tcp    111  portmapper\n"
+        "    100000    3   tcp    111  portmapper\n"
+        "    100000    2   tcp    111  portmapper\n"
+        "    100005    3   tcp  20048  mountd\n"
+        "    100003    3   tcp   2049  nfs\n"
+        "    100003    4   tcp   2049  nfs\n";
+    return succeeded(output, command);
+}
+
+NFSCommandResult SimulatedCommandBackend::runMount(const QStringList &arguments, const QString &command)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (arguments.isEmpty()) {
+        QString output;
+        for (auto it = m_mounts.constBegin(); it != m_mounts.constEnd(); ++it) {
+            output += QString("%1 on %2 type nfs (%3)\n").arg(it.value().source, it.key(), it.value().options);
+        }
+        return succeeded(output, command);
+    }
+
+    QString options;
+    QStringList positional;
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString &arg = arguments[i];
+        if (arg == "-t") {
+            ++i; // Only NFS is simulated
+        } else if (arg == "-o") {
+            if (i + 1 < arguments.size()) {
+                options = arguments[++i];
+            }
+        } else if (!arg.startsWith('-')) {
+            positional << arg;
+        }
+    }
+
+    if (positional.size() != 2) {
+        return failed(1, "mount: bad usage", command);
+    }
+
+    const QString source = positional[0];
+    const QString target = QDir::cleanPath(positional[1]);
+
+    if (m_mounts.contains(target)) {
+        return failed(32, QString("mount.nfs: %1 is busy or already mounted").arg(target), command);
+    }
+    if (!QFileInfo(target).isDir()) {
+        return failed(32, QString("mount.nfs: mount point %1 does not exist").arg(target), command);
+    }
+
+    const int colon = source.indexOf(':');
+    if (colon <= 0) {
+        return failed(32, QString("mount.nfs: remote share not in 'host:dir' format"), command);
+    }
+    const QString host = source.left(colon);
+    const QString remotePath = source.mid(colon + 1);
+
+    auto server = m_remoteServers.constFind(host);
+    if (server == m_remoteServers.constEnd()) {
+        return failed(32, QString("mount.nfs: Connection refused for %1 on %2").arg(source, target), command);
+    }
+    if (!server.value().contains(remotePath)) {
+        return failed(32, QString("mount.nfs: access denied by server while mounting %1").arg(source), command);
+    }
+
+    SimulatedMount mount;
+    mount.source = source;
+    mount.options = options.isEmpty() ? QString("rw") : options;
+    m_mounts.insert(target, mount);
+    return succeeded(QString(), command);
+}
+
+NFSCommandResult SimulatedCommandBackend::runUmount(const QStringList &arguments, const QString &command)
+{
+    QStringList targets;
+    for (const QString &arg : arguments) {
+        // -f (force) and -l (lazy) always succeed against the simulated server
+        if (!arg.startsWith('-')) {
+            targets << QDir::cleanPath(arg);
+        }
+    }
+
+    if (targets.isEmpty()) {
+        return failed(1, "umount: bad usage", command);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    for (const QString &target : targets) {
+        if (!m_mounts.contains(target)) {
+            return failed(32, QString("umount: %1: not mounted.").arg(target), command);
+        }
+    }
+    for (const QString &target : targets) {
+        m_mounts.remove(target);
+    }
+    return succeeded(QString(), command);
+}
+
+bool SimulatedCommandBackend::reloadExportsLocked(QString *error)
+{
+    QMap<QString, QString> exports;
+
+    // Like exportfs(8): the exports file, then *.exports in the exports.d next to it
+    QStringList files = {m_exportsFilePath};
+    const QDir exportsDirectory(QFileInfo(m_exportsFilePath).dir().filePath("exports.d"));
+    for (const QString &fileName : exportsDirectory.entryList({"*.exports"}, QDir::Files, QDir::Name)) {
+        files << exportsDirectory.filePath(fileName);
+    }
+
+    for (const QString &filePath : files) {
+        QFile file(filePath);
+        if (!file.exists()) {
+            continue;
+        }
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            *error = QString("exportfs: could not open %1 for locking: %2").arg(filePath, file.errorString());
+            return false;
+        }
+
+        const QStringList lines = QString::fromUtf8(file.readAll()).split('\n');
+        for (const QString &line : lines) {
+            const QString trimmed = line.trimmed();
+            if (trimmed.isEmpty() || trimmed.startsWith('#')) {
+                continue;
+            }
+            const int separator = trimmed.indexOf(QRegularExpression("\\s"));
+            const QString path = separator < 0 ? trimmed : trimmed.left(separator);
+            const QString clients = separator < 0 ? QString("*(ro,sync)") : trimmed.mid(separator + 1).trimmed();
+            exports.insert(path, clients);
+        }
+    }
+
+    m_exports = exports;
+    return true;
+}
+
+NFSCommandResult SimulatedCommandBackend::succeeded(const QString &output, const QString &command)
+{
+    return NFSCommandResult(true, 0, output, "", command);
+}
+
+NFSCommandResult SimulatedCommandBackend::failed(int exitCode, const QString &error, const QString &command)
+{
+    return NFSCommandResult(false, exitCode, "", error, command);
+}
+
+} // namespace NFSShareManager
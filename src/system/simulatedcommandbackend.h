@@ -0,0 +1,182 @@
+#pragma once
+
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <random>
+#include "commandbackend.h"
+
+namespace NFSShareManager {
+
+/**
+ * @brief In-process emulation of the NFS command-line tools
+ *
+ * Emulates the semantics NFSServiceInterface relies on for exportfs,
+ * showmount, rpcinfo, mount and umount: a kernel export table that
+ * "exportfs -r" re-reads from an exports file and the exports.d next to
+ * it, a table of remote servers with their export lists, and a table of
+ * active NFS mounts. Latency and
+ * failure rates can be injected per tool, and all randomness comes from
+ * a seeded generator so runs are reproducible in CI.
+ */
+class SimulatedCommandBackend : public CommandBackend
+{
+public:
+    /**
+     * @brief Create a simulator
+     * @param seed Seed for latency jitter and failure injection
+     */
+    explicit SimulatedCommandBackend(quint32 seed = 0);
+    ~SimulatedCommandBackend() override;
+
+    /**
+     * @brief Create a simulator from a configuration string
+     *
+     * The string is a comma-separated list of key=value pairs: latency and
+     * jitter (ms), failure (rate 0..1), seed, servers and exports (number of
+     * simulated servers and exports per server). Unknown keys are ignored,
+     * so "1" gives a simulator with no latency, no failures and no servers.
+     *
+     * @param spec Configuration string, e.g. "latency=5,failure=0.01,servers=20,exports=500"
+     * @return Configured simulator
+     */
+    static std::shared_ptr<SimulatedCommandBackend> fromSpec(const QString &spec);
+
+    QString name() const override;
+    bool isAvailable(const QString &program) override;
+    NFSCommandResult execute(const QString &program, const QStringList &arguments, int timeout) override;
+
+    /**
+     * @brief Set the latency of every tool
+     * @param baseMs Fixed latency in milliseconds
+     * @param jitterMs Uniform random extra latency in milliseconds
+     */
+    void setLatency(int baseMs, int jitterMs = 0);
+
+    /**
+     * @brief Set the latency of one tool, overriding setLatency()
+     */
+    void setCommandLatency(const QString &program, int baseMs, int jitterMs = 0);
+
+    /**
+     * @brief Set the probability that any tool invocation fails
+     * @param rate Failure probability between 0 and 1
+     */
+    void setFailureRate(double rate);
+
+    /**
+     * @brief Set the failure probability of one tool, overriding setFailureRate()
+     */
+    void setCommandFailureRate(const QString &program, double rate);
+
+    /**
+     * @brief Make the next invocations of a tool fail, regardless of the failure rate
+     * @param program The tool
+     * @param count Number of invocations to fail
+     */
+    void failNext(const QString &program, int count = 1);
+
+    /**
+     * @brief Make a tool appear installed or missing
+     */
+    void setToolAvailable(const QString &program, bool available);
+
+    /**
+     * @brief Add (or replace) a remote NFS server
+     * @param host Host name or address
+     * @param exports Exported paths
+     */
+    void addRemoteServer(const QString &host, const QStringList &exports);
+
+    /**
+     * @brief Remove a remote NFS server
+     */
+    void removeRemoteServer(const QString &host);
+
+    /**
+     * @brief Generate remote servers with large export tables
+     * @param servers Number of servers (10.99.x.y)
+     * @param exportsPerServer Exports on each server
+     */
+    void populateRemoteServers(int servers, int exportsPerServer);
+
+    /**
+     * @brief Get the simulated remote servers
+     */
+    QStringList remoteServers() const;
+
+    /**
+     * @brief Set the exports file re-read by "exportfs -r"
+     */
+    void setExportsFilePath(const QString &filePath);
+
+    /**
+     * @brief Get the exports file re-read by "exportfs -r"
+     */
+    QString exportsFilePath() const override;
+
+    /**
+     * @brief Get the paths in the simulated kernel export table
+     */
+    QStringList exportedPaths() const;
+
+    /**
+     * @brief Get the mount points of the simulated NFS mounts
+     */
+    QStringList mountPoints() const;
+
+    /**
+     * @brief Get how often a tool was invoked
+     */
+    int commandCount(const QString &program) const;
+
+    /**
+     * @brief Reset invocation counters
+     */
+    void resetCounters();
+
+private:
+    struct Latency {
+        int baseMs = 0;
+        int jitterMs = 0;
+    };
+
+    struct SimulatedMount {
+        QString source;
+        QString options;
+    };
+
+    NFSCommandResult runExportfs(const QStringList &arguments, const QString &command);
+    NFSCommandResult runShowmount(const QStringList &arguments, const QString &command);
+    NFSCommandResult runRpcinfo(const QStringList &arguments, const QString &command);
+    NFSCommandResult runMount(const QStringList &arguments, const QString &command);
+    NFSCommandResult runUmount(const QStringList &arguments, const QString &command);
+
+    /**
+     * @brief Re-read the export table from the exports file and its exports.d; m_mutex held
+     */
+    bool reloadExportsLocked(QString *error);
+
+    static NFSCommandResult succeeded(const QString &output, const QString &command);
+    static NFSCommandResult failed(int exitCode, const QString &error, const QString &command);
+
+    mutable QMutex m_mutex;
+    std::mt19937 m_random;                        ///< Seeded generator for jitter and failures
+    Latency m_defaultLatency;                     ///< Latency of tools without an override
+    QHash<QString, Latency> m_latency;            ///< Per-tool latency overrides
+    double m_defaultFailureRate;                  ///< Failure rate of tools without an override
+    QHash<QString, double> m_failureRate;         ///< Per-tool failure rate overrides
+    QHash<QString, int> m_failNext;               ///< Invocations per tool still to fail
+    QSet<QString> m_unavailableTools;             ///< Tools reported as missing
+    QHash<QString, int> m_commandCounts;          ///< Invocations per tool
+    QMap<QString, QString> m_exports;             ///< Kernel export table: path -> client(options)
+    QString m_exportsFilePath;                    ///< File re-read by exportfs -r
+    QHash<QString, QStringList> m_remoteServers;  ///< Remote servers and their exports
+    QMap<QString, SimulatedMount> m_mounts;       ///< Active mounts by mount point
+};
+
+} // namespace NFSShareManager
@@ -0,0 +1,298 @@
+#include "systemdmanager.h"
+
+#include <QDBusConnectionInterface>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusVariant>
+#include <QDir>
+#include <QRegularExpression>
+#include <QDebug>
+
+namespace NFSShareManager {
+
+namespace {
+
+const QString SystemdService = "org.freedesktop.systemd1";
+const QString SystemdPath = "/org/freedesktop/systemd1";
+const QString ManagerInterface = "org.freedesktop.systemd1.Manager";
+const QString UnitInterface = "org.freedesktop.systemd1.Unit";
+const QString PropertiesInterface = "org.freedesktop.DBus.Properties";
+
+QDBusMessage managerCall(const QString &method)
+{
+    return QDBusMessage::createMethodCall(SystemdService, SystemdPath, ManagerInterface, method);
+}
+
+} // namespace
+
+SystemdManager::SystemdManager(QObject *parent)
+    : QObject(parent)
+    , m_bus(QDBusConnection::systemBus())
+    , m_available(false)
+{
+    qRegisterMetaType<UnitStatus>("UnitStatus");
+
+    if (!m_bus.isConnected() || !m_bus.interface() ||
+        !m_bus.interface()->isServiceRegistered(SystemdService)) {
+        qDebug() << "SystemdManager: systemd is not available on the system bus";
+        return;
+    }
+    m_available = true;
+
+    // systemd only broadcasts unit and job signals while a client is subscribed
+    m_bus.asyncCall(managerCall("Subscribe"));
+    m_bus.connect(SystemdService, SystemdPath, ManagerInterface, "JobRemoved",
+                  this, SLOT(onJobRemoved(uint,QDBusObjectPath,QString,QString)));
+}
+
+SystemdManager::~SystemdManager()
+{
+    if (m_available) {
+        m_bus.asyncCall(managerCall("Unsubscribe"));
+    }
+}
+
+bool SystemdManager::isAvailable() const
+{
+    return m_available;
+}
+
+void SystemdManager::watchUnit(const QString &unit)
+{
+    if (m_units.contains(unit)) {
+        return;
+    }
+    UnitStatus status;
+    status.name = unit;
+    m_units.insert(unit, status);
+
+    if (!m_available) {
+        return;
+    }
+
+    // LoadUnit resolves aliases such as nfs-kernel-server.service
+    QDBusMessage call = managerCall("LoadUnit");
+    call << unit;
+    auto *watcher = new QDBusPendingCallWatcher(m_bus.asyncCall(call), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, unit](QDBusPendingCallWatcher *w) {
+        QDBusPendingReply<QDBusObjectPath> reply = *w;
+        w->deleteLater();
+        if (reply.isError()) {
+            qWarning() << "SystemdManager: Cannot load unit" << unit << ":" << reply.error().message();
+            return;
+        }
+        subscribeUnit(unit, reply.value().path());
+    });
+}
+
+QStringList SystemdManager::watchedUnits() const
+{
+    return m_units.keys();
+}
+
+UnitStatus SystemdManager::unitStatus(const QString &unit) const
+{
+    return m_units.value(unit);
+}
+
+bool SystemdManager::isUnitActive(const QString &unit) const
+{
+    return m_units.value(unit).isActive();
+}
+
+bool SystemdManager::requestOperation(const QString &unit, Operation operation)
+{
+    if (!m_available) {
+        return false;
+    }
+
+    QDBusMessage call = managerCall(methodForOperation(operation));
+    call << unit << QString("replace");
+    auto *watcher = new QDBusPendingCallWatcher(m_bus.asyncCall(call), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this,
+            [this, unit, operation](QDBusPendingCallWatcher *w) {
+        QDBusPendingReply<QDBusObjectPath> reply = *w;
+        w->deleteLater();
+        if (reply.isError()) {
+            // Includes PolicyKit refusing org.freedesktop.systemd1.manage-units
+            qWarning() << "SystemdManager:" << methodForOperation(operation) << unit
+                       << "failed:" << reply.error().message();
+            emit jobFinished(unit, operation, false, reply.error().message());
+            return;
+        }
+        m_pendingJobs.insert(reply.value().path(), PendingJob{unit, operation});
+    });
+    return true;
+}
+
+QString SystemdManager::methodForOperation(Operation operation)
+{
+    switch (operation) {
+    case Operation::Start:
+        return "StartUnit";
+    case Operation::Stop:
+        return "StopUnit";
+    case Operation::Restart:
+        return "RestartUnit";
+    case Operation::Reload:
+        return "ReloadUnit";
+    }
+    return QString();
+}
+
+bool SystemdManager::reloadDaemon()
+{
+    if (!m_available) {
+        return false;
+    }
+
+    // Reload returns once the generators ran and units were reloaded
+    auto *watcher = new QDBusPendingCallWatcher(m_bus.asyncCall(managerCall("Reload")), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *w) {
+        QDBusPendingReply<> reply = *w;
+        w->deleteLater();
+        if (reply.isError()) {
+            qWarning() << "SystemdManager: daemon reload failed:" << reply.error().message();
+            emit daemonReloaded(false, reply.error().message());
+            return;
+        }
+        emit daemonReloaded(true, QString());
+    });
+    return true;
+}
+
+QString SystemdManager::escapePath(const QString &path)
+{
+    const QString trimmed = QDir::cleanPath(path).remove(QRegularExpression("^/+|/+$"));
+    if (trimmed.isEmpty()) {
+        return QStringLiteral("-");
+    }
+
+    QString escaped;
+    const QByteArray bytes = trimmed.toUtf8();
+    for (int i = 0; i < bytes.size(); ++i) {
+        const char ch = bytes[i];
+        if (ch == '/') {
+            escaped += '-';
+        } else if ((ch == '.' && i > 0) || ch == '_' || ch == ':' ||
+                   (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z')) {
+            escaped += QLatin1Char(ch);
+        } else {
+            // Everything else, including '-' and UTF-8 bytes, becomes \xNN
+            escaped += QString("\\x%1").arg(uint(static_cast<uchar>(ch)), 2, 16, QChar('0'));
+        }
+    }
+    return escaped;
+}
+
+QString SystemdManager::unitNameForPath(const QString &path, const QString &suffix)
+{
+    return escapePath(path) + '.' + suffix;
+}
+
+void SystemdManager::onUnitPropertiesChanged(const QString &interfaceName, const QVariantMap &changed,
+                                             const QStringList &invalidated, const QDBusMessage &message)
+{
+    if (interfaceName != UnitInterface) {
+        return;
+    }
+    const QString unit = unitForPath(message.path());
+    if (unit.isEmpty()) {
+        return;
+    }
+
+    if (invalidated.contains("ActiveState") || invalidated.contains("SubState")) {
+        fetchUnitState(unit);
+        return;
+    }
+    applyProperties(unit, changed);
+}
+
+void SystemdManager::onJobRemoved(uint id, const QDBusObjectPath &job, const QString &unit, const QString &result)
+{
+    Q_UNUSED(id)
+    Q_UNUSED(unit)
+
+    auto it = m_pendingJobs.find(job.path());
+    if (it == m_pendingJobs.end()) {
+        return;
+    }
+    const PendingJob pending = it.value();
+    m_pendingJobs.erase(it);
+
+    // result is one of done, canceled, timeout, failed, dependency, skipped
+    const bool success = result == "done";
+    emit jobFinished(pending.unit, pending.operation, success,
+                     success ? QString() : tr("systemd job %1").arg(result));
+}
+
+void SystemdManager::subscribeUnit(const QString &unit, const QString &objectPath)
+{
+    auto it = m_units.find(unit);
+    if (it == m_units.end()) {
+        return;
+    }
+    it->objectPath = objectPath;
+
+    m_bus.connect(SystemdService, objectPath, PropertiesInterface, "PropertiesChanged", this,
+                  SLOT(onUnitPropertiesChanged(QString,QVariantMap,QStringList,QDBusMessage)));
+    fetchUnitState(unit);
+}
+
+void SystemdManager::fetchUnitState(const QString &unit)
+{
+    const QString objectPath = m_units.value(unit).objectPath;
+    if (objectPath.isEmpty()) {
+        return;
+    }
+
+    QDBusMessage call = QDBusMessage::createMethodCall(SystemdService, objectPath, PropertiesInterface, "GetAll");
+    call << UnitInterface;
+    auto *watcher = new QDBusPendingCallWatcher(m_bus.asyncCall(call), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, unit](QDBusPendingCallWatcher *w) {
+        QDBusPendingReply<QVariantMap> reply = *w;
+        w->deleteLater();
+        if (reply.isError()) {
+            qWarning() << "SystemdManager: Cannot read state of" << unit << ":" << reply.error().message();
+            return;
+        }
+        applyProperties(unit, reply.value());
+    });
+}
+
+void SystemdManager::applyProperties(const QString &unit, const QVariantMap &properties)
+{
+    auto it = m_units.find(unit);
+    if (it == m_units.end()) {
+        return;
+    }
+
+    const UnitStatus previous = it.value();
+    if (properties.contains("LoadState")) {
+        it->loadState = properties.value("LoadState").toString();
+    }
+    if (properties.contains("ActiveState")) {
+        it->activeState = properties.value("ActiveState").toString();
+    }
+    if (properties.contains("SubState")) {
+        it->subState = properties.value("SubState").toString();
+    }
+
+    if (it->activeState != previous.activeState || it->subState != previous.subState) {
+        const UnitStatus current = it.value();
+        qDebug() << "SystemdManager:" << unit << "is" << current.activeState << "/" << current.subState;
+        emit unitStateChanged(unit, current);
+    }
+}
+
+QString SystemdManager::unitForPath(const QString &objectPath) const
+{
+    for (auto it = m_units.cbegin(); it != m_units.cend(); ++it) {
+        if (it->objectPath == objectPath) {
+            return it.key();
+        }
+    }
+    return QString();
+}
+
+} // namespace NFSShareManager
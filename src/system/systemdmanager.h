@@ -0,0 +1,182 @@
+#pragma once
+
+#include <QObject>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+namespace NFSShareManager {
+
+/**
+ * @brief Cached state of one systemd unit
+ */
+struct UnitStatus {
+    QString name;           ///< Unit name as requested (e.g. "nfs-server.service")
+    QString objectPath;     ///< D-Bus object path of the unit
+    QString loadState;      ///< "loaded", "not-found", "masked", ...
+    QString activeState;    ///< "active", "inactive", "activating", "failed", ...
+    QString subState;       ///< Unit-type specific state (e.g. "exited", "running")
+
+    bool isActive() const { return activeState == "active" || activeState == "reloading"; }
+    bool isKnown() const { return !activeState.isEmpty(); }
+};
+
+/**
+ * @brief Event-driven access to systemd units over D-Bus
+ *
+ * Watched units are resolved with LoadUnit() and their ActiveState is
+ * tracked through the PropertiesChanged signal of each unit object, so
+ * state changes are reported as they happen instead of by polling
+ * systemctl. Start, stop, restart and reload are queued as systemd jobs
+ * with asynchronous Manager calls; systemd authorizes them through
+ * PolicyKit (org.freedesktop.systemd1.manage-units), and the outcome is
+ * reported by jobFinished() once the job is removed.
+ */
+class SystemdManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Job verbs for unit control
+     */
+    enum class Operation {
+        Start,
+        Stop,
+        Restart,
+        Reload
+    };
+    Q_ENUM(Operation)
+
+    explicit SystemdManager(QObject *parent = nullptr);
+    ~SystemdManager();
+
+    /**
+     * @brief Check whether systemd is reachable on the system bus
+     */
+    bool isAvailable() const;
+
+    /**
+     * @brief Start tracking a unit's state
+     * @param unit Unit name, e.g. "nfs-server.service"
+     *
+     * The initial state is fetched asynchronously; unitStateChanged() is
+     * emitted once it is known and on every later change.
+     */
+    void watchUnit(const QString &unit);
+
+    /**
+     * @brief Get the units being tracked
+     */
+    QStringList watchedUnits() const;
+
+    /**
+     * @brief Get the last known state of a watched unit
+     * @param unit Unit name
+     */
+    UnitStatus unitStatus(const QString &unit) const;
+
+    /**
+     * @brief Check whether a watched unit is active
+     * @param unit Unit name
+     */
+    bool isUnitActive(const QString &unit) const;
+
+    /**
+     * @brief Queue a job for a unit
+     * @param unit Unit name
+     * @param operation Job to run
+     * @return False if systemd is not reachable; the job's outcome is reported by jobFinished()
+     */
+    bool requestOperation(const QString &unit, Operation operation);
+
+    bool startUnit(const QString &unit) { return requestOperation(unit, Operation::Start); }
+    bool stopUnit(const QString &unit) { return requestOperation(unit, Operation::Stop); }
+    bool restartUnit(const QString &unit) { return requestOperation(unit, Operation::Restart); }
+    bool reloadUnit(const QString &unit) { return requestOperation(unit, Operation::Reload); }
+
+    /**
+     * @brief Get the Manager method that queues a job
+     * @param operation Job to run
+     * @return Method name such as "RestartUnit"
+     */
+    static QString methodForOperation(Operation operation);
+
+    /**
+     * @brief Ask systemd to reload its configuration (systemctl daemon-reload)
+     *
+     * Re-runs the generators, so units derived from /etc/fstab pick up
+     * edits. The outcome is reported by daemonReloaded().
+     *
+     * @return False if systemd is not reachable
+     */
+    bool reloadDaemon();
+
+    /**
+     * @brief Escape a path the way systemd-escape --path does
+     * @param path Absolute path, e.g. "/mnt/nfs/data"
+     * @return Unit name prefix, e.g. "mnt-nfs-data"; "-" for the root directory
+     */
+    static QString escapePath(const QString &path);
+
+    /**
+     * @brief Get the name of the unit systemd generates for a path
+     * @param path Mount point
+     * @param suffix Unit type, e.g. "mount" or "automount"
+     * @return Unit name such as "mnt-nfs-data.automount"
+     */
+    static QString unitNameForPath(const QString &path, const QString &suffix);
+
+signals:
+    /**
+     * @brief Emitted when a watched unit's ActiveState or SubState changes
+     * @param unit Unit name
+     * @param status New state
+     */
+    void unitStateChanged(const QString &unit, const UnitStatus &status);
+
+    /**
+     * @brief Emitted when a job requested through this object ends
+     * @param unit Unit name
+     * @param operation The job that ran
+     * @param success True if systemd reported the job as done
+     * @param errorMessage D-Bus error or systemd job result otherwise
+     */
+    void jobFinished(const QString &unit, Operation operation, bool success, const QString &errorMessage);
+
+    /**
+     * @brief Emitted when a reloadDaemon() call returns
+     * @param success True if systemd reloaded its configuration
+     * @param errorMessage D-Bus error otherwise
+     */
+    void daemonReloaded(bool success, const QString &errorMessage);
+
+private slots:
+    void onUnitPropertiesChanged(const QString &interfaceName, const QVariantMap &changed,
+                                 const QStringList &invalidated, const QDBusMessage &message);
+    void onJobRemoved(uint id, const QDBusObjectPath &job, const QString &unit, const QString &result);
+
+private:
+    struct PendingJob {
+        QString unit;
+        Operation operation;
+    };
+
+    void subscribeUnit(const QString &unit, const QString &objectPath);
+    void fetchUnitState(const QString &unit);
+    void applyProperties(const QString &unit, const QVariantMap &properties);
+    QString unitForPath(const QString &objectPath) const;
+
+    QDBusConnection m_bus;                      ///< System bus
+    bool m_available;                           ///< Whether systemd owns its bus name
+    QHash<QString, UnitStatus> m_units;         ///< Watched units by name
+    QHash<QString, PendingJob> m_pendingJobs;   ///< Queued jobs by job object path
+};
+
+} // namespace NFSShareManager
+
+Q_DECLARE_METATYPE(NFSShareManager::UnitStatus)
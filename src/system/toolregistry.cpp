@@ -0,0 +1,310 @@
+#include "toolregistry.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QSysInfo>
+
+#include <sys/stat.h>
+
+namespace NFSShareManager {
+
+const QString ToolRegistry::FeatureNconnect = QStringLiteral("nconnect");
+
+namespace {
+
+// Arguments that make a tool print its version; tools without an entry are not probed
+QStringList versionArguments(const QString &name)
+{
+    if (name == "mount.nfs") {
+        return {"-V"};
+    }
+    if (name == "mount" || name == "umount" || name == "showmount") {
+        return {"--version"};
+    }
+    return {};
+}
+
+bool statBinary(const QString &path, quint64 *inode, qint64 *mtime)
+{
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0) {
+        return false;
+    }
+    *inode = static_cast<quint64>(st.st_ino);
+    *mtime = static_cast<qint64>(st.st_mtime);
+    return true;
+}
+
+} // namespace
+
+ToolRegistry &ToolRegistry::instance()
+{
+    static ToolRegistry registry;
+    return registry;
+}
+
+ToolRegistry::ToolRegistry()
+    : m_loaded(false)
+{
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!cacheDir.isEmpty()) {
+        m_cacheFilePath = cacheDir + "/tools.ini";
+    }
+}
+
+ToolInfo ToolRegistry::tool(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    return lookupLocked(name);
+}
+
+ToolInfo ToolRegistry::probedTool(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    ToolInfo &info = lookupLocked(name);
+    if (info.isAvailable() && !info.versionProbed) {
+        probe(info);
+        storeLocked(info);
+    }
+    return info;
+}
+
+QString ToolRegistry::resolvedPath(const QString &name)
+{
+    return tool(name).path;
+}
+
+bool ToolRegistry::isAvailable(const QString &name)
+{
+    return tool(name).isAvailable();
+}
+
+bool ToolRegistry::hasFeature(const QString &name, const QString &feature)
+{
+    return probedTool(name).hasFeature(feature);
+}
+
+void ToolRegistry::invalidate()
+{
+    QMutexLocker locker(&m_mutex);
+    m_tools.clear();
+    m_validated.clear();
+    m_loaded = true;
+    if (!m_cacheFilePath.isEmpty()) {
+        QFile::remove(m_cacheFilePath);
+    }
+}
+
+void ToolRegistry::setCacheFilePath(const QString &filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cacheFilePath = filePath;
+    m_tools.clear();
+    m_validated.clear();
+    m_loaded = false;
+}
+
+QString ToolRegistry::cacheFilePath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cacheFilePath;
+}
+
+QString ToolRegistry::parseVersion(const QString &output)
+{
+    static const QRegularExpression versionPattern("(\\d+(?:\\.\\d+)+)");
+    QRegularExpressionMatch match = versionPattern.match(output);
+    return match.hasMatch() ? match.captured(1) : QString();
+}
+
+int ToolRegistry::compareVersions(const QString &a, const QString &b)
+{
+    const QStringList partsA = a.split('.');
+    const QStringList partsB = b.split('.');
+    const int count = qMax(partsA.size(), partsB.size());
+    for (int i = 0; i < count; ++i) {
+        int valueA = i < partsA.size() ? partsA[i].toInt() : 0;
+        int valueB = i < partsB.size() ? partsB[i].toInt() : 0;
+        if (valueA != valueB) {
+            return valueA < valueB ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+ToolInfo &ToolRegistry::lookupLocked(const QString &name)
+{
+    checkEnvironmentLocked();
+    if (!m_loaded) {
+        loadLocked();
+    }
+
+    auto it = m_tools.find(name);
+    if (it != m_tools.end()) {
+        // Persisted entries are checked against the binary once per run
+        if (m_validated.value(name) || isStillValid(it.value())) {
+            m_validated.insert(name, true);
+            return it.value();
+        }
+        qDebug() << "Tool changed on disk, re-resolving:" << name;
+    }
+
+    // A tool that is still missing changes nothing on disk
+    const bool persisted = it != m_tools.end() && it.value().isAvailable();
+    const ToolInfo resolved = resolve(name);
+    m_tools.insert(name, resolved);
+    m_validated.insert(name, true);
+    if (persisted || resolved.isAvailable()) {
+        storeLocked(resolved);
+    }
+    return m_tools[name];
+}
+
+ToolInfo ToolRegistry::resolve(const QString &name) const
+{
+    ToolInfo info;
+    info.name = name;
+
+    QString path = QStandardPaths::findExecutable(name);
+    if (path.isEmpty()) {
+        // Mount helpers and exportfs commonly live outside a user's PATH
+        path = QStandardPaths::findExecutable(name, {"/usr/sbin", "/sbin"});
+    }
+    if (path.isEmpty()) {
+        return info;
+    }
+
+    info.path = QFileInfo(path).absoluteFilePath();
+    statBinary(info.path, &info.inode, &info.mtime);
+    return info;
+}
+
+void ToolRegistry::probe(ToolInfo &info) const
+{
+    info.versionProbed = true;
+    info.features.clear();
+
+    const QStringList arguments = versionArguments(info.name);
+    if (!arguments.isEmpty()) {
+        QProcess process;
+        process.setProcessChannelMode(QProcess::MergedChannels);
+        process.start(info.path, arguments);
+        if (process.waitForFinished(2000)) {
+            info.version = parseVersion(QString::fromUtf8(process.readAll()));
+        } else {
+            process.kill();
+            process.waitForFinished(500);
+        }
+    }
+
+    // nconnect is handled by the kernel client and mount.nfs passes it through,
+    // so this is inferred from the kernel version (upstream 5.3) rather than
+    // tried: a test mount needs a server and root. Backports are missed.
+    if ((info.name == "mount.nfs" || info.name == "mount")
+        && compareVersions(parseVersion(m_kernelVersion), "5.3") >= 0) {
+        info.features << FeatureNconnect;
+    }
+}
+
+bool ToolRegistry::isStillValid(const ToolInfo &info) const
+{
+    if (!info.isAvailable()) {
+        // Missing tools are never persisted, so this is an in-memory miss
+        return true;
+    }
+    quint64 inode = 0;
+    qint64 mtime = 0;
+    return statBinary(info.path, &inode, &mtime) && inode == info.inode && mtime == info.mtime;
+}
+
+void ToolRegistry::checkEnvironmentLocked()
+{
+    QByteArray pathEnv = qgetenv("PATH");
+    if (m_kernelVersion.isEmpty()) {
+        m_kernelVersion = QSysInfo::kernelVersion();
+    }
+    if (pathEnv != m_pathEnv) {
+        if (!m_tools.isEmpty()) {
+            qDebug() << "PATH changed, dropping resolved tools";
+        }
+        m_pathEnv = pathEnv;
+        m_tools.clear();
+        m_validated.clear();
+        // Reload so that a cache written for the new PATH is still used
+        m_loaded = false;
+    }
+}
+
+void ToolRegistry::loadLocked()
+{
+    m_loaded = true;
+    if (m_cacheFilePath.isEmpty() || !QFile::exists(m_cacheFilePath)) {
+        return;
+    }
+
+    QSettings cache(m_cacheFilePath, QSettings::IniFormat);
+    if (cache.value("path").toByteArray() != m_pathEnv
+        || cache.value("kernel").toString() != m_kernelVersion) {
+        qDebug() << "Tool cache was built for a different PATH or kernel, discarding it";
+        cache.clear();
+        return;
+    }
+
+    cache.beginGroup("tools");
+    const QStringList names = cache.childGroups();
+    for (const QString &name : names) {
+        cache.beginGroup(name);
+        ToolInfo info;
+        info.name = name;
+        info.path = cache.value("path").toString();
+        info.version = cache.value("version").toString();
+        info.features = cache.value("features").toStringList();
+        info.inode = cache.value("inode").toULongLong();
+        info.mtime = cache.value("mtime").toLongLong();
+        info.versionProbed = cache.value("probed", false).toBool();
+        cache.endGroup();
+        if (info.isAvailable()) {
+            m_tools.insert(name, info);
+        }
+    }
+    cache.endGroup();
+}
+
+void ToolRegistry::storeLocked(const ToolInfo &info) const
+{
+    if (m_cacheFilePath.isEmpty()) {
+        return;
+    }
+
+    QDir().mkpath(QFileInfo(m_cacheFilePath).absolutePath());
+    QSettings cache(m_cacheFilePath, QSettings::IniFormat);
+    if (cache.value("path").toByteArray() != m_pathEnv || cache.value("kernel").toString() != m_kernelVersion) {
+        cache.setValue("path", m_pathEnv);
+        cache.setValue("kernel", m_kernelVersion);
+    }
+
+    // Only this tool's group is touched; missing tools are re-checked on the
+    // next run in case they get installed
+    const QString group = "tools/" + info.name;
+    if (!info.isAvailable()) {
+        cache.remove(group);
+    } else {
+        cache.beginGroup(group);
+        cache.setValue("path", info.path);
+        cache.setValue("version", info.version);
+        cache.setValue("features", info.features);
+        cache.setValue("inode", info.inode);
+        cache.setValue("mtime", info.mtime);
+        cache.setValue("probed", info.versionProbed);
+        cache.endGroup();
+    }
+    cache.sync();
+}
+
+} // namespace NFSShareManager
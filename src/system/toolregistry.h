@@ -0,0 +1,167 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMutex>
+
+namespace NFSShareManager {
+
+/**
+ * @brief Resolved system tool with probed version and capabilities
+ */
+struct ToolInfo {
+    QString name;           ///< Tool name as passed to the registry (e.g. "exportfs")
+    QString path;           ///< Absolute path of the binary, empty if not found
+    QString version;        ///< Version string reported by the tool, if probed
+    QStringList features;   ///< Feature flags detected for this tool
+    quint64 inode;          ///< Inode of the binary when it was resolved
+    qint64 mtime;           ///< Modification time (seconds) of the binary when it was resolved
+    bool versionProbed;     ///< Whether the version/feature probe has run
+
+    ToolInfo() : inode(0), mtime(0), versionProbed(false) {}
+
+    /**
+     * @brief Check if the tool was found on the system
+     */
+    bool isAvailable() const { return !path.isEmpty(); }
+
+    /**
+     * @brief Check if a feature flag was detected
+     */
+    bool hasFeature(const QString &feature) const { return features.contains(feature); }
+};
+
+/**
+ * @brief Process-wide registry of resolved NFS tools
+ *
+ * Resolves each tool to an absolute path once instead of scanning PATH
+ * for every command. Results, including probed versions and feature
+ * flags such as mount.nfs nconnect support, are persisted in the cache
+ * directory keyed by the binary's inode and mtime so that later runs can
+ * skip the scan and the probes. The cache is discarded when PATH or the
+ * running kernel changes. All methods are thread-safe.
+ */
+class ToolRegistry
+{
+public:
+    /// Feature flag: mount.nfs/kernel accept the nconnect= mount option (inferred from the kernel version)
+    static const QString FeatureNconnect;
+
+    /**
+     * @brief Get the shared registry instance
+     */
+    static ToolRegistry &instance();
+
+    /**
+     * @brief Resolve a tool, without probing its version
+     * @param name Tool name
+     * @return Resolved tool information
+     */
+    ToolInfo tool(const QString &name);
+
+    /**
+     * @brief Resolve a tool and probe its version and features
+     * @param name Tool name
+     * @return Resolved tool information including version/features
+     */
+    ToolInfo probedTool(const QString &name);
+
+    /**
+     * @brief Get the absolute path of a tool
+     * @param name Tool name
+     * @return Absolute path, or an empty string if the tool is not available
+     */
+    QString resolvedPath(const QString &name);
+
+    /**
+     * @brief Check if a tool is available
+     * @param name Tool name
+     * @return True if the tool was found
+     */
+    bool isAvailable(const QString &name);
+
+    /**
+     * @brief Check if a tool supports a feature (probes on first use)
+     * @param name Tool name
+     * @param feature Feature flag
+     * @return True if the feature was detected
+     */
+    bool hasFeature(const QString &name, const QString &feature);
+
+    /**
+     * @brief Drop all cached results, in memory and on disk
+     */
+    void invalidate();
+
+    /**
+     * @brief Set the file used to persist results
+     * @param filePath Cache file path (empty disables persistence)
+     */
+    void setCacheFilePath(const QString &filePath);
+
+    /**
+     * @brief Get the file used to persist results
+     */
+    QString cacheFilePath() const;
+
+    /**
+     * @brief Extract a version number from a tool's version output
+     * @param output Output of the version probe
+     * @return Version (e.g. "2.6.2"), or an empty string if none was found
+     */
+    static QString parseVersion(const QString &output);
+
+    /**
+     * @brief Compare two dotted version strings
+     * @return Negative, zero or positive like strcmp()
+     */
+    static int compareVersions(const QString &a, const QString &b);
+
+private:
+    ToolRegistry();
+    ToolRegistry(const ToolRegistry &) = delete;
+    ToolRegistry &operator=(const ToolRegistry &) = delete;
+
+    /**
+     * @brief Look up a tool; must be called with m_mutex held
+     */
+    ToolInfo &lookupLocked(const QString &name);
+
+    /**
+     * @brief Search PATH (and sbin directories) for a tool
+     */
+    ToolInfo resolve(const QString &name) const;
+
+    /**
+     * @brief Run the version probe and feature detection for a tool
+     */
+    void probe(ToolInfo &info) const;
+
+    /**
+     * @brief Check whether a cached entry still matches the binary on disk
+     */
+    bool isStillValid(const ToolInfo &info) const;
+
+    /**
+     * @brief Reset the cache if PATH or the kernel changed; m_mutex held
+     */
+    void checkEnvironmentLocked();
+
+    void loadLocked();
+
+    /**
+     * @brief Persist one tool's entry, or drop it if the tool is missing; m_mutex held
+     */
+    void storeLocked(const ToolInfo &info) const;
+
+    mutable QMutex m_mutex;
+    QHash<QString, ToolInfo> m_tools;      ///< Resolved tools by name
+    QHash<QString, bool> m_validated;      ///< Persisted entries checked against disk this run
+    QString m_cacheFilePath;               ///< Persistent cache file
+    QByteArray m_pathEnv;                  ///< PATH the cache was built for
+    QString m_kernelVersion;               ///< Kernel the feature flags were detected on
+    bool m_loaded;                         ///< Whether the persisted cache was read
+};
+
+} // namespace NFSShareManager
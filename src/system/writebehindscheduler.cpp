@@ -0,0 +1,120 @@
+#include "writebehindscheduler.h"
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+
+namespace NFSShareManager {
+
+WriteBehindScheduler::WriteBehindScheduler(FlushFunction flushFunction, QObject *parent)
+    : QObject(parent)
+    , m_flushFunction(std::move(flushFunction))
+    , m_timer(new QTimer(this))
+    , m_delay(500)
+    , m_maxDelay(5000)
+    , m_flushCount(0)
+    , m_flushing(false)
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &WriteBehindScheduler::onTimeout);
+}
+
+WriteBehindScheduler::~WriteBehindScheduler()
+{
+    if (!m_dirty.isEmpty()) {
+        qWarning() << "WriteBehindScheduler destroyed with" << m_dirty.size() << "unsaved changes";
+    }
+}
+
+void WriteBehindScheduler::setDelay(int msecs)
+{
+    m_delay = qMax(0, msecs);
+}
+
+int WriteBehindScheduler::delay() const
+{
+    return m_delay;
+}
+
+void WriteBehindScheduler::setMaxDelay(int msecs)
+{
+    m_maxDelay = qMax(0, msecs);
+}
+
+int WriteBehindScheduler::maxDelay() const
+{
+    return m_maxDelay;
+}
+
+void WriteBehindScheduler::markDirty(const QString &key)
+{
+    if (m_dirty.isEmpty()) {
+        m_oldestChange.start();
+    }
+    m_dirty.insert(key);
+    schedule();
+}
+
+bool WriteBehindScheduler::isDirty() const
+{
+    return !m_dirty.isEmpty();
+}
+
+QStringList WriteBehindScheduler::dirtyKeys() const
+{
+    QStringList keys(m_dirty.cbegin(), m_dirty.cend());
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+bool WriteBehindScheduler::flush()
+{
+    m_timer->stop();
+    if (m_dirty.isEmpty() || m_flushing) {
+        return m_dirty.isEmpty();
+    }
+
+    const QStringList keys = dirtyKeys();
+    m_dirty.clear();
+
+    m_flushing = true;
+    const bool success = m_flushFunction ? m_flushFunction(keys) : false;
+    m_flushing = false;
+    m_flushCount++;
+
+    if (!success) {
+        // Keep the records dirty; changes made during the flush are already in the set
+        qWarning() << "Write-behind flush failed for" << keys.size() << "records, retrying later";
+        if (m_dirty.isEmpty()) {
+            m_oldestChange.start();
+        }
+        for (const QString &key : keys) {
+            m_dirty.insert(key);
+        }
+    }
+
+    if (!m_dirty.isEmpty()) {
+        schedule();
+    }
+
+    emit flushed(success, keys);
+    return success;
+}
+
+int WriteBehindScheduler::flushCount() const
+{
+    return m_flushCount;
+}
+
+void WriteBehindScheduler::onTimeout()
+{
+    flush();
+}
+
+void WriteBehindScheduler::schedule()
+{
+    // Restart the quiet period, but never past the oldest change's deadline
+    const qint64 remaining = qMax<qint64>(0, m_maxDelay - m_oldestChange.elapsed());
+    m_timer->start(static_cast<int>(qMin<qint64>(m_delay, remaining)));
+}
+
+} // namespace NFSShareManager
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+class QTimer;
+
+namespace NFSShareManager {
+
+/**
+ * @brief Coalesces per-record changes into occasional persistence flushes
+ *
+ * Callers mark the records they changed with markDirty(). The flush
+ * function runs once the changes have been quiet for delay() ms, and at
+ * the latest maxDelay() ms after the first unsaved change, so a burst of
+ * N changes costs one save instead of N. A failed flush keeps its records
+ * dirty and is retried after another delay.
+ *
+ * Nothing is flushed on destruction, because the flush function usually
+ * refers to objects that may already be gone; owners call flush() on
+ * shutdown (e.g. from QCoreApplication::aboutToQuit).
+ */
+class WriteBehindScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Persist the current state
+     * @param dirtyKeys Records changed since the last successful flush, sorted
+     * @return True if the state was saved
+     */
+    using FlushFunction = std::function<bool(const QStringList &dirtyKeys)>;
+
+    explicit WriteBehindScheduler(FlushFunction flushFunction, QObject *parent = nullptr);
+    ~WriteBehindScheduler() override;
+
+    /**
+     * @brief Set the quiet period before a flush
+     * @param msecs Delay in milliseconds (default: 500)
+     */
+    void setDelay(int msecs);
+
+    /**
+     * @brief Get the quiet period before a flush
+     */
+    int delay() const;
+
+    /**
+     * @brief Set the longest time a change may stay unsaved
+     * @param msecs Maximum delay in milliseconds (default: 5000)
+     */
+    void setMaxDelay(int msecs);
+
+    /**
+     * @brief Get the longest time a change may stay unsaved
+     */
+    int maxDelay() const;
+
+    /**
+     * @brief Record that a record changed and schedule a flush
+     * @param key Identifier of the changed record
+     */
+    void markDirty(const QString &key);
+
+    /**
+     * @brief Check if any change is waiting to be flushed
+     */
+    bool isDirty() const;
+
+    /**
+     * @brief Get the records waiting to be flushed, sorted
+     */
+    QStringList dirtyKeys() const;
+
+    /**
+     * @brief Flush pending changes now
+     * @return True if nothing was pending or the flush succeeded
+     */
+    bool flush();
+
+    /**
+     * @brief Get the number of times the flush function ran
+     */
+    int flushCount() const;
+
+signals:
+    /**
+     * @brief Emitted after the flush function ran
+     * @param success Whether the state was saved
+     * @param keys Records covered by the flush
+     */
+    void flushed(bool success, const QStringList &keys);
+
+private slots:
+    void onTimeout();
+
+private:
+    void schedule();
+
+    FlushFunction m_flushFunction;    ///< Saves the current state
+    QTimer *m_timer;                  ///< Fires the coalesced flush
+    QElapsedTimer m_oldestChange;     ///< Age of the oldest unsaved change
+    QSet<QString> m_dirty;            ///< Records changed since the last flush
+    int m_delay;                      ///< Quiet period in ms
+    int m_maxDelay;                   ///< Upper bound on unsaved age in ms
+    int m_flushCount;                 ///< Flush function invocations
+    bool m_flushing;                  ///< Guards against re-entrant flushes
+};
+
+} // namespace NFSShareManager
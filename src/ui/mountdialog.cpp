@@ -136,53 +136,8 @@ void MountDialog::accept()
         return;
     }
     
-    // Start the mount operation
-    if (m_mountManager) {
-        m_isMounting = true;
-        updateDialogState();
-        
-        MountManager::MountResult result = m_mountManager->mountShare(
-            m_remoteShare, getMountPoint(), getMountOptions(), isPersistent());
-        
-        if (result == MountManager::MountResult::Success) {
-            QDialog::accept();
-        } else {
-            m_isMounting = false;
-            updateDialogState();
-            
-            QString errorMsg = tr("Mount operation failed");
-            switch (result) {
-            case MountManager::MountResult::InvalidMountPoint:
-                errorMsg = tr("Invalid mount point: The specified directory is not suitable for mounting.");
-                break;
-            case MountManager::MountResult::InvalidRemoteShare:
-                errorMsg = tr("Invalid remote share: The share information is not valid.");
-                break;
-            case MountManager::MountResult::MountPointExists:
-                errorMsg = tr("Mount point in use: Something is already mounted at this location.");
-                break;
-            case MountManager::MountResult::PermissionDenied:
-                errorMsg = tr("Permission denied: You don't have sufficient privileges for this operation.");
-                break;
-            case MountManager::MountResult::NetworkError:
-                errorMsg = tr("Network error: Unable to connect to the remote server.");
-                break;
-            case MountManager::MountResult::NFSServiceError:
-                errorMsg = tr("NFS service error: The NFS service is not available or configured incorrectly.");
-                break;
-            case MountManager::MountResult::SystemError:
-                errorMsg = tr("System error: A system-level error occurred during mounting.");
-                break;
-            case MountManager::MountResult::Cancelled:
-                errorMsg = tr("Operation cancelled by user.");
-                break;
-            default:
-                break;
-            }
-            
-            QMessageBox::warning(this, tr("Mount Failed"), errorMsg);
-        }
-    }
+    // The caller mounts getMount() in the background; the dialog only collects it
+    QDialog::accept();
 }
 
 void MountDialog::onBrowseMountPointClicked()
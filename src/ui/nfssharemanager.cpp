@@ -8,6 +8,10 @@
 #include "../business/mountmanager.h"
 #include "../business/networkdiscovery.h"
 #include "../business/permissionmanager.h"
+#include "../business/desiredstatereconciler.h"
+#include "../system/nfsserviceinterface.h"
+#include "../system/policykithelper.h"
+#include "../system/writebehindscheduler.h"
 #include "notificationmanager.h"
 #include "operationmanager.h"
 #include "sharecreatedialog.h"
@@ -16,6 +20,7 @@
 #include "notificationpreferencesdialog.h"
 
 #include <QApplication>
+#include <QLocale>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -41,6 +46,10 @@
 #include <QBrush>
 #include <QDateTime>
 #include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
 
 namespace NFSShareManager {
 
@@ -52,6 +61,8 @@ NFSShareManagerApp::NFSShareManagerApp(QWidget *parent)
     , m_networkDiscovery(new NetworkDiscovery(this))
     , m_permissionManager(new PermissionManager(this))
     , m_notificationManager(new NotificationManager(m_configurationManager, this))
+    , m_sharePersistence(nullptr)
+    , m_stateReconciler(new DesiredStateReconciler(m_shareManager, m_mountManager, this))
     , m_tabWidget(nullptr)
     , m_statusUpdateTimer(new QTimer(this))
     , m_discoveryTimeoutTimer(new QTimer(this))
@@ -70,6 +81,15 @@ NFSShareManagerApp::NFSShareManagerApp(QWidget *parent)
     setMinimumSize(800, 600);
     resize(1000, 700);
     
+    // Share changes are saved in coalesced batches, not one full save per change
+    m_sharePersistence = new WriteBehindScheduler([this](const QStringList &changedShares) {
+        m_configurationManager->setLocalShares(m_shareManager->getActiveShares());
+        const bool saved = m_configurationManager->saveConfiguration();
+        qDebug() << "Saved shares to configuration," << changedShares.size() << "changed";
+        return saved;
+    }, this);
+    connect(qApp, &QCoreApplication::aboutToQuit, m_sharePersistence, &WriteBehindScheduler::flush);
+
     // Initialize UI
     setupUI();
     
@@ -81,6 +101,10 @@ NFSShareManagerApp::NFSShareManagerApp(QWidget *parent)
     
     // Load configuration
     loadConfiguration();
+
+    // Persistent mounts that did not come up at boot, e.g. because the
+    // server was unreachable, are retried when the user logs in
+    m_mountManager->restorePersistentMounts();
     
     // Setup system tray if available
     setupSystemTray();
@@ -96,6 +120,9 @@ NFSShareManagerApp::NFSShareManagerApp(QWidget *parent)
 NFSShareManagerApp::~NFSShareManagerApp()
 {
     qDebug() << "NFSShareManagerApp: Shutting down";
+
+    // Last chance to save share changes still waiting for the write-behind timer
+    m_sharePersistence->flush();
 }
 
 void NFSShareManagerApp::setupUI()
@@ -155,6 +182,7 @@ void NFSShareManagerApp::setupLocalSharesTab()
     
     // Shares list
     m_localSharesList = new QListWidget();
+    m_localSharesList->setSelectionMode(QAbstractItemView::ExtendedSelection);
     layout->addWidget(m_localSharesList);
     
     // Buttons
@@ -204,11 +232,15 @@ void NFSShareManagerApp::setupRemoteSharesTab()
     // Buttons
     QHBoxLayout *buttonLayout = new QHBoxLayout();
     m_mountShareButton = new QPushButton(tr("Mount Share"));
+    m_autotuneShareButton = new QPushButton(tr("Tune Options"));
+    m_autotuneShareButton->setToolTip(tr("Measure mount options for the server of the selected share; "
+                                         "later mounts of the server use the best set"));
     m_refreshDiscoveryButton = new QPushButton(tr("Refresh"));
     m_discoveryModeButton = new QPushButton(tr("Discovery Mode"));
     m_autoDiscoveryToggle = new QPushButton(tr("Auto Discovery"));
     
     buttonLayout->addWidget(m_mountShareButton);
+    buttonLayout->addWidget(m_autotuneShareButton);
     buttonLayout->addWidget(m_refreshDiscoveryButton);
     buttonLayout->addWidget(m_discoveryModeButton);
     buttonLayout->addWidget(m_autoDiscoveryToggle);
@@ -231,6 +263,7 @@ void NFSShareManagerApp::setupRemoteSharesTab()
     
     // Connect buttons
     connect(m_mountShareButton, &QPushButton::clicked, this, &NFSShareManagerApp::onMountShareClicked);
+    connect(m_autotuneShareButton, &QPushButton::clicked, this, &NFSShareManagerApp::onAutotuneShareClicked);
     connect(m_refreshDiscoveryButton, &QPushButton::clicked, this, &NFSShareManagerApp::onRefreshDiscoveryClicked);
     connect(m_discoveryModeButton, &QPushButton::clicked, this, &NFSShareManagerApp::onDiscoveryModeClicked);
     connect(m_autoDiscoveryToggle, &QPushButton::clicked, this, [this]() {
@@ -251,13 +284,17 @@ void NFSShareManagerApp::setupMountedSharesTab()
     
     // Shares list
     m_mountedSharesList = new QListWidget();
+    m_mountedSharesList->setSelectionMode(QAbstractItemView::ExtendedSelection);
     layout->addWidget(m_mountedSharesList);
     
     // Buttons
     QHBoxLayout *buttonLayout = new QHBoxLayout();
     m_unmountShareButton = new QPushButton(tr("Unmount Share"));
+    m_benchmarkMountButton = new QPushButton(tr("Benchmark"));
+    m_benchmarkMountButton->setToolTip(tr("Measure throughput, IOPS and latency of the selected share"));
     
     buttonLayout->addWidget(m_unmountShareButton);
+    buttonLayout->addWidget(m_benchmarkMountButton);
     buttonLayout->addStretch();
     
     layout->addLayout(buttonLayout);
@@ -266,6 +303,7 @@ void NFSShareManagerApp::setupMountedSharesTab()
     
     // Connect buttons
     connect(m_unmountShareButton, &QPushButton::clicked, this, &NFSShareManagerApp::onUnmountShareClicked);
+    connect(m_benchmarkMountButton, &QPushButton::clicked, this, &NFSShareManagerApp::onBenchmarkMountClicked);
 }
 
 void NFSShareManagerApp::setupMenuBar()
@@ -280,6 +318,12 @@ void NFSShareManagerApp::setupMenuBar()
     fileMenu->addAction(m_exportConfigAction);
     fileMenu->addAction(m_importConfigAction);
     fileMenu->addSeparator();
+
+    m_importInventoryAction = new QAction(tr("Import Share &Inventory..."), this);
+    m_importInventoryAction->setToolTip(tr("Share every directory listed in a text file, one per line"));
+    connect(m_importInventoryAction, &QAction::triggered, this, &NFSShareManagerApp::onImportInventoryClicked);
+    fileMenu->addAction(m_importInventoryAction);
+    fileMenu->addSeparator();
     
     QAction *quitAction = new QAction(tr("&Quit"), this);
     quitAction->setShortcut(QKeySequence::Quit);
@@ -347,7 +391,17 @@ void NFSShareManagerApp::initializeComponents()
 {
     qDebug() << "Initializing components";
     // Components are already created in constructor
-    // This is where we would do additional initialization
+
+    // Export changes go through PolicyKit, one authorisation per batch;
+    // readahead settings only where sysfs is not writable
+    PolicyKitHelper *policyKitHelper = new PolicyKitHelper(this);
+    if (policyKitHelper->isPolicyKitAvailable()) {
+        m_shareManager->setPolicyKitHelper(policyKitHelper);
+        m_mountManager->setPolicyKitHelper(policyKitHelper);
+    } else {
+        qWarning() << "PolicyKit is not available, exports and readahead are written directly";
+        delete policyKitHelper;
+    }
 }
 
 void NFSShareManagerApp::loadConfiguration()
@@ -398,14 +452,129 @@ void NFSShareManagerApp::connectSignals()
     connect(m_shareManager, &ShareManager::shareError, this, &NFSShareManagerApp::onShareError);
     connect(m_shareManager, &ShareManager::sharesRefreshed, this, &NFSShareManagerApp::onSharesRefreshed);
     connect(m_shareManager, &ShareManager::sharesPersistenceRequested, this, &NFSShareManagerApp::onSharesPersistenceRequested);
+    connect(m_shareManager, &ShareManager::sharesCreated, this, &NFSShareManagerApp::updateLocalSharesList);
+    connect(m_shareManager, &ShareManager::sharesRemoved, this, &NFSShareManagerApp::updateLocalSharesList);
+    connect(m_shareManager, &ShareManager::bulkOperationProgress, this, &NFSShareManagerApp::onBulkOperationProgress);
+    connect(m_shareManager, &ShareManager::bulkOperationFinished, this, &NFSShareManagerApp::onBulkOperationFinished);
+    connect(m_shareManager->usageMonitor(), &ShareUsageMonitor::usageUpdated, this, &NFSShareManagerApp::onShareUsageUpdated);
+    connect(m_shareManager, &ShareManager::nfsServerStatusChanged, this, &NFSShareManagerApp::onNFSServerStatusChanged);
+    connect(m_shareManager, &ShareManager::activeClientsChanged, this, &NFSShareManagerApp::onActiveClientsChanged);
+    connect(m_shareManager, &ShareManager::nfsServiceOperationFailed, this,
+            [this](const QString &unit, const QString &error) {
+        if (m_notificationManager) {
+            m_notificationManager->showError(tr("NFS Service Error"),
+                tr("Could not change the state of %1: %2").arg(unit, error));
+        }
+    });
+    connect(m_shareManager->loadMonitor(), &NFSDLoadMonitor::threadPoolStarved, this,
+            [this](const NFSDLoadSummary &summary) {
+        if (m_notificationManager) {
+            m_notificationManager->showWarning(tr("NFS Server Overloaded"),
+                tr("%1% of client requests are waiting for one of the %2 nfsd threads. "
+                   "Consider increasing the number of NFS server threads.")
+                    .arg(qRound(summary.busyFraction * 100)).arg(summary.threads));
+        }
+    });
     
     // Connect MountManager signals
     connect(m_mountManager, &MountManager::mountStarted, this, &NFSShareManagerApp::onMountStarted);
     connect(m_mountManager, &MountManager::mountCompleted, this, &NFSShareManagerApp::onMountCompleted);
     connect(m_mountManager, &MountManager::unmountStarted, this, &NFSShareManagerApp::onUnmountStarted);
     connect(m_mountManager, &MountManager::unmountCompleted, this, &NFSShareManagerApp::onUnmountCompleted);
-    // Note: mountFailed and unmountFailed signals need signature fixes
+    connect(m_mountManager, &MountManager::unmountFailed, this, &NFSShareManagerApp::onUnmountFailed);
+    connect(m_mountManager, &MountManager::backingDeviceTuningFailed, this,
+            [this](const QString &mountPoint, const QString &error) {
+        m_notificationManager->showWarning(tr("Readahead Not Applied"),
+            tr("Could not tune the readahead of %1: %2").arg(mountPoint, error));
+    });
+    connect(m_mountManager, &MountManager::mountStatisticsUpdated, this, &NFSShareManagerApp::onMountStatisticsUpdated);
+    connect(m_mountManager, &MountManager::mountStatusChanged, this, &NFSShareManagerApp::onMountStatusChanged);
+    connect(m_mountManager, &MountManager::mountFailed, this,
+            [this](const RemoteNFSShare &remoteShare, const QString &mountPoint, MountManager::MountResult result,
+                   const QString &errorMessage) {
+        onMountFailed(remoteShare, mountPoint, static_cast<int>(result), errorMessage);
+    });
+
+    // Benchmarks run on worker threads and report through the operation manager
+    connect(m_mountManager->benchmark(), &MountBenchmark::progress, this, [this](int percent, const QString &stage) {
+        if (m_operationManager->hasOperation(m_benchmarkOperationId)) {
+            m_operationManager->updateProgress(m_benchmarkOperationId, percent, stage);
+        }
+    });
+    connect(m_mountManager->benchmark(), &MountBenchmark::finished, this, [this](const BenchmarkResult &result) {
+        if (!m_operationManager->hasOperation(m_benchmarkOperationId)) {
+            return;
+        }
+        if (result.success) {
+            m_operationManager->completeOperation(m_benchmarkOperationId, result.summary());
+        } else if (!result.cancelled) {
+            m_operationManager->failOperation(m_benchmarkOperationId, result.errorMessage);
+        }
+        m_benchmarkOperationId = QUuid();
+    });
+
+    // Autotuning mounts candidates on a worker thread and reports the same way
+    connect(m_mountManager->autotuner(), &MountAutotuner::progress, this,
+            [this](int current, int total, const QString &description) {
+        if (m_operationManager->hasOperation(m_autotuneOperationId)) {
+            m_operationManager->updateProgress(m_autotuneOperationId, (current - 1) * 100 / qMax(1, total),
+                                               description);
+        }
+    });
+    connect(m_mountManager->autotuner(), &MountAutotuner::finished, this,
+            [this](const RemoteNFSShare &remoteShare, const TuningResult &result) {
+        if (!m_operationManager->hasOperation(m_autotuneOperationId)) {
+            return;
+        }
+        if (result.success) {
+            m_operationManager->completeOperation(m_autotuneOperationId,
+                tr("Mounts of %1 now use %2").arg(MountAutotuner::serverKey(remoteShare), result.candidate.label()));
+        } else {
+            m_operationManager->failOperation(m_autotuneOperationId, result.errorMessage);
+        }
+        m_autotuneOperationId = QUuid();
+    });
+
+    // Temporary mounts go away with the application within a second, even if their
+    // servers are gone. commitDataRequest is not used: it also comes for session
+    // checkpoints, while a session that really ends quits the application
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
+        const QStringList remaining = m_mountManager->unmountForShutdown();
+        if (m_operationManager->hasOperation(m_shutdownOperationId)) {
+            if (remaining.isEmpty()) {
+                m_operationManager->completeOperation(m_shutdownOperationId, tr("Temporary shares unmounted"));
+            } else {
+                m_operationManager->failOperation(m_shutdownOperationId,
+                    tr("Still mounted: %1").arg(remaining.join(", ")));
+            }
+        }
+    });
+    connect(m_mountManager->shutdownUnmounter(), &ShutdownUnmounter::stepStarted, this,
+            [this](const QString &mountPoint, ShutdownUnmounter::Step step) {
+        if (!m_operationManager->hasOperation(m_shutdownOperationId)) {
+            m_shutdownOperationId = m_operationManager->startOperation(
+                tr("Unmounting temporary shares"), tr("Unmounting %1").arg(mountPoint), false);
+        }
+        if (step != ShutdownUnmounter::Step::Unmount) {
+            m_operationManager->updateProgress(m_shutdownOperationId, 50,
+                step == ShutdownUnmounter::Step::Lazy ? tr("%1 does not respond, detaching it").arg(mountPoint)
+                                                      : tr("%1 does not respond, forcing the unmount").arg(mountPoint));
+        }
+    });
     
+    // Configuration changes are applied in the background, mounts last
+    connect(m_stateReconciler, &DesiredStateReconciler::finished, this, [this](const ReconcileResult &result) {
+        if (result.success) {
+            m_notificationManager->showSuccess(tr("Applied %n configuration change(s)", "", result.applied));
+        } else {
+            m_notificationManager->showError(tr("Apply Configuration Failed"),
+                                             tr("%1 change(s) failed:\n%2")
+                                                 .arg(result.errors.size())
+                                                 .arg(result.errors.join('\n')));
+        }
+        refreshAll();
+    });
+
     // Connect NetworkDiscovery signals
     connect(m_networkDiscovery, &NetworkDiscovery::discoveryCompleted, this, &NFSShareManagerApp::onDiscoveryCompleted);
     connect(m_networkDiscovery, &NetworkDiscovery::discoveryStarted, this, &NFSShareManagerApp::onDiscoveryStarted);
@@ -437,26 +606,46 @@ void NFSShareManagerApp::onCreateShareClicked()
 
 void NFSShareManagerApp::onRemoveShareClicked()
 {
-    QListWidgetItem *currentItem = m_localSharesList->currentItem();
-    if (!currentItem) {
+    const QList<QListWidgetItem *> selectedItems = m_localSharesList->selectedItems();
+    if (selectedItems.isEmpty()) {
         QMessageBox::information(this, tr("Remove Share"), tr("Please select a share to remove."));
         return;
     }
     
-    QString sharePath = currentItem->data(Qt::UserRole).toString();
+    QStringList sharePaths;
+    for (QListWidgetItem *item : selectedItems) {
+        sharePaths << item->data(Qt::UserRole).toString();
+    }
     
-    int ret = QMessageBox::question(this, tr("Remove Share"), 
-                                   tr("Are you sure you want to remove the NFS share at:\n%1").arg(sharePath),
+    QString message = sharePaths.size() == 1
+        ? tr("Are you sure you want to remove the NFS share at:\n%1").arg(sharePaths.first())
+        : tr("Are you sure you want to remove these %1 NFS shares?\n%2").arg(sharePaths.size()).arg(sharePaths.join('\n'));
+    QList<NFSClientInfo> clients;
+    for (const QString &sharePath : sharePaths) {
+        clients << m_shareManager->activeClients(sharePath);
+    }
+    if (!clients.isEmpty()) {
+        message += tr("\n\nThe following clients are using these shares and will lose access:\n%1")
+                       .arg(formatClientList(clients));
+    }
+    
+    int ret = QMessageBox::question(this, tr("Remove Share"), message,
                                    QMessageBox::Yes | QMessageBox::No);
+    if (ret != QMessageBox::Yes) {
+        return;
+    }
     
-    if (ret == QMessageBox::Yes) {
-        bool result = m_shareManager->removeShare(sharePath);
+    if (sharePaths.size() == 1) {
+        bool result = m_shareManager->removeShare(sharePaths.first());
         if (!result) {
             // Only show error if removal failed - success notification comes from signal
-            m_notificationManager->showError(tr("Remove Share Failed"), tr("Failed to remove NFS share at %1").arg(sharePath));
+            m_notificationManager->showError(tr("Remove Share Failed"), tr("Failed to remove NFS share at %1").arg(sharePaths.first()));
         }
         // Note: Success notification and UI update will come from the shareRemoved signal
+    } else if (!m_shareManager->removeShares(sharePaths)) {
+        m_notificationManager->showWarning(tr("Remove Shares"), tr("Another share operation is still running."));
     }
+    // Note: The outcome of a batch is reported by onBulkOperationFinished()
 }
 
 void NFSShareManagerApp::onEditShareClicked()
@@ -501,50 +690,72 @@ void NFSShareManagerApp::onMountShareClicked()
     
     MountDialog dialog(remoteShare, m_mountManager, this);
     if (dialog.exec() == QDialog::Accepted) {
-        QString mountPoint = dialog.getMountPoint();
-        MountOptions options = dialog.getMountOptions();
-        bool isPersistent = dialog.isPersistent();
-        
-        // Start mount operation
-        auto result = m_mountManager->mountShare(remoteShare, mountPoint, options, isPersistent);
-        
-        if (result == MountManager::MountResult::Success) {
-            m_notificationManager->showSuccess(tr("Successfully mounted %1:%2 at %3")
-                                             .arg(remoteShare.hostAddress().toString())
-                                             .arg(remoteShare.exportPath())
-                                             .arg(mountPoint));
-            updateMountedSharesList();
-        } else {
-            QString errorMsg = tr("Mount failed with error code: %1").arg(static_cast<int>(result));
-            m_notificationManager->showError(tr("Mount Failed"), errorMsg);
-        }
+        // Mounts off the GUI thread; the result comes from mountCompleted or mountFailed
+        m_mountManager->mountShares({dialog.getMount()});
     }
 }
 
-void NFSShareManagerApp::onUnmountShareClicked()
+void NFSShareManagerApp::onAutotuneShareClicked()
 {
-    QListWidgetItem *currentItem = m_mountedSharesList->currentItem();
+    QListWidgetItem *currentItem = m_remoteSharesList->currentItem();
     if (!currentItem) {
+        QMessageBox::information(this, tr("Tune Options"), tr("Please select a remote share to tune."));
+        return;
+    }
+
+    const RemoteNFSShare remoteShare = currentItem->data(Qt::UserRole).value<RemoteNFSShare>();
+    if (!m_mountManager->autotuneMountOptions(remoteShare)) {
+        QMessageBox::information(this, tr("Tune Options"), tr("Mount options are already being tuned."));
+        return;
+    }
+
+    MountAutotuner *autotuner = m_mountManager->autotuner();
+    m_autotuneOperationId = m_operationManager->startOperation(
+        tr("Tuning mount options for %1").arg(MountAutotuner::serverKey(remoteShare)),
+        tr("Measuring candidate options"), true, [autotuner]() { autotuner->cancel(); });
+}
+
+void NFSShareManagerApp::onUnmountShareClicked()
+{
+    QStringList mountPoints;
+    for (const QListWidgetItem *item : m_mountedSharesList->selectedItems()) {
+        mountPoints << item->data(Qt::UserRole).toString();
+    }
+    if (mountPoints.isEmpty()) {
         QMessageBox::information(this, tr("Unmount Share"), tr("Please select a mounted share to unmount."));
         return;
     }
     
-    QString mountPoint = currentItem->data(Qt::UserRole).toString();
-    
     int ret = QMessageBox::question(this, tr("Unmount Share"), 
-                                   tr("Are you sure you want to unmount:\n%1").arg(mountPoint),
+                                   tr("Are you sure you want to unmount:\n%1").arg(mountPoints.join('\n')),
                                    QMessageBox::Yes | QMessageBox::No);
     
     if (ret == QMessageBox::Yes) {
-        bool result = m_mountManager->unmountShare(mountPoint);
-        
-        if (result) {
-            m_notificationManager->showSuccess(tr("Successfully unmounted %1").arg(mountPoint));
-            updateMountedSharesList();
-        } else {
-            m_notificationManager->showError(tr("Unmount Failed"), tr("Failed to unmount %1").arg(mountPoint));
-        }
+        // All selected shares go in one batch, nested mount points first
+        m_mountManager->unmountShares(mountPoints);
+    }
+}
+
+void NFSShareManagerApp::onBenchmarkMountClicked()
+{
+    QListWidgetItem *currentItem = m_mountedSharesList->currentItem();
+    if (!currentItem) {
+        QMessageBox::information(this, tr("Benchmark"), tr("Please select a mounted share to benchmark."));
+        return;
+    }
+
+    const QString mountPoint = currentItem->data(Qt::UserRole).toString();
+    if (!m_mountManager->benchmarkMount(mountPoint)) {
+        QMessageBox::information(this, tr("Benchmark"),
+                                 tr("%1 cannot be benchmarked now. It must be mounted and no other benchmark may be running.")
+                                     .arg(mountPoint));
+        return;
     }
+
+    MountBenchmark *benchmark = m_mountManager->benchmark();
+    m_benchmarkOperationId = m_operationManager->startOperation(
+        tr("Benchmarking %1").arg(mountPoint), tr("Preparing test files"), true,
+        [benchmark]() { benchmark->cancel(); });
 }
 
 void NFSShareManagerApp::onRefreshDiscoveryClicked()
@@ -625,8 +836,12 @@ void NFSShareManagerApp::quitApplication()
     // Set flag to indicate explicit quit (bypass system tray dialog)
     m_explicitQuit = true;
     
-    // Save configuration before quitting
-    m_configurationManager->saveConfiguration();
+    // Save configuration before quitting, including pending share changes
+    if (m_sharePersistence->isDirty()) {
+        m_sharePersistence->flush();
+    } else {
+        m_configurationManager->saveConfiguration();
+    }
     
     // Stop any ongoing operations
     if (m_networkDiscovery) {
@@ -638,7 +853,7 @@ void NFSShareManagerApp::quitApplication()
         m_statusUpdateTimer->stop();
     }
     
-    // Quit the application completely
+    // Quit the application completely; temporary mounts are unmounted on aboutToQuit
     QApplication::quit();
 }
 
@@ -671,6 +886,7 @@ void NFSShareManagerApp::hideToTray()
 
 void NFSShareManagerApp::refreshAll()
 {
+    m_shareManager->usageMonitor()->refreshAll();
     updateLocalSharesList();
     updateMountedSharesList();
     onRefreshDiscoveryClicked();
@@ -832,6 +1048,8 @@ bool NFSShareManagerApp::importConfiguration(const QString &filePath, bool merge
         bool success = m_configurationManager->importConfiguration(filePath, mergeMode);
         if (success) {
             m_notificationManager->showSuccess(tr("Configuration imported successfully from %1").arg(filePath));
+            // Apply only what differs from the live system, in one batch
+            applyConfigurationState();
             // Refresh all UI components
             refreshAll();
         } else {
@@ -844,6 +1062,38 @@ bool NFSShareManagerApp::importConfiguration(const QString &filePath, bool merge
     }
 }
 
+bool NFSShareManagerApp::applyConfigurationState()
+{
+    const DesiredState desired = DesiredStateReconciler::desiredStateOf(m_configurationManager);
+    const ReconcilePlan plan = m_stateReconciler->plan(desired);
+    if (plan.isEmpty()) {
+        qDebug() << "Configuration state already applied," << plan.unchanged << "entries unchanged";
+        return true;
+    }
+
+    // Dry run first: the user sees every change before anything is touched
+    QMessageBox confirm(QMessageBox::Question, tr("Apply Configuration"),
+                        tr("%n change(s) are needed to apply the configuration; "
+                           "%1 entries already match.", "", plan.steps.size()).arg(plan.unchanged),
+                        QMessageBox::Apply | QMessageBox::Cancel, this);
+    QStringList details = plan.describe();
+    if (!plan.conflicts.isEmpty()) {
+        details << QString() << tr("Left unchanged:") << plan.conflicts;
+    }
+    confirm.setDetailedText(details.join('\n'));
+    if (confirm.exec() != QMessageBox::Apply) {
+        return false;
+    }
+
+    // Mounts run in the background; the outcome is reported from DesiredStateReconciler::finished
+    if (!m_stateReconciler->execute(plan)) {
+        m_notificationManager->showError(tr("Apply Configuration Failed"),
+                                         tr("The previous configuration is still being applied."));
+        return false;
+    }
+    return true;
+}
+
 void NFSShareManagerApp::closeEvent(QCloseEvent *event)
 {
     // Only show system tray dialog if we're not explicitly quitting
@@ -937,69 +1187,127 @@ void NFSShareManagerApp::onSharesRefreshed()
 
 void NFSShareManagerApp::onNFSServerStatusChanged(bool running)
 {
-    Q_UNUSED(running)
-    qDebug() << "NFS server status changed (stub)";
+    qDebug() << "NFS server status changed:" << (running ? "running" : "stopped");
+    QString status = running ? tr("running") : tr("stopped");
+    showStatusMessage(tr("NFS server is %1").arg(status));
 }
 
-void NFSShareManagerApp::onSharesPersistenceRequested()
+void NFSShareManagerApp::onSharesPersistenceRequested(const QStringList &sharePaths)
 {
-    qDebug() << "Saving shares to configuration";
-    
-    // Get current shares from ShareManager
-    QList<NFSShare> currentShares = m_shareManager->getActiveShares();
-    
-    // Save to configuration
-    m_configurationManager->setLocalShares(currentShares);
-    m_configurationManager->saveConfiguration();
+    // Saved once the burst of changes settles
+    for (const QString &sharePath : sharePaths) {
+        m_sharePersistence->markDirty(sharePath);
+    }
+}
+
+void NFSShareManagerApp::onBulkOperationProgress(int progress, const QString &statusMessage)
+{
+    if (m_currentBulkOperationId.isNull() || !m_operationManager->hasOperation(m_currentBulkOperationId)) {
+        m_currentBulkOperationId = m_operationManager->startOperation(tr("Updating Shares"), statusMessage, false);
+    }
     
-    qDebug() << "Saved" << currentShares.size() << "shares to configuration";
+    if (progress >= 100) {
+        m_operationManager->completeOperation(m_currentBulkOperationId, statusMessage);
+        m_currentBulkOperationId = QUuid();
+    } else {
+        m_operationManager->updateProgress(m_currentBulkOperationId, progress, statusMessage);
+    }
 }
 
 void NFSShareManagerApp::onMountStarted(const RemoteNFSShare &remoteShare, const QString &mountPoint)
 {
-    Q_UNUSED(remoteShare)
-    Q_UNUSED(mountPoint)
-    qDebug() << "Mount started (stub)";
+    showStatusMessage(tr("Mounting %1 at %2...").arg(remoteShare.exportPath(), mountPoint));
 }
 
 void NFSShareManagerApp::onMountCompleted(const NFSMount &mount)
 {
-    Q_UNUSED(mount)
-    qDebug() << "Mount completed (stub)";
+    m_notificationManager->showSuccess(tr("Successfully mounted %1 at %2")
+                                           .arg(mount.remoteShare().exportPath(), mount.localMountPoint()));
+    updateMountedSharesList();
 }
 
 void NFSShareManagerApp::onMountFailed(const RemoteNFSShare &remoteShare, const QString &mountPoint, int result, const QString &errorMessage)
 {
-    Q_UNUSED(remoteShare)
-    Q_UNUSED(mountPoint)
     Q_UNUSED(result)
-    Q_UNUSED(errorMessage)
-    qDebug() << "Mount failed (stub)";
+    m_notificationManager->showError(tr("Mount Failed"), tr("Failed to mount %1 at %2: %3")
+                                         .arg(remoteShare.exportPath(), mountPoint, errorMessage));
 }
 
 void NFSShareManagerApp::onUnmountStarted(const QString &mountPoint)
 {
-    Q_UNUSED(mountPoint)
-    qDebug() << "Unmount started (stub)";
+    showStatusMessage(tr("Unmounting %1...").arg(mountPoint));
 }
 
 void NFSShareManagerApp::onUnmountCompleted(const QString &mountPoint)
 {
-    Q_UNUSED(mountPoint)
-    qDebug() << "Unmount completed (stub)";
+    m_notificationManager->showSuccess(tr("Successfully unmounted %1").arg(mountPoint));
+    updateMountedSharesList();
 }
 
 void NFSShareManagerApp::onUnmountFailed(const QString &mountPoint, const QString &errorMessage)
 {
-    Q_UNUSED(mountPoint)
-    Q_UNUSED(errorMessage)
-    qDebug() << "Unmount failed (stub)";
+    m_notificationManager->showError(tr("Unmount Failed"), tr("Failed to unmount %1: %2").arg(mountPoint, errorMessage));
 }
 
 void NFSShareManagerApp::onMountStatusChanged(const NFSMount &mount)
 {
-    Q_UNUSED(mount)
-    qDebug() << "Mount status changed (stub)";
+    qDebug() << "Mount status changed:" << mount.localMountPoint() << mount.errorMessage();
+
+    // Update the item in place; rebuilding the list would reset the selection
+    for (int i = 0; i < m_mountedSharesList->count(); ++i) {
+        QListWidgetItem *item = m_mountedSharesList->item(i);
+        if (item->data(Qt::UserRole).toString() == mount.localMountPoint()) {
+            item->setIcon(getMountStatusIcon(mount));
+            item->setToolTip(formatMountStatus(mount));
+            break;
+        }
+    }
+}
+
+void NFSShareManagerApp::onMountStatisticsUpdated()
+{
+    // Refresh tooltips in place so the selection and scroll position are kept
+    const QList<NFSMount> mounts = m_mountManager->getManagedMounts();
+    for (int i = 0; i < m_mountedSharesList->count(); ++i) {
+        QListWidgetItem *item = m_mountedSharesList->item(i);
+        const QString mountPoint = item->data(Qt::UserRole).toString();
+        for (const NFSMount &mount : mounts) {
+            if (mount.localMountPoint() == mountPoint) {
+                item->setToolTip(formatMountStatus(mount));
+                break;
+            }
+        }
+    }
+}
+
+void NFSShareManagerApp::onActiveClientsChanged()
+{
+    // Refresh tooltips in place so the selection and scroll position are kept
+    const QList<NFSShare> shares = m_shareManager->getActiveShares();
+    for (int i = 0; i < m_localSharesList->count(); ++i) {
+        QListWidgetItem *item = m_localSharesList->item(i);
+        const QString sharePath = item->data(Qt::UserRole).toString();
+        for (const NFSShare &share : shares) {
+            if (share.path() == sharePath) {
+                item->setToolTip(formatShareStatus(share));
+                break;
+            }
+        }
+    }
+}
+
+void NFSShareManagerApp::onShareUsageUpdated(const QString &sharePath, const ShareUsage &usage)
+{
+    Q_UNUSED(usage)
+    
+    // Update the text in place so the selection is kept
+    for (int i = 0; i < m_localSharesList->count(); ++i) {
+        QListWidgetItem *item = m_localSharesList->item(i);
+        if (item->data(Qt::UserRole).toString() == sharePath) {
+            item->setText(formatShareItemText(sharePath));
+            break;
+        }
+    }
 }
 
 void NFSShareManagerApp::onShareDiscovered(const RemoteNFSShare &share)
@@ -1087,6 +1395,9 @@ void NFSShareManagerApp::onDiscoveryCompleted(int sharesFound, int hostsScanned)
     // Update status
     m_remoteSharesStatus->setText(tr("Discovery completed - %1 shares found").arg(sharesFound));
     
+    // Shares exported by several servers become replicas of each other
+    m_mountManager->setKnownShares(m_networkDiscovery->getDiscoveredShares());
+    
     // Update the remote shares list
     updateRemoteSharesList();
     
@@ -1245,7 +1556,7 @@ void NFSShareManagerApp::updateLocalSharesList()
     
     for (const NFSShare &share : shares) {
         QListWidgetItem *item = new QListWidgetItem(m_localSharesList);
-        item->setText(tr("%1").arg(share.path()));
+        item->setText(formatShareItemText(share.path()));
         item->setData(Qt::UserRole, share.path());
         item->setIcon(getShareStatusIcon(share));
         item->setToolTip(formatShareStatus(share));
@@ -1368,9 +1679,33 @@ QString NFSShareManagerApp::formatShareStatus(const NFSShare &share) const
                      .arg(share.path())
                      .arg(share.isActive() ? tr("Active") : tr("Inactive"));
     
+    const QList<NFSClientInfo> clients = m_shareManager->activeClients(share.path());
+    if (!clients.isEmpty()) {
+        tooltip += tr("\nActive clients:\n%1").arg(formatClientList(clients));
+    }
+    
     return tooltip;
 }
 
+QString NFSShareManagerApp::formatClientList(const QList<NFSClientInfo> &clients) const
+{
+    QStringList lines;
+    for (const NFSClientInfo &client : clients) {
+        lines << tr("• %1 (%2)").arg(client.address, client.protocol);
+    }
+    return lines.join('\n');
+}
+
+QString NFSShareManagerApp::formatShareItemText(const QString &sharePath) const
+{
+    const ShareUsage usage = m_shareManager->usageMonitor()->usage(sharePath);
+    if (!usage.complete) {
+        return sharePath;
+    }
+    return tr("%1 (%2, %3 files)")
+        .arg(sharePath, QLocale().formattedDataSize(usage.bytes), QLocale().toString(usage.files));
+}
+
 QString NFSShareManagerApp::formatMountStatus(const NFSMount &mount) const
 {
     QString tooltip = tr("Remote: %1\nMount Point: %2\nStatus: %3")
@@ -1382,6 +1717,27 @@ QString NFSShareManagerApp::formatMountStatus(const NFSMount &mount) const
         tooltip += tr("\nMounted: %1").arg(formatTimeAgo(mount.mountedAt()));
     }
     
+    if (mount.hasError()) {
+        tooltip += tr("\nError: %1").arg(mount.errorMessage());
+    }
+    
+    if (mount.status() == MountStatus::Mounted && m_mountManager->hasMountStatistics(mount.localMountPoint())) {
+        const MountStatsRate stats = m_mountManager->getMountStatistics(mount.localMountPoint());
+        const NFSOpRate &read = stats.op(NFSOperation::Read);
+        const NFSOpRate &write = stats.op(NFSOperation::Write);
+        const NFSOpRate &total = stats.op(NFSOperation::Total);
+        tooltip += tr("\nRead: %1/s, avg RTT %2 ms")
+                   .arg(QLocale().formattedDataSize(static_cast<qint64>(stats.readBytesPerSecond)))
+                   .arg(read.averageRttMs, 0, 'f', 1);
+        tooltip += tr("\nWrite: %1/s, avg RTT %2 ms")
+                   .arg(QLocale().formattedDataSize(static_cast<qint64>(stats.writeBytesPerSecond)))
+                   .arg(write.averageRttMs, 0, 'f', 1);
+        tooltip += tr("\nOperations: %1/s, retransmits: %2, backlog: %3")
+                   .arg(total.operationsPerSecond, 0, 'f', 1)
+                   .arg(total.retransmissions)
+                   .arg(stats.averageBacklog, 0, 'f', 2);
+    }
+    
     return tooltip;
 }
 
@@ -1411,7 +1767,9 @@ QIcon NFSShareManagerApp::getShareStatusIcon(const NFSShare &share) const
 
 QIcon NFSShareManagerApp::getMountStatusIcon(const NFSMount &mount) const
 {
-    if (mount.status() == MountStatus::Mounted) {
+    if (mount.status() == MountStatus::Mounted && mount.hasError()) {
+        return QIcon::fromTheme("dialog-warning");
+    } else if (mount.status() == MountStatus::Mounted) {
         return QIcon::fromTheme("drive-harddisk-network", QIcon(":/icons/drive-harddisk-network.png"));
     } else {
         return QIcon::fromTheme("drive-harddisk-network-offline", QIcon(":/icons/drive-harddisk-network-offline.png"));
@@ -1486,4 +1844,102 @@ void NFSShareManagerApp::onImportConfigurationClicked()
     }
 }
 
+void NFSShareManagerApp::onImportInventoryClicked()
+{
+    if (m_shareManager->isBulkOperationRunning()) {
+        m_notificationManager->showWarning(tr("Import Share Inventory"), tr("Another share operation is still running."));
+        return;
+    }
+
+    QString fileName = QInputDialog::getText(this, tr("Import Share Inventory"),
+                                           tr("Enter the file listing the directories to share (one per line):"),
+                                           QLineEdit::Normal, "shares.txt");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        m_notificationManager->showError(tr("Import Share Inventory"),
+                                         tr("Could not read %1: %2").arg(fileName, file.errorString()));
+        return;
+    }
+
+    // One directory per line; blank lines and # comments are skipped
+    QStringList paths;
+    QSet<QString> seen;
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#') || seen.contains(line)) {
+            continue;
+        }
+        seen.insert(line);
+        paths << line;
+    }
+    if (paths.isEmpty()) {
+        m_notificationManager->showWarning(tr("Import Share Inventory"), tr("%1 lists no directories.").arg(fileName));
+        return;
+    }
+
+    // Every share of the inventory gets the same configuration
+    bool ok = false;
+    const QStringList accessModes = {tr("Read Only"), tr("Read/Write")};
+    const QString accessMode = QInputDialog::getItem(this, tr("Import Share Inventory"),
+                                                     tr("Access mode for the %1 shares:").arg(paths.size()),
+                                                     accessModes, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+    const QString hosts = QInputDialog::getText(this, tr("Import Share Inventory"),
+                                                tr("Allowed hosts (space separated, * for all):"),
+                                                QLineEdit::Normal, "*", &ok).trimmed();
+    if (!ok || hosts.isEmpty()) {
+        return;
+    }
+
+    QList<ShareRequest> requests;
+    for (const QString &path : paths) {
+        ShareConfiguration config(QFileInfo(path).fileName(),
+                                  accessMode == accessModes.first() ? AccessMode::ReadOnly : AccessMode::ReadWrite);
+        for (const QString &host : hosts.split(' ', Qt::SkipEmptyParts)) {
+            config.addAllowedHost(host);
+        }
+        requests << ShareRequest(path, config);
+    }
+
+    if (!m_shareManager->createShares(requests)) {
+        m_notificationManager->showWarning(tr("Import Share Inventory"), tr("Another share operation is still running."));
+    }
+    // Note: The outcome is reported by onBulkOperationFinished()
+}
+
+void NFSShareManagerApp::onBulkOperationFinished(const ExportBatchResult &result)
+{
+    int applied = 0;
+    QStringList failures;
+    for (const ExportEntryResult &entry : result.entries) {
+        if (entry.success) {
+            ++applied;
+        } else {
+            failures << tr("%1: %2").arg(entry.path, entry.error);
+        }
+    }
+
+    if (failures.isEmpty()) {
+        m_notificationManager->showSuccess(tr("%n share(s) updated.", "", applied));
+        return;
+    }
+
+    // Keep the message readable for large batches
+    const int shown = 10;
+    QString details = failures.mid(0, shown).join('\n');
+    if (failures.size() > shown) {
+        details += tr("\n... and %1 more").arg(failures.size() - shown);
+    }
+    m_notificationManager->showError(tr("Share Update Failed"),
+                                     tr("%1 of %2 share(s) failed:\n%3")
+                                         .arg(failures.size()).arg(result.entries.size()).arg(details));
+}
+
 } // namespace NFSShareManager
\ No newline at end of file
@@ -21,6 +21,8 @@
 namespace NFSShareManager {
 
 class ConfigurationManager;
+class WriteBehindScheduler;
+class DesiredStateReconciler;
 class ShareManager;
 class MountManager;
 class NetworkDiscovery;
@@ -28,6 +30,9 @@ class PermissionManager;
 class NotificationManager;
 class StartupManager;
 struct ValidationResult;
+struct ShareUsage;
+struct ExportBatchResult;
+struct NFSClientInfo;
 struct NFSShare;
 struct NFSMount;
 struct RemoteNFSShare;
@@ -106,6 +111,17 @@ public slots:
      */
     bool importConfiguration(const QString &filePath, bool mergeMode = false);
 
+    /**
+     * @brief Bring exports and mounts in line with the stored configuration
+     *
+     * Shows the change plan as a dry run and applies it as one batch once
+     * the user confirms. Entries that already match are not touched. The
+     * outcome is reported when the mounts of the plan have finished.
+     *
+     * @return True if there was nothing to do or the changes were started
+     */
+    bool applyConfigurationState();
+
     /**
      * @brief Refresh all data (shares, mounts, discovery)
      */
@@ -155,7 +171,10 @@ private slots:
     void onShareError(const QString &path, const QString &error);
     void onSharesRefreshed();
     void onNFSServerStatusChanged(bool running);
-    void onSharesPersistenceRequested();
+    void onSharesPersistenceRequested(const QStringList &sharePaths);
+    void onBulkOperationProgress(int progress, const QString &statusMessage);
+    void onShareUsageUpdated(const QString &sharePath, const ShareUsage &usage);
+    void onActiveClientsChanged();
 
     // Mount management slots
     void onMountStarted(const RemoteNFSShare &remoteShare, const QString &mountPoint);
@@ -166,6 +185,7 @@ private slots:
     void onUnmountCompleted(const QString &mountPoint);
     void onUnmountFailed(const QString &mountPoint, const QString &errorMessage);
     void onMountStatusChanged(const NFSMount &mount);
+    void onMountStatisticsUpdated();
 
     // Network discovery slots
     void onShareDiscovered(const RemoteNFSShare &share);
@@ -185,13 +205,17 @@ private slots:
     void onRemoveShareClicked();
     void onEditShareClicked();
     void onMountShareClicked();
+    void onAutotuneShareClicked();
     void onUnmountShareClicked();
+    void onBenchmarkMountClicked();
     void onRefreshDiscoveryClicked();
     void onDiscoveryModeClicked();
     void onManageTargetsClicked();
     void onAutoDiscoveryToggled(bool enabled);
     void onExportConfigurationClicked();
     void onImportConfigurationClicked();
+    void onImportInventoryClicked();
+    void onBulkOperationFinished(const ExportBatchResult &result);
 
     // Operation manager slots
     void onOperationStarted(const QUuid &operationId, const QString &title);
@@ -245,6 +269,8 @@ private:
     void showSuccessMessage(const QString &message);
     bool isSystemTrayAvailable() const;
     QString formatShareStatus(const NFSShare &share) const;
+    QString formatShareItemText(const QString &sharePath) const;
+    QString formatClientList(const QList<NFSClientInfo> &clients) const;
     QString formatMountStatus(const NFSMount &mount) const;
     QString formatTimeAgo(const QDateTime &dateTime) const;
     QString formatRemoteShareTooltip(const RemoteNFSShare &share) const;
@@ -261,6 +287,8 @@ private:
     NetworkDiscovery *m_networkDiscovery;
     PermissionManager *m_permissionManager;
     NotificationManager *m_notificationManager;
+    WriteBehindScheduler *m_sharePersistence;
+    DesiredStateReconciler *m_stateReconciler;
 
     // UI components
     QTabWidget *m_tabWidget;
@@ -278,6 +306,7 @@ private:
     QWidget *m_remoteSharesTab;
     QListWidget *m_remoteSharesList;
     QPushButton *m_mountShareButton;
+    QPushButton *m_autotuneShareButton;
     QPushButton *m_refreshDiscoveryButton;
     QPushButton *m_discoveryModeButton;
     QPushButton *m_manageTargetsButton;
@@ -293,6 +322,7 @@ private:
     QWidget *m_mountedSharesTab;
     QListWidget *m_mountedSharesList;
     QPushButton *m_unmountShareButton;
+    QPushButton *m_benchmarkMountButton;
     QLabel *m_mountedSharesStatus;
 
     // System tray
@@ -308,6 +338,7 @@ private:
     QAction *m_aboutAction;
     QAction *m_exportConfigAction;
     QAction *m_importConfigAction;
+    QAction *m_importInventoryAction;
 
     // Status and timers
     QTimer *m_statusUpdateTimer;
@@ -319,6 +350,10 @@ private:
     // Operation management
     class OperationManager *m_operationManager;
     QUuid m_currentDiscoveryOperationId;
+    QUuid m_currentBulkOperationId;
+    QUuid m_benchmarkOperationId;
+    QUuid m_autotuneOperationId;
+    QUuid m_shutdownOperationId;
     
     // Global progress indication
     QProgressBar *m_globalProgressBar;
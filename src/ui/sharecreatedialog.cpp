@@ -29,6 +29,7 @@ ShareCreateDialog::ShareCreateDialog(ShareManager *shareManager, QWidget *parent
     , m_nfsVersionCombo(nullptr)
     , m_allowRootAccessCheck(nullptr)
     , m_pathValidationLabel(nullptr)
+    , m_pathValidationTimer(new QTimer(this))
     , m_shareNameValidationLabel(nullptr)
     , m_permissionsTab(nullptr)
     , m_allowedHostsList(nullptr)
@@ -200,7 +201,7 @@ void ShareCreateDialog::onPathChanged()
         m_shareNameEdit->setText(suggestedName);
     }
     
-    validateConfiguration();
+    m_pathValidationTimer->start();
 }
 
 void ShareCreateDialog::onShareNameChanged()
@@ -738,6 +739,11 @@ void ShareCreateDialog::connectSignals()
         connect(m_pathEdit, &QLineEdit::textChanged, this, &ShareCreateDialog::onPathChanged);
     }
     
+    // Validate once typing pauses rather than on every keystroke
+    m_pathValidationTimer->setSingleShot(true);
+    m_pathValidationTimer->setInterval(250);
+    connect(m_pathValidationTimer, &QTimer::timeout, this, &ShareCreateDialog::validateConfiguration);
+    
     if (m_shareNameEdit) {
         connect(m_shareNameEdit, &QLineEdit::textChanged, this, &ShareCreateDialog::onShareNameChanged);
     }
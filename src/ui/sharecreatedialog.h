@@ -19,6 +19,7 @@
 #include <QDialogButtonBox>
 #include <QProgressBar>
 #include <QMessageBox>
+#include <QTimer>
 
 #include "../core/shareconfiguration.h"
 #include "../core/permissionset.h"
@@ -251,6 +252,7 @@ protected:
     QComboBox *m_nfsVersionCombo;
     QCheckBox *m_allowRootAccessCheck;
     QLabel *m_pathValidationLabel;
+    QTimer *m_pathValidationTimer;     ///< Debounces path validation while typing
     QLabel *m_shareNameValidationLabel;
 
     // Permissions tab
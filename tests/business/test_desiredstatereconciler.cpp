@@ -0,0 +1,263 @@
+#include <QtTest/QtTest>
+#include <QMutex>
+#include <QSignalSpy>
+#include "../../src/business/desiredstatereconciler.h"
+#include "../../src/business/mountmanager.h"
+#include "../../src/business/mountorchestrator.h"
+#include "../../src/core/shareconfiguration.h"
+#include "../../src/core/remotenfsshare.h"
+
+using namespace NFSShareManager;
+
+namespace {
+
+NFSShare makeShare(const QString &path, AccessMode mode = AccessMode::ReadOnly)
+{
+    ShareConfiguration config("test", mode);
+    config.addAllowedHost("*");
+    return NFSShare(path, path, config);
+}
+
+/**
+ * @brief Kernel table entries for a share as exported
+ */
+QList<KernelExport> kernelExportsOf(const NFSShare &share)
+{
+    QList<KernelExport> exports = ExportReconciler::parseExportTable(share.config().toExportLine(share.path()));
+    for (KernelExport &entry : exports) {
+        entry.options << "wdelay" << "hide" << "no_subtree_check";
+    }
+    return exports;
+}
+
+NFSMount makeMount(const QString &host, const QString &exportPath, const QString &mountPoint, bool persistent)
+{
+    RemoteNFSShare remoteShare(host, QHostAddress(), exportPath);
+    return NFSMount(remoteShare, mountPoint, MountOptions(), persistent);
+}
+
+QList<PlanStep::Action> actionsOf(const ReconcilePlan &plan)
+{
+    QList<PlanStep::Action> actions;
+    for (const PlanStep &step : plan.steps) {
+        actions << step.action;
+    }
+    return actions;
+}
+
+QStringList targetsOf(const ReconcilePlan &plan)
+{
+    QStringList targets;
+    for (const PlanStep &step : plan.steps) {
+        targets << step.target;
+    }
+    return targets;
+}
+
+} // namespace
+
+class TestDesiredStateReconciler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testParseMountTable();
+    void testInSyncPlanIsEmpty();
+    void testLargeProfileTouchesOnlyDifferences();
+    void testForeignExportsAreLeftAlone();
+    void testMountOrdering();
+    void testFstabEntries();
+    void testExecuteRunsMountBatches();
+};
+
+void TestDesiredStateReconciler::testParseMountTable()
+{
+    const QList<MountTableEntry> entries = DesiredStateReconciler::parseMountTable(
+        "# /etc/fstab\n"
+        "UUID=1234 / ext4 defaults 0 1\n"
+        "server:/srv/data /mnt/data nfs4 rw,hard,nfsvers=4.2 0 0\n"
+        "nfsd /proc/fs/nfsd nfsd rw,relatime 0 0\n"
+        "nas:/export/My\\040Files /mnt/my\\040files nfs ro\n");
+    QCOMPARE(entries.size(), 2);
+    QCOMPARE(entries[0].source, QString("server:/srv/data"));
+    QCOMPARE(entries[0].mountPoint, QString("/mnt/data"));
+    QCOMPARE(entries[0].type, QString("nfs4"));
+    QCOMPARE(entries[0].options, QStringList({"rw", "hard", "nfsvers=4.2"}));
+    QCOMPARE(entries[1].source, QString("nas:/export/My Files"));
+    QCOMPARE(entries[1].mountPoint, QString("/mnt/my files"));
+}
+
+void TestDesiredStateReconciler::testInSyncPlanIsEmpty()
+{
+    const NFSShare share = makeShare("/srv/share");
+    const NFSMount mount = makeMount("server", "/export", "/mnt/export", true);
+
+    DesiredState desired;
+    desired.shares << share;
+    desired.mounts << mount;
+
+    ObservedState observed;
+    observed.exports = kernelExportsOf(share);
+    observed.managedExports << "/srv/share";
+    observed.mounts << MountTableEntry("server:/export", "/mnt/export", "nfs4", {"rw", "relatime"});
+    observed.fstab << MountTableEntry("server:/export/", "/mnt/export", "nfs",
+                                      DesiredStateReconciler::fstabOptions(mount) + QStringList{"_netdev"});
+    observed.managedMountPoints << "/mnt/export";
+
+    const ReconcilePlan plan = DesiredStateReconciler::computePlan(desired, observed);
+    QVERIFY(plan.isEmpty());
+    QVERIFY(plan.conflicts.isEmpty());
+    QCOMPARE(plan.unchanged, 2);
+}
+
+void TestDesiredStateReconciler::testLargeProfileTouchesOnlyDifferences()
+{
+    DesiredState desired;
+    ObservedState observed;
+    for (int i = 0; i < 1000; ++i) {
+        const NFSShare share = makeShare(QString("/srv/share%1").arg(i, 4, 10, QChar('0')));
+        desired.shares << share;
+        if (i != 10) {
+            observed.exports << kernelExportsOf(i == 20 ? makeShare(share.path(), AccessMode::ReadWrite) : share);
+            observed.managedExports << share.path();
+        }
+    }
+    // Managed, exported and no longer in the profile
+    observed.exports << kernelExportsOf(makeShare("/srv/retired"));
+    observed.managedExports << "/srv/retired";
+
+    const ReconcilePlan plan = DesiredStateReconciler::computePlan(desired, observed);
+    QCOMPARE(actionsOf(plan), QList<PlanStep::Action>({PlanStep::Action::Unexport,
+                                                       PlanStep::Action::UpdateExport,
+                                                       PlanStep::Action::Export}));
+    QCOMPARE(targetsOf(plan), QStringList({"/srv/retired", "/srv/share0020", "/srv/share0010"}));
+    QCOMPARE(plan.steps[1].share.config().toExportLine("/srv/share0020"),
+             makeShare("/srv/share0020").config().toExportLine("/srv/share0020"));
+    QCOMPARE(plan.unchanged, 998);
+}
+
+void TestDesiredStateReconciler::testForeignExportsAreLeftAlone()
+{
+    DesiredState desired;
+    desired.shares << makeShare("/srv/shared");
+
+    // Both exports come from someone else's /etc/exports lines
+    ObservedState observed;
+    observed.exports << kernelExportsOf(makeShare("/srv/shared", AccessMode::ReadWrite));
+    observed.exports << kernelExportsOf(makeShare("/srv/admin"));
+
+    const ReconcilePlan plan = DesiredStateReconciler::computePlan(desired, observed);
+    QVERIFY(plan.isEmpty());
+    QCOMPARE(plan.conflicts.size(), 1);
+    QVERIFY(plan.conflicts.first().startsWith("/srv/shared"));
+}
+
+void TestDesiredStateReconciler::testMountOrdering()
+{
+    DesiredState desired;
+    desired.mounts << makeMount("server", "/export/a/b", "/mnt/a/b", false);
+    desired.mounts << makeMount("server", "/export/a", "/mnt/a", false);
+    desired.mounts << makeMount("other", "/moved", "/mnt/moved", false);
+
+    ObservedState observed;
+    observed.mounts << MountTableEntry("server:/old", "/mnt/old", "nfs4", {});
+    observed.mounts << MountTableEntry("server:/old/inner", "/mnt/old/inner", "nfs4", {});
+    observed.mounts << MountTableEntry("server:/moved", "/mnt/moved", "nfs4", {});
+    observed.managedMountPoints << "/mnt/old" << "/mnt/old/inner" << "/mnt/moved";
+
+    const ReconcilePlan plan = DesiredStateReconciler::computePlan(desired, observed);
+
+    // Unmounts deepest first, then mounts parents before children
+    QCOMPARE(actionsOf(plan), QList<PlanStep::Action>({PlanStep::Action::Unmount,
+                                                       PlanStep::Action::Unmount,
+                                                       PlanStep::Action::Unmount,
+                                                       PlanStep::Action::Mount,
+                                                       PlanStep::Action::Mount,
+                                                       PlanStep::Action::Mount}));
+    QCOMPARE(targetsOf(plan), QStringList({"/mnt/old/inner", "/mnt/old", "/mnt/moved",
+                                           "/mnt/a", "/mnt/a/b", "/mnt/moved"}));
+    QCOMPARE(plan.count(PlanStep::Action::Mount), 3);
+}
+
+void TestDesiredStateReconciler::testFstabEntries()
+{
+    NFSMount tuned = makeMount("server", "/export/tuned", "/mnt/tuned", true);
+    MountOptions options = tuned.options();
+    options.rsize = 1048576;
+    tuned = NFSMount(tuned.remoteShare(), tuned.localMountPoint(), options, true);
+
+    DesiredState desired;
+    desired.mounts << makeMount("server", "/export/new", "/mnt/new", true);
+    desired.mounts << tuned;
+    desired.mounts << makeMount("server", "/export/taken", "/mnt/taken", true);
+
+    ObservedState observed;
+    for (const NFSMount &mount : desired.mounts) {
+        observed.mounts << MountTableEntry(QString("server:%1").arg(mount.remoteShare().exportPath()),
+                                           mount.localMountPoint(), "nfs4", {});
+    }
+    observed.fstab << MountTableEntry("server:/export/tuned", "/mnt/tuned", "nfs", {"rw", "hard"});
+    observed.fstab << MountTableEntry("elsewhere:/data", "/mnt/taken", "nfs", {"rw"});
+    observed.fstab << MountTableEntry("server:/export/gone", "/mnt/gone", "nfs", {"rw"});
+    observed.managedMountPoints << "/mnt/new" << "/mnt/tuned" << "/mnt/gone";
+
+    const ReconcilePlan plan = DesiredStateReconciler::computePlan(desired, observed);
+    QCOMPARE(actionsOf(plan), QList<PlanStep::Action>({PlanStep::Action::RemoveFstabEntry,
+                                                       PlanStep::Action::RemoveFstabEntry,
+                                                       PlanStep::Action::AddFstabEntry,
+                                                       PlanStep::Action::AddFstabEntry}));
+    QCOMPARE(targetsOf(plan), QStringList({"/mnt/gone", "/mnt/tuned", "/mnt/new", "/mnt/tuned"}));
+    QCOMPARE(plan.conflicts.size(), 1);
+    QVERIFY(plan.conflicts.first().contains("/mnt/taken"));
+    QVERIFY(!plan.describe().isEmpty());
+}
+
+void TestDesiredStateReconciler::testExecuteRunsMountBatches()
+{
+    // The operations run on the orchestrator's pool
+    QMutex mutex;
+    QStringList calls;
+    MountManager mountManager;
+    mountManager.orchestrator()->setUnmountOperation([&mutex, &calls](const QString &mountPoint, bool) {
+        QMutexLocker locker(&mutex);
+        calls << "umount " + mountPoint;
+        return QString();
+    });
+    mountManager.orchestrator()->setMountOperation([&mutex, &calls](const NFSMount &mount) {
+        QMutexLocker locker(&mutex);
+        calls << "mount " + mount.localMountPoint();
+        return mount.localMountPoint() == "/mnt/broken" ? QString("access denied by server") : QString();
+    });
+
+    DesiredState desired;
+    desired.mounts << makeMount("server", "/export/a", "/mnt/a", false);
+    desired.mounts << makeMount("server", "/export/broken", "/mnt/broken", false);
+    ObservedState observed;
+    observed.mounts << MountTableEntry("server:/old", "/mnt/old", "nfs4", {});
+    observed.managedMountPoints << "/mnt/old";
+    const ReconcilePlan plan = DesiredStateReconciler::computePlan(desired, observed);
+    QCOMPARE(plan.steps.size(), 3);
+
+    DesiredStateReconciler reconciler(nullptr, &mountManager);
+    QSignalSpy finishedSpy(&reconciler, &DesiredStateReconciler::finished);
+    QVERIFY(reconciler.execute(plan));
+    QVERIFY(reconciler.isRunning());
+    QVERIFY(!reconciler.execute(plan));
+
+    QTRY_COMPARE(finishedSpy.count(), 1);
+    QVERIFY(!reconciler.isRunning());
+    const ReconcileResult result = finishedSpy.first().first().value<ReconcileResult>();
+    QVERIFY(!result.success);
+    QCOMPARE(result.applied, 2);
+    QCOMPARE(result.errors.size(), 1);
+    QVERIFY(result.errors.first().contains("/mnt/broken"));
+    QVERIFY(result.errors.first().contains("access denied"));
+
+    // The unmount batch has finished before any mount starts
+    QMutexLocker locker(&mutex);
+    QCOMPARE(calls.size(), 3);
+    QCOMPARE(calls.first(), QString("umount /mnt/old"));
+}
+
+QTEST_MAIN(TestDesiredStateReconciler)
+#include "test_desiredstatereconciler.moc"
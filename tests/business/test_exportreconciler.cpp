@@ -0,0 +1,192 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include "../../src/business/exportreconciler.h"
+#include "../../src/core/shareconfiguration.h"
+
+using namespace NFSShareManager;
+
+namespace {
+
+NFSShare makeShare(const QString &path)
+{
+    ShareConfiguration config("test", AccessMode::ReadOnly);
+    config.addAllowedHost("*");
+    return NFSShare(path, path, config);
+}
+
+/**
+ * @brief Render the etab lines the kernel would hold for a share
+ */
+QString etabLines(const NFSShare &share, const QStringList &extraOptions = {"wdelay", "hide", "no_subtree_check"})
+{
+    QString content;
+    const QList<KernelExport> specs = ExportReconciler::parseExportTable(share.config().toExportLine(share.path()));
+    for (const KernelExport &spec : specs) {
+        content += QString("%1\t%2(%3)\n").arg(spec.path, spec.client, (spec.options + extraOptions).join(','));
+    }
+    return content;
+}
+
+} // namespace
+
+class TestExportReconciler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testParseEtab();
+    void testParseWrappedExportfsOutput();
+    void testInSync();
+    void testMissingAndExtra();
+    void testOptionsDrifted();
+    void testOnlyDeltaIsReported();
+    void testSkipsUnchangedEtab();
+
+private:
+    void writeEtab(const QString &content);
+
+    QTemporaryDir *m_tempDir;
+    ExportReconciler *m_reconciler;
+};
+
+void TestExportReconciler::init()
+{
+    m_tempDir = new QTemporaryDir();
+    QVERIFY(m_tempDir->isValid());
+    m_reconciler = new ExportReconciler();
+    m_reconciler->setEtabPath(m_tempDir->filePath("etab"));
+}
+
+void TestExportReconciler::cleanup()
+{
+    delete m_reconciler;
+    m_reconciler = nullptr;
+    delete m_tempDir;
+    m_tempDir = nullptr;
+}
+
+void TestExportReconciler::writeEtab(const QString &content)
+{
+    // Replace the file like exportfs does, so the inode changes
+    const QString tmp = m_tempDir->filePath("etab.tmp");
+    QFile file(tmp);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(content.toUtf8());
+    file.close();
+    QFile::remove(m_reconciler->etabPath());
+    QVERIFY(QFile::rename(tmp, m_reconciler->etabPath()));
+}
+
+void TestExportReconciler::testParseEtab()
+{
+    const QString etab = "/srv/data\t192.168.1.0/24(rw,sync,wdelay,hide,root_squash)\n"
+                         "/srv/data\t*(ro,sync)\n"
+                         "/srv/with\\040space\t*(ro)\n";
+    QList<KernelExport> exports = ExportReconciler::parseExportTable(etab);
+    QCOMPARE(exports.size(), 3);
+    QCOMPARE(exports[0].path, QString("/srv/data"));
+    QCOMPARE(exports[0].client, QString("192.168.1.0/24"));
+    QVERIFY(exports[0].options.contains("root_squash"));
+    QCOMPARE(exports[1].client, QString("*"));
+    QCOMPARE(exports[2].path, QString("/srv/with space"));
+}
+
+void TestExportReconciler::testParseWrappedExportfsOutput()
+{
+    const QString output = "/srv/a/very/long/path/that/exportfs/wraps\n"
+                           "\t\t<world>(sync,wdelay,hide,ro)\n"
+                           "/srv/short     \t10.0.0.1(rw)\n";
+    QList<KernelExport> exports = ExportReconciler::parseExportTable(output);
+    QCOMPARE(exports.size(), 2);
+    QCOMPARE(exports[0].path, QString("/srv/a/very/long/path/that/exportfs/wraps"));
+    QCOMPARE(exports[0].client, QString("<world>"));
+    QCOMPARE(exports[1].path, QString("/srv/short"));
+}
+
+void TestExportReconciler::testInSync()
+{
+    const QList<NFSShare> managed = {makeShare("/srv/b"), makeShare("/srv/a")};
+    writeEtab(etabLines(managed[0]) + etabLines(managed[1]));
+
+    ExportDriftDelta delta = m_reconciler->reconcile(managed);
+    QVERIFY(delta.isEmpty());
+    QVERIFY(m_reconciler->currentDrift().isEmpty());
+}
+
+void TestExportReconciler::testMissingAndExtra()
+{
+    const QList<NFSShare> managed = {makeShare("/srv/a"), makeShare("/srv/c")};
+    writeEtab(etabLines(managed[0]) + etabLines(makeShare("/srv/b")));
+
+    ExportDriftDelta delta = m_reconciler->reconcile(managed);
+    QCOMPARE(delta.detected.size(), 2);
+    QCOMPARE(delta.detected[0].path, QString("/srv/b"));
+    QCOMPARE(delta.detected[0].kind, ExportDrift::Kind::Extra);
+    QCOMPARE(delta.detected[1].path, QString("/srv/c"));
+    QCOMPARE(delta.detected[1].kind, ExportDrift::Kind::Missing);
+}
+
+void TestExportReconciler::testOptionsDrifted()
+{
+    const NFSShare share = makeShare("/srv/a");
+
+    // Same client, but the kernel exports it with a different option set
+    QList<KernelExport> kernel = ExportReconciler::parseExportTable(share.config().toExportLine(share.path()));
+    QVERIFY(!kernel.isEmpty());
+    kernel.first().options = QStringList({"rw", "async"});
+
+    QList<ExportDrift> drift = ExportReconciler::diff({share}, kernel);
+    QCOMPARE(drift.size(), 1);
+    QCOMPARE(drift.first().kind, ExportDrift::Kind::OptionsDrifted);
+    QVERIFY(drift.first().actual.contains("async"));
+
+    // An extra client on a managed path is drift too
+    kernel = ExportReconciler::parseExportTable(etabLines(share) + "/srv/a\t10.0.0.99(rw)\n");
+    drift = ExportReconciler::diff({share}, kernel);
+    QCOMPARE(drift.size(), 1);
+    QCOMPARE(drift.first().kind, ExportDrift::Kind::OptionsDrifted);
+}
+
+void TestExportReconciler::testOnlyDeltaIsReported()
+{
+    const QList<NFSShare> managed = {makeShare("/srv/a"), makeShare("/srv/b")};
+    writeEtab(etabLines(managed[0]));
+
+    ExportDriftDelta delta = m_reconciler->reconcile(managed);
+    QCOMPARE(delta.detected.size(), 1);
+
+    // Unrelated change: the known drift is not reported again
+    writeEtab(etabLines(managed[0]) + "\n");
+    delta = m_reconciler->reconcile(managed);
+    QVERIFY(delta.isEmpty());
+    QCOMPARE(m_reconciler->currentDrift().size(), 1);
+
+    writeEtab(etabLines(managed[0]) + etabLines(managed[1]));
+    delta = m_reconciler->reconcile(managed);
+    QVERIFY(delta.detected.isEmpty());
+    QCOMPARE(delta.resolved, QStringList({"/srv/b"}));
+}
+
+void TestExportReconciler::testSkipsUnchangedEtab()
+{
+    const QList<NFSShare> managed = {makeShare("/srv/a")};
+    QVERIFY(m_reconciler->needsReconcile());
+
+    writeEtab(etabLines(managed[0]));
+    m_reconciler->reconcile(managed);
+    QVERIFY(!m_reconciler->needsReconcile());
+
+    m_reconciler->invalidate();
+    QVERIFY(m_reconciler->needsReconcile());
+    m_reconciler->reconcile(managed);
+
+    writeEtab(QString());
+    QVERIFY(m_reconciler->needsReconcile());
+}
+
+QTEST_MAIN(TestExportReconciler)
+#include "test_exportreconciler.moc"
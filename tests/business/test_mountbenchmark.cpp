@@ -0,0 +1,210 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QDir>
+#include "../../src/business/mountbenchmark.h"
+
+using namespace NFSShareManager;
+
+namespace {
+
+BenchmarkConfig smallConfig()
+{
+    BenchmarkConfig config;
+    config.sequentialSize = 4 * 1024 * 1024;
+    config.randomFileSize = 1024 * 1024;
+    config.randomDurationMs = 100;
+    config.queueDepth = 2;
+    config.metadataFiles = 20;
+    return config;
+}
+
+} // namespace
+
+class TestMountBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testPercentiles();
+    void testRunMeasuresAndCleansUp();
+    void testUnwritableDirectory();
+    void testStartRecordsHistory();
+    void testHistoryIsBounded();
+    void testReadAheadSweep();
+
+private:
+    QTemporaryDir *m_tempDir;
+};
+
+void TestMountBenchmark::init()
+{
+    m_tempDir = new QTemporaryDir();
+    QVERIFY(m_tempDir->isValid());
+}
+
+void TestMountBenchmark::cleanup()
+{
+    delete m_tempDir;
+    m_tempDir = nullptr;
+}
+
+void TestMountBenchmark::testPercentiles()
+{
+    std::vector<qint64> samples;
+    for (int i = 100; i >= 1; --i) {
+        samples.push_back(i * 1000);
+    }
+    const LatencyStats stats = LatencyStats::fromSamples(samples);
+    QCOMPARE(stats.samples, qint64(100));
+    QCOMPARE(stats.p50Us, 50.0);
+    QCOMPARE(stats.p95Us, 95.0);
+    QCOMPARE(stats.p99Us, 99.0);
+    QCOMPARE(stats.maxUs, 100.0);
+
+    std::vector<qint64> single = {2500};
+    QCOMPARE(LatencyStats::fromSamples(single).p99Us, 2.5);
+
+    std::vector<qint64> none;
+    QCOMPARE(LatencyStats::fromSamples(none).samples, qint64(0));
+}
+
+void TestMountBenchmark::testRunMeasuresAndCleansUp()
+{
+    const QString mountPoint = m_tempDir->filePath("mnt");
+    QVERIFY(QDir().mkpath(mountPoint));
+
+    MountBenchmark benchmark;
+    QSignalSpy progress(&benchmark, &MountBenchmark::progress);
+    const BenchmarkResult result = benchmark.run(mountPoint, smallConfig());
+
+    QVERIFY2(result.success, qPrintable(result.errorMessage));
+    QVERIFY(result.sequentialWriteMBps > 0.0);
+    QVERIFY(result.sequentialReadMBps > 0.0);
+    QVERIFY(result.randomReadIops > 0.0);
+    QVERIFY(result.randomWriteIops > 0.0);
+    QVERIFY(result.randomReadLatency.samples > 0);
+    QVERIFY(result.randomReadLatency.p50Us <= result.randomReadLatency.p99Us);
+    QVERIFY(result.metadataOpsPerSecond > 0.0);
+    QCOMPARE(result.metadataLatency.samples, qint64(2 * 20 * 3));
+    QVERIFY(!result.summary().isEmpty());
+
+    // Five workloads plus the final report
+    QCOMPARE(progress.count(), 6);
+    QCOMPARE(progress.last().at(0).toInt(), 100);
+
+    // No test files are left behind
+    QVERIFY(QDir(mountPoint).entryList(QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot).isEmpty());
+}
+
+void TestMountBenchmark::testUnwritableDirectory()
+{
+    MountBenchmark benchmark;
+    const BenchmarkResult result = benchmark.run(m_tempDir->filePath("absent"), smallConfig());
+    QVERIFY(!result.success);
+    QVERIFY(!result.errorMessage.isEmpty());
+}
+
+void TestMountBenchmark::testStartRecordsHistory()
+{
+    const QString mountPoint = m_tempDir->filePath("mnt");
+    QVERIFY(QDir().mkpath(mountPoint));
+
+    MountBenchmark benchmark;
+    benchmark.setHistoryFilePath(m_tempDir->filePath("benchmarks.ini"));
+    QSignalSpy finished(&benchmark, &MountBenchmark::finished);
+
+    BenchmarkConfig config = smallConfig();
+    config.randomIO = false;
+    QVERIFY(benchmark.start(mountPoint, "192.168.1.10", config));
+    QVERIFY(benchmark.isRunning());
+    QVERIFY(!benchmark.start(mountPoint, "192.168.1.10", config));
+
+    QTRY_COMPARE_WITH_TIMEOUT(finished.count(), 1, 10000);
+    QVERIFY(!benchmark.isRunning());
+    const BenchmarkResult result = finished.first().at(0).value<BenchmarkResult>();
+    QVERIFY(result.success);
+    QCOMPARE(result.serverKey, QString("192.168.1.10"));
+
+    const QList<BenchmarkResult> history = benchmark.mountHistory(mountPoint);
+    QCOMPARE(history.size(), 1);
+    QCOMPARE(history.first().sequentialWriteMBps, result.sequentialWriteMBps);
+    QCOMPARE(history.first().metadataLatency.p99Us, result.metadataLatency.p99Us);
+    QCOMPARE(benchmark.serverHistory("192.168.1.10").size(), 1);
+}
+
+void TestMountBenchmark::testHistoryIsBounded()
+{
+    MountBenchmark benchmark;
+    benchmark.setHistoryFilePath(m_tempDir->filePath("benchmarks.ini"));
+
+    for (int i = 0; i < MountBenchmark::HistorySize + 5; ++i) {
+        BenchmarkResult result;
+        result.mountPoint = i % 2 ? "/mnt/a" : "/mnt/b";
+        result.serverKey = "server";
+        result.success = true;
+        result.randomReadIops = i;
+        benchmark.recordResult(result);
+    }
+
+    const QList<BenchmarkResult> server = benchmark.serverHistory("server");
+    QCOMPARE(server.size(), MountBenchmark::HistorySize);
+    QCOMPARE(server.first().randomReadIops, 5.0);
+    QCOMPARE(server.last().randomReadIops, double(MountBenchmark::HistorySize + 4));
+    QCOMPARE(benchmark.mountHistory("/mnt/a").size(), 12);
+    QCOMPARE(benchmark.mountHistory("/mnt/a/").size(), 12);
+}
+
+void TestMountBenchmark::testReadAheadSweep()
+{
+    const QString mountPoint = m_tempDir->filePath("mnt");
+    QVERIFY(QDir().mkpath(mountPoint));
+
+    BenchmarkConfig config = smallConfig();
+    config.sequential = false;
+    config.randomIO = false;
+    config.metadata = false;
+    config.readAheadKb = {128, 4096};
+    QList<int> applied;
+    config.applyReadAhead = [&applied](int readAheadKb) {
+        applied << readAheadKb;
+        return QString();
+    };
+
+    MountBenchmark benchmark;
+    const BenchmarkResult result = benchmark.run(mountPoint, config);
+    QVERIFY2(result.success, qPrintable(result.errorMessage));
+    QCOMPARE(applied, QList<int>({128, 4096}));
+    QCOMPARE(result.readAheadSamples.size(), 2);
+    QCOMPARE(result.readAheadSamples.first().readAheadKb, 128);
+    QVERIFY(result.readAheadSamples.first().readMBps > 0.0);
+    QVERIFY(config.readAheadKb.contains(result.bestReadAheadKb()));
+    QVERIFY(result.summary().contains("Readahead"));
+    QVERIFY(QDir(mountPoint).entryList(QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot).isEmpty());
+
+    // Kept in the history
+    benchmark.setHistoryFilePath(m_tempDir->filePath("benchmarks.ini"));
+    benchmark.recordResult(result);
+    QCOMPARE(benchmark.mountHistory(mountPoint).first().bestReadAheadKb(), result.bestReadAheadKb());
+
+    // Without permission to change the readahead nothing is measured
+    config.applyReadAhead = [](int) { return QString("Permission denied"); };
+    const BenchmarkResult denied = benchmark.run(mountPoint, config);
+    QVERIFY(!denied.success);
+    QVERIFY(denied.errorMessage.contains("Permission denied"));
+
+    // Nor is a sweep that loses permission half way through a success
+    config.applyReadAhead = [](int readAheadKb) {
+        return readAheadKb == 128 ? QString() : QString("Permission denied");
+    };
+    const BenchmarkResult partial = benchmark.run(mountPoint, config);
+    QVERIFY(!partial.success);
+    QCOMPARE(partial.readAheadSamples.size(), 1);
+    QVERIFY(partial.errorMessage.contains("4096"));
+}
+
+QTEST_MAIN(TestMountBenchmark)
+#include "test_mountbenchmark.moc"
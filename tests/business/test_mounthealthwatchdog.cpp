@@ -0,0 +1,157 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <QTcpServer>
+#include <QtEndian>
+#include <atomic>
+#include "../../src/business/mounthealthwatchdog.h"
+#include "../../src/core/remotenfsshare.h"
+
+using namespace NFSShareManager;
+
+namespace {
+
+NFSMount makeMount(const QString &mountPoint)
+{
+    RemoteNFSShare remoteShare("server", QHostAddress(), "/export");
+    return NFSMount(remoteShare, mountPoint, MountOptions(), false);
+}
+
+QByteArray words(const QList<quint32> &values)
+{
+    QByteArray data;
+    for (quint32 value : values) {
+        const quint32 word = qToBigEndian(value);
+        data.append(reinterpret_cast<const char *>(&word), sizeof(word));
+    }
+    return data;
+}
+
+} // namespace
+
+class TestMountHealthWatchdog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRpcNullCall();
+    void testRpcReply();
+    void testRpcPingRefused();
+    void testHealthyAndError();
+    void testUnreachableServerSkipsProbe();
+    void testHungProbeIsUnresponsive();
+};
+
+void TestMountHealthWatchdog::testRpcNullCall()
+{
+    const QByteArray call = MountHealthWatchdog::buildRpcNullCall(0x1234, MountHealthWatchdog::NFSProgram, 3);
+    QCOMPARE(call, words({0x80000028, 0x1234, 0, 2, 100003, 3, 0, 0, 0, 0, 0}));
+}
+
+void TestMountHealthWatchdog::testRpcReply()
+{
+    // Accepted reply with AUTH_NONE verifier and SUCCESS
+    QVERIFY(MountHealthWatchdog::checkRpcReply(words({0x80000018, 7, 1, 0, 0, 0, 0}), 7).isEmpty());
+    // Denied still proves the server is alive
+    QVERIFY(MountHealthWatchdog::checkRpcReply(words({0x80000018, 7, 1, 1, 0, 2, 2}), 7).isEmpty());
+    QVERIFY(!MountHealthWatchdog::checkRpcReply(words({0x80000018, 8, 1, 0, 0, 0, 0}), 7).isEmpty());
+    QVERIFY(!MountHealthWatchdog::checkRpcReply(words({0x80000018, 7, 0, 0, 0, 0, 0}), 7).isEmpty());
+    QVERIFY(!MountHealthWatchdog::checkRpcReply(words({0x80000018, 7}), 7).isEmpty());
+}
+
+void TestMountHealthWatchdog::testRpcPingRefused()
+{
+    // Grab a free port and close it again so the connection is refused
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    const quint16 port = server.serverPort();
+    server.close();
+
+    QElapsedTimer timer;
+    timer.start();
+    const QString error = MountHealthWatchdog::rpcNullPing("127.0.0.1", port, MountHealthWatchdog::NFSProgram, 4, 2000);
+    QVERIFY(!error.isEmpty());
+    QVERIFY(timer.elapsed() < 2500);
+}
+
+void TestMountHealthWatchdog::testHealthyAndError()
+{
+    MountHealthWatchdog watchdog;
+    watchdog.setPingOperation([](const NFSMount &, int) { return QString(); });
+    watchdog.setProbeOperation([](const QString &mountPoint) {
+        return mountPoint == "/mnt/stale" ? QString("Stale file handle") : QString();
+    });
+    watchdog.setMounts({makeMount("/mnt/good"), makeMount("/mnt/stale")});
+
+    QSignalSpy changed(&watchdog, &MountHealthWatchdog::healthChanged);
+    watchdog.checkNow();
+    QTRY_COMPARE(changed.count(), 2);
+    QCOMPARE(watchdog.health("/mnt/good"), MountHealthWatchdog::Health::Healthy);
+    QCOMPARE(watchdog.health("/mnt/stale"), MountHealthWatchdog::Health::Error);
+    QCOMPARE(watchdog.healthMessage("/mnt/stale"), QString("Stale file handle"));
+
+    // Unchanged results are not reported again
+    watchdog.checkNow();
+    QTRY_VERIFY(!watchdog.isChecking("/mnt/good") && !watchdog.isChecking("/mnt/stale"));
+    QCOMPARE(changed.count(), 2);
+}
+
+void TestMountHealthWatchdog::testUnreachableServerSkipsProbe()
+{
+    std::atomic<int> probes(0);
+    MountHealthWatchdog watchdog;
+    watchdog.setPingOperation([](const NFSMount &, int) { return QString("Connection refused"); });
+    watchdog.setProbeOperation([&probes](const QString &) {
+        probes++;
+        return QString();
+    });
+    watchdog.setMounts({makeMount("/mnt/data")});
+
+    QSignalSpy changed(&watchdog, &MountHealthWatchdog::healthChanged);
+    watchdog.checkNow();
+    QTRY_COMPARE(changed.count(), 1);
+    QCOMPARE(watchdog.health("/mnt/data"), MountHealthWatchdog::Health::ServerUnreachable);
+    QVERIFY(watchdog.healthMessage("/mnt/data").contains("Connection refused"));
+    QCOMPARE(probes.load(), 0);
+}
+
+void TestMountHealthWatchdog::testHungProbeIsUnresponsive()
+{
+    QSemaphore release;
+    std::atomic<int> probes(0);
+    MountHealthWatchdog watchdog;
+    watchdog.setPingTimeout(50);
+    watchdog.setProbeTimeout(100);
+    watchdog.setPingOperation([](const NFSMount &, int) { return QString(); });
+    watchdog.setProbeOperation([&release, &probes](const QString &) {
+        probes++;
+        release.acquire();
+        return QString();
+    });
+    watchdog.setMounts({makeMount("/mnt/hung")});
+
+    QSignalSpy changed(&watchdog, &MountHealthWatchdog::healthChanged);
+    QElapsedTimer timer;
+    timer.start();
+    watchdog.checkNow();
+    QVERIFY(timer.elapsed() < 50);
+
+    QTRY_COMPARE(changed.count(), 1);
+    QCOMPARE(watchdog.health("/mnt/hung"), MountHealthWatchdog::Health::Unresponsive);
+    QVERIFY(watchdog.isChecking("/mnt/hung"));
+
+    // The stuck check is not duplicated
+    watchdog.checkNow();
+    QTest::qWait(50);
+    QCOMPARE(probes.load(), 1);
+
+    // A late answer clears the state
+    release.release();
+    QTRY_COMPARE(changed.count(), 2);
+    QCOMPARE(watchdog.health("/mnt/hung"), MountHealthWatchdog::Health::Healthy);
+    QVERIFY(!watchdog.isChecking("/mnt/hung"));
+}
+
+QTEST_MAIN(TestMountHealthWatchdog)
+#include "test_mounthealthwatchdog.moc"
@@ -2,7 +2,14 @@
 #include <QTemporaryDir>
 #include <QDir>
 #include <QFileInfo>
+#include <QSignalSpy>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSemaphore>
+#include <memory>
 #include "../../src/business/mountmanager.h"
+#include "../../src/business/mountorchestrator.h"
+#include "../../src/system/simulatedcommandbackend.h"
 #include "../../src/core/remotenfsshare.h"
 #include "../../src/core/nfsmount.h"
 
@@ -25,12 +32,21 @@ private slots:
     void testCreateMountPoint();
     void testIsMountPointSuitable();
     void testGetDefaultMountOptions();
+    void testTunedDefaultMountOptions();
+    void testToMountArguments();
+    void testComputeScore();
+    void testAutotuneRunsInBackground();
     void testGenerateMountPoint();
 
     // Mount management tests
     void testMountShareValidation();
     void testMountTrackingOperations();
     void testFstabOperations();
+    void testAutomountPersistence();
+    void testExternalMountTracking();
+    void testBackingDeviceTuning();
+    void testShutdownUnmount();
+    void testBatchLoadWithSimulator();
 
     // Error handling tests
     void testInvalidMountPoint();
@@ -59,6 +75,7 @@ void TestMountManager::cleanupTestCase()
 void TestMountManager::init()
 {
     m_mountManager = new MountManager(this);
+    m_mountManager->autotuner()->setSettingsFilePath(m_tempDir->path() + "/mounttuning.ini");
 }
 
 void TestMountManager::cleanup()
@@ -71,6 +88,10 @@ void TestMountManager::testConstructor()
 {
     QVERIFY(m_mountManager != nullptr);
     QVERIFY(m_mountManager->getManagedMounts().isEmpty());
+
+    // Nothing is mounted yet, so no periodic monitoring runs
+    QVERIFY(!m_mountManager->healthWatchdog()->isRunning());
+    QVERIFY(!m_mountManager->replicaSelector()->isRunning());
 }
 
 void TestMountManager::testValidateMountPoint_data()
@@ -163,6 +184,103 @@ void TestMountManager::testGetDefaultMountOptions()
     QVERIFY(options.wsize > 0);
 }
 
+void TestMountManager::testTunedDefaultMountOptions()
+{
+    RemoteNFSShare share;
+    share.setHostName("tunedserver");
+    share.setHostAddress(QHostAddress("192.168.1.101"));
+    share.setExportPath("/export/tuned");
+    share.setSupportedVersion(NFSVersion::Version4);
+    
+    QVERIFY(!m_mountManager->hasTunedMountOptions(share));
+    
+    TuningResult result;
+    result.success = true;
+    result.candidate.nfsVersion = NFSVersion::Version4_2;
+    result.candidate.rsize = 262144;
+    result.candidate.wsize = 262144;
+    result.candidate.nconnect = 4;
+    m_mountManager->autotuner()->saveTunedOptions(MountAutotuner::serverKey(share), result);
+    
+    QVERIFY(m_mountManager->hasTunedMountOptions(share));
+    MountOptions options = m_mountManager->getDefaultMountOptions(share);
+    QCOMPARE(options.nfsVersion, NFSVersion::Version4_2);
+    QCOMPARE(options.rsize, 262144);
+    QCOMPARE(options.wsize, 262144);
+    QCOMPARE(options.customOptions.value("nconnect").toInt(), 4);
+    
+    m_mountManager->autotuner()->clearTunedOptions(MountAutotuner::serverKey(share));
+    QVERIFY(!m_mountManager->hasTunedMountOptions(share));
+}
+
+void TestMountManager::testToMountArguments()
+{
+    MountOptions options;
+    options.readOnly = true;
+    options.softMount = false;
+    options.backgroundMount = false;
+    options.timeoutSeconds = 60;
+    options.retryCount = 2;
+    options.rsize = 0;
+    options.wsize = 1048576;
+    options.customOptions.insert("nconnect", 8);
+    
+    QStringList arguments = MountManager::toMountArguments(options);
+    QVERIFY(arguments.contains("ro"));
+    QVERIFY(arguments.contains("hard"));
+    QVERIFY(!arguments.contains("bg"));
+    QVERIFY(arguments.contains("timeo=600"));
+    QVERIFY(arguments.contains("retrans=2"));
+    QVERIFY(arguments.contains("wsize=1048576"));
+    QVERIFY(arguments.contains("nconnect=8"));
+    // Unset transfer sizes are negotiated by the kernel
+    QVERIFY(!arguments.filter(QRegularExpression("^rsize=")).size());
+}
+
+void TestMountManager::testComputeScore()
+{
+    // Scores favour the candidate that is better on every figure
+    TuningResult slow;
+    slow.readMBps = 100.0;
+    slow.writeMBps = 50.0;
+    slow.metadataOpsPerSecond = 500.0;
+    TuningResult fast = slow;
+    fast.readMBps = 400.0;
+    QVERIFY(MountAutotuner::computeScore(fast) > MountAutotuner::computeScore(slow));
+
+    // Figures that could not be measured are left out instead of zeroing the score
+    TuningResult readOnly;
+    readOnly.metadataOpsPerSecond = 500.0;
+    QCOMPARE(MountAutotuner::computeScore(readOnly), 500.0);
+    QCOMPARE(MountAutotuner::computeScore(TuningResult()), 0.0);
+}
+
+void TestMountManager::testAutotuneRunsInBackground()
+{
+    RemoteNFSShare share;
+    share.setHostAddress(QHostAddress("192.168.1.102"));
+    share.setExportPath("/export/untunable");
+    share.setSupportedVersion(NFSVersion::Version3);
+
+    // Without an NFS service no candidate can be mounted
+    MountAutotuner autotuner(nullptr);
+    autotuner.setSettingsFilePath(m_tempDir->path() + "/untunable.ini");
+    QSignalSpy measuredSpy(&autotuner, &MountAutotuner::candidateMeasured);
+    QSignalSpy finishedSpy(&autotuner, &MountAutotuner::finished);
+
+    QVERIFY(autotuner.start(share));
+    QVERIFY(autotuner.isRunning());
+    QVERIFY(!autotuner.start(share));
+
+    QTRY_COMPARE(finishedSpy.count(), 1);
+    QVERIFY(!autotuner.isRunning());
+    QCOMPARE(measuredSpy.count(), 1);
+    const TuningResult result = finishedSpy.first().at(1).value<TuningResult>();
+    QVERIFY(!result.success);
+    QVERIFY(!result.errorMessage.isEmpty());
+    QVERIFY(!autotuner.loadTunedOptions(MountAutotuner::serverKey(share), nullptr));
+}
+
 void TestMountManager::testGenerateMountPoint()
 {
     // Use reflection to access private method (for testing purposes)
@@ -255,6 +373,268 @@ void TestMountManager::testFstabOperations()
     // In a real test environment, you would mock the PolicyKit operations
 }
 
+void TestMountManager::testAutomountPersistence()
+{
+    RemoteNFSShare share;
+    share.setHostName("testserver");
+    share.setHostAddress(QHostAddress("192.168.1.100"));
+    share.setExportPath("/export/test");
+
+    const QString fstabPath = m_tempDir->filePath("fstab.automount");
+    m_mountManager->setFstabPath(fstabPath);
+    QCOMPARE(m_mountManager->persistenceMode(), MountManager::PersistenceMode::Boot);
+
+    // Boot mode writes a plain entry
+    NFSMount bootMount(share, "/mnt/nfs/boot", MountOptions(), true);
+    QVERIFY(m_mountManager->addToFstab(bootMount));
+    FstabFile fstab(fstabPath);
+    QVERIFY(fstab.load());
+    QVERIFY(!fstab.entry("/mnt/nfs/boot").options.contains("x-systemd.automount"));
+
+    // Automount mode adds the systemd options with the idle timeout
+    m_mountManager->setPersistenceMode(MountManager::PersistenceMode::Automount);
+    m_mountManager->setAutomountIdleTimeout(120);
+    NFSMount lazyMount(share, "/mnt/nfs/lazy", MountOptions(), true);
+    QVERIFY(m_mountManager->addToFstab(lazyMount));
+    QVERIFY(fstab.reloadIfChanged());
+    const QStringList options = fstab.entry("/mnt/nfs/lazy").options;
+    QVERIFY(options.contains("_netdev"));
+    QVERIFY(options.contains("x-systemd.automount"));
+    QVERIFY(options.contains("x-systemd.idle-timeout=120"));
+    QVERIFY(!options.contains("noauto"));
+    QCOMPARE(MountManager::automountOptions(120), options.mid(options.size() - 3));
+
+    // The systemd options do not leak into the mount options read back
+    const QList<NFSMount> persistent = m_mountManager->loadPersistentMounts();
+    QCOMPARE(persistent.size(), 2);
+    for (const NFSMount &mount : persistent) {
+        QVERIFY(!MountManager::toMountArguments(mount.options()).join(',').contains("x-systemd"));
+    }
+}
+
+void TestMountManager::testExternalMountTracking()
+{
+    const QString tablePath = m_tempDir->filePath("mountinfo");
+    auto writeTable = [&tablePath](const QByteArray &content) {
+        QFile file(tablePath);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(content);
+    };
+    const QByteArray rootLine = "22 1 259:2 / / rw,relatime shared:1 - ext4 /dev/nvme0n1p2 rw\n";
+    const QByteArray nfsLine = "36 22 0:52 / /mnt/nfs/external rw,relatime shared:40 - nfs4 "
+                               "server:/srv/data rw,vers=4.2,rsize=1048576,addr=192.168.1.10\n";
+
+    writeTable(rootLine);
+    m_mountManager->setFstabPath(m_tempDir->filePath("fstab.external"));
+    m_mountManager->mountTableMonitor()->setMountInfoPath(tablePath);
+    m_mountManager->mountTableMonitor()->rescan();
+    QVERIFY(!m_mountManager->isManagedMount("/mnt/nfs/external"));
+
+    // A mount made outside the application is tracked as soon as the table changes
+    QSignalSpy statusChanged(m_mountManager, &MountManager::mountStatusChanged);
+    writeTable(rootLine + nfsLine);
+    m_mountManager->refreshMountStatus();
+    QCOMPARE(statusChanged.count(), 1);
+    const NFSMount mount = m_mountManager->getMountByPath("/mnt/nfs/external");
+    QCOMPARE(mount.status(), MountStatus::Mounted);
+    QCOMPARE(mount.remoteShare().exportPath(), QString("/srv/data"));
+    QCOMPARE(mount.options().nfsVersion, NFSVersion::Version4_2);
+    QVERIFY(!mount.options().customOptions.contains("addr"));
+
+    // Re-reading an unchanged table reports nothing
+    m_mountManager->refreshMountStatus();
+    QCOMPARE(statusChanged.count(), 1);
+
+    // An external unmount drops the temporary mount
+    writeTable(rootLine);
+    m_mountManager->refreshMountStatus();
+    QCOMPARE(statusChanged.count(), 2);
+    QCOMPARE(statusChanged.last().at(0).value<NFSMount>().status(), MountStatus::NotMounted);
+    QVERIFY(!m_mountManager->isManagedMount("/mnt/nfs/external"));
+}
+
+void TestMountManager::testBackingDeviceTuning()
+{
+    MountOptions options;
+    BdiSettings settings;
+    settings.readAheadKb = 4096;
+    MountManager::setBdiSettings(&options, settings);
+    QCOMPARE(MountManager::bdiSettingsOf(options), settings);
+    QVERIFY(MountManager::toMountArguments(options).contains("x-nfs-share-manager.read_ahead_kb=4096"));
+    QCOMPARE(MountManager::bdiSettingsOf(MountManager::fromMountArguments(MountManager::toMountArguments(options))),
+             settings);
+
+    // Fake sysfs and mount table with one NFS mount on device 0:52
+    const QString sysfsRoot = m_tempDir->filePath("bdi");
+    QVERIFY(QDir().mkpath(sysfsRoot + "/0:52"));
+    const auto readAhead = [&sysfsRoot]() {
+        QFile file(sysfsRoot + "/0:52/read_ahead_kb");
+        return file.open(QIODevice::ReadOnly) ? file.readAll().trimmed().toInt() : -1;
+    };
+    QFile defaultValue(sysfsRoot + "/0:52/read_ahead_kb");
+    QVERIFY(defaultValue.open(QIODevice::WriteOnly));
+    defaultValue.write("128\n");
+    defaultValue.close();
+    m_mountManager->bdiTuner()->setSysfsRoot(sysfsRoot);
+
+    // A persistent mount brought up by the system takes its settings from fstab
+    const QString fstabPath = m_tempDir->filePath("fstab.bdi");
+    QFile fstab(fstabPath);
+    QVERIFY(fstab.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    fstab.write("server:/srv/data /mnt/nfs/tuned nfs rw,x-nfs-share-manager.read_ahead_kb=4096,_netdev 0 0\n");
+    fstab.close();
+    m_mountManager->setFstabPath(fstabPath);
+
+    const QString tablePath = m_tempDir->filePath("mountinfo.bdi");
+    QFile table(tablePath);
+    QVERIFY(table.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    table.write("22 1 259:2 / / rw,relatime shared:1 - ext4 /dev/nvme0n1p2 rw\n"
+                "36 22 0:52 / /mnt/nfs/tuned rw,relatime shared:40 - nfs4 server:/srv/data rw,vers=4.2\n");
+    table.close();
+    m_mountManager->mountTableMonitor()->setMountInfoPath(tablePath);
+    m_mountManager->refreshMountStatus();
+
+    QVERIFY(m_mountManager->isManagedMount("/mnt/nfs/tuned"));
+    QCOMPARE(readAhead(), 4096);
+    QCOMPARE(m_mountManager->backingDeviceSettings("/mnt/nfs/tuned").readAheadKb, 4096);
+
+    // Changing the settings applies them and rewrites the fstab entry
+    settings.readAheadKb = 16384;
+    QVERIFY(m_mountManager->tuneBackingDevice("/mnt/nfs/tuned", settings));
+    QCOMPARE(readAhead(), 16384);
+    QVERIFY(fstab.open(QIODevice::ReadOnly));
+    QVERIFY(fstab.readAll().contains("x-nfs-share-manager.read_ahead_kb=16384"));
+    fstab.close();
+
+    settings.maxRatio = 150;
+    QVERIFY(!m_mountManager->tuneBackingDevice("/mnt/nfs/tuned", settings));
+    QVERIFY(!m_mountManager->tuneBackingDevice("/mnt/nfs/unknown", BdiSettings()));
+
+    // Settings that cannot be written are reported, not only logged
+    QSignalSpy failedSpy(m_mountManager, &MountManager::backingDeviceTuningFailed);
+    QVERIFY(QDir(sysfsRoot + "/0:52").removeRecursively());
+    settings.maxRatio = 50;
+    QVERIFY(!m_mountManager->tuneBackingDevice("/mnt/nfs/tuned", settings));
+    QCOMPARE(failedSpy.count(), 1);
+    QCOMPARE(failedSpy.first().at(0).toString(), QString("/mnt/nfs/tuned"));
+    QVERIFY(failedSpy.first().at(1).toString().contains("0:52"));
+}
+
+void TestMountManager::testShutdownUnmount()
+{
+    // Two temporary mounts and one persistent mount, all made outside the application
+    const QString fstabPath = m_tempDir->filePath("fstab.shutdown");
+    QFile fstab(fstabPath);
+    QVERIFY(fstab.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    fstab.write("server:/srv/home /mnt/nfs/home nfs rw,_netdev 0 0\n");
+    fstab.close();
+    m_mountManager->setFstabPath(fstabPath);
+
+    const QString tablePath = m_tempDir->filePath("mountinfo.shutdown");
+    QFile table(tablePath);
+    QVERIFY(table.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    table.write("22 1 259:2 / / rw,relatime shared:1 - ext4 /dev/nvme0n1p2 rw\n"
+                "36 22 0:52 / /mnt/nfs/alive rw,relatime shared:40 - nfs4 alive:/srv/data rw,vers=4.2\n"
+                "37 22 0:53 / /mnt/nfs/dead rw,relatime shared:41 - nfs4 dead:/srv/data rw,vers=4.2\n"
+                "38 22 0:54 / /mnt/nfs/home rw,relatime shared:42 - nfs4 server:/srv/home rw,vers=4.2\n");
+    table.close();
+    m_mountManager->mountTableMonitor()->setMountInfoPath(tablePath);
+    m_mountManager->refreshMountStatus();
+    QCOMPARE(m_mountManager->getManagedMounts().size(), 3);
+
+    // The dead server never answers any step
+    const auto hung = std::make_shared<QSemaphore>();
+    const auto mutex = std::make_shared<QMutex>();
+    const auto unmounted = std::make_shared<QStringList>();
+    m_mountManager->shutdownUnmounter()->setUnmountOperation(
+        [hung, mutex, unmounted](const QString &mountPoint, ShutdownUnmounter::Step) {
+        {
+            QMutexLocker locker(mutex.get());
+            *unmounted << mountPoint;
+        }
+        if (mountPoint == "/mnt/nfs/dead") {
+            hung->acquire();
+        }
+        return QString();
+    });
+    QSignalSpy completedSpy(m_mountManager, &MountManager::unmountCompleted);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QCOMPARE(m_mountManager->unmountForShutdown(300), QStringList{"/mnt/nfs/dead"});
+    QVERIFY(elapsed.elapsed() < 1000);
+    QCOMPARE(completedSpy.count(), 1);
+    QCOMPARE(completedSpy.at(0).at(0).toString(), QString("/mnt/nfs/alive"));
+    QVERIFY(!m_mountManager->isManagedMount("/mnt/nfs/alive"));
+    QVERIFY(m_mountManager->isManagedMount("/mnt/nfs/dead"));
+    QVERIFY(m_mountManager->isManagedMount("/mnt/nfs/home"));
+    int calls = 0;
+    {
+        QMutexLocker locker(mutex.get());
+        QVERIFY(!unmounted->contains("/mnt/nfs/home"));
+        calls = unmounted->size();
+    }
+
+    // A second exit path does not retry the stragglers
+    elapsed.restart();
+    QCOMPARE(m_mountManager->unmountForShutdown(300), QStringList{"/mnt/nfs/dead"});
+    QVERIFY(elapsed.elapsed() < 100);
+    QCOMPARE(completedSpy.count(), 1);
+    {
+        QMutexLocker locker(mutex.get());
+        QCOMPARE(unmounted->size(), calls);
+    }
+
+    hung->release(3);
+}
+
+void TestMountManager::testBatchLoadWithSimulator()
+{
+    // 100 mounts across four servers, each mount taking 20 ms and one in ten failing
+    auto simulator = std::make_shared<SimulatedCommandBackend>(11);
+    simulator->setExportsFilePath(m_tempDir->filePath("exports.load"));
+    simulator->populateRemoteServers(4, 25);
+    simulator->setCommandLatency("mount", 20);
+    simulator->setCommandLatency("umount", 20);
+    simulator->setCommandFailureRate("mount", 0.1);
+    m_mountManager->nfsService()->setCommandBackend(simulator);
+    m_mountManager->orchestrator()->setMaxConcurrency(8);
+
+    QList<NFSMount> mounts;
+    for (int i = 0; i < 100; ++i) {
+        RemoteNFSShare share;
+        share.setHostAddress(QHostAddress(QString("10.99.0.%1").arg(i % 4 + 1)));
+        share.setExportPath(QString("/export/share%1").arg(i / 4, 4, 10, QChar('0')));
+        share.setSupportedVersion(NFSVersion::Version4);
+        mounts << NFSMount(share, m_testMountRoot + QString("/load%1").arg(i));
+    }
+
+    QSignalSpy completedSpy(m_mountManager, &MountManager::mountCompleted);
+    QSignalSpy failedSpy(m_mountManager, &MountManager::mountFailed);
+    QSignalSpy finishedSpy(m_mountManager, &MountManager::mountBatchFinished);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QVERIFY(m_mountManager->mountShares(mounts));
+    QVERIFY(finishedSpy.wait(10000));
+
+    // Eight at a time: far below the 2 s the mounts take one after another
+    QVERIFY(elapsed.elapsed() < 1500);
+    QCOMPARE(completedSpy.count() + failedSpy.count(), 100);
+    QVERIFY(failedSpy.count() > 0);
+    QCOMPARE(finishedSpy.first().at(1).toInt(), completedSpy.count());
+    QCOMPARE(simulator->mountPoints().size(), completedSpy.count());
+    QCOMPARE(simulator->commandCount("mount"), 100);
+
+    QStringList mountPoints = simulator->mountPoints();
+    QSignalSpy unmountedSpy(m_mountManager, &MountManager::unmountCompleted);
+    finishedSpy.clear();
+    QVERIFY(m_mountManager->unmountShares(mountPoints));
+    QVERIFY(finishedSpy.wait(10000));
+    QCOMPARE(unmountedSpy.count(), mountPoints.size());
+    QVERIFY(simulator->mountPoints().isEmpty());
+}
+
 void TestMountManager::testInvalidMountPoint()
 {
     RemoteNFSShare validShare;
@@ -0,0 +1,240 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+#include "../../src/business/mountorchestrator.h"
+#include "../../src/core/remotenfsshare.h"
+
+using namespace NFSShareManager;
+
+namespace {
+
+NFSMount makeMount(const QString &mountPoint)
+{
+    RemoteNFSShare remoteShare("server", QHostAddress(), "/export" + mountPoint);
+    return NFSMount(remoteShare, mountPoint, MountOptions(), false);
+}
+
+/**
+ * @brief Records start and end order of operations across pool threads
+ */
+class OperationLog
+{
+public:
+    void started(const QString &mountPoint)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_events << "start " + mountPoint;
+        m_maxActive = qMax(m_maxActive, ++m_active);
+    }
+
+    void finished(const QString &mountPoint)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_events << "end " + mountPoint;
+        --m_active;
+    }
+
+    QStringList events() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_events;
+    }
+
+    int maxActive() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_maxActive;
+    }
+
+private:
+    mutable QMutex m_mutex;
+    QStringList m_events;
+    int m_active = 0;
+    int m_maxActive = 0;
+};
+
+} // namespace
+
+class TestMountOrchestrator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testBuildDependencies();
+    void testIndependentMountsRunConcurrently();
+    void testNestedMountsWaitForParent();
+    void testFailedParentSkipsChildren();
+    void testUnmountChildrenFirst();
+    void testInvalidEntries();
+    void testConcurrentBatches();
+};
+
+void TestMountOrchestrator::testBuildDependencies()
+{
+    const QHash<QString, QString> parents = MountOrchestrator::buildDependencies(
+        {"/mnt", "/mnt/a", "/mnt/a/b/c", "/mnt/ab", "/srv/x", "/"});
+    QCOMPARE(parents.value("/mnt"), QString("/"));
+    QCOMPARE(parents.value("/mnt/a"), QString("/mnt"));
+    QCOMPARE(parents.value("/mnt/a/b/c"), QString("/mnt/a"));
+    QCOMPARE(parents.value("/mnt/ab"), QString("/mnt"));
+    QCOMPARE(parents.value("/srv/x"), QString("/"));
+    QVERIFY(!parents.contains("/"));
+}
+
+void TestMountOrchestrator::testIndependentMountsRunConcurrently()
+{
+    OperationLog log;
+    MountOrchestrator orchestrator;
+    orchestrator.setMaxConcurrency(4);
+    orchestrator.setMountOperation([&log](const NFSMount &mount) {
+        log.started(mount.localMountPoint());
+        QThread::msleep(100);
+        log.finished(mount.localMountPoint());
+        return QString();
+    });
+
+    QList<NFSMount> mounts;
+    for (int i = 0; i < 8; ++i) {
+        mounts << makeMount(QString("/mnt/share%1").arg(i));
+    }
+
+    QSignalSpy completed(&orchestrator, &MountOrchestrator::mountCompleted);
+    QSignalSpy finished(&orchestrator, &MountOrchestrator::finished);
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(orchestrator.mountAll(mounts));
+    QVERIFY(orchestrator.waitForFinished(10000));
+
+    // Two waves of four, not eight mounts in a row
+    QVERIFY(timer.elapsed() < 700);
+    QCOMPARE(log.maxActive(), 4);
+    QCOMPARE(completed.count(), 8);
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(finished.first().at(1).toInt(), 8);
+    QCOMPARE(finished.first().at(2).toInt(), 0);
+}
+
+void TestMountOrchestrator::testNestedMountsWaitForParent()
+{
+    OperationLog log;
+    MountOrchestrator orchestrator;
+    orchestrator.setMountOperation([&log](const NFSMount &mount) {
+        log.started(mount.localMountPoint());
+        QThread::msleep(20);
+        log.finished(mount.localMountPoint());
+        return QString();
+    });
+
+    QVERIFY(orchestrator.mountAll({makeMount("/mnt/a/b"), makeMount("/mnt/a"), makeMount("/mnt/c")}));
+    QVERIFY(orchestrator.waitForFinished(10000));
+
+    const QStringList events = log.events();
+    QVERIFY(events.indexOf("end /mnt/a") < events.indexOf("start /mnt/a/b"));
+    // The independent mount does not wait for the chain
+    QVERIFY(events.indexOf("start /mnt/c") < events.indexOf("end /mnt/a"));
+}
+
+void TestMountOrchestrator::testFailedParentSkipsChildren()
+{
+    std::atomic<int> calls(0);
+    MountOrchestrator orchestrator;
+    orchestrator.setMountOperation([&calls](const NFSMount &mount) {
+        calls++;
+        return mount.localMountPoint() == "/mnt/a" ? QString("mount.nfs: access denied") : QString();
+    });
+
+    QSignalSpy failed(&orchestrator, &MountOrchestrator::mountFailed);
+    QSignalSpy finished(&orchestrator, &MountOrchestrator::finished);
+    QVERIFY(orchestrator.mountAll({makeMount("/mnt/a"), makeMount("/mnt/a/b"), makeMount("/mnt/a/b/c"),
+                                   makeMount("/mnt/d")}));
+    QVERIFY(orchestrator.waitForFinished(10000));
+
+    QCOMPARE(calls.load(), 2);
+    QCOMPARE(failed.count(), 3);
+    QCOMPARE(failed.at(0).at(1).value<MountOrchestrator::FailureReason>(),
+             MountOrchestrator::FailureReason::OperationFailed);
+    QCOMPARE(failed.at(1).at(1).value<MountOrchestrator::FailureReason>(),
+             MountOrchestrator::FailureReason::DependencyFailed);
+    QCOMPARE(failed.at(2).at(0).value<NFSMount>().localMountPoint(), QString("/mnt/a/b/c"));
+    QCOMPARE(finished.first().at(1).toInt(), 1);
+    QCOMPARE(finished.first().at(2).toInt(), 3);
+}
+
+void TestMountOrchestrator::testUnmountChildrenFirst()
+{
+    OperationLog log;
+    MountOrchestrator orchestrator;
+    orchestrator.setUnmountOperation([&log](const QString &mountPoint, bool force) {
+        Q_UNUSED(force)
+        log.started(mountPoint);
+        QThread::msleep(20);
+        log.finished(mountPoint);
+        return QString();
+    });
+
+    QSignalSpy completed(&orchestrator, &MountOrchestrator::unmountCompleted);
+    QVERIFY(orchestrator.unmountAll({"/mnt/a", "/mnt/a/b", "/mnt/a/c", "/mnt/a/b/d"}));
+    QVERIFY(orchestrator.waitForFinished(10000));
+
+    const QStringList events = log.events();
+    QCOMPARE(completed.count(), 4);
+    QVERIFY(events.indexOf("end /mnt/a/b/d") < events.indexOf("start /mnt/a/b"));
+    QVERIFY(events.indexOf("end /mnt/a/b") < events.indexOf("start /mnt/a"));
+    QVERIFY(events.indexOf("end /mnt/a/c") < events.indexOf("start /mnt/a"));
+    QCOMPARE(completed.last().at(0).toString(), QString("/mnt/a"));
+}
+
+void TestMountOrchestrator::testInvalidEntries()
+{
+    MountOrchestrator orchestrator;
+    orchestrator.setMountOperation([](const NFSMount &) {
+        QThread::msleep(50);
+        return QString();
+    });
+
+    QSignalSpy failed(&orchestrator, &MountOrchestrator::mountFailed);
+    QVERIFY(orchestrator.mountAll({makeMount("/mnt/x"), makeMount("/mnt/x/"), makeMount("relative")}));
+    QVERIFY(orchestrator.waitForFinished(10000));
+
+    QCOMPARE(failed.count(), 2);
+    for (const QList<QVariant> &arguments : failed) {
+        QCOMPARE(arguments.at(1).value<MountOrchestrator::FailureReason>(),
+                 MountOrchestrator::FailureReason::InvalidEntry);
+    }
+    QVERIFY(!orchestrator.isRunning());
+}
+
+void TestMountOrchestrator::testConcurrentBatches()
+{
+    OperationLog log;
+    MountOrchestrator orchestrator;
+    orchestrator.setMountOperation([&log](const NFSMount &mount) {
+        log.started(mount.localMountPoint());
+        QThread::msleep(mount.localMountPoint() == "/mnt/a" ? 200 : 20);
+        log.finished(mount.localMountPoint());
+        return QString();
+    });
+
+    QSignalSpy started(&orchestrator, &MountOrchestrator::mountStarted);
+    QSignalSpy finished(&orchestrator, &MountOrchestrator::finished);
+    const int slow = orchestrator.mountAll({makeMount("/mnt/a")});
+    const int nested = orchestrator.mountAll({makeMount("/mnt/a/b")});
+    const int independent = orchestrator.mountAll({makeMount("/mnt/c")});
+    QVERIFY(slow > 0 && nested > 0 && independent > 0);
+    QVERIFY(orchestrator.waitForFinished(10000));
+
+    // The independent batch runs beside the slow one, the nested one after it
+    const QStringList events = log.events();
+    QVERIFY(events.indexOf("end /mnt/c") < events.indexOf("end /mnt/a"));
+    QVERIFY(events.indexOf("end /mnt/a") < events.indexOf("start /mnt/a/b"));
+    QCOMPARE(started.count(), 3);
+    QCOMPARE(finished.count(), 3);
+    QCOMPARE(finished.at(0).at(0).toInt(), independent);
+    QCOMPARE(finished.last().at(0).toInt(), nested);
+}
+
+QTEST_MAIN(TestMountOrchestrator)
+#include "test_mountorchestrator.moc"
@@ -0,0 +1,182 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+#include "../../src/business/nfsdclienttracker.h"
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+using namespace NFSShareManager;
+
+class TestNFSDClientTracker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testParseClientInfo();
+    void testParseStateDevices();
+    void testParseRmtab();
+    void testIncrementalRefresh();
+    void testNfsv3ClientsFromRmtab();
+
+private:
+    void writeFile(const QString &path, const QByteArray &content);
+    void addClient(const QString &id, const QString &address, const QByteArray &states);
+    QByteArray openStateOn(const QString &path) const;
+
+    QTemporaryDir *m_tempDir;
+    QString m_export;
+    NFSDClientTracker *m_tracker;
+};
+
+void TestNFSDClientTracker::init()
+{
+    m_tempDir = new QTemporaryDir();
+    QVERIFY(m_tempDir->isValid());
+    QVERIFY(QDir().mkpath(m_tempDir->filePath("nfsd/clients")));
+    m_export = m_tempDir->filePath("export");
+    QVERIFY(QDir().mkpath(m_export));
+
+    m_tracker = new NFSDClientTracker();
+    m_tracker->setNfsdRoot(m_tempDir->filePath("nfsd"));
+    m_tracker->setRmtabPath(m_tempDir->filePath("rmtab"));
+    m_tracker->setExports({m_export});
+}
+
+void TestNFSDClientTracker::cleanup()
+{
+    delete m_tracker;
+    m_tracker = nullptr;
+    delete m_tempDir;
+    m_tempDir = nullptr;
+}
+
+void TestNFSDClientTracker::writeFile(const QString &path, const QByteArray &content)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(content);
+    file.close();
+}
+
+void TestNFSDClientTracker::addClient(const QString &id, const QString &address, const QByteArray &states)
+{
+    const QString dir = m_tempDir->filePath("nfsd/clients/" + id);
+    QVERIFY(QDir().mkpath(dir));
+    writeFile(dir + "/info", QString("clientid: 0x%1\naddress: \"%2:815\"\nstatus: confirmed\n"
+                                     "name: \"Linux NFSv4.2 %2\"\nminor version: 2\n")
+                                 .arg(id, address).toUtf8());
+    writeFile(dir + "/states", states);
+}
+
+QByteArray TestNFSDClientTracker::openStateOn(const QString &path) const
+{
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0) {
+        return QByteArray();
+    }
+    return QString("- 0x00000001: { type: open, access: rw, deny: --, superblock: \"%1:%2:%3\", "
+                   "filename: \"file\", owner: \"open id:\" }\n")
+        .arg(major(st.st_dev), 2, 16, QChar('0'))
+        .arg(minor(st.st_dev), 2, 16, QChar('0'))
+        .arg(quint64(st.st_ino))
+        .toUtf8();
+}
+
+void TestNFSDClientTracker::testParseClientInfo()
+{
+    NFSClientInfo info = NFSDClientTracker::parseClientInfo(
+        "clientid: 0xc7f2a5cd5f3f7c04\n"
+        "address: \"192.168.1.10:980\"\n"
+        "status: confirmed\n"
+        "name: \"Linux NFSv4.1 client.example.com\"\n"
+        "minor version: 1\n");
+    QCOMPARE(info.address, QString("192.168.1.10"));
+    QCOMPARE(info.name, QString("Linux NFSv4.1 client.example.com"));
+    QCOMPARE(info.protocol, QString("NFSv4.1"));
+
+    info = NFSDClientTracker::parseClientInfo("address: \"[fe80::1]:980\"\nminor version: 0\n");
+    QCOMPARE(info.address, QString("fe80::1"));
+    QCOMPARE(info.protocol, QString("NFSv4.0"));
+}
+
+void TestNFSDClientTracker::testParseStateDevices()
+{
+    const QList<quint64> devices = NFSDClientTracker::parseStateDevices(
+        "- 0x1: { type: open, access: r-, deny: --, superblock: \"fd:01:1835021\", filename: \"a\" }\n"
+        "- 0x2: { type: lock, superblock: \"08:11:42\", filename: \"b\", owner: \"lock id\" }\n"
+        "- 0x3: { type: deleg, access: r }\n");
+    QCOMPARE(devices, QList<quint64>({quint64(makedev(0xfd, 0x01)), quint64(makedev(0x08, 0x11))}));
+}
+
+void TestNFSDClientTracker::testParseRmtab()
+{
+    const auto mounts = NFSDClientTracker::parseRmtab(
+        "client.example.com:/srv/share:0x00000001\n"
+        "\n"
+        "10.0.0.5:/srv/other/:0x00000002\n"
+        "garbage\n");
+    QCOMPARE(mounts.size(), 2);
+    QCOMPARE(mounts[0], qMakePair(QString("client.example.com"), QString("/srv/share")));
+    QCOMPARE(mounts[1], qMakePair(QString("10.0.0.5"), QString("/srv/other")));
+}
+
+void TestNFSDClientTracker::testIncrementalRefresh()
+{
+    QSignalSpy spy(m_tracker, &NFSDClientTracker::clientsChanged);
+    QVERIFY(m_tracker->isAvailable());
+    QVERIFY(!m_tracker->refresh());
+
+    addClient("1", "192.168.1.10", openStateOn(m_export + "/."));
+    addClient("2", "192.168.1.11", QByteArray());
+    QVERIFY(m_tracker->refresh());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(m_tracker->infoReads(), 2);
+    QCOMPARE(m_tracker->clients().size(), 2);
+
+    // Only the client with open state can be attributed to the export
+    QList<NFSClientInfo> active = m_tracker->activeClients(m_export);
+    QCOMPARE(active.size(), 1);
+    QCOMPARE(active.first().address, QString("192.168.1.10"));
+    QCOMPARE(active.first().openStates, 1);
+
+    // Nothing changed: no info file is read again
+    QVERIFY(!m_tracker->refresh());
+    QCOMPARE(m_tracker->infoReads(), 2);
+
+    // The second client opens a file; the first one goes away
+    writeFile(m_tempDir->filePath("nfsd/clients/2/states"), openStateOn(m_export));
+    QVERIFY(QDir(m_tempDir->filePath("nfsd/clients/1")).removeRecursively());
+    QVERIFY(m_tracker->refresh());
+    QCOMPARE(m_tracker->infoReads(), 2);
+    active = m_tracker->activeClients(m_export + "/");
+    QCOMPARE(active.size(), 1);
+    QCOMPARE(active.first().address, QString("192.168.1.11"));
+}
+
+void TestNFSDClientTracker::testNfsv3ClientsFromRmtab()
+{
+    writeFile(m_tempDir->filePath("rmtab"),
+              QString("old-client:%1:0x00000001\nold-client:/srv/elsewhere:0x00000001\n")
+                  .arg(m_export).toUtf8());
+    QVERIFY(m_tracker->refresh());
+
+    const QList<NFSClientInfo> active = m_tracker->activeClients(m_export);
+    QCOMPARE(active.size(), 1);
+    QCOMPARE(active.first().address, QString("old-client"));
+    QCOMPARE(active.first().protocol, QString("NFSv3"));
+    QCOMPARE(active.first().exports.size(), 2);
+
+    // Unchanged rmtab is not parsed again
+    QVERIFY(!m_tracker->refresh());
+
+    QVERIFY(QFile::remove(m_tempDir->filePath("rmtab")));
+    QVERIFY(m_tracker->refresh());
+    QVERIFY(m_tracker->activeClients(m_export).isEmpty());
+}
+
+QTEST_MAIN(TestNFSDClientTracker)
+#include "test_nfsdclienttracker.moc"
@@ -0,0 +1,128 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include "../../src/business/nfsdloadmonitor.h"
+
+using namespace NFSShareManager;
+
+namespace {
+
+QByteArray rpcNfsd(quint64 hits, quint64 misses, quint64 readBytes, quint64 v3Ops, quint64 v4Ops)
+{
+    return QString("rc %1 %2 500\n"
+                   "fh 0 0 0 0 0\n"
+                   "io %3 4096\n"
+                   "th 8 0 0.000 0.000 0.000 0.000 0.000 0.000 0.000 0.000 0.000 0.000\n"
+                   "net 100 0 100 5\n"
+                   "rpc 100 0 0 0 0\n"
+                   "proc3 4 0 %4 0 0\n"
+                   "proc4 2 0 10\n"
+                   "proc4ops 3 0 %5 0\n")
+        .arg(hits).arg(misses).arg(readBytes).arg(v3Ops).arg(v4Ops).toUtf8();
+}
+
+QByteArray poolStats(quint64 arrived, quint64 enqueued)
+{
+    return QString("# pool packets-arrived sockets-enqueued threads-woken threads-timedout\n"
+                   "0 %1 %2 %3 0\n").arg(arrived).arg(enqueued).arg(arrived - enqueued).toUtf8();
+}
+
+} // namespace
+
+class TestNFSDLoadMonitor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFirstSampleHasNoRates();
+    void testRatesOverWindow();
+    void testReplyCacheHitRate();
+    void testStarvationSignals();
+    void testSampleFromProcRoot();
+};
+
+void TestNFSDLoadMonitor::testFirstSampleHasNoRates()
+{
+    NFSDLoadMonitor monitor;
+    monitor.sample(rpcNfsd(0, 0, 0, 0, 0), poolStats(0, 0), "8\n", 1000);
+    QVERIFY(monitor.history().isEmpty());
+    QCOMPARE(monitor.summary().sampleCount, 0);
+}
+
+void TestNFSDLoadMonitor::testRatesOverWindow()
+{
+    NFSDLoadMonitor monitor;
+    monitor.setWindowSize(2);
+    monitor.sample(rpcNfsd(0, 0, 0, 0, 0), poolStats(0, 0), "8\n", 1000);
+    monitor.sample(rpcNfsd(0, 0, 1000, 100, 100), poolStats(100, 0), "8\n", 2000);
+    monitor.sample(rpcNfsd(0, 0, 3000, 200, 300), poolStats(200, 0), "8\n", 3000);
+    monitor.sample(rpcNfsd(0, 0, 7000, 300, 500), poolStats(300, 0), "8\n", 4000);
+
+    QCOMPARE(monitor.history().size(), 3);
+    NFSDLoadSummary summary = monitor.summary();
+    QCOMPARE(summary.sampleCount, 2);
+    // Last two intervals: 100 v3 + 200 v4 ops per second each
+    QCOMPARE(summary.operationsPerSecond, 300.0);
+    QCOMPARE(summary.readBytesPerSecond, 3000.0);
+    QCOMPARE(summary.threads, 8);
+    QVERIFY(!summary.starved);
+}
+
+void TestNFSDLoadMonitor::testReplyCacheHitRate()
+{
+    NFSDLoadMonitor monitor;
+    monitor.sample(rpcNfsd(10, 10, 0, 0, 0), QByteArray(), QByteArray(), 1000);
+    monitor.sample(rpcNfsd(40, 20, 0, 0, 0), QByteArray(), QByteArray(), 2000);
+
+    NFSDLoadSummary summary = monitor.summary();
+    QCOMPARE(summary.replyCacheHitRate, 0.75);
+    // Without the threads file the count comes from the "th" line
+    QCOMPARE(summary.threads, 8);
+}
+
+void TestNFSDLoadMonitor::testStarvationSignals()
+{
+    NFSDLoadMonitor monitor;
+    monitor.setWindowSize(1);
+    monitor.setStarvationThreshold(0.1);
+    QSignalSpy starvedSpy(&monitor, &NFSDLoadMonitor::threadPoolStarved);
+    QSignalSpy recoveredSpy(&monitor, &NFSDLoadMonitor::threadPoolRecovered);
+
+    monitor.sample(rpcNfsd(0, 0, 0, 0, 0), poolStats(0, 0), "8\n", 1000);
+    monitor.sample(rpcNfsd(0, 0, 0, 0, 0), poolStats(100, 50), "8\n", 2000);
+    QCOMPARE(starvedSpy.count(), 1);
+    QVERIFY(monitor.summary().starved);
+    QCOMPARE(monitor.summary().busyFraction, 0.5);
+
+    // Still starved: no repeated signal
+    monitor.sample(rpcNfsd(0, 0, 0, 0, 0), poolStats(200, 100), "8\n", 3000);
+    QCOMPARE(starvedSpy.count(), 1);
+
+    monitor.sample(rpcNfsd(0, 0, 0, 0, 0), poolStats(300, 101), "8\n", 4000);
+    QCOMPARE(recoveredSpy.count(), 1);
+    QVERIFY(!monitor.summary().starved);
+}
+
+void TestNFSDLoadMonitor::testSampleFromProcRoot()
+{
+    QTemporaryDir procRoot;
+    QVERIFY(procRoot.isValid());
+
+    NFSDLoadMonitor monitor;
+    monitor.setProcRoot(procRoot.path());
+    QVERIFY(!monitor.isAvailable());
+    QVERIFY(!monitor.sample());
+
+    QVERIFY(QDir().mkpath(procRoot.path() + "/net/rpc"));
+    QFile file(procRoot.path() + "/net/rpc/nfsd");
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(rpcNfsd(1, 1, 0, 0, 0));
+    file.close();
+
+    QVERIFY(monitor.isAvailable());
+    QVERIFY(monitor.sample());
+    QVERIFY(monitor.sample());
+}
+
+QTEST_MAIN(TestNFSDLoadMonitor)
+#include "test_nfsdloadmonitor.moc"
@@ -0,0 +1,250 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtEndian>
+#include <atomic>
+#include <thread>
+#include "../../src/business/replicaselector.h"
+
+using namespace NFSShareManager;
+
+namespace {
+
+RemoteNFSShare makeShare(const QString &host, const QString &exportPath)
+{
+    return RemoteNFSShare(host, QHostAddress(), exportPath);
+}
+
+NFSMount makeMount(const RemoteNFSShare &share, const QString &mountPoint)
+{
+    MountOptions options;
+    options.readOnly = true;
+    NFSMount mount(share, mountPoint, options, false);
+    mount.setStatus(MountStatus::Mounted);
+    return mount;
+}
+
+/**
+ * @brief Answers every RPC call it receives with an accepted empty reply
+ */
+class RpcEchoServer : public QTcpServer
+{
+public:
+    RpcEchoServer()
+    {
+        connect(this, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket *socket = nextPendingConnection()) {
+                connect(socket, &QTcpSocket::readyRead, socket, [socket]() { answer(socket); });
+            }
+        });
+    }
+
+private:
+    static void answer(QTcpSocket *socket)
+    {
+        QByteArray pending = socket->property("pending").toByteArray() + socket->readAll();
+        QByteArray replies;
+        while (pending.size() >= 4) {
+            const int length = 4 + (qFromBigEndian<quint32>(pending.constData()) & 0x7fffffff);
+            if (pending.size() < length) {
+                break;
+            }
+            const quint32 xid = qFromBigEndian<quint32>(pending.constData() + 4);
+            pending.remove(0, length);
+
+            // xid, REPLY, MSG_ACCEPTED, AUTH_NONE verifier, SUCCESS
+            const quint32 words[] = {0x80000000u | 24, xid, 1, 0, 0, 0, 0};
+            for (quint32 word : words) {
+                const quint32 value = qToBigEndian(word);
+                replies.append(reinterpret_cast<const char *>(&value), sizeof(value));
+            }
+        }
+        socket->setProperty("pending", pending);
+        socket->write(replies);
+    }
+};
+
+} // namespace
+
+class TestReplicaSelector : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testGrouping();
+    void testContentMarker();
+    void testSelectFastest();
+    void testUnreachableReplicaLoses();
+    void testSustainedDegradation();
+    void testPipelinedRtt();
+    void testPipelinedRttRefused();
+};
+
+void TestReplicaSelector::testGrouping()
+{
+    ReplicaSelector selector;
+    selector.setShares({makeShare("mirror1", "/data/set"), makeShare("mirror2", "/data/set/"),
+                        makeShare("mirror1", "/data/set"), makeShare("mirror1", "/home")});
+
+    QCOMPARE(selector.replicasOf(makeShare("mirror2", "/data/set")).size(), 2);
+    QVERIFY(selector.hasReplicas(makeShare("mirror1", "/data/set")));
+    QVERIFY(!selector.hasReplicas(makeShare("mirror1", "/home")));
+    QCOMPARE(selector.replicaGroups().size(), 1);
+
+    // Unknown shares are only their own replica
+    QCOMPARE(selector.replicasOf(makeShare("other", "/srv")).size(), 1);
+    QVERIFY(ReplicaSelector::isSameReplica(makeShare("a", "/x/"), makeShare("a", "/x")));
+    QVERIFY(!ReplicaSelector::isSameReplica(makeShare("a", "/x"), makeShare("b", "/x")));
+}
+
+void TestReplicaSelector::testContentMarker()
+{
+    ReplicaSelector selector;
+    selector.setMarkerOperation([](const RemoteNFSShare &share) {
+        return share.hostName() == "stale" ? QString("v1") : QString("v2");
+    });
+    selector.setShares({makeShare("mirror1", "/data"), makeShare("mirror2", "/data"), makeShare("stale", "/data")});
+
+    const QList<RemoteNFSShare> replicas = selector.replicasOf(makeShare("mirror1", "/data"));
+    QCOMPARE(replicas.size(), 2);
+    for (const RemoteNFSShare &replica : replicas) {
+        QVERIFY(replica.hostName() != "stale");
+    }
+    QVERIFY(!selector.hasReplicas(makeShare("stale", "/data")));
+    QCOMPARE(selector.replicaKey(makeShare("stale", "/data/")), QString("/data#v1"));
+}
+
+void TestReplicaSelector::testSelectFastest()
+{
+    std::atomic<int> running(0);
+    std::atomic<int> concurrent(0);
+    ReplicaSelector selector;
+    selector.setRttOperation([&running, &concurrent](const RemoteNFSShare &replica, int, double *rttMs) {
+        concurrent = qMax(concurrent.load(), ++running);
+        QThread::msleep(50);
+        --running;
+        *rttMs = replica.hostName() == "near" ? 0.4 : 12.0;
+        return QString();
+    });
+    selector.setShares({makeShare("far", "/data"), makeShare("near", "/data"), makeShare("farther", "/data")});
+
+    QCOMPARE(selector.selectFastest(makeShare("far", "/data")).hostName(), QString("near"));
+    // All replicas are measured at the same time
+    QCOMPARE(concurrent.load(), 3);
+
+    RemoteNFSShare selected;
+    QCOMPARE(selector.selectForMount("/mnt/data", makeShare("far", "/data")).hostName(), QString("near"));
+    QVERIFY(selector.takeSelection("/mnt/data", &selected));
+    QCOMPARE(selected.hostName(), QString("near"));
+    QVERIFY(!selector.takeSelection("/mnt/data", &selected));
+}
+
+void TestReplicaSelector::testUnreachableReplicaLoses()
+{
+    ReplicaSelector selector;
+    selector.setRttOperation([](const RemoteNFSShare &replica, int, double *rttMs) {
+        if (replica.hostName() == "down") {
+            return QString("Connection refused");
+        }
+        *rttMs = 30.0;
+        return QString();
+    });
+    selector.setShares({makeShare("down", "/data"), makeShare("slow", "/data")});
+
+    const QList<ReplicaMeasurement> measurements = selector.measure(selector.replicasOf(makeShare("down", "/data")));
+    QCOMPARE(measurements.size(), 2);
+    QVERIFY(measurements.first().reachable);
+    QCOMPARE(measurements.first().replica.hostName(), QString("slow"));
+    QCOMPARE(measurements.last().errorMessage, QString("Connection refused"));
+    QCOMPARE(selector.selectFastest(makeShare("down", "/data")).hostName(), QString("slow"));
+
+    // With nothing reachable the picked share is kept
+    selector.setRttOperation([](const RemoteNFSShare &, int, double *) { return QString("timeout"); });
+    QCOMPARE(selector.selectFastest(makeShare("down", "/data")).hostName(), QString("down"));
+}
+
+void TestReplicaSelector::testSustainedDegradation()
+{
+    std::atomic<double> mountedRtt(1.0);
+    ReplicaSelector selector;
+    selector.setDegradationSamples(2);
+    selector.setRttOperation([&mountedRtt](const RemoteNFSShare &replica, int, double *rttMs) {
+        *rttMs = replica.hostName() == "mounted" ? mountedRtt.load() : 2.0;
+        return QString();
+    });
+    selector.setShares({makeShare("mounted", "/data"), makeShare("mirror", "/data")});
+    selector.setMounts({makeMount(makeShare("mounted", "/data"), "/mnt/data"),
+                        makeMount(makeShare("lonely", "/other"), "/mnt/other")});
+
+    QSignalSpy degraded(&selector, &ReplicaSelector::replicaDegraded);
+    const auto check = [&selector]() {
+        selector.checkNow();
+        QVERIFY(selector.isChecking("/mnt/data"));
+        QVERIFY(!selector.isChecking("/mnt/other"));
+        QTRY_VERIFY(!selector.isChecking("/mnt/data"));
+    };
+
+    // Faster than the mirror
+    check();
+    QCOMPARE(degraded.count(), 0);
+
+    // One slow check is not enough, and a good one resets the count
+    mountedRtt = 20.0;
+    check();
+    mountedRtt = 1.0;
+    check();
+    mountedRtt = 20.0;
+    check();
+    QCOMPARE(degraded.count(), 0);
+
+    check();
+    QCOMPARE(degraded.count(), 1);
+    QCOMPARE(degraded.first().at(0).value<NFSMount>().localMountPoint(), QString("/mnt/data"));
+    QCOMPARE(degraded.first().at(1).value<RemoteNFSShare>().hostName(), QString("mirror"));
+    QCOMPARE(degraded.first().at(2).toDouble(), 20.0);
+
+    // Once moved, the mirror is the mounted replica
+    selector.setMounts({makeMount(makeShare("mirror", "/data"), "/mnt/data")});
+    check();
+    QCOMPARE(degraded.count(), 1);
+}
+
+void TestReplicaSelector::testPipelinedRtt()
+{
+    RpcEchoServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    QString error = "not run";
+    double rttMs = -1.0;
+    std::atomic<bool> done(false);
+    std::thread client([&]() {
+        error = ReplicaSelector::pipelinedRpcRtt("127.0.0.1", server.serverPort(), 100003, 4,
+                                                 ReplicaSelector::PipelinedPings, 2000, &rttMs);
+        done = true;
+    });
+    QTRY_VERIFY(done.load());
+    client.join();
+
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+    QVERIFY(rttMs >= 0.0);
+    QVERIFY(rttMs < 2000.0);
+}
+
+void TestReplicaSelector::testPipelinedRttRefused()
+{
+    // Grab a free port and close it again so the connection is refused
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    const quint16 port = server.serverPort();
+    server.close();
+
+    QElapsedTimer timer;
+    timer.start();
+    double rttMs = 0.0;
+    QVERIFY(!ReplicaSelector::pipelinedRpcRtt("127.0.0.1", port, 100003, 4, 5, 2000, &rttMs).isEmpty());
+    QVERIFY(timer.elapsed() < 2500);
+}
+
+QTEST_MAIN(TestReplicaSelector)
+#include "test_replicaselector.moc"
@@ -1,10 +1,13 @@
 #include <QtTest/QtTest>
 #include <QTemporaryDir>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include "../../src/business/sharemanager.h"
 #include "../../src/core/shareconfiguration.h"
 #include "../../src/core/permissionset.h"
+#include "../../src/system/simulatedcommandbackend.h"
+#include <QSignalSpy>
 
 using namespace NFSShareManager;
 
@@ -28,8 +31,13 @@ private slots:
     void testShareConfiguration();
     void testPermissionUpdates();
     void testExportsFileGeneration();
+    void testSingleShareSurvivesReload();
+    void testBulkCreateAndRemove();
+    void testBulkLoadWithSimulator();
 
 private:
+    ExportBatchResult waitForBulkResult(QSignalSpy &finishedSpy);
+
     ShareManager *m_shareManager;
     QTemporaryDir *m_tempDir;
     QString m_testPath;
@@ -183,5 +191,149 @@ void ShareManagerTest::testExportsFileGeneration()
     QVERIFY(exportsContent.contains("# Generated by NFS Share Manager"));
 }
 
+void ShareManagerTest::testSingleShareSurvivesReload()
+{
+    auto simulator = std::make_shared<SimulatedCommandBackend>(5);
+    simulator->setExportsFilePath(m_tempDir->path() + "/exports.single");
+    m_shareManager->nfsService()->setCommandBackend(simulator);
+
+    ShareConfiguration config("Single", AccessMode::ReadOnly);
+    config.addAllowedHost("*");
+
+    QSignalSpy createdSpy(m_shareManager, &ShareManager::shareCreated);
+    QVERIFY(m_shareManager->createShare(m_testPath, config));
+    QCOMPARE(createdSpy.count(), 1);
+    QVERIFY(m_shareManager->nfsService()->reloadExports().success);
+    QCOMPARE(simulator->exportedPaths(), QStringList({m_testPath}));
+
+    // Removed from the exports table, so a reload does not export it again
+    QSignalSpy removedSpy(m_shareManager, &ShareManager::shareRemoved);
+    QVERIFY(m_shareManager->removeShare(m_testPath));
+    QCOMPARE(removedSpy.count(), 1);
+    QVERIFY(m_shareManager->nfsService()->reloadExports().success);
+    QVERIFY(simulator->exportedPaths().isEmpty());
+    QVERIFY(!m_shareManager->isShared(m_testPath));
+
+    // A failed unexport keeps the share
+    QVERIFY(m_shareManager->createShare(m_testPath, config));
+    QSignalSpy errorSpy(m_shareManager, &ShareManager::shareError);
+    simulator->failNext("exportfs");
+    QVERIFY(!m_shareManager->removeShare(m_testPath));
+    QCOMPARE(errorSpy.count(), 1);
+    QVERIFY(m_shareManager->isShared(m_testPath));
+    QCOMPARE(simulator->exportedPaths(), QStringList({m_testPath}));
+}
+
+ExportBatchResult ShareManagerTest::waitForBulkResult(QSignalSpy &finishedSpy)
+{
+    // Batches with nothing to export may finish before the call returns
+    if (finishedSpy.isEmpty() && !finishedSpy.wait(10000)) {
+        return ExportBatchResult();
+    }
+    return finishedSpy.takeFirst().at(0).value<ExportBatchResult>();
+}
+
+void ShareManagerTest::testBulkCreateAndRemove()
+{
+    auto simulator = std::make_shared<SimulatedCommandBackend>(7);
+    simulator->setExportsFilePath(m_tempDir->path() + "/exports");
+    m_shareManager->nfsService()->setCommandBackend(simulator);
+
+    ShareConfiguration config("Bulk", AccessMode::ReadOnly);
+    config.addAllowedHost("*");
+
+    QList<ShareRequest> requests;
+    QStringList paths;
+    for (int i = 0; i < 20; ++i) {
+        const QString path = m_tempDir->path() + QString("/bulk%1").arg(i);
+        QVERIFY(QDir().mkpath(path));
+        requests << ShareRequest(path, config);
+        paths << path;
+    }
+    requests << ShareRequest(paths.first(), config); // Duplicate is rejected
+
+    QSignalSpy createdSpy(m_shareManager, &ShareManager::sharesCreated);
+    QSignalSpy persistSpy(m_shareManager, &ShareManager::sharesPersistenceRequested);
+    QSignalSpy progressSpy(m_shareManager, &ShareManager::bulkOperationProgress);
+    QSignalSpy finishedSpy(m_shareManager, &ShareManager::bulkOperationFinished);
+
+    QVERIFY(m_shareManager->createShares(requests));
+    QVERIFY(m_shareManager->isBulkOperationRunning());
+    QVERIFY(!m_shareManager->createShares(requests)); // Busy until the first one is done
+    ExportBatchResult result = waitForBulkResult(finishedSpy);
+    QVERIFY(!m_shareManager->isBulkOperationRunning());
+    QVERIFY(!result.success);
+    QCOMPARE(result.entries.size(), 21);
+    QCOMPARE(result.failedPaths(), QStringList({paths.first()}));
+    QCOMPARE(createdSpy.count(), 1);
+    QCOMPARE(createdSpy.first().at(0).value<QList<NFSShare>>().size(), 20);
+    QCOMPARE(persistSpy.count(), 1);
+    QCOMPARE(progressSpy.last().at(0).toInt(), 100);
+
+    // One export transaction for the whole batch
+    QCOMPARE(simulator->commandCount("exportfs"), 1);
+    QCOMPARE(simulator->exportedPaths().size(), 20);
+
+    QSignalSpy removedSpy(m_shareManager, &ShareManager::sharesRemoved);
+    QVERIFY(m_shareManager->removeShares(paths));
+    QVERIFY(finishedSpy.isEmpty()); // exportfs runs on the worker pool
+    result = waitForBulkResult(finishedSpy);
+    QVERIFY(result.success);
+    QCOMPARE(removedSpy.count(), 1);
+    QVERIFY(simulator->exportedPaths().isEmpty());
+    QCOMPARE(simulator->commandCount("exportfs"), 2);
+    QVERIFY(m_shareManager->getActiveShares().isEmpty());
+}
+
+void ShareManagerTest::testBulkLoadWithSimulator()
+{
+    // 500 shares with a slow exportfs: the batch cost must not grow with the share count
+    auto simulator = std::make_shared<SimulatedCommandBackend>(13);
+    simulator->setExportsFilePath(m_tempDir->path() + "/exports.load");
+    simulator->setCommandLatency("exportfs", 10, 5);
+    m_shareManager->nfsService()->setCommandBackend(simulator);
+
+    ShareConfiguration config("Load", AccessMode::ReadOnly);
+    config.addAllowedHost("*");
+
+    QList<ShareRequest> requests;
+    QStringList paths;
+    for (int i = 0; i < 500; ++i) {
+        const QString path = m_tempDir->path() + QString("/load%1").arg(i);
+        QVERIFY(QDir().mkpath(path));
+        requests << ShareRequest(path, config);
+        paths << path;
+    }
+
+    QSignalSpy finishedSpy(m_shareManager, &ShareManager::bulkOperationFinished);
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QVERIFY(m_shareManager->createShares(requests));
+    ExportBatchResult result = waitForBulkResult(finishedSpy);
+    QVERIFY(result.success);
+    QCOMPARE(simulator->exportedPaths().size(), 500);
+    QVERIFY(simulator->commandCount("exportfs") <= 2);
+    QVERIFY(elapsed.elapsed() < 5000);
+    qDebug() << "Created 500 shares in" << elapsed.elapsed() << "ms";
+
+    // A failed reload leaves neither the table nor the registry half changed
+    simulator->failNext("exportfs");
+    QVERIFY(m_shareManager->removeShares(paths.mid(0, 250)));
+    result = waitForBulkResult(finishedSpy);
+    QVERIFY(!result.success);
+    QCOMPARE(simulator->exportedPaths().size(), 500);
+    QCOMPARE(m_shareManager->getActiveShares().size(), 500);
+
+    simulator->resetCounters();
+    elapsed.restart();
+    QVERIFY(m_shareManager->removeShares(paths));
+    result = waitForBulkResult(finishedSpy);
+    QVERIFY(result.success);
+    QVERIFY(simulator->exportedPaths().isEmpty());
+    QVERIFY(simulator->commandCount("exportfs") <= 2);
+    QVERIFY(m_shareManager->getActiveShares().isEmpty());
+    qDebug() << "Removed 500 shares in" << elapsed.elapsed() << "ms";
+}
+
 QTEST_MAIN(ShareManagerTest)
 #include "test_sharemanager.moc"
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include "../../src/business/sharepathvalidator.h"
+
+using namespace NFSShareManager;
+
+class TestSharePathValidator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testBasicErrors();
+    void testValidDirectory();
+    void testCacheInvalidatedByChange();
+    void testFileSystemFromMountTable();
+    void testBatchKeepsOrder();
+
+private:
+    void writeMountInfo(const QString &content);
+
+    QTemporaryDir *m_tempDir;
+    SharePathValidator *m_validator;
+};
+
+void TestSharePathValidator::init()
+{
+    m_tempDir = new QTemporaryDir();
+    QVERIFY(m_tempDir->isValid());
+    m_validator = new SharePathValidator();
+}
+
+void TestSharePathValidator::cleanup()
+{
+    delete m_validator;
+    m_validator = nullptr;
+    delete m_tempDir;
+    m_tempDir = nullptr;
+}
+
+void TestSharePathValidator::writeMountInfo(const QString &content)
+{
+    QFile file(m_tempDir->filePath("mountinfo"));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(content.toUtf8());
+    file.close();
+    m_validator->setMountInfoPath(file.fileName());
+}
+
+void TestSharePathValidator::testBasicErrors()
+{
+    QCOMPARE(m_validator->validate("").errors, QStringList({"Path cannot be empty"}));
+    QCOMPARE(m_validator->validate("/nonexistent/path").errors, QStringList({"Directory does not exist"}));
+    QVERIFY(m_validator->validate("/").errors.join(' ').contains("Cannot share system directory"));
+
+    QFile file(m_tempDir->filePath("file"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+    QCOMPARE(m_validator->validate(file.fileName()).errors, QStringList({"Path is not a directory"}));
+}
+
+void TestSharePathValidator::testValidDirectory()
+{
+    const QString dir = m_tempDir->filePath("share");
+    QVERIFY(QDir().mkpath(dir));
+    QFile::setPermissions(dir, QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner |
+                               QFileDevice::ReadOther | QFileDevice::ExeOther);
+
+    const PathValidation result = m_validator->validate(dir);
+    QVERIFY(result.isValid());
+    QCOMPARE(result.canonicalPath, QFileInfo(dir).canonicalFilePath());
+    QCOMPARE(m_validator->cacheHits(), 0);
+
+    // Second check is answered from the cache
+    QVERIFY(m_validator->validate(dir).isValid());
+    QCOMPARE(m_validator->cacheHits(), 1);
+}
+
+void TestSharePathValidator::testCacheInvalidatedByChange()
+{
+    const QString dir = m_tempDir->filePath("share");
+    QVERIFY(QDir().mkpath(dir));
+    QFile::setPermissions(dir, QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner);
+    QVERIFY(m_validator->validate(dir).warnings.join(' ').contains("searchable"));
+
+    // chmod changes ctime, so the cached result is not reused
+    QTest::qWait(10);
+    QFile::setPermissions(dir, QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner |
+                               QFileDevice::ReadOther | QFileDevice::ExeOther);
+    QVERIFY(!m_validator->validate(dir).warnings.join(' ').contains("searchable"));
+    QCOMPARE(m_validator->cacheHits(), 0);
+
+    // Replacing the directory changes the inode
+    QVERIFY(QDir(dir).removeRecursively());
+    QVERIFY(QDir().mkpath(dir));
+    m_validator->validate(dir);
+    QCOMPARE(m_validator->cacheHits(), 0);
+}
+
+void TestSharePathValidator::testFileSystemFromMountTable()
+{
+    const QString root = m_tempDir->path();
+    const QString nfsDir = root + "/remote";
+    const QString tmpDir = root + "/scratch dir";
+    QVERIFY(QDir().mkpath(nfsDir));
+    QVERIFY(QDir().mkpath(tmpDir));
+
+    // Mount ids will not match a fake table, so lookups fall back to mount points
+    QString escaped = tmpDir;
+    escaped.replace(' ', "\\040");
+    writeMountInfo(QString("1 0 8:1 / / rw - ext4 /dev/sda1 rw\n"
+                           "900001 1 0:50 / %1 rw - nfs4 server:/export rw\n"
+                           "900002 1 0:51 / %2 rw - tmpfs tmpfs rw\n").arg(nfsDir, escaped));
+
+    PathValidation result = m_validator->validate(nfsDir);
+    if (result.fileSystem != "nfs4") {
+        QSKIP("Mount id of the test directory is in the fake mount table");
+    }
+    QVERIFY(!result.isValid());
+
+    result = m_validator->validate(tmpDir);
+    QCOMPARE(result.fileSystem, QString("tmpfs"));
+    QVERIFY(result.isValid());
+    QVERIFY(result.warnings.join(' ').contains("fsid"));
+}
+
+void TestSharePathValidator::testBatchKeepsOrder()
+{
+    QStringList paths;
+    for (int i = 0; i < 200; ++i) {
+        const QString dir = m_tempDir->filePath(QString("d%1").arg(i));
+        QVERIFY(QDir().mkpath(dir));
+        paths << dir;
+    }
+    paths << "/nonexistent/path";
+
+    QList<PathValidation> results = m_validator->validateBatch(paths);
+    QCOMPARE(results.size(), paths.size());
+    for (int i = 0; i < 200; ++i) {
+        QCOMPARE(results[i].path, paths[i]);
+        QVERIFY(results[i].isValid());
+    }
+    QVERIFY(!results.last().isValid());
+
+    // Warm cache: every directory is a hit
+    results = m_validator->validateBatch(paths);
+    QCOMPARE(m_validator->cacheHits(), 200);
+}
+
+QTEST_MAIN(TestSharePathValidator)
+#include "test_sharepathvalidator.moc"
@@ -0,0 +1,206 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include "../../src/business/shareregistry.h"
+#include "../../src/core/shareconfiguration.h"
+
+using namespace NFSShareManager;
+
+namespace {
+
+NFSShare makeShare(const QString &path)
+{
+    return NFSShare(path, path, ShareConfiguration("test", AccessMode::ReadOnly));
+}
+
+} // namespace
+
+class TestShareRegistry : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testInsertAndFind();
+    void testDuplicateSpellings();
+    void testSymlinkAliases();
+    void testRemovePreservesOrder();
+    void testExportedAncestor();
+    void testExportedDescendants();
+    void testPruneOnRemove();
+    void testManyShares();
+
+private:
+    QString makeDir(const QString &relativePath);
+
+    QTemporaryDir *m_tempDir;
+    QString m_root;
+};
+
+void TestShareRegistry::init()
+{
+    m_tempDir = new QTemporaryDir();
+    QVERIFY(m_tempDir->isValid());
+    m_root = ShareRegistry::canonicalPath(m_tempDir->path());
+}
+
+void TestShareRegistry::cleanup()
+{
+    delete m_tempDir;
+    m_tempDir = nullptr;
+}
+
+QString TestShareRegistry::makeDir(const QString &relativePath)
+{
+    const QString path = m_root + "/" + relativePath;
+    QDir().mkpath(path);
+    return path;
+}
+
+void TestShareRegistry::testInsertAndFind()
+{
+    ShareRegistry registry;
+    const QString path = makeDir("data");
+
+    QVERIFY(registry.isEmpty());
+    QVERIFY(registry.insert(makeShare(path)));
+    QCOMPARE(registry.size(), 1);
+    QVERIFY(registry.contains(path));
+    QVERIFY(registry.find(path));
+    QCOMPARE(registry.find(path)->path(), path);
+
+    QVERIFY(!registry.contains(m_root));
+    QVERIFY(!registry.find(""));
+    QVERIFY(!registry.contains("/nonexistent/path"));
+}
+
+void TestShareRegistry::testDuplicateSpellings()
+{
+    ShareRegistry registry;
+    const QString path = makeDir("data");
+
+    QVERIFY(registry.insert(makeShare(path)));
+    QVERIFY(!registry.insert(makeShare(path + "/")));
+    QVERIFY(!registry.insert(makeShare(m_root + "/./other/../data")));
+    QVERIFY(registry.contains(path + "//"));
+    QCOMPARE(registry.size(), 1);
+}
+
+void TestShareRegistry::testSymlinkAliases()
+{
+    ShareRegistry registry;
+    const QString path = makeDir("real");
+    const QString link = m_root + "/link";
+    QVERIFY(QFile::link(path, link));
+
+    QVERIFY(registry.insert(makeShare(link)));
+    QVERIFY(registry.contains(path));
+    QVERIFY(!registry.insert(makeShare(path)));
+
+    // The share keeps the path it was created with
+    QCOMPARE(registry.find(path)->path(), link);
+    QVERIFY(registry.remove(path));
+    QVERIFY(registry.isEmpty());
+}
+
+void TestShareRegistry::testRemovePreservesOrder()
+{
+    ShareRegistry registry;
+    const QString a = makeDir("a");
+    const QString b = makeDir("b");
+    const QString c = makeDir("c");
+
+    QVERIFY(registry.insert(makeShare(c)));
+    QVERIFY(registry.insert(makeShare(a)));
+    QVERIFY(registry.insert(makeShare(b)));
+    QVERIFY(registry.remove(a));
+    QVERIFY(!registry.remove(a));
+
+    QList<NFSShare> shares = registry.shares();
+    QCOMPARE(shares.size(), 2);
+    QCOMPARE(shares[0].path(), c);
+    QCOMPARE(shares[1].path(), b);
+}
+
+void TestShareRegistry::testExportedAncestor()
+{
+    ShareRegistry registry;
+    const QString outer = makeDir("srv");
+    const QString inner = makeDir("srv/projects/alpha");
+    makeDir("srv/projects/alpha/src");
+
+    QVERIFY(registry.insert(makeShare(outer)));
+    QCOMPARE(registry.exportedAncestor(inner), outer);
+    QCOMPARE(registry.exportedAncestor(outer), QString());
+
+    QVERIFY(registry.insert(makeShare(inner)));
+    QCOMPARE(registry.exportedAncestor(inner + "/src"), inner);
+    QCOMPARE(registry.exportedAncestor(inner + "/missing/dir"), inner);
+    QCOMPARE(registry.exportedAncestor(m_root), QString());
+}
+
+void TestShareRegistry::testExportedDescendants()
+{
+    ShareRegistry registry;
+    const QString one = makeDir("srv/one");
+    const QString two = makeDir("srv/deep/two");
+    const QString other = makeDir("other");
+
+    QVERIFY(registry.insert(makeShare(two)));
+    QVERIFY(registry.insert(makeShare(one)));
+    QVERIFY(registry.insert(makeShare(other)));
+
+    QVERIFY(registry.hasExportedDescendant(m_root + "/srv"));
+    QCOMPARE(registry.exportedDescendants(m_root + "/srv"), QStringList({two, one}));
+    QCOMPARE(registry.exportedDescendants(m_root).size(), 3);
+    QVERIFY(!registry.hasExportedDescendant(one));
+    QVERIFY(!registry.hasExportedDescendant(m_root + "/unrelated"));
+}
+
+void TestShareRegistry::testPruneOnRemove()
+{
+    ShareRegistry registry;
+    const QString outer = makeDir("srv");
+    const QString inner = makeDir("srv/a/b");
+
+    QVERIFY(registry.insert(makeShare(outer)));
+    QVERIFY(registry.insert(makeShare(inner)));
+
+    // Removing the parent keeps the nested export reachable
+    QVERIFY(registry.remove(outer));
+    QVERIFY(registry.hasExportedDescendant(m_root));
+    QCOMPARE(registry.exportedAncestor(inner + "/c"), inner);
+    QCOMPARE(registry.exportedAncestor(inner), QString());
+
+    QVERIFY(registry.remove(inner));
+    QVERIFY(!registry.hasExportedDescendant("/"));
+
+    // Re-inserting after pruning works
+    QVERIFY(registry.insert(makeShare(inner)));
+    QCOMPARE(registry.exportedDescendants(outer), QStringList({inner}));
+}
+
+void TestShareRegistry::testManyShares()
+{
+    ShareRegistry registry;
+    const int count = 2000;
+    for (int i = 0; i < count; ++i) {
+        QVERIFY(registry.insert(makeShare(QString("/srv/export/group%1/share%2").arg(i % 20).arg(i))));
+    }
+    QCOMPARE(registry.size(), count);
+    QVERIFY(registry.contains("/srv/export/group7/share1507"));
+    QCOMPARE(registry.exportedDescendants("/srv/export/group3").size(), count / 20);
+    QCOMPARE(registry.exportedAncestor("/srv/export/group3/share3/sub"), QString("/srv/export/group3/share3"));
+
+    for (int i = 0; i < count; i += 2) {
+        QVERIFY(registry.remove(QString("/srv/export/group%1/share%2").arg(i % 20).arg(i)));
+    }
+    QCOMPARE(registry.size(), count / 2);
+    QCOMPARE(registry.exportedDescendants("/srv/export").size(), count / 2);
+}
+
+QTEST_MAIN(TestShareRegistry)
+#include "test_shareregistry.moc"
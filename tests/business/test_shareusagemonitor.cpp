@@ -0,0 +1,184 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+#include "../../src/business/shareusagemonitor.h"
+#include "../../src/system/filesystemwatcher.h"
+#include <unistd.h>
+
+using namespace NFSShareManager;
+
+class TestShareUsageMonitor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testCountsFilesAndDirectories();
+    void testHardLinksCountedOnce();
+    void testRefreshOnlyReadsChangedDirectories();
+    void testRefreshSeesFileGrowingInPlace();
+    void testWatcherTriggersRescan();
+    void testCacheMakesFirstScanIncremental();
+
+private:
+    void writeFile(const QString &path, int size);
+    void waitForScan(ShareUsageMonitor *monitor);
+
+    QTemporaryDir *m_tempDir;
+    QString m_share;
+    ShareUsageMonitor *m_monitor;
+};
+
+void TestShareUsageMonitor::init()
+{
+    m_tempDir = new QTemporaryDir();
+    QVERIFY(m_tempDir->isValid());
+    m_share = m_tempDir->filePath("share");
+    QVERIFY(QDir().mkpath(m_share + "/a/b"));
+    QVERIFY(QDir().mkpath(m_share + "/c"));
+    writeFile(m_share + "/top.txt", 100);
+    writeFile(m_share + "/a/one.bin", 1000);
+    writeFile(m_share + "/a/b/two.bin", 2000);
+    writeFile(m_share + "/c/three.bin", 3000);
+
+    m_monitor = new ShareUsageMonitor();
+    m_monitor->setCacheFilePath(m_tempDir->filePath("usage.cache"));
+    m_monitor->watcher()->setDebounceInterval(50);
+}
+
+void TestShareUsageMonitor::cleanup()
+{
+    delete m_monitor;
+    m_monitor = nullptr;
+    delete m_tempDir;
+    m_tempDir = nullptr;
+}
+
+void TestShareUsageMonitor::writeFile(const QString &path, int size)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(QByteArray(size, 'x'));
+    file.close();
+}
+
+void TestShareUsageMonitor::waitForScan(ShareUsageMonitor *monitor)
+{
+    QTRY_VERIFY(!monitor->isScanning());
+}
+
+void TestShareUsageMonitor::testCountsFilesAndDirectories()
+{
+    QSignalSpy spy(m_monitor, &ShareUsageMonitor::usageUpdated);
+    m_monitor->setShares({m_share + "/"});
+    QVERIFY(m_monitor->isScanning());
+    waitForScan(m_monitor);
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(0).toString(), m_share);
+
+    const ShareUsage usage = m_monitor->usage(m_share);
+    QVERIFY(usage.complete);
+    QCOMPARE(usage.bytes, qint64(6100));
+    QCOMPARE(usage.files, qint64(4));
+    QCOMPARE(usage.directories, qint64(4));
+    QCOMPARE(m_monitor->directoriesRead(), 4);
+
+    // Dropping the share forgets its totals
+    m_monitor->setShares({});
+    QVERIFY(!m_monitor->usage(m_share).complete);
+}
+
+void TestShareUsageMonitor::testHardLinksCountedOnce()
+{
+    writeFile(m_share + "/linked.bin", 500);
+    QCOMPARE(::link(QFile::encodeName(m_share + "/linked.bin").constData(),
+                    QFile::encodeName(m_share + "/c/linked-again.bin").constData()), 0);
+
+    m_monitor->setShares({m_share});
+    waitForScan(m_monitor);
+
+    const ShareUsage usage = m_monitor->usage(m_share);
+    QCOMPARE(usage.bytes, qint64(6600));
+    QCOMPARE(usage.files, qint64(5));
+}
+
+void TestShareUsageMonitor::testRefreshOnlyReadsChangedDirectories()
+{
+    m_monitor->setShares({m_share});
+    waitForScan(m_monitor);
+    QCOMPARE(m_monitor->directoriesRead(), 4);
+
+    // Nothing changed: every directory is stat()ed, none is re-read
+    m_monitor->refresh(m_share);
+    waitForScan(m_monitor);
+    QCOMPARE(m_monitor->directoriesRead(), 4);
+
+    writeFile(m_share + "/a/b/new.bin", 50);
+    QVERIFY(QDir(m_share + "/c").removeRecursively());
+    m_monitor->refresh(m_share);
+    waitForScan(m_monitor);
+
+    // The root lost "c" and "a/b" gained a file
+    QCOMPARE(m_monitor->directoriesRead(), 6);
+    const ShareUsage usage = m_monitor->usage(m_share);
+    QCOMPARE(usage.bytes, qint64(3150));
+    QCOMPARE(usage.files, qint64(4));
+    QCOMPARE(usage.directories, qint64(3));
+}
+
+void TestShareUsageMonitor::testRefreshSeesFileGrowingInPlace()
+{
+    m_monitor->setShares({m_share});
+    waitForScan(m_monitor);
+    QCOMPARE(m_monitor->usage(m_share).bytes, qint64(6100));
+
+    // Appending changes neither the directory's mtime nor its ctime
+    QFile file(m_share + "/a/b/two.bin");
+    QVERIFY(file.open(QIODevice::Append));
+    file.write(QByteArray(500, 'y'));
+    file.close();
+
+    m_monitor->refreshAll();
+    waitForScan(m_monitor);
+    QCOMPARE(m_monitor->usage(m_share).bytes, qint64(6600));
+    QCOMPARE(m_monitor->usage(m_share).files, qint64(4));
+    QCOMPARE(m_monitor->directoriesRead(), 4);
+}
+
+void TestShareUsageMonitor::testWatcherTriggersRescan()
+{
+    m_monitor->setShares({m_share});
+    waitForScan(m_monitor);
+    QVERIFY(m_monitor->watcher()->isWatching(m_share + "/a/b"));
+
+    const int readsBefore = m_monitor->directoriesRead();
+    writeFile(m_share + "/a/b/more.bin", 400);
+
+    QTRY_COMPARE(m_monitor->usage(m_share).bytes, qint64(6500));
+    waitForScan(m_monitor);
+    QCOMPARE(m_monitor->directoriesRead(), readsBefore + 1);
+}
+
+void TestShareUsageMonitor::testCacheMakesFirstScanIncremental()
+{
+    m_monitor->setShares({m_share});
+    waitForScan(m_monitor);
+    QVERIFY(m_monitor->saveCache());
+
+    ShareUsageMonitor restarted;
+    restarted.setCacheFilePath(m_tempDir->filePath("usage.cache"));
+    QVERIFY(restarted.loadCache());
+    restarted.setShares({m_share});
+    waitForScan(&restarted);
+
+    QCOMPARE(restarted.directoriesRead(), 0);
+    QCOMPARE(restarted.usage(m_share).bytes, qint64(6100));
+    QCOMPARE(restarted.usage(m_share).files, qint64(4));
+}
+
+QTEST_MAIN(TestShareUsageMonitor)
+#include "test_shareusagemonitor.moc"
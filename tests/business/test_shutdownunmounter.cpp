@@ -0,0 +1,131 @@
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSemaphore>
+#include <QSignalSpy>
+#include <memory>
+#include "../../src/business/shutdownunmounter.h"
+
+using namespace NFSShareManager;
+
+using Step = ShutdownUnmounter::Step;
+
+class TestShutdownUnmounter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testAllUnmounted();
+    void testBusyEscalatesAtOnce();
+    void testHungEscalatesOnTime();
+    void testStaleMountsWithinDeadline();
+};
+
+void TestShutdownUnmounter::testAllUnmounted()
+{
+    ShutdownUnmounter unmounter;
+    unmounter.setUnmountOperation([](const QString &, Step) { return QString(); });
+    QSignalSpy finishedSpy(&unmounter, &ShutdownUnmounter::stepFinished);
+
+    const QStringList mountPoints = {"/mnt/nfs/a", "/mnt/nfs/b", "/mnt/nfs/c"};
+    QVERIFY(unmounter.run(mountPoints, 1000).isEmpty());
+    QCOMPARE(finishedSpy.count(), 3);
+    for (const auto &arguments : finishedSpy) {
+        QCOMPARE(arguments.at(1).value<Step>(), Step::Unmount);
+        QVERIFY(arguments.at(2).toBool());
+    }
+
+    QVERIFY(unmounter.run(QStringList(), 1000).isEmpty());
+}
+
+void TestShutdownUnmounter::testBusyEscalatesAtOnce()
+{
+    ShutdownUnmounter unmounter;
+    unmounter.setUnmountOperation([](const QString &, Step step) {
+        return step == Step::Unmount ? QString("umount: /mnt/nfs/busy: target is busy.") : QString();
+    });
+    QSignalSpy startedSpy(&unmounter, &ShutdownUnmounter::stepStarted);
+    QSignalSpy finishedSpy(&unmounter, &ShutdownUnmounter::stepFinished);
+
+    // A failed step moves on without waiting for the escalation timers
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QVERIFY(unmounter.run({"/mnt/nfs/busy"}, 5000).isEmpty());
+    QVERIFY(elapsed.elapsed() < 1000);
+
+    QCOMPARE(startedSpy.count(), 2);
+    QCOMPARE(startedSpy.at(1).at(1).value<Step>(), Step::Lazy);
+    QCOMPARE(finishedSpy.count(), 2);
+    QVERIFY(!finishedSpy.at(0).at(2).toBool());
+    QVERIFY(finishedSpy.at(0).at(3).toString().contains("busy"));
+    QVERIFY(finishedSpy.at(1).at(2).toBool());
+}
+
+void TestShutdownUnmounter::testHungEscalatesOnTime()
+{
+    // The plain unmount never returns until released; the lazy one works
+    const auto hung = std::make_shared<QSemaphore>();
+    ShutdownUnmounter unmounter;
+    unmounter.setUnmountOperation([hung](const QString &, Step step) {
+        if (step == Step::Unmount) {
+            hung->acquire();
+            return QString("released");
+        }
+        return QString();
+    });
+    QSignalSpy startedSpy(&unmounter, &ShutdownUnmounter::stepStarted);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QVERIFY(unmounter.run({"/mnt/nfs/dead"}, 1000).isEmpty());
+    const qint64 lazyAfter = 1000 * ShutdownUnmounter::LazyAfterPercent / 100;
+    QVERIFY(elapsed.elapsed() >= lazyAfter - 10);
+    QVERIFY(elapsed.elapsed() < 1000);
+
+    QCOMPARE(startedSpy.count(), 2);
+    QCOMPARE(startedSpy.at(0).at(1).value<Step>(), Step::Unmount);
+    QCOMPARE(startedSpy.at(1).at(1).value<Step>(), Step::Lazy);
+
+    hung->release();
+}
+
+void TestShutdownUnmounter::testStaleMountsWithinDeadline()
+{
+    // A dozen mounts of a dead server: every step hangs
+    const auto hung = std::make_shared<QSemaphore>();
+    const auto mutex = std::make_shared<QMutex>();
+    const auto calls = std::make_shared<int>(0);
+    ShutdownUnmounter unmounter;
+    unmounter.setUnmountOperation([hung, mutex, calls](const QString &, Step) {
+        {
+            QMutexLocker locker(mutex.get());
+            ++*calls;
+        }
+        hung->acquire();
+        return QString("released");
+    });
+    QSignalSpy startedSpy(&unmounter, &ShutdownUnmounter::stepStarted);
+
+    QStringList mountPoints;
+    for (int i = 0; i < 12; ++i) {
+        mountPoints << QString("/mnt/nfs/stale%1").arg(i);
+    }
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    const QStringList remaining = unmounter.run(mountPoints, 500);
+    QVERIFY(elapsed.elapsed() >= 490);
+    QVERIFY(elapsed.elapsed() < 1000);
+    QCOMPARE(remaining, mountPoints);
+
+    // Every mount went through all three steps
+    QCOMPARE(startedSpy.count(), 36);
+    QCOMPARE(startedSpy.last().at(1).value<Step>(), Step::Force);
+
+    // Let the abandoned threads finish; their results go nowhere
+    QTRY_COMPARE_WITH_TIMEOUT(([mutex, calls]() { QMutexLocker locker(mutex.get()); return *calls; })(), 36, 2000);
+    hung->release(36);
+}
+
+QTEST_MAIN(TestShutdownUnmounter)
+#include "test_shutdownunmounter.moc"
@@ -0,0 +1,116 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include "../../src/system/bdituner.h"
+
+using namespace NFSShareManager;
+
+class TestBdiTuner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testApplyAndRead();
+    void testPartialSettings();
+    void testValidation();
+    void testMissingDevice();
+
+private:
+    QString readFile(const QString &name) const;
+
+    QTemporaryDir *m_tempDir;
+    BdiTuner m_tuner;
+};
+
+void TestBdiTuner::init()
+{
+    m_tempDir = new QTemporaryDir();
+    QVERIFY(m_tempDir->isValid());
+
+    // A fake /sys/class/bdi with the kernel defaults of an NFS mount
+    QVERIFY(QDir().mkpath(m_tempDir->filePath("0:52")));
+    for (const auto &file : {qMakePair(QString("read_ahead_kb"), QByteArray("128\n")),
+                             qMakePair(QString("max_ratio"), QByteArray("100\n"))}) {
+        QFile sysfsFile(m_tempDir->filePath("0:52/" + file.first));
+        QVERIFY(sysfsFile.open(QIODevice::WriteOnly));
+        sysfsFile.write(file.second);
+    }
+    m_tuner.setSysfsRoot(m_tempDir->path());
+}
+
+void TestBdiTuner::cleanup()
+{
+    delete m_tempDir;
+    m_tempDir = nullptr;
+}
+
+QString TestBdiTuner::readFile(const QString &name) const
+{
+    QFile file(m_tempDir->filePath("0:52/" + name));
+    return file.open(QIODevice::ReadOnly) ? QString::fromLatin1(file.readAll().trimmed()) : QString();
+}
+
+void TestBdiTuner::testApplyAndRead()
+{
+    QVERIFY(m_tuner.exists("0:52"));
+    QCOMPARE(m_tuner.current("0:52").readAheadKb, 128);
+    QCOMPARE(m_tuner.current("0:52").maxRatio, 100);
+
+    BdiSettings settings;
+    settings.readAheadKb = 16384;
+    settings.maxRatio = 20;
+    QString error;
+    QVERIFY2(m_tuner.apply("0:52", settings, &error), qPrintable(error));
+    QCOMPARE(readFile("read_ahead_kb"), QString("16384"));
+    QCOMPARE(readFile("max_ratio"), QString("20"));
+    QCOMPARE(m_tuner.current("0:52"), settings);
+}
+
+void TestBdiTuner::testPartialSettings()
+{
+    BdiSettings settings;
+    QVERIFY(settings.isEmpty());
+    settings.readAheadKb = 0;
+    QVERIFY(!settings.isEmpty());
+
+    // Unset values are left alone
+    QVERIFY(m_tuner.apply("0:52", settings));
+    QCOMPARE(readFile("read_ahead_kb"), QString("0"));
+    QCOMPARE(readFile("max_ratio"), QString("100"));
+}
+
+void TestBdiTuner::testValidation()
+{
+    BdiSettings settings;
+    settings.maxRatio = 101;
+    QString error;
+    QVERIFY(!BdiTuner::validate(settings, &error));
+    QVERIFY(!error.isEmpty());
+    QVERIFY(!m_tuner.apply("0:52", settings));
+    QCOMPARE(readFile("max_ratio"), QString("100"));
+
+    settings.maxRatio = -1;
+    settings.readAheadKb = 4 * 1024 * 1024;
+    QVERIFY(!BdiTuner::validate(settings));
+}
+
+void TestBdiTuner::testMissingDevice()
+{
+    BdiSettings settings;
+    settings.readAheadKb = 1024;
+    QString error;
+    QVERIFY(!m_tuner.exists("0:99"));
+    QVERIFY(!m_tuner.apply("0:99", settings, &error));
+    QVERIFY(error.contains("0:99"));
+    QVERIFY(!m_tuner.exists("../0:52"));
+    QVERIFY(!m_tuner.exists("."));
+    QVERIFY(!m_tuner.exists(".."));
+    QCOMPARE(m_tuner.current("0:99").readAheadKb, -1);
+}
+
+QTEST_MAIN(TestBdiTuner)
+#include "test_bdituner.moc"
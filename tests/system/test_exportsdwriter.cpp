@@ -0,0 +1,163 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include "../../src/system/exportsdwriter.h"
+
+using namespace NFSShareManager;
+
+class TestExportsDWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testFileNames();
+    void testWriteAndRead();
+    void testUnchangedIsNotRewritten();
+    void testRejectsMismatchedLine();
+    void testRemove();
+    void testSyncTouchesOnlyDifferences();
+    void testForeignFilesAreIgnored();
+    void testReexportCommands();
+
+private:
+    QTemporaryDir *m_tempDir;
+    ExportsDWriter *m_writer;
+};
+
+void TestExportsDWriter::init()
+{
+    m_tempDir = new QTemporaryDir();
+    QVERIFY(m_tempDir->isValid());
+    m_writer = new ExportsDWriter(m_tempDir->path());
+}
+
+void TestExportsDWriter::cleanup()
+{
+    delete m_writer;
+    m_writer = nullptr;
+    delete m_tempDir;
+    m_tempDir = nullptr;
+}
+
+void TestExportsDWriter::testFileNames()
+{
+    const QString name = ExportsDWriter::fileNameForShare("/srv/data");
+    QVERIFY(name.startsWith("nfs-share-manager-srv-data-"));
+    QVERIFY(name.endsWith(".exports"));
+
+    // Same path in another spelling maps to the same file
+    QCOMPARE(ExportsDWriter::fileNameForShare("/srv//data/"), name);
+
+    // Paths that slug alike still get distinct files
+    QVERIFY(ExportsDWriter::fileNameForShare("/srv/a b") != ExportsDWriter::fileNameForShare("/srv/a_b"));
+    QVERIFY(!ExportsDWriter::fileNameForShare("/").isEmpty());
+}
+
+void TestExportsDWriter::testWriteAndRead()
+{
+    QVERIFY(m_writer->isAvailable());
+    QVERIFY(m_writer->readShare("/srv/data").isEmpty());
+
+    bool changed = false;
+    QVERIFY(m_writer->writeShare("/srv/data", "/srv/data *(ro,sync)", &changed));
+    QVERIFY(changed);
+    QCOMPARE(m_writer->readShare("/srv/data"), QString("/srv/data *(ro,sync)"));
+    QCOMPARE(m_writer->readAll().value("/srv/data"), QString("/srv/data *(ro,sync)"));
+}
+
+void TestExportsDWriter::testUnchangedIsNotRewritten()
+{
+    QVERIFY(m_writer->writeShare("/srv/data", "/srv/data *(ro,sync)"));
+
+    bool changed = true;
+    QVERIFY(m_writer->writeShare("/srv/data", "/srv/data *(ro,sync)", &changed));
+    QVERIFY(!changed);
+
+    QVERIFY(m_writer->writeShare("/srv/data", "/srv/data *(rw,sync)", &changed));
+    QVERIFY(changed);
+}
+
+void TestExportsDWriter::testRejectsMismatchedLine()
+{
+    QString error;
+    QVERIFY(!m_writer->writeShare("/srv/data", "/srv/other *(ro)", nullptr, &error));
+    QVERIFY(!error.isEmpty());
+    QVERIFY(!QFile::exists(m_writer->filePathForShare("/srv/data")));
+}
+
+void TestExportsDWriter::testRemove()
+{
+    QVERIFY(m_writer->writeShare("/srv/a", "/srv/a *(ro)"));
+    QVERIFY(m_writer->writeShare("/srv/b", "/srv/b *(ro)"));
+
+    QVERIFY(m_writer->removeShare("/srv/a"));
+    QVERIFY(!QFile::exists(m_writer->filePathForShare("/srv/a")));
+    QVERIFY(QFile::exists(m_writer->filePathForShare("/srv/b")));
+
+    // Removing a share without a file is not an error
+    QVERIFY(m_writer->removeShare("/srv/a"));
+}
+
+void TestExportsDWriter::testSyncTouchesOnlyDifferences()
+{
+    QVERIFY(m_writer->writeShare("/srv/a", "/srv/a *(ro)"));
+    QVERIFY(m_writer->writeShare("/srv/b", "/srv/b *(ro)"));
+    QVERIFY(m_writer->writeShare("/srv/c", "/srv/c *(ro)"));
+
+    QHash<QString, QString> wanted;
+    wanted.insert("/srv/a", "/srv/a *(ro)");
+    wanted.insert("/srv/b", "/srv/b *(rw)");
+    wanted.insert("/srv/d", "/srv/d *(ro)");
+
+    ExportsDSyncResult result = m_writer->sync(wanted);
+    QVERIFY(result.success);
+    QCOMPARE(result.unchanged, 1);
+    QStringList written = result.written;
+    written.sort();
+    QCOMPARE(written, QStringList({"/srv/b", "/srv/d"}));
+    QCOMPARE(result.removed, QStringList({"/srv/c"}));
+    QCOMPARE(m_writer->readAll().size(), 3);
+
+    result = m_writer->sync(wanted);
+    QVERIFY(result.success);
+    QCOMPARE(result.unchanged, 3);
+    QVERIFY(result.written.isEmpty());
+    QVERIFY(result.removed.isEmpty());
+}
+
+void TestExportsDWriter::testForeignFilesAreIgnored()
+{
+    QFile foreign(m_tempDir->filePath("local.exports"));
+    QVERIFY(foreign.open(QIODevice::WriteOnly));
+    foreign.write("/srv/local *(ro)\n");
+    foreign.close();
+
+    QVERIFY(m_writer->readAll().isEmpty());
+    QVERIFY(m_writer->sync({}).success);
+    QVERIFY(QFile::exists(foreign.fileName()));
+}
+
+void TestExportsDWriter::testReexportCommands()
+{
+    // New share: export each client
+    QList<QStringList> commands = ExportsDWriter::reexportCommands(QString(), "/srv/a 10.0.0.1(rw,sync) *(ro)");
+    QCOMPARE(commands.size(), 2);
+    QCOMPARE(commands[0], QStringList({"-i", "-o", "rw,sync", "10.0.0.1:/srv/a"}));
+    QCOMPARE(commands[1], QStringList({"-i", "-o", "ro", "*:/srv/a"}));
+
+    // Dropped client is unexported, kept client re-exported with new options
+    commands = ExportsDWriter::reexportCommands("/srv/a 10.0.0.1(rw) *(ro)", "/srv/a 10.0.0.1(ro)");
+    QCOMPARE(commands.size(), 2);
+    QCOMPARE(commands[0], QStringList({"-u", "*:/srv/a"}));
+    QCOMPARE(commands[1], QStringList({"-i", "-o", "ro", "10.0.0.1:/srv/a"}));
+
+    // Removed share
+    commands = ExportsDWriter::reexportCommands("/srv/a *(ro)", QString());
+    QCOMPARE(commands, QList<QStringList>({QStringList({"-u", "*:/srv/a"})}));
+}
+
+QTEST_MAIN(TestExportsDWriter)
+#include "test_exportsdwriter.moc"
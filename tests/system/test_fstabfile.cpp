@@ -0,0 +1,188 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include "../../src/system/fstabfile.h"
+
+using namespace NFSShareManager;
+
+namespace {
+
+const QByteArray sampleFstab =
+    "# /etc/fstab: static file system information.\n"
+    "#\n"
+    "UUID=1234-abcd  /          ext4    errors=remount-ro  0  1\n"
+    "\n"
+    "server:/srv/data   /mnt/data   nfs   rw,hard,_netdev   0 0\n"
+    "# old backup share\n"
+    "nas:/export/My\\040Files /mnt/my\\040files nfs4 ro 0 0\n"
+    "tmpfs /tmp tmpfs defaults 0 0\n";
+
+} // namespace
+
+class TestFstabFile : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testRoundTripIsLossless();
+    void testLookupByMountPoint();
+    void testReplaceInPlace();
+    void testRemoveAndDuplicates();
+    void testAppendAndEscape();
+    void testSaveAndReloadIfChanged();
+
+private:
+    QString writeFstab(const QByteArray &content);
+
+    QTemporaryDir *m_tempDir;
+};
+
+void TestFstabFile::init()
+{
+    m_tempDir = new QTemporaryDir();
+    QVERIFY(m_tempDir->isValid());
+}
+
+void TestFstabFile::cleanup()
+{
+    delete m_tempDir;
+    m_tempDir = nullptr;
+}
+
+QString TestFstabFile::writeFstab(const QByteArray &content)
+{
+    const QString path = m_tempDir->filePath("fstab");
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(content);
+    }
+    return path;
+}
+
+void TestFstabFile::testRoundTripIsLossless()
+{
+    FstabFile fstab;
+    fstab.parse(sampleFstab);
+    QCOMPARE(fstab.serialize(), sampleFstab);
+    QVERIFY(!fstab.isModified());
+
+    // No trailing newline stays without one
+    fstab.parse("tmpfs /tmp tmpfs defaults 0 0");
+    QCOMPARE(fstab.serialize(), QByteArray("tmpfs /tmp tmpfs defaults 0 0"));
+}
+
+void TestFstabFile::testLookupByMountPoint()
+{
+    FstabFile fstab;
+    fstab.parse(sampleFstab);
+
+    QCOMPARE(fstab.entries().size(), 4);
+    QVERIFY(fstab.contains("/mnt/data"));
+    QVERIFY(fstab.contains("/mnt/data/"));
+    QVERIFY(!fstab.contains("/mnt/other"));
+
+    const FstabEntry data = fstab.entry("/mnt/data");
+    QCOMPARE(data.source, QString("server:/srv/data"));
+    QCOMPARE(data.type, QString("nfs"));
+    QCOMPARE(data.options, QStringList({"rw", "hard", "_netdev"}));
+    QVERIFY(data.isNFS());
+
+    const FstabEntry files = fstab.entry("/mnt/my files");
+    QCOMPARE(files.source, QString("nas:/export/My Files"));
+    QCOMPARE(fstab.entry("/").pass, 1);
+}
+
+void TestFstabFile::testReplaceInPlace()
+{
+    FstabFile fstab;
+    fstab.parse(sampleFstab);
+
+    FstabEntry entry = fstab.entry("/mnt/data");
+    QVERIFY(!fstab.setEntry(entry));
+    QVERIFY(!fstab.isModified());
+
+    entry.options = QStringList({"ro", "soft", "_netdev"});
+    QVERIFY(fstab.setEntry(entry));
+    QVERIFY(fstab.isModified());
+
+    // Only the changed line differs; comments and order are untouched
+    const QList<QByteArray> before = sampleFstab.split('\n');
+    const QList<QByteArray> after = fstab.serialize().split('\n');
+    QCOMPARE(after.size(), before.size());
+    for (int i = 0; i < before.size(); ++i) {
+        if (i == 4) {
+            QCOMPARE(after[i], QByteArray("server:/srv/data /mnt/data nfs ro,soft,_netdev 0 0"));
+        } else {
+            QCOMPARE(after[i], before[i]);
+        }
+    }
+}
+
+void TestFstabFile::testRemoveAndDuplicates()
+{
+    FstabFile fstab;
+    fstab.parse(sampleFstab + "server:/srv/data /mnt/data nfs rw 0 0\n");
+    QCOMPARE(fstab.entries().size(), 5);
+
+    // Setting an entry collapses the duplicates into the first line
+    FstabEntry entry = fstab.entry("/mnt/data");
+    QVERIFY(fstab.setEntry(entry));
+    QCOMPARE(fstab.serialize(), sampleFstab);
+
+    QVERIFY(fstab.removeEntry("/mnt/data"));
+    QVERIFY(!fstab.removeEntry("/mnt/data"));
+    QVERIFY(!fstab.contains("/mnt/data"));
+    QVERIFY(!fstab.serialize().contains("/srv/data"));
+    QVERIFY(fstab.serialize().contains("# old backup share"));
+    QVERIFY(fstab.contains("/tmp"));
+}
+
+void TestFstabFile::testAppendAndEscape()
+{
+    FstabFile fstab;
+    fstab.parse("tmpfs /tmp tmpfs defaults 0 0");
+
+    QVERIFY(fstab.setEntry(FstabEntry("host:/a b", "/mnt/a b", "nfs", {"rw", "_netdev"})));
+    QCOMPARE(fstab.serialize(),
+             QByteArray("tmpfs /tmp tmpfs defaults 0 0\nhost:/a\\040b /mnt/a\\040b nfs rw,_netdev 0 0\n"));
+
+    FstabEntry parsed;
+    QVERIFY(FstabFile::parseLine(FstabFile::formatLine(fstab.entry("/mnt/a b")), &parsed));
+    QVERIFY(parsed == fstab.entry("/mnt/a b"));
+    QVERIFY(!FstabFile::parseLine("  # comment", &parsed));
+    QVERIFY(!FstabFile::parseLine("", &parsed));
+}
+
+void TestFstabFile::testSaveAndReloadIfChanged()
+{
+    const QString path = writeFstab(sampleFstab);
+    FstabFile fstab(path);
+    QVERIFY(fstab.reloadIfChanged());
+    QVERIFY(fstab.contains("/mnt/data"));
+
+    QVERIFY(fstab.removeEntry("/mnt/data"));
+    QVERIFY(fstab.save());
+    QVERIFY(!fstab.isModified());
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), fstab.serialize());
+    file.close();
+
+    // Someone else edits the file; the next check picks it up
+    writeFstab("server:/srv/new /mnt/new nfs rw 0 0\nserver:/srv/other /mnt/other nfs rw 0 0\n");
+    QVERIFY(fstab.reloadIfChanged());
+    QVERIFY(fstab.contains("/mnt/new"));
+    QVERIFY(!fstab.contains("/tmp"));
+
+    // A missing file is an empty table
+    FstabFile missing(m_tempDir->filePath("absent"));
+    QVERIFY(missing.load());
+    QVERIFY(missing.entries().isEmpty());
+}
+
+QTEST_MAIN(TestFstabFile)
+#include "test_fstabfile.moc"
@@ -0,0 +1,138 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include "../../src/system/mountstatistics.h"
+
+using namespace NFSShareManager;
+
+namespace {
+
+QByteArray mountStats(quint64 readBytes, quint64 readOps, quint64 readTrans, quint64 readRtt,
+                      quint64 sends, quint64 backlog)
+{
+    QByteArray content;
+    content += "device proc mounted on /proc with fstype proc\n";
+    content += "device server:/export mounted on /mnt/nfs\\040share with fstype nfs4 statvers=1.1\n";
+    content += "\topts:\trw,vers=4.2,rsize=1048576,wsize=1048576\n";
+    content += "\tage:\t120\n";
+    content += QString("\tbytes:\t%1 2048 0 0 %1 2048 10 1\n").arg(readBytes).toUtf8();
+    content += "\tRPC iostats version: 1.1  p/v: 100003/4 (nfs)\n";
+    content += QString("\txprt:\ttcp 870 1 1 0 0 %1 %1 0 %1 %2 2 0 0\n").arg(sends).arg(backlog).toUtf8();
+    content += "\tper-op statistics\n";
+    content += "\t        NULL: 1 1 0 44 24 0 0 0 0\n";
+    content += QString("\t        READ: %1 %2 0 1000 %3 0 %4 %4 0\n")
+                   .arg(readOps).arg(readTrans).arg(readBytes).arg(readRtt).toUtf8();
+    content += "\t       WRITE: 2 2 0 2300 200 0 4 6 0\n";
+    content += "\t     GETATTR: 10 10 0 1000 2000 0 5 6 0\n";
+    content += "\n";
+    content += "device tmpfs mounted on /tmp with fstype tmpfs\n";
+    return content;
+}
+
+} // namespace
+
+class TestMountStatistics : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRingBuffer();
+    void testParseSnapshot();
+    void testRatesBetweenSamples();
+    void testCounterResetClearsHistory();
+    void testUnmountedMountsAreDropped();
+    void testSampleFromFile();
+};
+
+void TestMountStatistics::testRingBuffer()
+{
+    RingBuffer<int, 3> buffer;
+    QVERIFY(buffer.isEmpty());
+    for (int i = 1; i <= 5; ++i) {
+        buffer.push(i);
+    }
+    QCOMPARE(buffer.size(), std::size_t(3));
+    QCOMPARE(buffer.at(0), 3);
+    QCOMPARE(buffer.last(), 5);
+}
+
+void TestMountStatistics::testParseSnapshot()
+{
+    MountStatistics stats;
+    stats.sample(mountStats(4096, 4, 4, 8, 100, 0), 1000);
+
+    QCOMPARE(stats.mountPoints(), QStringList() << "/mnt/nfs share");
+    QVERIFY(stats.hasMount("/mnt/nfs share"));
+    QVERIFY(!stats.hasMount("/proc"));
+
+    MountStatsSnapshot snapshot = stats.lastSnapshot("/mnt/nfs share");
+    QCOMPARE(snapshot.bytesRead, quint64(4096));
+    QCOMPARE(snapshot.bytesWritten, quint64(2048));
+    QCOMPARE(snapshot.xprtSends, quint64(100));
+    QCOMPARE(snapshot.ops[static_cast<std::size_t>(NFSOperation::Read)].operations, quint64(4));
+    QCOMPARE(snapshot.ops[static_cast<std::size_t>(NFSOperation::Total)].operations, quint64(17));
+
+    // A single sample does not produce a rate yet
+    QVERIFY(stats.rateHistory("/mnt/nfs share").isEmpty());
+}
+
+void TestMountStatistics::testRatesBetweenSamples()
+{
+    MountStatistics stats;
+    stats.sample(mountStats(4096, 4, 4, 8, 100, 0), 1000);
+    stats.sample(mountStats(4096 + 2 * 1048576, 14, 16, 58, 200, 50), 3000);
+
+    MountStatsRate rate = stats.latestRate("/mnt/nfs share");
+    QCOMPARE(rate.intervalSeconds, 2.0);
+    QCOMPARE(rate.readBytesPerSecond, 1048576.0);
+    QCOMPARE(rate.writeBytesPerSecond, 0.0);
+    QCOMPARE(rate.averageBacklog, 0.5);
+    QCOMPARE(rate.op(NFSOperation::Read).operationsPerSecond, 5.0);
+    QCOMPARE(rate.op(NFSOperation::Read).averageRttMs, 5.0);
+    QCOMPARE(rate.op(NFSOperation::Read).retransmissions, quint64(2));
+    QCOMPARE(stats.rateHistory("/mnt/nfs share").size(), 1);
+}
+
+void TestMountStatistics::testCounterResetClearsHistory()
+{
+    MountStatistics stats;
+    stats.sample(mountStats(4096, 4, 4, 8, 100, 0), 1000);
+    stats.sample(mountStats(8192, 8, 8, 16, 200, 0), 2000);
+    QCOMPARE(stats.rateHistory("/mnt/nfs share").size(), 1);
+
+    // Remount: counters start from zero again
+    stats.sample(mountStats(0, 0, 0, 0, 0, 0), 3000);
+    QVERIFY(stats.rateHistory("/mnt/nfs share").isEmpty());
+}
+
+void TestMountStatistics::testUnmountedMountsAreDropped()
+{
+    MountStatistics stats;
+    stats.sample(mountStats(4096, 4, 4, 8, 100, 0), 1000);
+    QVERIFY(stats.hasMount("/mnt/nfs share"));
+
+    stats.sample("device proc mounted on /proc with fstype proc\n", 2000);
+    QVERIFY(!stats.hasMount("/mnt/nfs share"));
+    QVERIFY(stats.mountPoints().isEmpty());
+}
+
+void TestMountStatistics::testSampleFromFile()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    QString path = tempDir.path() + "/mountstats";
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(mountStats(4096, 4, 4, 8, 100, 0));
+    file.close();
+
+    MountStatistics stats;
+    stats.setStatsFilePath(path);
+    QVERIFY(stats.sample());
+    QVERIFY(stats.hasMount("/mnt/nfs share"));
+
+    stats.setStatsFilePath(tempDir.path() + "/missing");
+    QVERIFY(!stats.sample());
+}
+
+QTEST_MAIN(TestMountStatistics)
+#include "test_mountstatistics.moc"
@@ -0,0 +1,165 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+#include "../../src/system/mounttablemonitor.h"
+
+using namespace NFSShareManager;
+
+namespace {
+
+const QByteArray rootLine = "22 1 259:2 / / rw,relatime shared:1 - ext4 /dev/nvme0n1p2 rw\n";
+const QByteArray dataLine =
+    "36 22 0:52 / /mnt/data rw,relatime shared:40 - nfs4 server:/srv/data rw,vers=4.2,rsize=1048576,hard\n";
+const QByteArray nestedLine =
+    "37 36 0:53 / /mnt/data/my\\040files rw shared:41 - nfs [fd00::1]:/export ro,vers=3\n";
+
+} // namespace
+
+class TestMountTableMonitor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testParseLine();
+    void testAddRemoveAndChange();
+    void testUnchangedTableIsSilent();
+    void testStartOnLiveTable();
+
+private:
+    void writeTable(const QByteArray &content);
+
+    QTemporaryDir *m_tempDir;
+    QString m_tablePath;
+};
+
+void TestMountTableMonitor::init()
+{
+    m_tempDir = new QTemporaryDir();
+    QVERIFY(m_tempDir->isValid());
+    m_tablePath = m_tempDir->filePath("mountinfo");
+}
+
+void TestMountTableMonitor::cleanup()
+{
+    delete m_tempDir;
+    m_tempDir = nullptr;
+}
+
+void TestMountTableMonitor::writeTable(const QByteArray &content)
+{
+    QFile file(m_tablePath);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(content);
+    }
+}
+
+void TestMountTableMonitor::testParseLine()
+{
+    MountInfoEntry entry;
+    QVERIFY(MountTableMonitor::parseLine(QString::fromUtf8(dataLine).trimmed(), &entry));
+    QCOMPARE(entry.mountId, 36);
+    QCOMPARE(entry.parentId, 22);
+    QCOMPARE(entry.device, QString("0:52"));
+    QCOMPARE(entry.mountPoint, QString("/mnt/data"));
+    QCOMPARE(entry.mountOptions, QStringList({"rw", "relatime"}));
+    QCOMPARE(entry.fsType, QString("nfs4"));
+    QCOMPARE(entry.source, QString("server:/srv/data"));
+    QVERIFY(entry.superOptions.contains("vers=4.2"));
+    QVERIFY(entry.isNFS());
+
+    // Escaped blanks and no optional fields
+    QVERIFY(MountTableMonitor::parseLine(QString::fromUtf8(nestedLine).trimmed(), &entry));
+    QCOMPARE(entry.mountPoint, QString("/mnt/data/my files"));
+    QCOMPARE(entry.source, QString("[fd00::1]:/export"));
+
+    QVERIFY(!MountTableMonitor::parseLine("", &entry));
+    QVERIFY(!MountTableMonitor::parseLine("36 22 0:52 / /mnt/data rw", &entry));
+    QVERIFY(!MountTableMonitor::parseLine("x 22 0:52 / /mnt/data rw - nfs server:/srv rw", &entry));
+}
+
+void TestMountTableMonitor::testAddRemoveAndChange()
+{
+    writeTable(rootLine + dataLine);
+    MountTableMonitor monitor;
+    monitor.setMountInfoPath(m_tablePath);
+
+    QSignalSpy added(&monitor, &MountTableMonitor::mountAdded);
+    QSignalSpy removed(&monitor, &MountTableMonitor::mountRemoved);
+    QSignalSpy changed(&monitor, &MountTableMonitor::mountChanged);
+
+    QVERIFY(monitor.rescan());
+    QCOMPARE(added.count(), 2);
+    QCOMPARE(monitor.entries().size(), 2);
+    QCOMPARE(monitor.entryForMountPoint("/mnt/data/").mountId, 36);
+    QVERIFY(!monitor.entryForMountPoint("/mnt/other").isValid());
+
+    // A nested mount appears
+    writeTable(rootLine + dataLine + nestedLine);
+    QVERIFY(monitor.rescan());
+    QCOMPARE(added.count(), 3);
+    QCOMPARE(added.last().at(0).value<MountInfoEntry>().mountId, 37);
+
+    // Remounting read-only keeps the ID
+    QByteArray remounted = dataLine;
+    remounted.replace("/mnt/data rw,relatime", "/mnt/data ro,relatime");
+    writeTable(rootLine + remounted + nestedLine);
+    QVERIFY(monitor.rescan());
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(changed.first().at(1).value<MountInfoEntry>().mountOptions.first(), QString("ro"));
+
+    // Both NFS mounts go away, the nested one is reported first
+    writeTable(rootLine);
+    QVERIFY(monitor.rescan());
+    QCOMPARE(removed.count(), 2);
+    QCOMPARE(removed.at(0).at(0).value<MountInfoEntry>().mountId, 37);
+    QCOMPARE(removed.at(1).at(0).value<MountInfoEntry>().mountId, 36);
+    QCOMPARE(added.count(), 3);
+    QCOMPARE(changed.count(), 1);
+}
+
+void TestMountTableMonitor::testUnchangedTableIsSilent()
+{
+    writeTable(rootLine + dataLine);
+    MountTableMonitor monitor;
+    monitor.setMountInfoPath(m_tablePath);
+    QVERIFY(monitor.rescan());
+
+    QSignalSpy added(&monitor, &MountTableMonitor::mountAdded);
+    QSignalSpy removed(&monitor, &MountTableMonitor::mountRemoved);
+    QSignalSpy changed(&monitor, &MountTableMonitor::mountChanged);
+    QVERIFY(monitor.rescan());
+    QCOMPARE(added.count() + removed.count() + changed.count(), 0);
+
+    monitor.setMountInfoPath(m_tempDir->filePath("absent"));
+    QVERIFY(!monitor.rescan());
+    QVERIFY(!monitor.start());
+    QCOMPARE(monitor.entries().size(), 2);
+}
+
+void TestMountTableMonitor::testStartOnLiveTable()
+{
+    if (!QFile::exists("/proc/self/mountinfo")) {
+        QSKIP("/proc/self/mountinfo is not available");
+    }
+
+    MountTableMonitor monitor;
+    QSignalSpy added(&monitor, &MountTableMonitor::mountAdded);
+    QVERIFY(monitor.start());
+    QVERIFY(monitor.isRunning());
+    QVERIFY(!monitor.entries().isEmpty());
+    QCOMPARE(added.count(), monitor.entries().size());
+
+    // Nothing changes while idle
+    QTest::qWait(100);
+    QCOMPARE(added.count(), monitor.entries().size());
+
+    monitor.stop();
+    QVERIFY(!monitor.isRunning());
+}
+
+QTEST_MAIN(TestMountTableMonitor)
+#include "test_mounttablemonitor.moc"
@@ -3,6 +3,8 @@
 #include <QTemporaryDir>
 #include <QHostAddress>
 #include "../../src/system/nfsserviceinterface.h"
+#include "../../src/system/simulatedcommandbackend.h"
+#include "../../src/system/exportsdwriter.h"
 #include "../../src/core/shareconfiguration.h"
 #include "../../src/core/remotenfsshare.h"
 
@@ -30,6 +32,8 @@ private slots:
     void testUnexportDirectory();
     void testGetExportedDirectories();
     void testReloadExports();
+    void testApplyExportsEmptyBatch();
+    void testApplyExportsRejectsInvalidBatch();
 
     // Network discovery tests
     void testQueryRemoteExportsWithHostname();
@@ -53,7 +57,21 @@ private slots:
     void testInvalidCommand();
     void testMountPointValidation();
 
+    // Simulated toolchain tests
+    void testSimulatedApplyExports();
+    void testSimulatedReloadFailureRollsBack();
+    void testSimulatedExportsDirectory();
+    void testSimulatedLegacyExportsMigrated();
+    void testSimulatedMountLifecycle();
+    void testSimulatedShowmount();
+    void testSimulatedMissingTool();
+    void testSimulatedBackendRestoresExportsPaths();
+    void testSimulatedUnexportAll();
+
 private:
+    std::shared_ptr<SimulatedCommandBackend> createSimulator();
+
+
     NFSServiceInterface *m_interface;
     QTemporaryDir *m_tempDir;
 };
@@ -170,6 +188,52 @@ void TestNFSServiceInterface::testReloadExports()
     QVERIFY(!result.command.isEmpty());
 }
 
+void TestNFSServiceInterface::testApplyExportsEmptyBatch()
+{
+    ExportBatchResult result = m_interface->applyExports(ExportBatch());
+    QVERIFY(result.success);
+    QVERIFY(result.entries.isEmpty());
+    QVERIFY(!result.rolledBack);
+}
+
+void TestNFSServiceInterface::testApplyExportsRejectsInvalidBatch()
+{
+    // exportfs is present, so only validation can reject the batch
+    auto simulator = createSimulator();
+    QString exportsPath = m_tempDir->path() + "/exports";
+    QByteArray original = "/srv/existing *(ro,sync,no_subtree_check)\n";
+    QFile file(exportsPath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(original);
+    file.close();
+
+    m_interface->setExportsFilePath(exportsPath);
+    QCOMPARE(m_interface->exportsFilePath(), exportsPath);
+
+    ShareConfiguration config("test", AccessMode::ReadOnly);
+    config.addAllowedHost("*");
+
+    ExportBatch batch;
+    batch << ExportChange::add(m_tempDir->path(), config);
+    batch << ExportChange::add("relative/path", config);
+    batch << ExportChange::remove("/srv/not-exported");
+
+    ExportBatchResult result = m_interface->applyExports(batch);
+    QVERIFY(!result.success);
+    QVERIFY(!result.rolledBack);
+    QCOMPARE(result.entries.size(), batch.size());
+    QCOMPARE(result.failedPaths().size(), batch.size());
+    QCOMPARE(result.entries[0].error, QString("Not applied: another entry in the batch is invalid"));
+    QCOMPARE(result.entries[1].error, QString("Export path must be absolute"));
+    QCOMPARE(result.entries[2].error, QString("Path is not exported"));
+    QCOMPARE(simulator->commandCount("exportfs"), 0);
+
+    // Nothing may be written when any entry of the batch is rejected
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), original);
+    file.close();
+}
+
 void TestNFSServiceInterface::testQueryRemoteExportsWithHostname()
 {
     // Test with localhost (should be safe on most systems)
@@ -361,5 +425,263 @@ void TestNFSServiceInterface::testMountPointValidation()
     QVERIFY(result3.error.contains("Invalid mount point"));
 }
 
+std::shared_ptr<SimulatedCommandBackend> TestNFSServiceInterface::createSimulator()
+{
+    auto simulator = std::make_shared<SimulatedCommandBackend>(42);
+    simulator->setExportsFilePath(m_tempDir->filePath("exports"));
+    m_interface->setCommandBackend(simulator);
+    return simulator;
+}
+
+void TestNFSServiceInterface::testSimulatedApplyExports()
+{
+    auto simulator = createSimulator();
+    QCOMPARE(m_interface->exportsFilePath(), m_tempDir->filePath("exports"));
+    QVERIFY(m_interface->isNFSToolsAvailable());
+
+    QDir(m_tempDir->path()).mkpath("one");
+    QDir(m_tempDir->path()).mkpath("two");
+    const QString one = m_tempDir->filePath("one");
+    const QString two = m_tempDir->filePath("two");
+
+    ShareConfiguration config("test", AccessMode::ReadOnly);
+    config.addAllowedHost("*");
+
+    ExportBatch batch;
+    batch << ExportChange::add(one, config) << ExportChange::add(two, config);
+    ExportBatchResult result = m_interface->applyExports(batch);
+    QVERIFY(result.success);
+    QCOMPARE(simulator->exportedPaths(), QStringList({one, two}));
+
+    // Only the two new shares are exported; nothing else is re-read
+    QCOMPARE(simulator->commandCount("exportfs"), 2);
+
+    // The kernel table is visible through exportfs -v
+    NFSCommandResult listed = m_interface->getExportedDirectories();
+    QVERIFY(listed.success);
+    QCOMPARE(m_interface->parseExportfsOutput(listed.output).size(), 2);
+
+    result = m_interface->applyExports(ExportBatch() << ExportChange::remove(one));
+    QVERIFY(result.success);
+    QCOMPARE(simulator->exportedPaths(), QStringList({two}));
+
+    QVERIFY(m_interface->unexportDirectory(two).success);
+    QVERIFY(simulator->exportedPaths().isEmpty());
+    QVERIFY(!m_interface->unexportDirectory(two).success);
+}
+
+void TestNFSServiceInterface::testSimulatedReloadFailureRollsBack()
+{
+    auto simulator = createSimulator();
+    simulator->failNext("exportfs");
+
+    ShareConfiguration config("test", AccessMode::ReadOnly);
+    config.addAllowedHost("*");
+
+    ExportBatchResult result = m_interface->applyExports(ExportBatch() << ExportChange::add(m_tempDir->path(), config));
+    QVERIFY(!result.success);
+    QVERIFY(result.rolledBack);
+    QCOMPARE(result.failedPaths().size(), 1);
+
+    QFile file(m_interface->exportsFilePath());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.readAll().isEmpty());
+    file.close();
+
+    // When undoing the re-export fails too, the caller is not told it was restored
+    simulator->setCommandFailureRate("exportfs", 1.0);
+    result = m_interface->applyExports(ExportBatch() << ExportChange::add(m_tempDir->path(), config));
+    QVERIFY(!result.success);
+    QVERIFY(!result.rolledBack);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.readAll().isEmpty());
+}
+
+void TestNFSServiceInterface::testSimulatedExportsDirectory()
+{
+    auto simulator = createSimulator();
+    QVERIFY(QDir(m_tempDir->path()).mkpath("exports.d"));
+    m_interface->setExportsDirectory(m_tempDir->filePath("exports.d"));
+
+    QDir(m_tempDir->path()).mkpath("one");
+    QDir(m_tempDir->path()).mkpath("two");
+    const QString one = m_tempDir->filePath("one");
+    const QString two = m_tempDir->filePath("two");
+
+    ShareConfiguration config("test", AccessMode::ReadOnly);
+    config.addAllowedHost("*");
+
+    ExportBatchResult result = m_interface->applyExports(ExportBatch() << ExportChange::add(one, config)
+                                                                        << ExportChange::add(two, config));
+    QVERIFY(result.success);
+    QCOMPARE(simulator->exportedPaths(), QStringList({one, two}));
+
+    ExportsDWriter writer(m_interface->exportsDirectory());
+    QVERIFY(QFile::exists(writer.filePathForShare(one)));
+    QVERIFY(QFile::exists(writer.filePathForShare(two)));
+    QVERIFY(!QFile::exists(m_interface->exportsFilePath()));
+
+    // Removing a share touches its own file and re-exports only that share
+    simulator->resetCounters();
+    result = m_interface->applyExports(ExportBatch() << ExportChange::remove(one));
+    QVERIFY(result.success);
+    QVERIFY(!QFile::exists(writer.filePathForShare(one)));
+    QVERIFY(QFile::exists(writer.filePathForShare(two)));
+    QCOMPARE(simulator->exportedPaths(), QStringList({two}));
+    QCOMPARE(simulator->commandCount("exportfs"), 1);
+
+    // A failed re-export restores the previous file
+    simulator->failNext("exportfs");
+    result = m_interface->applyExports(ExportBatch() << ExportChange::remove(two));
+    QVERIFY(!result.success);
+    QVERIFY(result.rolledBack);
+    QVERIFY(QFile::exists(writer.filePathForShare(two)));
+}
+
+void TestNFSServiceInterface::testSimulatedLegacyExportsMigrated()
+{
+    auto simulator = createSimulator();
+    QDir(m_tempDir->path()).mkpath("legacy");
+    QDir(m_tempDir->path()).mkpath("other");
+    const QString legacy = m_tempDir->filePath("legacy");
+    const QString other = m_tempDir->filePath("other");
+
+    // Shares from before the exports directory was used
+    QFile table(m_interface->exportsFilePath());
+    QVERIFY(table.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    table.write(QString("# Existing shares\n%1 *(ro,sync)\n%2 *(rw,sync)\n").arg(legacy, other).toUtf8());
+    table.close();
+    QVERIFY(simulator->execute("exportfs", {"-r"}, 1000).success);
+    QCOMPARE(simulator->exportedPaths(), QStringList({legacy, other}));
+
+    QVERIFY(QDir(m_tempDir->path()).mkpath("exports.d"));
+    m_interface->setExportsDirectory(m_tempDir->filePath("exports.d"));
+    ExportsDWriter writer(m_interface->exportsDirectory());
+
+    ShareConfiguration config("test", AccessMode::ReadWrite);
+    config.addAllowedHost("*");
+
+    // A share in the table is already exported
+    ExportBatchResult result = m_interface->applyExports(ExportBatch() << ExportChange::add(legacy, config));
+    QVERIFY(!result.success);
+    QCOMPARE(result.entries.first().error, QString("Path is already exported"));
+
+    // Changing it moves it from the table into its own file
+    result = m_interface->applyExports(ExportBatch() << ExportChange::modify(legacy, config));
+    QVERIFY(result.success);
+    QVERIFY(QFile::exists(writer.filePathForShare(legacy)));
+    QVERIFY(table.open(QIODevice::ReadOnly));
+    const QString content = QString::fromUtf8(table.readAll());
+    table.close();
+    QVERIFY(!content.contains(legacy + " "));
+    QVERIFY(content.contains(other + " "));
+    QVERIFY(content.contains("# Existing shares"));
+
+    // Removing a share from the table for good: a full reload does not bring it back
+    result = m_interface->applyExports(ExportBatch() << ExportChange::remove(other));
+    QVERIFY(result.success);
+    QVERIFY(m_interface->reloadExports().success);
+    QCOMPARE(simulator->exportedPaths(), QStringList({legacy}));
+}
+
+void TestNFSServiceInterface::testSimulatedMountLifecycle()
+{
+    auto simulator = createSimulator();
+    simulator->addRemoteServer("nfs.example.com", {"/export/data"});
+
+    const QString mountPoint = m_tempDir->filePath("mnt");
+    NFSCommandResult result = m_interface->mountNFSShare("nfs.example.com", "/export/data", mountPoint);
+    QVERIFY2(result.success, qPrintable(result.error));
+    QVERIFY(m_interface->isNFSMountPoint(mountPoint));
+
+    QList<MountInfo> mounts = m_interface->getMountedNFSShares();
+    QCOMPARE(mounts.size(), 1);
+    QCOMPARE(mounts.first().device, QString("nfs.example.com:/export/data"));
+    QVERIFY(mounts.first().options.contains("nfsvers=4"));
+
+    // Mounting twice and unknown exports fail like mount.nfs
+    result = m_interface->mountNFSShare("nfs.example.com", "/export/data", mountPoint);
+    QVERIFY(!result.success);
+    QCOMPARE(result.exitCode, 32);
+    QVERIFY(QDir(m_tempDir->path()).mkpath("other"));
+    result = m_interface->mountNFSShare("nfs.example.com", "/export/other", m_tempDir->filePath("other"));
+    QVERIFY(!result.success);
+    QVERIFY(result.error.contains("access denied"));
+
+    QVERIFY(m_interface->unmountNFSShare(mountPoint).success);
+    QVERIFY(simulator->mountPoints().isEmpty());
+    QVERIFY(!m_interface->unmountNFSShare(mountPoint).success);
+}
+
+void TestNFSServiceInterface::testSimulatedShowmount()
+{
+    auto simulator = createSimulator();
+    simulator->populateRemoteServers(3, 250);
+    QCOMPARE(simulator->remoteServers().size(), 3);
+
+    NFSCommandResult result = m_interface->queryRemoteExports("10.99.0.2");
+    QVERIFY(result.success);
+    QList<RemoteNFSShare> shares = m_interface->parseShowmountOutput(result.output, "10.99.0.2");
+    QCOMPARE(shares.size(), 250);
+    QCOMPARE(shares.first().exportPath(), QString("/export/share0000"));
+
+    QVERIFY(m_interface->queryRPCServices("10.99.0.2").success);
+    QVERIFY(!m_interface->queryRemoteExports("10.99.9.9").success);
+}
+
+void TestNFSServiceInterface::testSimulatedMissingTool()
+{
+    auto simulator = createSimulator();
+    simulator->setToolAvailable("showmount", false);
+
+    QVERIFY(!m_interface->isNFSToolsAvailable());
+    QCOMPARE(m_interface->getMissingTools(), QStringList({"showmount"}));
+
+    // Latency beyond the timeout is reported like a hung process
+    simulator->setToolAvailable("showmount", true);
+    simulator->setCommandLatency("rpcinfo", 200);
+    NFSCommandResult result = m_interface->queryRPCServices("10.99.0.1", 50);
+    QVERIFY(!result.success);
+    QCOMPARE(result.error, QString("Command execution timed out"));
+}
+
+void TestNFSServiceInterface::testSimulatedBackendRestoresExportsPaths()
+{
+    const QString exportsFile = m_tempDir->filePath("real-exports");
+    const QString exportsDirectory = m_tempDir->filePath("real-exports.d");
+    m_interface->setExportsFilePath(exportsFile);
+    m_interface->setExportsDirectory(exportsDirectory);
+
+    createSimulator();
+    QCOMPARE(m_interface->exportsFilePath(), m_tempDir->filePath("exports"));
+    QVERIFY(m_interface->exportsDirectory().isEmpty());
+
+    // Another simulator keeps the paths from before the first one
+    createSimulator();
+    m_interface->setCommandBackend(nullptr);
+    QCOMPARE(m_interface->exportsFilePath(), exportsFile);
+    QCOMPARE(m_interface->exportsDirectory(), exportsDirectory);
+}
+
+void TestNFSServiceInterface::testSimulatedUnexportAll()
+{
+    auto simulator = createSimulator();
+    QDir(m_tempDir->path()).mkpath("one");
+    const QString one = m_tempDir->filePath("one");
+
+    ShareConfiguration config("test", AccessMode::ReadOnly);
+    config.addAllowedHost("*");
+    QVERIFY(m_interface->applyExports(ExportBatch() << ExportChange::add(one, config)).success);
+    QCOMPARE(simulator->exportedPaths(), QStringList({one}));
+
+    // exportfs -ua empties the kernel table even though the file still lists the share
+    QVERIFY(simulator->execute("exportfs", {"-ua"}, 1000).success);
+    QVERIFY(simulator->exportedPaths().isEmpty());
+
+    // exportfs -a puts it back from the file
+    QVERIFY(simulator->execute("exportfs", {"-a"}, 1000).success);
+    QCOMPARE(simulator->exportedPaths(), QStringList({one}));
+}
+
 QTEST_MAIN(TestNFSServiceInterface)
 #include "test_nfsserviceinterface.moc"
\ No newline at end of file
@@ -88,6 +88,9 @@ void TestPolicyKitHelper::testActionIdGeneration()
     
     QCOMPARE(PolicyKitHelper::getActionId(PolicyKitHelper::Action::ModifySystemFiles),
              QString("org.kde.nfs-share-manager.modify-system-files"));
+    
+    QCOMPARE(PolicyKitHelper::getActionId(PolicyKitHelper::Action::TuneBackingDevice),
+             QString("org.kde.nfs-share-manager.tune-backing-device"));
 }
 
 void TestPolicyKitHelper::testActionDescriptions()
@@ -176,6 +179,25 @@ void TestPolicyKitHelper::testInvalidParameters()
         QList<QVariant> arguments = spy.takeFirst();
         QVERIFY(arguments.at(1).toBool() == false); // success should be false
     }
+
+    // The sysfs tree of a backing device write is never the caller's choice
+    QVariantMap tuneParams;
+    tuneParams["device"] = "0:52";
+    tuneParams["readAheadKb"] = 1024;
+    tuneParams["sysfsRoot"] = "/etc";
+    QString error;
+    QVERIFY(!m_helper->executePrivilegedAction(PolicyKitHelper::Action::TuneBackingDevice, tuneParams,
+                                               &error, nullptr));
+    QVERIFY(!error.isEmpty());
+
+    // Neither is the file an fstab edit goes to
+    QVariantMap fstabParams;
+    fstabParams["fstabEntries"] = QStringList{"server:/data /mnt/data nfs ro 0 0"};
+    fstabParams["fstabFile"] = "/etc/shadow";
+    error.clear();
+    QVERIFY(!m_helper->executePrivilegedAction(PolicyKitHelper::Action::ModifyFstab, fstabParams,
+                                               &error, nullptr));
+    QVERIFY(!error.isEmpty());
 }
 
 void TestPolicyKitHelper::testMissingPolicyKit()
@@ -0,0 +1,75 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include "../../src/system/systemdmanager.h"
+
+using namespace NFSShareManager;
+
+class TestSystemdManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testMethodNames();
+    void testEscapePath();
+    void testWithoutSystemd();
+    void testWatchUnitReportsState();
+};
+
+void TestSystemdManager::testMethodNames()
+{
+    QCOMPARE(SystemdManager::methodForOperation(SystemdManager::Operation::Start), QString("StartUnit"));
+    QCOMPARE(SystemdManager::methodForOperation(SystemdManager::Operation::Stop), QString("StopUnit"));
+    QCOMPARE(SystemdManager::methodForOperation(SystemdManager::Operation::Restart), QString("RestartUnit"));
+    QCOMPARE(SystemdManager::methodForOperation(SystemdManager::Operation::Reload), QString("ReloadUnit"));
+}
+
+void TestSystemdManager::testEscapePath()
+{
+    // Same results as systemd-escape --path
+    QCOMPARE(SystemdManager::escapePath("/mnt/nfs/data"), QString("mnt-nfs-data"));
+    QCOMPARE(SystemdManager::escapePath("//mnt//nfs/data/"), QString("mnt-nfs-data"));
+    QCOMPARE(SystemdManager::escapePath("/"), QString("-"));
+    QCOMPARE(SystemdManager::escapePath("/mnt/my-share"), QString("mnt-my\\x2dshare"));
+    QCOMPARE(SystemdManager::escapePath("/mnt/my files"), QString("mnt-my\\x20files"));
+    QCOMPARE(SystemdManager::escapePath("/.hidden/a.b"), QString("\\x2ehidden-a.b"));
+    QCOMPARE(SystemdManager::unitNameForPath("/mnt/nfs/data", "automount"), QString("mnt-nfs-data.automount"));
+}
+
+void TestSystemdManager::testWithoutSystemd()
+{
+    SystemdManager manager;
+    if (manager.isAvailable()) {
+        QSKIP("systemd is available on the system bus");
+    }
+
+    // Units can be watched but stay unknown, and no job is queued
+    manager.watchUnit("nfs-server.service");
+    QCOMPARE(manager.watchedUnits(), QStringList({"nfs-server.service"}));
+    QVERIFY(!manager.unitStatus("nfs-server.service").isKnown());
+    QVERIFY(!manager.isUnitActive("nfs-server.service"));
+    QVERIFY(!manager.restartUnit("nfs-server.service"));
+    QVERIFY(!manager.reloadDaemon());
+}
+
+void TestSystemdManager::testWatchUnitReportsState()
+{
+    SystemdManager manager;
+    if (!manager.isAvailable()) {
+        QSKIP("systemd is not available on the system bus");
+    }
+
+    // dbus.service is active on every systemd host that has a system bus
+    QSignalSpy spy(&manager, &SystemdManager::unitStateChanged);
+    manager.watchUnit("dbus.service");
+    QTRY_VERIFY_WITH_TIMEOUT(spy.count() >= 1, 5000);
+
+    const UnitStatus status = manager.unitStatus("dbus.service");
+    QCOMPARE(spy.first().at(0).toString(), QString("dbus.service"));
+    QVERIFY(status.isKnown());
+    QCOMPARE(status.loadState, QString("loaded"));
+    QVERIFY(status.isActive());
+    QVERIFY(status.objectPath.startsWith("/org/freedesktop/systemd1/unit/"));
+}
+
+QTEST_MAIN(TestSystemdManager)
+#include "test_systemdmanager.moc"
@@ -0,0 +1,138 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QSettings>
+#include "../../src/system/toolregistry.h"
+
+using namespace NFSShareManager;
+
+class TestToolRegistry : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    // Parsing helpers
+    void testParseVersion();
+    void testCompareVersions();
+
+    // Resolution tests
+    void testResolvesAbsolutePath();
+    void testMissingTool();
+    void testPersistsResolvedTools();
+    void testPathChangeInvalidates();
+
+private:
+    QString createFakeTool(const QString &dir, const QString &name);
+
+    QTemporaryDir *m_tempDir;
+    QByteArray m_originalPath;
+};
+
+void TestToolRegistry::init()
+{
+    m_tempDir = new QTemporaryDir();
+    QVERIFY(m_tempDir->isValid());
+    m_originalPath = qgetenv("PATH");
+    ToolRegistry::instance().setCacheFilePath(m_tempDir->path() + "/tools.ini");
+}
+
+void TestToolRegistry::cleanup()
+{
+    qputenv("PATH", m_originalPath);
+    ToolRegistry::instance().setCacheFilePath(QString());
+    delete m_tempDir;
+    m_tempDir = nullptr;
+}
+
+QString TestToolRegistry::createFakeTool(const QString &dir, const QString &name)
+{
+    QDir().mkpath(dir);
+    QString path = dir + "/" + name;
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write("#!/bin/sh\necho \"" + name.toUtf8() + " 1.2.3\"\n");
+        file.close();
+        file.setPermissions(file.permissions() | QFile::ExeOwner | QFile::ExeUser);
+    }
+    return path;
+}
+
+void TestToolRegistry::testParseVersion()
+{
+    QCOMPARE(ToolRegistry::parseVersion("mount.nfs: (linux nfs-utils 2.6.2)"), QString("2.6.2"));
+    QCOMPARE(ToolRegistry::parseVersion("mount from util-linux 2.38.1 (libmount 2.38.1)"), QString("2.38.1"));
+    QCOMPARE(ToolRegistry::parseVersion("6.1.0-13-amd64"), QString("6.1.0"));
+    QVERIFY(ToolRegistry::parseVersion("no version here").isEmpty());
+}
+
+void TestToolRegistry::testCompareVersions()
+{
+    QVERIFY(ToolRegistry::compareVersions("5.3", "5.3.0") == 0);
+    QVERIFY(ToolRegistry::compareVersions("5.10", "5.3") > 0);
+    QVERIFY(ToolRegistry::compareVersions("4.19.2", "5.3") < 0);
+}
+
+void TestToolRegistry::testResolvesAbsolutePath()
+{
+    QString binDir = m_tempDir->path() + "/bin";
+    QString toolPath = createFakeTool(binDir, "nfs-fake-tool");
+    qputenv("PATH", binDir.toLocal8Bit());
+
+    ToolInfo info = ToolRegistry::instance().tool("nfs-fake-tool");
+    QVERIFY(info.isAvailable());
+    QCOMPARE(info.path, toolPath);
+    QVERIFY(info.inode != 0);
+    QCOMPARE(ToolRegistry::instance().resolvedPath("nfs-fake-tool"), toolPath);
+}
+
+void TestToolRegistry::testMissingTool()
+{
+    QVERIFY(!ToolRegistry::instance().isAvailable("nfs-tool-that-does-not-exist"));
+    QVERIFY(ToolRegistry::instance().resolvedPath("nfs-tool-that-does-not-exist").isEmpty());
+    QVERIFY(!ToolRegistry::instance().hasFeature("nfs-tool-that-does-not-exist",
+                                                 ToolRegistry::FeatureNconnect));
+}
+
+void TestToolRegistry::testPersistsResolvedTools()
+{
+    QString binDir = m_tempDir->path() + "/bin";
+    QString toolPath = createFakeTool(binDir, "nfs-fake-tool");
+    qputenv("PATH", binDir.toLocal8Bit());
+
+    QVERIFY(ToolRegistry::instance().isAvailable("nfs-fake-tool"));
+    ToolRegistry::instance().isAvailable("nfs-tool-that-does-not-exist");
+
+    QSettings cache(ToolRegistry::instance().cacheFilePath(), QSettings::IniFormat);
+    QCOMPARE(cache.value("tools/nfs-fake-tool/path").toString(), toolPath);
+    // Missing tools are not persisted so that later installs are picked up
+    QVERIFY(!cache.contains("tools/nfs-tool-that-does-not-exist/path"));
+
+    // A fresh load must come back with the same resolution
+    ToolRegistry::instance().setCacheFilePath(ToolRegistry::instance().cacheFilePath());
+    QCOMPARE(ToolRegistry::instance().resolvedPath("nfs-fake-tool"), toolPath);
+
+    // Lookups that change no entry do not write the cache
+    QVERIFY(QFile::remove(ToolRegistry::instance().cacheFilePath()));
+    QCOMPARE(ToolRegistry::instance().resolvedPath("nfs-fake-tool"), toolPath);
+    ToolRegistry::instance().isAvailable("another-nfs-tool-that-does-not-exist");
+    QVERIFY(!QFile::exists(ToolRegistry::instance().cacheFilePath()));
+}
+
+void TestToolRegistry::testPathChangeInvalidates()
+{
+    QString firstDir = m_tempDir->path() + "/first";
+    QString secondDir = m_tempDir->path() + "/second";
+    createFakeTool(firstDir, "nfs-fake-tool");
+    QString secondPath = createFakeTool(secondDir, "nfs-fake-tool");
+
+    qputenv("PATH", firstDir.toLocal8Bit());
+    QVERIFY(ToolRegistry::instance().resolvedPath("nfs-fake-tool").startsWith(firstDir));
+
+    qputenv("PATH", secondDir.toLocal8Bit());
+    QCOMPARE(ToolRegistry::instance().resolvedPath("nfs-fake-tool"), secondPath);
+}
+
+QTEST_MAIN(TestToolRegistry)
+#include "test_toolregistry.moc"
@@ -0,0 +1,111 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include "../../src/system/writebehindscheduler.h"
+
+using namespace NFSShareManager;
+
+class TestWriteBehindScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testBurstIsCoalesced();
+    void testMaxDelayBoundsLatency();
+    void testExplicitFlush();
+    void testFailedFlushIsRetried();
+
+private:
+    WriteBehindScheduler *m_scheduler;
+    QList<QStringList> m_flushes;
+    bool m_failFlush;
+};
+
+void TestWriteBehindScheduler::init()
+{
+    m_flushes.clear();
+    m_failFlush = false;
+    m_scheduler = new WriteBehindScheduler([this](const QStringList &keys) {
+        m_flushes << keys;
+        return !m_failFlush;
+    });
+    m_scheduler->setDelay(50);
+    m_scheduler->setMaxDelay(1000);
+}
+
+void TestWriteBehindScheduler::cleanup()
+{
+    delete m_scheduler;
+    m_scheduler = nullptr;
+}
+
+void TestWriteBehindScheduler::testBurstIsCoalesced()
+{
+    for (int i = 0; i < 100; ++i) {
+        m_scheduler->markDirty(QString("/srv/share%1").arg(i % 10));
+    }
+    QVERIFY(m_scheduler->isDirty());
+    QCOMPARE(m_scheduler->dirtyKeys().size(), 10);
+    QVERIFY(m_flushes.isEmpty());
+
+    QTRY_COMPARE(m_flushes.size(), 1);
+    QCOMPARE(m_flushes.first().size(), 10);
+    QVERIFY(!m_scheduler->isDirty());
+
+    // Nothing else is pending
+    QTest::qWait(150);
+    QCOMPARE(m_scheduler->flushCount(), 1);
+}
+
+void TestWriteBehindScheduler::testMaxDelayBoundsLatency()
+{
+    m_scheduler->setDelay(200);
+    m_scheduler->setMaxDelay(300);
+
+    // Keep changing faster than the quiet period; the deadline still flushes
+    QElapsedTimer timer;
+    timer.start();
+    while (m_flushes.isEmpty() && timer.elapsed() < 2000) {
+        m_scheduler->markDirty("/srv/busy");
+        QTest::qWait(20);
+    }
+    QCOMPARE(m_flushes.size(), 1);
+    QVERIFY(timer.elapsed() < 1000);
+}
+
+void TestWriteBehindScheduler::testExplicitFlush()
+{
+    QSignalSpy spy(m_scheduler, &WriteBehindScheduler::flushed);
+
+    QVERIFY(m_scheduler->flush());
+    QCOMPARE(m_scheduler->flushCount(), 0);
+
+    m_scheduler->markDirty("/srv/b");
+    m_scheduler->markDirty("/srv/a");
+    QVERIFY(m_scheduler->flush());
+    QCOMPARE(m_flushes, QList<QStringList>({QStringList({"/srv/a", "/srv/b"})}));
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(spy.first().at(0).toBool());
+
+    // The timer was cancelled by the flush
+    QTest::qWait(150);
+    QCOMPARE(m_scheduler->flushCount(), 1);
+}
+
+void TestWriteBehindScheduler::testFailedFlushIsRetried()
+{
+    m_failFlush = true;
+    m_scheduler->markDirty("/srv/a");
+    QVERIFY(!m_scheduler->flush());
+    QVERIFY(m_scheduler->isDirty());
+    QCOMPARE(m_scheduler->dirtyKeys(), QStringList({"/srv/a"}));
+
+    m_failFlush = false;
+    QTRY_VERIFY(!m_scheduler->isDirty());
+    QCOMPARE(m_flushes.size(), 2);
+}
+
+QTEST_MAIN(TestWriteBehindScheduler)
+#include "test_writebehindscheduler.moc"